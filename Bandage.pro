@@ -15,7 +15,7 @@
 # You should have received a copy of the GNU General Public License
 # along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
 
-QT       += core gui svg widgets
+QT       += core gui svg network widgets
 
 TARGET = Bandage
 TEMPLATE = app
@@ -35,6 +35,8 @@ SOURCES += \
     program/settings.cpp \
     program/globals.cpp \
     program/graphlayoutworker.cpp \
+    program/contiguitysearchworker.cpp \
+    program/graphloadworker.cpp \
     graph/debruijnnode.cpp \
     graph/debruijnedge.cpp \
     graph/graphicsitemnode.cpp \
@@ -67,6 +69,13 @@ SOURCES += \
     graph/path.cpp \
     ui/pathspecifydialog.cpp \
     graph/graphlocation.cpp \
+    graph/graphstatistics.cpp \
+    graph/nodenameindex.cpp \
+    graph/sequenceindex.cpp \
+    graph/csvtable.cpp \
+    graph/unitigcompactor.cpp \
+    graph/contiguitysearch.cpp \
+    graph/graphwriter.cpp \
     ui/tablewidgetitemint.cpp \
     ui/tablewidgetitemdouble.cpp \
     ui/tablewidgetitemshown.cpp \
@@ -79,9 +88,14 @@ SOURCES += \
     ui/changenodenamedialog.cpp \
     ui/querypathsequencecopybutton.cpp \
     command_line/querypaths.cpp \
+    command_line/gafseq.cpp \
+    command_line/findseq.cpp \
     command_line/info.cpp \
     command_line/reduce.cpp \
+    command_line/batch.cpp \
+    command_line/serve.cpp \
     program/gafparser.cpp \
+    program/gafcoverage.cpp \
     ui/gafpathsdialog.cpp \
     ogdf/basic/Graph.cpp \
     ogdf/basic/GraphAttributes.cpp \
@@ -90,6 +104,7 @@ SOURCES += \
     ogdf/cluster/ClusterGraphAttributes.cpp \
     ogdf/internal/energybased/FruchtermanReingold.cpp \
     ogdf/internal/energybased/NMM.cpp \
+    ogdf/internal/energybased/BarnesHut.cpp \
     ogdf/fileformats/GmlParser.cpp \
     ogdf/basic/simple_graph_alg.cpp \
     ogdf/basic/basic.cpp \
@@ -129,6 +144,8 @@ HEADERS  += \
     program/settings.h \
     program/globals.h \
     program/graphlayoutworker.h \
+    program/contiguitysearchworker.h \
+    program/graphloadworker.h \
     graph/debruijnnode.h \
     graph/debruijnedge.h \
     graph/graphicsitemnode.h \
@@ -163,6 +180,14 @@ HEADERS  += \
     graph/path.h \
     ui/pathspecifydialog.h \
     graph/graphlocation.h \
+    graph/graphstatistics.h \
+    graph/nodenameindex.h \
+    graph/sequenceindex.h \
+    graph/csvtable.h \
+    graph/unitigcompactor.h \
+    graph/contiguitysearch.h \
+    graph/graphwriter.h \
+    program/parallel.h \
     ui/tablewidgetitemint.h \
     ui/tablewidgetitemdouble.h \
     ui/tablewidgetitemshown.h \
@@ -176,9 +201,14 @@ HEADERS  += \
     ui/changenodenamedialog.h \
     ui/querypathsequencecopybutton.h \
     command_line/querypaths.h \
+    command_line/gafseq.h \
+    command_line/findseq.h \
     command_line/info.h \
     command_line/reduce.h \
+    command_line/batch.h \
+    command_line/serve.h \
     program/gafparser.h \
+    program/gafcoverage.h \
     ui/gafpathsdialog.h \
     ui/selectededgepathwidget.h \
     ui/nodesequencewidget.h \
@@ -191,6 +221,7 @@ HEADERS  += \
     ogdf/module/LayoutModule.h \
     ogdf/internal/energybased/FruchtermanReingold.h \
     ogdf/internal/energybased/NMM.h \
+    ogdf/internal/energybased/BarnesHut.h \
     ogdf/basic/AdjEntryArray.h \
     ogdf/basic/Array.h \
     ogdf/fileformats/GmlParser.h \
@@ -15,7 +15,7 @@
 # You should have received a copy of the GNU General Public License
 # along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
 
-QT       += core gui svg testlib
+QT       += core gui svg network testlib
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -33,6 +33,8 @@ SOURCES += \
     program/settings.cpp \
     program/globals.cpp \
     program/graphlayoutworker.cpp \
+    program/contiguitysearchworker.cpp \
+    program/graphloadworker.cpp \
     graph/debruijnnode.cpp \
     graph/debruijnedge.cpp \
     graph/graphicsitemnode.cpp \
@@ -65,6 +67,13 @@ SOURCES += \
     graph/path.cpp \
     ui/pathspecifydialog.cpp \
     graph/graphlocation.cpp \
+    graph/graphstatistics.cpp \
+    graph/nodenameindex.cpp \
+    graph/sequenceindex.cpp \
+    graph/csvtable.cpp \
+    graph/unitigcompactor.cpp \
+    graph/contiguitysearch.cpp \
+    graph/graphwriter.cpp \
     ui/tablewidgetitemint.cpp \
     ui/tablewidgetitemdouble.cpp \
     ui/tablewidgetitemshown.cpp \
@@ -79,8 +88,14 @@ SOURCES += \
     ui/changenodedepthdialog.cpp \
     ui/querypathsequencecopybutton.cpp \
     command_line/querypaths.cpp \
+    command_line/gafseq.cpp \
+    command_line/findseq.cpp \
+    program/gafparser.cpp \
+    program/gafcoverage.cpp \
     command_line/info.cpp \
     command_line/reduce.cpp \
+    command_line/batch.cpp \
+    command_line/serve.cpp \
     ogdf/basic/Graph.cpp \
     ogdf/basic/GraphAttributes.cpp \
     ogdf/energybased/FMMMLayout.cpp \
@@ -88,6 +103,7 @@ SOURCES += \
     ogdf/cluster/ClusterGraphAttributes.cpp \
     ogdf/internal/energybased/FruchtermanReingold.cpp \
     ogdf/internal/energybased/NMM.cpp \
+    ogdf/internal/energybased/BarnesHut.cpp \
     ogdf/fileformats/GmlParser.cpp \
     ogdf/basic/simple_graph_alg.cpp \
     ogdf/basic/basic.cpp \
@@ -124,6 +140,8 @@ HEADERS  += \
     program/settings.h \
     program/globals.h \
     program/graphlayoutworker.h \
+    program/contiguitysearchworker.h \
+    program/graphloadworker.h \
     graph/debruijnnode.h \
     graph/debruijnedge.h \
     graph/graphicsitemnode.h \
@@ -158,6 +176,14 @@ HEADERS  += \
     graph/path.h \
     ui/pathspecifydialog.h \
     graph/graphlocation.h \
+    graph/graphstatistics.h \
+    graph/nodenameindex.h \
+    graph/sequenceindex.h \
+    graph/csvtable.h \
+    graph/unitigcompactor.h \
+    graph/contiguitysearch.h \
+    graph/graphwriter.h \
+    program/parallel.h \
     ui/tablewidgetitemint.h \
     ui/tablewidgetitemdouble.h \
     ui/tablewidgetitemshown.h \
@@ -172,8 +198,14 @@ HEADERS  += \
     ui/changenodedepthdialog.h \
     ui/querypathsequencecopybutton.h \
     command_line/querypaths.h \
+    command_line/gafseq.h \
+    command_line/findseq.h \
+    program/gafparser.h \
+    program/gafcoverage.h \
     command_line/info.h \
     command_line/reduce.h \
+    command_line/batch.h \
+    command_line/serve.h \
     ogdf/basic/Graph.h \
     ogdf/basic/GraphAttributes.h \
     ogdf/energybased/FMMMLayout.h \
@@ -182,6 +214,7 @@ HEADERS  += \
     ogdf/module/LayoutModule.h \
     ogdf/internal/energybased/FruchtermanReingold.h \
     ogdf/internal/energybased/NMM.h \
+    ogdf/internal/energybased/BarnesHut.h \
     ogdf/basic/AdjEntryArray.h \
     ogdf/basic/Array.h \
     ogdf/fileformats/GmlParser.h \
@@ -22,6 +22,8 @@
 #include <QTextStream>
 #include "blastsearch.h"
 #include "../program/memory.h"
+#include <QSet>
+#include <algorithm>
 
 BlastQueries::BlastQueries() :
     m_tempNuclFile(0), m_tempProtFile(0)
@@ -110,11 +112,16 @@ void BlastQueries::clearAllQueries()
 
 void BlastQueries::clearSomeQueries(std::vector<BlastQuery *> queriesToRemove)
 {
+    QSet<BlastQuery *> deletedQueries;
     for (size_t i = 0; i < queriesToRemove.size(); ++i)
-    {
-        m_queries.erase(std::remove(m_queries.begin(), m_queries.end(), queriesToRemove[i]), m_queries.end());
-        delete queriesToRemove[i];
-    }
+        deletedQueries.insert(queriesToRemove[i]);
+    m_queries.erase(std::remove_if(m_queries.begin(), m_queries.end(),
+                                   [&deletedQueries](BlastQuery * query) {return deletedQueries.contains(query);}),
+                    m_queries.end());
+
+    QSetIterator<BlastQuery *> i(deletedQueries);
+    while (i.hasNext())
+        delete i.next();
 
     updateTempFiles();
 }
@@ -186,7 +186,7 @@ double BlastQueryPath::getRelativeLengthDiscrepancy() const
 
     int hitQueryLength = getHitQueryLength();
 
-    int discrepancy = m_path.getLength() - hitQueryLength;
+    long long discrepancy = m_path.getLength() - hitQueryLength;
     return double(discrepancy) / hitQueryLength;
 }
 
@@ -205,7 +205,7 @@ double BlastQueryPath::getRelativePathLength() const
 //short; more than 0 means it is too long.
 int BlastQueryPath::getAbsolutePathLengthDifference() const
 {
-    return m_path.getLength() - getHitQueryLength();
+    return int(m_path.getLength() - getHitQueryLength());
 }
 
 
@@ -27,6 +27,9 @@
 #include "../graph/debruijnnode.h"
 #include "../program/memory.h"
 #include <math.h>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
 
 BlastSearch::BlastSearch() :
     m_blastQueries(), m_tempDirectory("bandage_temp/")
@@ -60,6 +63,18 @@ void BlastSearch::buildHitsFromBlastOutput()
 {
     QStringList blastHitList = m_blastOutput.split("\n", Qt::SkipEmptyParts);
 
+    //Queries and nodes are looked up by name for every hit, so tables are
+    //made for them first.  A node usually has many hits, so each BLAST node
+    //label is only converted to a node once.
+    QHash<QString, BlastQuery *> queriesByName;
+    for (size_t i = 0; i < m_blastQueries.m_queries.size(); ++i)
+    {
+        BlastQuery * query = m_blastQueries.m_queries[i];
+        if (!queriesByName.contains(query->getName()))
+            queriesByName.insert(query->getName(), query);
+    }
+    QHash<QString, DeBruijnNode *> nodesByLabel;
+
     for (int i = 0; i < blastHitList.size(); ++i)
     {
         QString hitString = blastHitList[i];
@@ -85,14 +100,14 @@ void BlastSearch::buildHitsFromBlastOutput()
         if (nodeStart > nodeEnd)
             continue;
 
-        QString nodeName = getNodeNameFromString(nodeLabel);
-        DeBruijnNode * node;
-        if (g_assemblyGraph->m_deBruijnGraphNodes.contains(nodeName))
-            node = g_assemblyGraph->m_deBruijnGraphNodes[nodeName];
-        else
+        QHash<QString, DeBruijnNode *>::const_iterator foundNode = nodesByLabel.constFind(nodeLabel);
+        if (foundNode == nodesByLabel.constEnd())
+            foundNode = nodesByLabel.insert(nodeLabel, g_assemblyGraph->m_deBruijnGraphNodes.value(getNodeNameFromString(nodeLabel)));
+        DeBruijnNode * node = foundNode.value();
+        if (node == 0)
             continue;
 
-        BlastQuery * query = g_blastSearch->m_blastQueries.getQueryFromName(queryName);
+        BlastQuery * query = queriesByName.value(queryName);
         if (query == 0)
             continue;
 
@@ -221,17 +236,15 @@ bool BlastSearch::findProgram(QString programName, QString * command)
 
 void BlastSearch::clearSomeQueries(std::vector<BlastQuery *> queriesToRemove)
 {
-    //Remove any hits that are for queries that will be deleted.
-    QList< QSharedPointer<BlastHit> >::iterator i = m_allHits.begin();
-    while (i != m_allHits.end())
-    {
-        BlastQuery * hitQuery = (*i)->m_query;
-        bool hitIsForDeletedQuery = (std::find(queriesToRemove.begin(), queriesToRemove.end(), hitQuery) != queriesToRemove.end());
-        if (hitIsForDeletedQuery)
-            i = m_allHits.erase(i);
-        else
-            ++i;
-    }
+    //Remove any hits that are for queries that will be deleted.  This is done
+    //in one pass, as erasing the hits one at a time would move the rest of
+    //the list each time.
+    QSet<BlastQuery *> deletedQueries;
+    for (size_t i = 0; i < queriesToRemove.size(); ++i)
+        deletedQueries.insert(queriesToRemove[i]);
+    m_allHits.erase(std::remove_if(m_allHits.begin(), m_allHits.end(),
+                                   [&deletedQueries](const QSharedPointer<BlastHit> & hit) {return deletedQueries.contains(hit->m_query);}),
+                    m_allHits.end());
 
     //Now actually delete the queries.
     m_blastQueries.clearSomeQueries(queriesToRemove);
@@ -361,15 +374,12 @@ void BlastSearch::blastQueryChanged(QString queryName)
     }
 
     //Add the blast hit pointers to nodes that have a hit for
-    //the selected target(s).
+    //the selected target(s).  Each query holds its own hits, so only those
+    //need to be looked at.
     for (size_t i = 0; i < shownQueries.size(); ++i)
     {
-        BlastQuery * query = shownQueries[i];
-        for (int j = 0; j < g_blastSearch->m_allHits.size(); ++j)
-        {
-            BlastHit * hit = g_blastSearch->m_allHits[j].data();
-            if (hit->m_query == query)
-                hit->m_node->addBlastHit(hit);
-        }
+        QList< QSharedPointer<BlastHit> > queryHits = shownQueries[i]->getHits();
+        for (int j = 0; j < queryHits.size(); ++j)
+            queryHits[j]->m_node->addBlastHit(queryHits[j].data());
     }
 }
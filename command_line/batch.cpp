@@ -0,0 +1,650 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "batch.h"
+#include "commoncommandlinefunctions.h"
+#include "info.h"
+#include "image.h"
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../graph/assemblygraph.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace
+{
+
+//This class runs the jobs from a manifest.  The graphs are loaded and
+//processed by a pool of worker threads, each graph with its own copy of the
+//settings.  A job is only started when its estimated memory fits in what is
+//left of the memory limit, or when nothing else is running (so a graph larger
+//than the limit is still processed, on its own).  Images are drawn in the
+//thread which calls run, because graphics items and painting with fonts
+//belong in the main thread.
+class BatchRunner
+{
+public:
+    BatchRunner(std::vector<BatchJob> * jobs, int threadCount, long long memoryLimit,
+                int imageWidth, int imageHeight);
+    void run();
+
+private:
+    struct ImageRequest
+    {
+        BatchJob * job;
+        QSharedPointer<AssemblyGraph> assemblyGraph;
+        bool drawn;
+    };
+
+    std::vector<BatchJob> * m_jobs;
+    int m_threadCount;
+    long long m_memoryLimit;
+    int m_imageWidth;
+    int m_imageHeight;
+    QElapsedTimer m_batchTimer;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    size_t m_nextJob;
+    size_t m_finishedJobs;
+    int m_runningJobs;
+    long long m_runningMemory;
+    std::deque<ImageRequest *> m_imageRequests;
+
+    bool canStartNextJob() const;
+    void runWorker();
+    void runJob(BatchJob * job);
+    void drawImages(ImageRequest * request);
+};
+
+
+double getMilliseconds(const QElapsedTimer & timer)
+{
+    return timer.nsecsElapsed() / 1000000.0;
+}
+
+
+BatchRunner::BatchRunner(std::vector<BatchJob> * jobs, int threadCount, long long memoryLimit,
+                         int imageWidth, int imageHeight) :
+    m_jobs(jobs), m_threadCount(threadCount), m_memoryLimit(memoryLimit),
+    m_imageWidth(imageWidth), m_imageHeight(imageHeight),
+    m_nextJob(0), m_finishedJobs(0), m_runningJobs(0), m_runningMemory(0)
+{
+}
+
+
+void BatchRunner::run()
+{
+    m_batchTimer.start();
+
+    int threadCount = std::max(1, std::min(m_threadCount, int(m_jobs->size())));
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threadCount; ++i)
+        workers.push_back(std::thread(&BatchRunner::runWorker, this));
+
+    //This thread draws the images the workers ask for until all of the jobs
+    //are finished.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this] {return !m_imageRequests.empty() || m_finishedJobs == m_jobs->size();});
+        if (m_imageRequests.empty())
+            break;
+
+        ImageRequest * request = m_imageRequests.front();
+        m_imageRequests.pop_front();
+        lock.unlock();
+        drawImages(request);
+        lock.lock();
+        request->drawn = true;
+        m_condition.notify_all();
+    }
+    lock.unlock();
+
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+}
+
+
+//Jobs are started in manifest order, so a large graph waiting for memory
+//isn't passed over indefinitely by smaller ones.
+bool BatchRunner::canStartNextJob() const
+{
+    if (m_runningJobs == 0 || m_memoryLimit <= 0)
+        return true;
+    return m_runningMemory + (*m_jobs)[m_nextJob].estimatedMemory <= m_memoryLimit;
+}
+
+
+void BatchRunner::runWorker()
+{
+    while (true)
+    {
+        BatchJob * job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] {return m_nextJob >= m_jobs->size() || canStartNextJob();});
+            if (m_nextJob >= m_jobs->size())
+                return;
+            job = &(*m_jobs)[m_nextJob];
+            ++m_nextJob;
+            ++m_runningJobs;
+            m_runningMemory += job->estimatedMemory;
+        }
+
+        runJob(job);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_runningJobs;
+            m_runningMemory -= job->estimatedMemory;
+            ++m_finishedJobs;
+        }
+        m_condition.notify_all();
+    }
+}
+
+
+void BatchRunner::runJob(BatchJob * job)
+{
+    QElapsedTimer jobTimer;
+    jobTimer.start();
+    job->waitMilliseconds = getMilliseconds(m_batchTimer);
+
+    QSharedPointer<AssemblyGraph> assemblyGraph(new AssemblyGraph(QSharedPointer<Settings>(new Settings(*g_settings))));
+    Settings * settings = assemblyGraph->m_settings.data();
+
+    QElapsedTimer stepTimer;
+    stepTimer.start();
+    bool loadSuccess = checkIfFileExists(job->graphFilename) &&
+            assemblyGraph->loadGraphFromFile(job->graphFilename);
+    job->loadMilliseconds = getMilliseconds(stepTimer);
+    if (!loadSuccess)
+        job->error = "could not load " + job->graphFilename;
+
+    bool scopeNeeded = false;
+    bool imageNeeded = false;
+    for (size_t i = 0; i < job->operations.size(); ++i)
+    {
+        if (job->operations[i].type != BATCH_INFO)
+            scopeNeeded = true;
+        if (job->operations[i].type == BATCH_IMAGE)
+            imageNeeded = true;
+    }
+
+    //The reduce and image operations both use the graph scope settings, so the
+    //OGDF graph is built once for both of them.
+    if (job->error.isEmpty() && scopeNeeded)
+    {
+        QString errorTitle;
+        QString errorMessage;
+        std::vector<DeBruijnNode *> startingNodes = assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
+                                                                                    settings->doubleMode,
+                                                                                    settings->startingNodes,
+                                                                                    "all");
+        if (errorMessage != "")
+            job->error = errorMessage;
+        else
+            assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, settings->nodeDistance);
+    }
+
+    if (job->error.isEmpty())
+    {
+        for (size_t i = 0; i < job->operations.size(); ++i)
+        {
+            BatchOperation & operation = job->operations[i];
+            stepTimer.restart();
+            if (operation.type == BATCH_INFO)
+            {
+                job->infoValues = getInfoValues(assemblyGraph.data());
+                operation.success = true;
+                if (!operation.output.isEmpty())
+                {
+                    QFile file(operation.output);
+                    operation.success = file.open(QIODevice::WriteOnly | QIODevice::Text);
+                    if (operation.success)
+                    {
+                        QTextStream out(&file);
+                        out << job->graphFilename << "\t" << job->infoValues.join("\t") << "\n";
+                    }
+                }
+            }
+            else if (operation.type == BATCH_REDUCE)
+                operation.success = assemblyGraph->saveVisibleGraphToGfa(operation.output);
+            else
+                continue;
+            operation.milliseconds = getMilliseconds(stepTimer);
+        }
+
+        if (imageNeeded)
+        {
+            stepTimer.restart();
+            assemblyGraph->layoutGraph();
+            job->layoutMilliseconds = getMilliseconds(stepTimer);
+
+            ImageRequest request = {job, assemblyGraph, false};
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_imageRequests.push_back(&request);
+            m_condition.notify_all();
+            m_condition.wait(lock, [&request] {return request.drawn;});
+        }
+    }
+
+    job->success = job->error.isEmpty();
+    for (size_t i = 0; i < job->operations.size() && job->success; ++i)
+    {
+        if (!job->operations[i].success)
+        {
+            job->success = false;
+            job->error = "could not save " + job->operations[i].output;
+        }
+    }
+
+    assemblyGraph->cleanUp();
+    job->totalMilliseconds = getMilliseconds(jobTimer);
+}
+
+
+void BatchRunner::drawImages(ImageRequest * request)
+{
+    BatchJob * job = request->job;
+    for (size_t i = 0; i < job->operations.size(); ++i)
+    {
+        BatchOperation & operation = job->operations[i];
+        if (operation.type != BATCH_IMAGE)
+            continue;
+
+        QElapsedTimer timer;
+        timer.start();
+        bool pixelImage = !operation.output.endsWith(".svg");
+        operation.success = saveGraphImage(request->assemblyGraph.data(), operation.output, pixelImage,
+                                           m_imageWidth, m_imageHeight);
+        operation.milliseconds = getMilliseconds(timer);
+    }
+}
+
+
+QString getOperationName(BatchOperationType type)
+{
+    if (type == BATCH_INFO)
+        return "info";
+    if (type == BATCH_REDUCE)
+        return "reduce";
+    return "image";
+}
+
+
+QJsonObject getJobSummary(const BatchJob & job)
+{
+    QJsonObject summary;
+    summary["graph"] = job.graphFilename;
+    summary["success"] = job.success;
+    if (!job.error.isEmpty())
+        summary["error"] = job.error;
+    summary["estimated_memory_mb"] = job.estimatedMemory / 1048576.0;
+    summary["wait_ms"] = job.waitMilliseconds;
+    summary["load_ms"] = job.loadMilliseconds;
+    summary["layout_ms"] = job.layoutMilliseconds;
+    summary["total_ms"] = job.totalMilliseconds;
+
+    QJsonArray operations;
+    for (size_t i = 0; i < job.operations.size(); ++i)
+    {
+        const BatchOperation & operation = job.operations[i];
+        QJsonObject operationSummary;
+        operationSummary["operation"] = getOperationName(operation.type);
+        if (!operation.output.isEmpty())
+            operationSummary["output"] = operation.output;
+        operationSummary["success"] = operation.success;
+        operationSummary["ms"] = operation.milliseconds;
+        operations.append(operationSummary);
+    }
+    summary["operations"] = operations;
+
+    if (!job.infoValues.isEmpty())
+    {
+        QStringList labels = getInfoLabels();
+        QJsonObject info;
+        for (int i = 0; i < labels.size() && i < job.infoValues.size(); ++i)
+            info[labels[i]] = job.infoValues[i];
+        summary["info"] = info;
+    }
+
+    return summary;
+}
+
+}
+
+
+
+int bandageBatch(QStringList arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (checkForHelp(arguments))
+    {
+        printBatchUsage(&out, false);
+        return 0;
+    }
+
+    if (checkForHelpAll(arguments))
+    {
+        printBatchUsage(&out, true);
+        return 0;
+    }
+
+    if (arguments.size() < 1)
+    {
+        printBatchUsage(&err, false);
+        return 1;
+    }
+
+    QString manifestFilename = arguments.at(0);
+    arguments.pop_front();
+
+    if (!checkIfFileExists(manifestFilename))
+    {
+        outputText("Bandage error: " + manifestFilename + " does not exist", &err);
+        return 1;
+    }
+
+    QString error = checkForInvalidBatchOptions(arguments);
+    if (error.length() > 0)
+    {
+        outputText("Bandage error: " + error, &err);
+        return 1;
+    }
+
+    //These are the same image defaults used by Bandage image.
+    g_settings->outlineThickness = 0.3;
+
+    int threads = QThread::idealThreadCount();
+    int memoryLimit = 0;
+    QString summaryFilename;
+    int width = 0;
+    int height = 0;
+    parseBatchOptions(arguments, &threads, &memoryLimit, &summaryFilename, &width, &height);
+
+    g_settings->positionTextNodeCentre = true;
+    g_absoluteZoom = 10.0;
+
+    std::vector<BatchJob> jobs;
+    if (!parseBatchManifest(manifestFilename, &jobs, &error))
+    {
+        outputText("Bandage error: " + error, &err);
+        return 1;
+    }
+
+    QElapsedTimer batchTimer;
+    batchTimer.start();
+    BatchRunner runner(&jobs, threads, memoryLimit * 1048576LL, width, height);
+    runner.run();
+
+    QJsonArray graphs;
+    int failedCount = 0;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        graphs.append(getJobSummary(jobs[i]));
+        if (!jobs[i].success)
+            ++failedCount;
+    }
+
+    QJsonObject summary;
+    summary["manifest"] = manifestFilename;
+    summary["threads"] = threads;
+    summary["memory_limit_mb"] = memoryLimit;
+    summary["graph_count"] = int(jobs.size());
+    summary["failed_count"] = failedCount;
+    summary["total_ms"] = getMilliseconds(batchTimer);
+    summary["graphs"] = graphs;
+    QByteArray summaryJson = QJsonDocument(summary).toJson(QJsonDocument::Indented);
+
+    if (summaryFilename.isEmpty())
+        out << summaryJson;
+    else
+    {
+        QFile summaryFile(summaryFilename);
+        if (!summaryFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            outputText("Bandage error: could not write " + summaryFilename, &err);
+            return 1;
+        }
+        summaryFile.write(summaryJson);
+    }
+
+    if (failedCount > 0)
+    {
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            if (!jobs[i].success)
+                err << "Bandage error: " << jobs[i].graphFilename << ": " << jobs[i].error << Qt::endl;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+void printBatchUsage(QTextStream * out, bool all)
+{
+    QStringList text;
+
+    text << "Bandage batch runs info, reduce and image operations on many graphs in one process. Each graph is loaded once, all of its operations are run, and graphs are processed in parallel.";
+    text << "";
+    text << "The manifest is a tab-delimited file with one graph per line: the graph file followed by one or more operations. An operation is 'info', 'info=<file>', 'reduce=<file>' or 'image=<file>'. Info results are included in the summary and, if a file is given, saved there in the same format as Bandage info --tsv. Reduce saves a GFA file and image saves a '.jpg', '.png' or '.svg' file. Relative paths are relative to the manifest's directory. Empty lines and lines starting with '#' are ignored.";
+    text << "";
+    text << "A summary of the results, with timings for each graph, is output in JSON format.";
+    text << "";
+    text << "Usage:    Bandage batch <manifest> [options]";
+    text << "";
+    text << "Positional parameters:";
+    text << "<manifest>          A tab-delimited file of graphs and operations";
+    text << "";
+    text << "Options:  --threads <int>     Number of graphs processed at once " + getRangeAndDefault(1, 1024, QThread::idealThreadCount());
+    text << "--memory <int>      Estimated memory (in MB) that graphs being processed at once may use, 0 for no limit " + getRangeAndDefault(0, 16777216, 0);
+    text << "--summary <file>    Save the JSON summary to this file instead of stdout";
+    text << "--height <int>      Image height (default: 1000)";
+    text << "--width <int>       Image width (default: not set)";
+    text << "";
+
+    getCommonHelp(&text);
+    if (all)
+        getSettingsUsage(&text);
+    else
+    {
+        int nextLineIndex = text.size();
+        getGraphScopeOptions(&text);
+        text[nextLineIndex] = "Settings: " + text[nextLineIndex];
+    }
+    text << "";
+    getOnlineHelpMessage(&text);
+
+    outputText(text, out);
+}
+
+
+
+QString checkForInvalidBatchOptions(QStringList arguments)
+{
+    if (isOptionPresent("--query", &arguments))
+        return "Bandage batch does not support BLAST queries";
+
+    QString error = checkOptionForInt("--threads", &arguments, IntSetting(1, 1, 1024), false);
+    if (error.length() > 0) return error;
+
+    error = checkOptionForInt("--memory", &arguments, IntSetting(0, 0, 16777216), false);
+    if (error.length() > 0) return error;
+
+    error = checkOptionForString("--summary", &arguments, QStringList(), "a file path");
+    if (error.length() > 0) return error;
+
+    error = checkOptionForInt("--height", &arguments, IntSetting(0, 1, 32767), false);
+    if (error.length() > 0) return error;
+
+    error = checkOptionForInt("--width", &arguments, IntSetting(0, 1, 32767), false);
+    if (error.length() > 0) return error;
+
+    return checkForInvalidOrExcessSettings(&arguments);
+}
+
+
+
+//This function parses the command line options.  It assumes that the options
+//have already been checked for correctness.
+void parseBatchOptions(QStringList arguments, int * threads, int * memoryLimit,
+                       QString * summaryFilename, int * width, int * height)
+{
+    if (isOptionPresent("--threads", &arguments))
+        *threads = getIntOption("--threads", &arguments);
+
+    if (isOptionPresent("--memory", &arguments))
+        *memoryLimit = getIntOption("--memory", &arguments);
+
+    if (isOptionPresent("--summary", &arguments))
+        *summaryFilename = getStringOption("--summary", &arguments);
+
+    if (isOptionPresent("--height", &arguments))
+        *height = getIntOption("--height", &arguments);
+
+    if (isOptionPresent("--width", &arguments))
+        *width = getIntOption("--width", &arguments);
+
+    parseSettings(arguments);
+}
+
+
+
+//This function reads a manifest into jobs.  If there is a problem with the
+//manifest, it returns false and sets the error.
+bool parseBatchManifest(QString manifestFilename, std::vector<BatchJob> * jobs, QString * error)
+{
+    QFile manifestFile(manifestFilename);
+    if (!manifestFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        *error = "could not open " + manifestFilename;
+        return false;
+    }
+    QDir manifestDir = QFileInfo(manifestFilename).absoluteDir();
+
+    QTextStream in(&manifestFile);
+    int lineNumber = 0;
+    while (!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith("#"))
+            continue;
+
+        QString lineDescription = manifestFilename + " line " + QString::number(lineNumber);
+        QStringList parts = line.split('\t', Qt::SkipEmptyParts);
+        if (parts.size() < 2)
+        {
+            *error = lineDescription + " needs a graph and at least one operation";
+            return false;
+        }
+
+        BatchJob job;
+        job.graphFilename = QDir::cleanPath(manifestDir.filePath(parts[0].trimmed()));
+        job.estimatedMemory = estimateGraphMemory(job.graphFilename);
+        job.success = false;
+        job.waitMilliseconds = 0.0;
+        job.loadMilliseconds = 0.0;
+        job.layoutMilliseconds = 0.0;
+        job.totalMilliseconds = 0.0;
+
+        for (int i = 1; i < parts.size(); ++i)
+        {
+            QString operationText = parts[i].trimmed();
+            int equalsIndex = operationText.indexOf('=');
+            QString name = operationText.left(equalsIndex).toLower();
+            QString output;
+            if (equalsIndex > -1)
+                output = operationText.mid(equalsIndex + 1).trimmed();
+
+            BatchOperation operation;
+            operation.success = false;
+            operation.milliseconds = 0.0;
+            if (name == "info")
+                operation.type = BATCH_INFO;
+            else if (name == "reduce")
+            {
+                operation.type = BATCH_REDUCE;
+                if (!output.isEmpty() && !output.endsWith(".gfa"))
+                    output += ".gfa";
+            }
+            else if (name == "image")
+            {
+                operation.type = BATCH_IMAGE;
+                if (!output.isEmpty() && !output.endsWith(".png") && !output.endsWith(".jpg") &&
+                        !output.endsWith(".svg"))
+                {
+                    *error = lineDescription + ": image filenames must end in .png, .jpg or .svg";
+                    return false;
+                }
+            }
+            else
+            {
+                *error = lineDescription + ": " + operationText + " is not a valid operation";
+                return false;
+            }
+
+            if (operation.type != BATCH_INFO && output.isEmpty())
+            {
+                *error = lineDescription + ": " + name + " needs an output file (e.g. " + name + "=<file>)";
+                return false;
+            }
+            if (!output.isEmpty())
+                output = QDir::cleanPath(manifestDir.filePath(output));
+            operation.output = output;
+            job.operations.push_back(operation);
+        }
+
+        jobs->push_back(job);
+    }
+
+    if (jobs->empty())
+    {
+        *error = manifestFilename + " does not contain any graphs";
+        return false;
+    }
+    return true;
+}
+
+
+
+//This is a rough estimate of the memory used to load and process a graph,
+//based on the size of its file.  Sequences are stored for both strands and
+//the nodes, edges and layout add to that, so it is a few times the file size.
+long long estimateGraphMemory(QString graphFilename)
+{
+    return 4 * QFileInfo(graphFilename).size() + 1048576;
+}
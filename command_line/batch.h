@@ -0,0 +1,62 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <QStringList>
+#include <QString>
+#include <QTextStream>
+#include <vector>
+
+enum BatchOperationType {BATCH_INFO, BATCH_REDUCE, BATCH_IMAGE};
+
+struct BatchOperation
+{
+    BatchOperationType type;
+    QString output;
+    bool success;
+    double milliseconds;
+};
+
+//One line of the manifest: a graph and the operations to run on it.  The rest
+//of the values are filled in as the graph is processed.
+struct BatchJob
+{
+    QString graphFilename;
+    std::vector<BatchOperation> operations;
+    long long estimatedMemory;
+
+    bool success;
+    QString error;
+    QStringList infoValues;
+    double waitMilliseconds;
+    double loadMilliseconds;
+    double layoutMilliseconds;
+    double totalMilliseconds;
+};
+
+int bandageBatch(QStringList arguments);
+void printBatchUsage(QTextStream * out, bool all);
+QString checkForInvalidBatchOptions(QStringList arguments);
+void parseBatchOptions(QStringList arguments, int * threads, int * memoryLimit,
+                       QString * summaryFilename, int * width, int * height);
+bool parseBatchManifest(QString manifestFilename, std::vector<BatchJob> * jobs, QString * error);
+long long estimateGraphMemory(QString graphFilename);
+
+#endif // BATCH_H
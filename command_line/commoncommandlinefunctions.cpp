@@ -68,6 +68,7 @@ void getSettingsUsage(QStringList * text)
     *text << "--nodseglen <float> Node segment length " + getRangeAndDefault(g_settings->nodeSegmentLength);
     *text << "--iter <int>        Graph layout iterations " + getRangeAndDefault(g_settings->graphLayoutQuality);
     *text << "--linear            Linear graph layout (default: off)" ;
+    *text << "--coarse            Coarse-then-refine graph layout (default: off)";
     *text << "";
     *text << "Graph appearance";
     *text << dashes;
@@ -248,6 +249,7 @@ QString checkForInvalidOrExcessSettings(QStringList * arguments)
     error = checkOptionForFloat("--doubsep", arguments, g_settings->doubleModeNodeSeparation, false); if (error.length() > 0) return error;
     error = checkOptionForInt("--iter", arguments, g_settings->graphLayoutQuality, false); if (error.length() > 0) return error;
     checkOptionWithoutValue("--linear", arguments);
+    checkOptionWithoutValue("--coarse", arguments);
     error = checkOptionForFloat("--nodseglen", arguments, g_settings->nodeSegmentLength, false); if (error.length() > 0) return error;
     error = checkOptionForFloat("--nodewidth", arguments, g_settings->averageNodeWidth, false); if (error.length() > 0) return error;
     error = checkOptionForFloat("--depwidth", arguments, g_settings->depthEffectOnWidth, false); if (error.length() > 0) return error;
@@ -395,36 +397,44 @@ QString checkForInvalidOrExcessSettings(QStringList * arguments)
 
 
 void parseSettings(QStringList arguments)
+{
+    parseSettings(arguments, g_settings.data());
+}
+
+
+//This version applies the options to the given settings object, so a graph
+//loader can fill in its own graph's settings without touching g_settings.
+void parseSettings(QStringList arguments, Settings * settings)
 {
     if (isOptionPresent("--scope", &arguments))
-        g_settings->graphScope = getGraphScopeOption("--scope", &arguments);
+        settings->graphScope = getGraphScopeOption("--scope", &arguments);
 
     if (isOptionPresent("--distance", &arguments))
-        g_settings->nodeDistance = getIntOption("--distance", &arguments);
+        settings->nodeDistance = getIntOption("--distance", &arguments);
 
     if (isOptionPresent("--mindepth", &arguments))
-        g_settings->minDepthRange = getFloatOption("--mindepth", &arguments);
+        settings->minDepthRange = getFloatOption("--mindepth", &arguments);
     if (isOptionPresent("--maxdepth", &arguments))
-        g_settings->maxDepthRange = getFloatOption("--maxdepth", &arguments);
+        settings->maxDepthRange = getFloatOption("--maxdepth", &arguments);
 
     if (isOptionPresent("--nodes", &arguments))
-        g_settings->startingNodes = getStringOption("--nodes", &arguments);
-    g_settings->startingNodesExactMatch = !isOptionPresent("--partial", &arguments);
+        settings->startingNodes = getStringOption("--nodes", &arguments);
+    settings->startingNodesExactMatch = !isOptionPresent("--partial", &arguments);
 
     if (isOptionPresent("--query", &arguments))
-        g_settings->blastQueryFilename = getStringOption("--query", &arguments);
+        settings->blastQueryFilename = getStringOption("--query", &arguments);
     if (isOptionPresent("--blastp", &arguments))
-        g_settings->blastSearchParameters = getStringOption("--blastp", &arguments);
+        settings->blastSearchParameters = getStringOption("--blastp", &arguments);
 
-    g_settings->doubleMode = isOptionPresent("--double", &arguments);
+    settings->doubleMode = isOptionPresent("--double", &arguments);
 
     if (isOptionPresent("--nodelen", &arguments))
     {
-        g_settings->manualNodeLengthPerMegabase = getIntOption("--nodelen", &arguments);
-        g_settings->nodeLengthMode = MANUAL_NODE_LENGTH;
+        settings->manualNodeLengthPerMegabase = getIntOption("--nodelen", &arguments);
+        settings->nodeLengthMode = MANUAL_NODE_LENGTH;
     }
     if (isOptionPresent("--edgelen", &arguments))
-        g_settings->edgeLength = getFloatOption("--edgelen", &arguments);
+        settings->edgeLength = getFloatOption("--edgelen", &arguments);
 
     if (isOptionPresent("--iter", &arguments))
     {
@@ -433,207 +443,208 @@ void parseSettings(QStringList arguments)
             quality = 0;
         if (quality > 4)
             quality = 4;
-        g_settings->graphLayoutQuality = quality;
+        settings->graphLayoutQuality = quality;
     }
-    g_settings->linearLayout = isOptionPresent("--linear", &arguments);
+    settings->linearLayout = isOptionPresent("--linear", &arguments);
+    settings->coarseLayout = isOptionPresent("--coarse", &arguments);
 
     if (isOptionPresent("--nodseglen", &arguments))
-        g_settings->nodeSegmentLength = getFloatOption("--nodseglen", &arguments);
+        settings->nodeSegmentLength = getFloatOption("--nodseglen", &arguments);
     if (isOptionPresent("--nodewidth", &arguments))
-        g_settings->averageNodeWidth = getFloatOption("--nodewidth", &arguments);
+        settings->averageNodeWidth = getFloatOption("--nodewidth", &arguments);
     if (isOptionPresent("--depwidth", &arguments))
-        g_settings->depthEffectOnWidth = getFloatOption("--depwidth", &arguments);
+        settings->depthEffectOnWidth = getFloatOption("--depwidth", &arguments);
     if (isOptionPresent("--deppower", &arguments))
-        g_settings->depthPower = getFloatOption("--deppower", &arguments);
+        settings->depthPower = getFloatOption("--deppower", &arguments);
 
     if (isOptionPresent("--edgewidth", &arguments))
-        g_settings->edgeWidth = getFloatOption("--edgewidth", &arguments);
+        settings->edgeWidth = getFloatOption("--edgewidth", &arguments);
     if (isOptionPresent("--outline", &arguments))
-        g_settings->outlineThickness = getFloatOption("--outline", &arguments);
-    g_settings->antialiasing = !isOptionPresent("--noaa", &arguments);
-    g_settings->arrowheadsInSingleMode = isOptionPresent("--singlearr", &arguments);
+        settings->outlineThickness = getFloatOption("--outline", &arguments);
+    settings->antialiasing = !isOptionPresent("--noaa", &arguments);
+    settings->arrowheadsInSingleMode = isOptionPresent("--singlearr", &arguments);
 
 
     if (isOptionPresent("--edgecol", &arguments))
-        g_settings->edgeColour = getColourOption("--edgecol", &arguments);
+        settings->edgeColour = getColourOption("--edgecol", &arguments);
     if (isOptionPresent("--outcol", &arguments))
-        g_settings->outlineColour = getColourOption("--outcol", &arguments);
+        settings->outlineColour = getColourOption("--outcol", &arguments);
     if (isOptionPresent("--selcol", &arguments))
-        g_settings->selectionColour = getColourOption("--selcol", &arguments);
+        settings->selectionColour = getColourOption("--selcol", &arguments);
     if (isOptionPresent("--textcol", &arguments))
-        g_settings->textColour = getColourOption("--textcol", &arguments);
+        settings->textColour = getColourOption("--textcol", &arguments);
     if (isOptionPresent("--toutcol", &arguments))
-        g_settings->textOutlineColour = getColourOption("--toutcol", &arguments);
-    g_settings->positionTextNodeCentre = isOptionPresent("--centre", &arguments);
+        settings->textOutlineColour = getColourOption("--toutcol", &arguments);
+    settings->positionTextNodeCentre = isOptionPresent("--centre", &arguments);
 
-    g_settings->displayNodeNames = isOptionPresent("--names", &arguments);
-    g_settings->displayNodeLengths = isOptionPresent("--lengths", &arguments);
-    g_settings->displayNodeDepth = isOptionPresent("--depth", &arguments);
-    g_settings->displayBlastHits = isOptionPresent("--blasthits", &arguments);
+    settings->displayNodeNames = isOptionPresent("--names", &arguments);
+    settings->displayNodeLengths = isOptionPresent("--lengths", &arguments);
+    settings->displayNodeDepth = isOptionPresent("--depth", &arguments);
+    settings->displayBlastHits = isOptionPresent("--blasthits", &arguments);
 
     if (isOptionPresent("--fontsize", &arguments))
     {
         int fontsize = getIntOption("--fontsize", &arguments);
-        QFont font = g_settings->labelFont;
+        QFont font = settings->labelFont;
         font.setPointSize(fontsize);
-        g_settings->labelFont = font;
+        settings->labelFont = font;
     }
 
     if (isOptionPresent("--toutline", &arguments))
     {
         double textOutlineThickness = getFloatOption("--toutline", &arguments);
         if (textOutlineThickness == 0.0)
-            g_settings->textOutline = false;
+            settings->textOutline = false;
         else
         {
-            g_settings->textOutline = true;
-            g_settings->textOutlineThickness = textOutlineThickness;
+            settings->textOutline = true;
+            settings->textOutlineThickness = textOutlineThickness;
         }
     }
 
-    g_settings->nodeColourScheme = getColourSchemeOption("--colour", &arguments);
+    settings->nodeColourScheme = getColourSchemeOption("--colour", &arguments);
 
     if (isOptionPresent("--ransatpos", &arguments))
-        g_settings->randomColourPositiveSaturation = getIntOption("--ransatpos", &arguments);
+        settings->randomColourPositiveSaturation = getIntOption("--ransatpos", &arguments);
     if (isOptionPresent("--ransatneg", &arguments))
-        g_settings->randomColourNegativeSaturation = getIntOption("--ransatneg", &arguments);
+        settings->randomColourNegativeSaturation = getIntOption("--ransatneg", &arguments);
     if (isOptionPresent("--ranligpos", &arguments))
-        g_settings->randomColourPositiveLightness = getIntOption("--ranligpos", &arguments);
+        settings->randomColourPositiveLightness = getIntOption("--ranligpos", &arguments);
     if (isOptionPresent("--ranligneg", &arguments))
-        g_settings->randomColourNegativeLightness = getIntOption("--ranligneg", &arguments);
+        settings->randomColourNegativeLightness = getIntOption("--ranligneg", &arguments);
     if (isOptionPresent("--ranopapos", &arguments))
-        g_settings->randomColourPositiveOpacity = getIntOption("--ranopapos", &arguments);
+        settings->randomColourPositiveOpacity = getIntOption("--ranopapos", &arguments);
     if (isOptionPresent("--ranopaneg", &arguments))
-        g_settings->randomColourNegativeOpacity = getIntOption("--ranopaneg", &arguments);
+        settings->randomColourNegativeOpacity = getIntOption("--ranopaneg", &arguments);
 
     if (isOptionPresent("--unicolpos", &arguments))
-        g_settings->uniformPositiveNodeColour = getColourOption("--unicolpos", &arguments);
+        settings->uniformPositiveNodeColour = getColourOption("--unicolpos", &arguments);
     if (isOptionPresent("--unicolneg", &arguments))
-        g_settings->uniformNegativeNodeColour = getColourOption("--unicolneg", &arguments);
+        settings->uniformNegativeNodeColour = getColourOption("--unicolneg", &arguments);
     if (isOptionPresent("--unicolspe", &arguments))
-        g_settings->uniformNodeSpecialColour = getColourOption("--unicolspe", &arguments);
+        settings->uniformNodeSpecialColour = getColourOption("--unicolspe", &arguments);
 
     if (isOptionPresent("--depcollow", &arguments))
-        g_settings->lowDepthColour = getColourOption("--depcollow", &arguments);
+        settings->lowDepthColour = getColourOption("--depcollow", &arguments);
     if (isOptionPresent("--depcolhi", &arguments))
-        g_settings->highDepthColour = getColourOption("--depcolhi", &arguments);
+        settings->highDepthColour = getColourOption("--depcolhi", &arguments);
     if (isOptionPresent("--depvallow", &arguments))
     {
-        g_settings->lowDepthValue = getFloatOption("--depvallow", &arguments);
-        g_settings->autoDepthValue = false;
+        settings->lowDepthValue = getFloatOption("--depvallow", &arguments);
+        settings->autoDepthValue = false;
     }
     if (isOptionPresent("--depvalhi", &arguments))
     {
-        g_settings->highDepthValue = getFloatOption("--depvalhi", &arguments);
-        g_settings->autoDepthValue = false;
+        settings->highDepthValue = getFloatOption("--depvalhi", &arguments);
+        settings->autoDepthValue = false;
     }
 
     if (isOptionPresent("--pathnodes", &arguments))
-        g_settings->maxQueryPathNodes = getIntOption("--pathnodes", &arguments);
+        settings->maxQueryPathNodes = getIntOption("--pathnodes", &arguments);
     if (isOptionPresent("--minpatcov", &arguments))
-        g_settings->minQueryCoveredByPath = getFloatOption("--minpatcov", &arguments);
+        settings->minQueryCoveredByPath = getFloatOption("--minpatcov", &arguments);
     if (isOptionPresent("--minhitcov", &arguments))
     {
         QString optionString = getStringOption("--minhitcov", &arguments);
         if (optionString.toLower() == "off")
-            g_settings->minQueryCoveredByHits.on = false;
+            settings->minQueryCoveredByHits.on = false;
         else
         {
-            g_settings->minQueryCoveredByHits.on = true;
-            g_settings->minQueryCoveredByHits = getFloatOption("--minhitcov", &arguments);
+            settings->minQueryCoveredByHits.on = true;
+            settings->minQueryCoveredByHits = getFloatOption("--minhitcov", &arguments);
         }
     }
     if (isOptionPresent("--minmeanid", &arguments))
     {
         QString optionString = getStringOption("--minmeanid", &arguments);
         if (optionString.toLower() == "off")
-            g_settings->minMeanHitIdentity.on = false;
+            settings->minMeanHitIdentity.on = false;
         else
         {
-            g_settings->minMeanHitIdentity.on = true;
-            g_settings->minMeanHitIdentity = getFloatOption("--minmeanid", &arguments);
+            settings->minMeanHitIdentity.on = true;
+            settings->minMeanHitIdentity = getFloatOption("--minmeanid", &arguments);
         }
     }
     if (isOptionPresent("--maxevprod", &arguments))
     {
         QString optionString = getStringOption("--maxevprod", &arguments);
         if (optionString.toLower() == "off")
-            g_settings->maxEValueProduct.on = false;
+            settings->maxEValueProduct.on = false;
         else
         {
-            g_settings->maxEValueProduct.on = true;
-            g_settings->maxEValueProduct = getSciNotOption("--maxevprod", &arguments);
+            settings->maxEValueProduct.on = true;
+            settings->maxEValueProduct = getSciNotOption("--maxevprod", &arguments);
         }
     }
     if (isOptionPresent("--minpatlen", &arguments))
     {
         QString optionString = getStringOption("--minpatlen", &arguments);
         if (optionString.toLower() == "off")
-            g_settings->minLengthPercentage.on = false;
+            settings->minLengthPercentage.on = false;
         else
         {
-            g_settings->minLengthPercentage.on = true;
-            g_settings->minLengthPercentage = getFloatOption("--minpatlen", &arguments);
+            settings->minLengthPercentage.on = true;
+            settings->minLengthPercentage = getFloatOption("--minpatlen", &arguments);
         }
     }
     if (isOptionPresent("--maxpatlen", &arguments))
     {
         QString optionString = getStringOption("--maxpatlen", &arguments);
         if (optionString.toLower() == "off")
-            g_settings->maxLengthPercentage.on = false;
+            settings->maxLengthPercentage.on = false;
         else
         {
-            g_settings->maxLengthPercentage.on = true;
-            g_settings->maxLengthPercentage = getFloatOption("--maxpatlen", &arguments);
+            settings->maxLengthPercentage.on = true;
+            settings->maxLengthPercentage = getFloatOption("--maxpatlen", &arguments);
         }
     }
     if (isOptionPresent("--minlendis", &arguments))
     {
         QString optionString = getStringOption("--minlendis", &arguments);
         if (optionString.toLower() == "off")
-            g_settings->minLengthBaseDiscrepancy.on = false;
+            settings->minLengthBaseDiscrepancy.on = false;
         else
         {
-            g_settings->minLengthBaseDiscrepancy.on = true;
-            g_settings->minLengthBaseDiscrepancy = getIntOption("--minlendis", &arguments);
+            settings->minLengthBaseDiscrepancy.on = true;
+            settings->minLengthBaseDiscrepancy = getIntOption("--minlendis", &arguments);
         }
     }
     if (isOptionPresent("--maxlendis", &arguments))
     {
         QString optionString = getStringOption("--maxlendis", &arguments);
         if (optionString.toLower() == "off")
-            g_settings->maxLengthBaseDiscrepancy.on = false;
+            settings->maxLengthBaseDiscrepancy.on = false;
         else
         {
-            g_settings->maxLengthBaseDiscrepancy.on = true;
-            g_settings->maxLengthBaseDiscrepancy = getIntOption("--maxlendis", &arguments);
+            settings->maxLengthBaseDiscrepancy.on = true;
+            settings->maxLengthBaseDiscrepancy = getIntOption("--maxlendis", &arguments);
         }
     }
 
     if (isOptionPresent("--alfilter", &arguments))
     {
-        g_settings->blastAlignmentLengthFilter.on = true;
-        g_settings->blastAlignmentLengthFilter = getIntOption("--alfilter", &arguments);
+        settings->blastAlignmentLengthFilter.on = true;
+        settings->blastAlignmentLengthFilter = getIntOption("--alfilter", &arguments);
     }
     if (isOptionPresent("--qcfilter", &arguments))
     {
-        g_settings->blastQueryCoverageFilter.on = true;
-        g_settings->blastQueryCoverageFilter = getFloatOption("--qcfilter", &arguments);
+        settings->blastQueryCoverageFilter.on = true;
+        settings->blastQueryCoverageFilter = getFloatOption("--qcfilter", &arguments);
     }
     if (isOptionPresent("--ifilter", &arguments))
     {
-        g_settings->blastIdentityFilter.on = true;
-        g_settings->blastIdentityFilter = getFloatOption("--ifilter", &arguments);
+        settings->blastIdentityFilter.on = true;
+        settings->blastIdentityFilter = getFloatOption("--ifilter", &arguments);
     }
     if (isOptionPresent("--evfilter", &arguments))
     {
-        g_settings->blastEValueFilter.on = true;
-        g_settings->blastEValueFilter = getSciNotOption("--evfilter", &arguments);
+        settings->blastEValueFilter.on = true;
+        settings->blastEValueFilter = getSciNotOption("--evfilter", &arguments);
     }
     if (isOptionPresent("--bsfilter", &arguments))
     {
-        g_settings->blastBitScoreFilter.on = true;
-        g_settings->blastBitScoreFilter = getFloatOption("--bsfilter", &arguments);
+        settings->blastBitScoreFilter.on = true;
+        settings->blastBitScoreFilter = getFloatOption("--bsfilter", &arguments);
     }
 }
 
@@ -1291,7 +1302,11 @@ bool isCommand(QString text)
             text.startsWith("info   ") ||
             text.startsWith("image   ") ||
             text.startsWith("querypaths   ") ||
-            text.startsWith("reduce   ");
+            text.startsWith("gafseq   ") ||
+            text.startsWith("findseq   ") ||
+            text.startsWith("reduce   ") ||
+            text.startsWith("batch   ") ||
+            text.startsWith("serve   ");
 }
 
 
@@ -67,6 +67,7 @@ QString checkForInvalidOrExcessSettings(QStringList * arguments);
 QString checkForExcessArguments(QStringList arguments);
 
 void parseSettings(QStringList arguments);
+void parseSettings(QStringList arguments, Settings * settings);
 
 void getCommonHelp(QStringList * text);
 void getSettingsUsage(QStringList *text);
@@ -0,0 +1,256 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "findseq.h"
+#include "commoncommandlinefunctions.h"
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../program/parallel.h"
+#include "../graph/assemblygraph.h"
+#include "../graph/sequenceindex.h"
+#include "../graph/path.h"
+#include <QFile>
+#include <QThread>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <algorithm>
+
+int bandageFindSeq(QStringList arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (checkForHelp(arguments))
+    {
+        printFindSeqUsage(&out, false);
+        return 0;
+    }
+
+    if (checkForHelpAll(arguments))
+    {
+        printFindSeqUsage(&out, true);
+        return 0;
+    }
+
+    if (arguments.size() < 3)
+    {
+        printFindSeqUsage(&err, false);
+        return 1;
+    }
+
+    QString graphFilename = arguments.at(0);
+    arguments.pop_front();
+    if (!checkIfFileExists(graphFilename))
+    {
+        outputText("Bandage error: " + graphFilename + " does not exist", &err);
+        return 1;
+    }
+
+    QString queriesFilename = arguments.at(0);
+    arguments.pop_front();
+    if (!checkIfFileExists(queriesFilename))
+    {
+        outputText("Bandage error: " + queriesFilename + " does not exist", &err);
+        return 1;
+    }
+
+    QString outputFilename = arguments.at(0);
+    arguments.pop_front();
+
+    QString error = checkForInvalidFindSeqOptions(arguments);
+    if (error.length() > 0)
+    {
+        outputText("Bandage error: " + error, &err);
+        return 1;
+    }
+
+    FindSeqOptions options;
+    options.threads = QThread::idealThreadCount();
+    options.mismatches = 0;
+    options.maxHits = 100;
+    parseFindSeqOptions(arguments, &options);
+
+    std::vector<QString> queryNames;
+    std::vector<QByteArray> querySequences;
+    AssemblyGraph::readFastaOrFastqFile(queriesFilename, &queryNames, &querySequences);
+    if (querySequences.empty())
+    {
+        outputText("Bandage error: no sequences were found in " + queriesFilename, &err);
+        return 1;
+    }
+
+    QDateTime startTime = QDateTime::currentDateTime();
+
+    out << Qt::endl << "(" << QDateTime::currentDateTime().toString("dd MMM yyyy hh:mm:ss") << ") Loading graph...        " << Qt::flush;
+    if (!g_assemblyGraph->loadGraphFromFile(graphFilename))
+    {
+        outputText("Bandage error: could not load " + graphFilename, &err);
+        return 1;
+    }
+    out << "done" << Qt::endl;
+
+    out << "(" << QDateTime::currentDateTime().toString("dd MMM yyyy hh:mm:ss") << ") Indexing sequences...   " << Qt::flush;
+    g_assemblyGraph->getSequenceIndex();
+    out << "done" << Qt::endl;
+
+    out << "(" << QDateTime::currentDateTime().toString("dd MMM yyyy hh:mm:ss") << ") Finding queries...      " << Qt::flush;
+    FindSeqSummary summary;
+    QByteArray table = findQuerySequences(g_assemblyGraph.data(), queryNames, querySequences, options, &summary);
+    QFile outputFile(outputFilename);
+    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text) || outputFile.write(table) != table.size())
+    {
+        outputText("Bandage error: could not write " + outputFilename, &err);
+        return 1;
+    }
+    out << "done" << Qt::endl;
+
+    double seconds = std::max(summary.milliseconds / 1000.0, 0.001);
+    out << Qt::endl << "Results:            " << outputFilename << Qt::endl;
+    out << Qt::endl << "Summary: Queries:            " << formatIntForDisplay(summary.queries) << Qt::endl;
+    out << "         Queries found:      " << formatIntForDisplay(summary.queriesFound) << Qt::endl;
+    out << "         Hits:               " << formatIntForDisplay(summary.hits) << Qt::endl;
+    out << "         Throughput:         " << formatIntForDisplay((long long)(summary.queries / seconds)) << " queries/s" << Qt::endl;
+    out << Qt::endl << "Elapsed time: " << getElapsedTime(startTime, QDateTime::currentDateTime()) << Qt::endl;
+
+    if (summary.truncatedQueries > 0)
+        err << "Bandage warning: " << summary.truncatedQueries << " queries had more than "
+            << options.maxHits << " hits, and only the first " << options.maxHits << " were saved" << Qt::endl;
+
+    return 0;
+}
+
+
+//This function does the work of Bandage findseq on a loaded graph.  It
+//returns the table of hits, with one row for each hit.  The queries are
+//shared between threads, but the table is in the same order as the queries.
+QByteArray findQuerySequences(AssemblyGraph * assemblyGraph, const std::vector<QString> & queryNames,
+                              const std::vector<QByteArray> & querySequences,
+                              const FindSeqOptions & options, FindSeqSummary * summary)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const SequenceIndex & sequenceIndex = assemblyGraph->getSequenceIndex();
+
+    long long queryCount = (long long)querySequences.size();
+    std::vector<QByteArray> rows(querySequences.size());
+    std::vector<int> hitCounts(querySequences.size());
+    std::vector<char> truncated(querySequences.size());
+    int threads = std::max(1, options.threads);
+    long long minQueriesPerThread = std::max(1LL, queryCount / threads);
+    parallelForChunks(queryCount, [&](int, long long begin, long long end)
+    {
+        for (long long i = begin; i < end; ++i)
+        {
+            bool queryTruncated = false;
+            std::vector<SequenceMatch> matches = sequenceIndex.findSequence(querySequences[i], options.mismatches,
+                                                                            options.maxHits, &queryTruncated);
+            for (size_t j = 0; j < matches.size(); ++j)
+            {
+                rows[i] += queryNames[i].toUtf8() + "\t";
+                rows[i] += matches[j].path.getString(true).toUtf8() + "\t";
+                rows[i] += QByteArray::number(matches[j].mismatches) + "\t";
+                rows[i] += matches[j].path.getPathSequence() + "\n";
+            }
+            hitCounts[i] = int(matches.size());
+            truncated[i] = queryTruncated;
+        }
+    }, minQueriesPerThread);
+
+    QByteArray table = "Query\tPath\tMismatches\tSequence\n";
+    summary->queries = queryCount;
+    summary->queriesFound = 0;
+    summary->hits = 0;
+    summary->truncatedQueries = 0;
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        table += rows[i];
+        if (hitCounts[i] > 0)
+            ++summary->queriesFound;
+        summary->hits += hitCounts[i];
+        if (truncated[i])
+            ++summary->truncatedQueries;
+    }
+    summary->milliseconds = timer.nsecsElapsed() / 1000000.0;
+    return table;
+}
+
+
+
+void printFindSeqUsage(QTextStream * out, bool all)
+{
+    QStringList text;
+
+    text << "Bandage findseq finds where query sequences occur in a graph. Matches can run through more than one node, following the graph's edges, and can have mismatches (but not insertions or deletions). Each match is saved as a graph path, with its start and end positions in the first and last nodes.";
+    text << "";
+    QString k = QString::number(SequenceIndex::getKmerSize());
+    text << "The graph's sequences are put in a k-mer index (k = " + k + "), which is then shared by threads searching for the queries. The index includes the k-mers which cross from one node into the next, so a match is found if any of its k-mers is an exact match, within a node or across an edge. This is certain when the query is at least (mismatches + 1) times k long, unless the match passes through nodes shorter than k.";
+    text << "";
+    text << "Shorter queries, or queries with more mismatches, can't be found this way, so each one is instead compared at every position in the graph. This is much slower for large graphs. For example, a primer shorter than " + QString::number(2 * SequenceIndex::getKmerSize()) + " bp with 1 mismatch is searched for this way.";
+    text << "";
+    text << "Usage:    Bandage findseq <graph> <queries> <output> [options]";
+    text << "";
+    text << "Positional parameters:";
+    text << "<graph>             A graph file of any type supported by Bandage";
+    text << "<queries>           A FASTA or FASTQ file of query sequences";
+    text << "<output>            The table of matches to create (tab-delimited, with a header line)";
+    text << "";
+    text << "Options:  --mismatches <int> Mismatches allowed in each match " + getRangeAndDefault(0, 100, 0);
+    text << "--maxhits <int>     Matches saved for each query " + getRangeAndDefault(1, 1000000, 100);
+    text << "--threads <int>     Number of worker threads " + getRangeAndDefault(1, 1024, QThread::idealThreadCount());
+    text << "";
+
+    getCommonHelp(&text);
+    if (all)
+        getSettingsUsage(&text);
+    getOnlineHelpMessage(&text);
+
+    outputText(text, out);
+}
+
+
+
+QString checkForInvalidFindSeqOptions(QStringList arguments)
+{
+    QString error = checkOptionForInt("--mismatches", &arguments, IntSetting(0, 0, 100), false);
+    if (error.length() > 0) return error;
+
+    error = checkOptionForInt("--maxhits", &arguments, IntSetting(100, 1, 1000000), false);
+    if (error.length() > 0) return error;
+
+    error = checkOptionForInt("--threads", &arguments, IntSetting(1, 1, 1024), false);
+    if (error.length() > 0) return error;
+
+    return checkForInvalidOrExcessSettings(&arguments);
+}
+
+
+
+//This function parses the command line options.  It assumes that the options
+//have already been checked for correctness.
+void parseFindSeqOptions(QStringList arguments, FindSeqOptions * options)
+{
+    if (isOptionPresent("--mismatches", &arguments))
+        options->mismatches = getIntOption("--mismatches", &arguments);
+    if (isOptionPresent("--maxhits", &arguments))
+        options->maxHits = getIntOption("--maxhits", &arguments);
+    if (isOptionPresent("--threads", &arguments))
+        options->threads = getIntOption("--threads", &arguments);
+
+    parseSettings(arguments);
+}
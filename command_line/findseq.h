@@ -0,0 +1,54 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef FINDSEQ_H
+#define FINDSEQ_H
+
+#include <QStringList>
+#include <QString>
+#include <QByteArray>
+#include <QTextStream>
+#include <vector>
+
+class AssemblyGraph;
+
+struct FindSeqOptions
+{
+    int threads;
+    int mismatches;
+    int maxHits;
+};
+
+struct FindSeqSummary
+{
+    long long queries;
+    long long queriesFound;
+    long long hits;
+    long long truncatedQueries;
+    double milliseconds;
+};
+
+int bandageFindSeq(QStringList arguments);
+void printFindSeqUsage(QTextStream * out, bool all);
+QString checkForInvalidFindSeqOptions(QStringList arguments);
+void parseFindSeqOptions(QStringList arguments, FindSeqOptions * options);
+QByteArray findQuerySequences(AssemblyGraph * assemblyGraph, const std::vector<QString> & queryNames,
+                              const std::vector<QByteArray> & querySequences,
+                              const FindSeqOptions & options, FindSeqSummary * summary);
+
+#endif // FINDSEQ_H
@@ -0,0 +1,550 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gafseq.h"
+#include "commoncommandlinefunctions.h"
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../program/gafparser.h"
+#include "../graph/assemblygraph.h"
+#include "../graph/debruijnnode.h"
+#include "../graph/graphwriter.h"
+#include "../graph/path.h"
+#include <QFile>
+#include <QThread>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+namespace
+{
+
+//The GAF file is read in chunks of up to this many lines or bytes, whichever
+//comes first.
+const int CHUNK_LINES = 4096;
+const qint64 CHUNK_BYTES = 4 * 1024 * 1024;
+
+//Only this many skipped records are described individually.
+const int MAX_WARNINGS = 20;
+
+//Progress is reported this often (in milliseconds).
+const qint64 PROGRESS_INTERVAL = 5000;
+
+struct GafChunk
+{
+    long long firstLineNumber;
+    std::vector<QByteArray> lines;
+    bool processed;
+
+    QByteArray output;
+    long long records;
+    long long sequences;
+    long long skipped;
+    long long bases;
+    QStringList warnings;
+};
+
+
+//This class extracts the sequences.  The calling thread reads the GAF file
+//in chunks, a pool of workers turns each chunk into FASTA or FASTQ records,
+//and a writer thread writes the chunks to the output file in the order they
+//were read.  Only a few chunks per worker are held at once, so memory use
+//depends on the thread count and not on the size of the GAF file.
+class GafSequenceExtractor
+{
+public:
+    GafSequenceExtractor(AssemblyGraph * assemblyGraph, const GafSeqOptions & options,
+                         QFile * outputFile, QTextStream * progressOut);
+    bool run(QFile * gafFile, GafSeqSummary * summary);
+
+private:
+    AssemblyGraph * m_assemblyGraph;
+    GafSeqOptions m_options;
+    QFile * m_outputFile;
+    QTextStream * m_progressOut;
+    size_t m_maxChunks;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<GafChunk *> m_chunks;
+    size_t m_nextChunk;
+    bool m_readingFinished;
+    bool m_writeFailed;
+
+    //These are only used by the writer thread until it finishes.
+    GafSeqSummary * m_summary;
+    QElapsedTimer m_timer;
+    qint64 m_lastProgress;
+
+    void runWorker();
+    void runWriter();
+    void processChunk(GafChunk * chunk) const;
+    void processLine(const QByteArray & line, long long lineNumber, GafChunk * chunk) const;
+    void reportProgress();
+};
+
+
+GafSequenceExtractor::GafSequenceExtractor(AssemblyGraph * assemblyGraph, const GafSeqOptions & options,
+                                           QFile * outputFile, QTextStream * progressOut) :
+    m_assemblyGraph(assemblyGraph), m_options(options), m_outputFile(outputFile),
+    m_progressOut(progressOut), m_maxChunks(2 * std::max(1, options.threads)),
+    m_nextChunk(0), m_readingFinished(false), m_writeFailed(false),
+    m_summary(0), m_lastProgress(0)
+{
+}
+
+
+bool GafSequenceExtractor::run(QFile * gafFile, GafSeqSummary * summary)
+{
+    m_summary = summary;
+    m_timer.start();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::max(1, m_options.threads); ++i)
+        workers.push_back(std::thread(&GafSequenceExtractor::runWorker, this));
+    std::thread writer(&GafSequenceExtractor::runWriter, this);
+
+    long long lineNumber = 0;
+    while (!gafFile->atEnd())
+    {
+        GafChunk * chunk = new GafChunk();
+        chunk->firstLineNumber = lineNumber + 1;
+        chunk->processed = false;
+        chunk->records = chunk->sequences = chunk->skipped = chunk->bases = 0;
+        qint64 chunkBytes = 0;
+        while (!gafFile->atEnd() && int(chunk->lines.size()) < CHUNK_LINES && chunkBytes < CHUNK_BYTES)
+        {
+            chunk->lines.push_back(gafFile->readLine());
+            chunkBytes += chunk->lines.back().size();
+            ++lineNumber;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] {return m_chunks.size() < m_maxChunks || m_writeFailed;});
+        if (m_writeFailed)
+        {
+            delete chunk;
+            break;
+        }
+        m_chunks.push_back(chunk);
+        lock.unlock();
+        m_condition.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_readingFinished = true;
+    }
+    m_condition.notify_all();
+
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    writer.join();
+
+    summary->milliseconds = m_timer.nsecsElapsed() / 1000000.0;
+    return !m_writeFailed;
+}
+
+
+void GafSequenceExtractor::runWorker()
+{
+    while (true)
+    {
+        GafChunk * chunk;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] {return m_nextChunk < m_chunks.size() || m_readingFinished;});
+            if (m_nextChunk >= m_chunks.size())
+                return;
+            chunk = m_chunks[m_nextChunk];
+            ++m_nextChunk;
+        }
+
+        processChunk(chunk);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            chunk->processed = true;
+        }
+        m_condition.notify_all();
+    }
+}
+
+
+//Chunks are written in file order, so the writer waits on the oldest chunk
+//even if later ones are already done.
+void GafSequenceExtractor::runWriter()
+{
+    while (true)
+    {
+        GafChunk * chunk;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] {return (!m_chunks.empty() && m_chunks.front()->processed) ||
+                                                  (m_chunks.empty() && m_readingFinished);});
+            if (m_chunks.empty())
+                return;
+            chunk = m_chunks.front();
+            m_chunks.pop_front();
+            --m_nextChunk;
+        }
+        m_condition.notify_all();
+
+        if (!m_writeFailed && !chunk->output.isEmpty() &&
+                m_outputFile->write(chunk->output) != chunk->output.size())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_writeFailed = true;
+        }
+        m_condition.notify_all();
+
+        m_summary->records += chunk->records;
+        m_summary->sequences += chunk->sequences;
+        m_summary->skipped += chunk->skipped;
+        m_summary->bases += chunk->bases;
+        for (int i = 0; i < chunk->warnings.size() && m_summary->warnings.size() < MAX_WARNINGS; ++i)
+            m_summary->warnings.push_back(chunk->warnings[i]);
+        delete chunk;
+
+        reportProgress();
+    }
+}
+
+
+void GafSequenceExtractor::reportProgress()
+{
+    if (m_progressOut == 0 || m_timer.elapsed() - m_lastProgress < PROGRESS_INTERVAL)
+        return;
+    m_lastProgress = m_timer.elapsed();
+
+    double seconds = m_timer.elapsed() / 1000.0;
+    *m_progressOut << "(" << QDateTime::currentDateTime().toString("dd MMM yyyy hh:mm:ss") << ") "
+                   << formatIntForDisplay(m_summary->records) << " records, "
+                   << formatIntForDisplay((long long)(m_summary->records / seconds)) << " records/s, "
+                   << QString::number(m_summary->bases / seconds / 1000000.0, 'f', 1) << " Mbp/s" << Qt::endl;
+}
+
+
+void GafSequenceExtractor::processChunk(GafChunk * chunk) const
+{
+    for (size_t i = 0; i < chunk->lines.size(); ++i)
+        processLine(chunk->lines[i], chunk->firstLineNumber + (long long)i, chunk);
+    chunk->lines.clear();
+    chunk->lines.shrink_to_fit();
+}
+
+
+void GafSequenceExtractor::processLine(const QByteArray & line, long long lineNumber, GafChunk * chunk) const
+{
+    QByteArray trimmed = line.trimmed();
+    if (trimmed.isEmpty() || trimmed.startsWith('#'))
+        return;
+    ++chunk->records;
+
+    QString warningStart = "line " + QString::number(lineNumber) + ": ";
+    QList<QByteArray> fields = trimmed.split('\t');
+    if (fields.size() < (m_options.untrimmed ? 6 : 9))
+    {
+        ++chunk->skipped;
+        chunk->warnings << warningStart + "not enough fields";
+        return;
+    }
+
+    QString pathError;
+    QStringList nodeNames = parseGafPath(QString::fromUtf8(fields[5]), &pathError);
+    if (nodeNames.isEmpty())
+    {
+        ++chunk->skipped;
+        chunk->warnings << warningStart + "failed to parse path (" + pathError + ")";
+        return;
+    }
+
+    QList<DeBruijnNode *> nodes;
+    for (int i = 0; i < nodeNames.size(); ++i)
+    {
+        DeBruijnNode * node = m_assemblyGraph->m_deBruijnGraphNodes.value(nodeNames[i]);
+        if (node == 0)
+        {
+            ++chunk->skipped;
+            chunk->warnings << warningStart + "node " + nodeNames[i] + " is not in the graph";
+            return;
+        }
+        nodes.push_back(node);
+    }
+
+    Path path = Path::makeFromOrderedNodes(nodes, false);
+    if (path.isEmpty())
+    {
+        ++chunk->skipped;
+        chunk->warnings << warningStart + "the nodes do not form a path";
+        return;
+    }
+
+    //The path start and end (columns 8 and 9) are 0-based positions on the
+    //forward strand of the walk.
+    long long walkLength = path.getPathSequenceLength();
+    long long start = 0;
+    long long end = walkLength;
+    if (!m_options.untrimmed)
+    {
+        bool startOkay, endOkay;
+        start = fields[7].toLongLong(&startOkay);
+        end = fields[8].toLongLong(&endOkay);
+        if (!startOkay || !endOkay || start < 0 || end > walkLength || start > end)
+        {
+            ++chunk->skipped;
+            chunk->warnings << warningStart + "the path coordinates are outside the walk";
+            return;
+        }
+    }
+
+    //A query on the minus strand aligns to the reverse complement of the
+    //walk, so its sequence is given in the query's orientation.
+    QByteArray sequence = path.getPathSubsequence(start, end);
+    if (fields[4] == "-")
+        sequence = AssemblyGraph::getReverseComplement(sequence);
+
+    QByteArray description = " query=" + fields[2] + "-" + fields[3] + " strand=" + fields[4] +
+            " path=" + fields[5] + ":" + QByteArray::number(start) + "-" + QByteArray::number(end);
+    if (m_options.fastq)
+    {
+        chunk->output += "@" + fields[0] + description + "\n";
+        chunk->output += sequence;
+        chunk->output += "\n+\n";
+        chunk->output += QByteArray(sequence.size(), 'I');
+        chunk->output += "\n";
+    }
+    else
+    {
+        chunk->output += ">" + fields[0] + description + "\n";
+        GraphWriter::appendSequenceWithNewlines(&chunk->output, sequence);
+    }
+
+    ++chunk->sequences;
+    chunk->bases += sequence.size();
+}
+
+}
+
+
+
+int bandageGafSeq(QStringList arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (checkForHelp(arguments))
+    {
+        printGafSeqUsage(&out, false);
+        return 0;
+    }
+
+    if (checkForHelpAll(arguments))
+    {
+        printGafSeqUsage(&out, true);
+        return 0;
+    }
+
+    if (arguments.size() < 3)
+    {
+        printGafSeqUsage(&err, false);
+        return 1;
+    }
+
+    QString graphFilename = arguments.at(0);
+    arguments.pop_front();
+    if (!checkIfFileExists(graphFilename))
+    {
+        outputText("Bandage error: " + graphFilename + " does not exist", &err);
+        return 1;
+    }
+
+    QString gafFilename = arguments.at(0);
+    arguments.pop_front();
+    if (!checkIfFileExists(gafFilename))
+    {
+        outputText("Bandage error: " + gafFilename + " does not exist", &err);
+        return 1;
+    }
+
+    QString outputFilename = arguments.at(0);
+    arguments.pop_front();
+
+    QString error = checkForInvalidGafSeqOptions(arguments);
+    if (error.length() > 0)
+    {
+        outputText("Bandage error: " + error, &err);
+        return 1;
+    }
+
+    GafSeqOptions options;
+    options.threads = QThread::idealThreadCount();
+    options.fastq = false;
+    options.untrimmed = false;
+    parseGafSeqOptions(arguments, &options);
+
+    QDateTime startTime = QDateTime::currentDateTime();
+
+    out << Qt::endl << "(" << QDateTime::currentDateTime().toString("dd MMM yyyy hh:mm:ss") << ") Loading graph...        " << Qt::flush;
+    if (!g_assemblyGraph->loadGraphFromFile(graphFilename))
+    {
+        outputText("Bandage error: could not load " + graphFilename, &err);
+        return 1;
+    }
+    out << "done" << Qt::endl;
+    out << "(" << QDateTime::currentDateTime().toString("dd MMM yyyy hh:mm:ss") << ") Extracting sequences" << Qt::endl;
+
+    GafSeqSummary summary;
+    if (!extractGafSequences(g_assemblyGraph.data(), gafFilename, outputFilename, options,
+                             &summary, &error, &out))
+    {
+        outputText("Bandage error: " + error, &err);
+        return 1;
+    }
+
+    double seconds = std::max(summary.milliseconds / 1000.0, 0.001);
+    out << Qt::endl << "Results:            " << outputFilename << Qt::endl;
+    out << Qt::endl << "Summary: Records:            " << formatIntForDisplay(summary.records) << Qt::endl;
+    out << "         Sequences written:  " << formatIntForDisplay(summary.sequences) << Qt::endl;
+    out << "         Records skipped:    " << formatIntForDisplay(summary.skipped) << Qt::endl;
+    out << "         Bases written:      " << formatIntForDisplay(summary.bases) << Qt::endl;
+    out << "         Throughput:         " << formatIntForDisplay((long long)(summary.records / seconds)) << " records/s, "
+        << QString::number(summary.bases / seconds / 1000000.0, 'f', 1) << " Mbp/s" << Qt::endl;
+    out << Qt::endl << "Elapsed time: " << getElapsedTime(startTime, QDateTime::currentDateTime()) << Qt::endl;
+
+    for (int i = 0; i < summary.warnings.size(); ++i)
+        err << "Bandage warning: " << summary.warnings[i] << Qt::endl;
+    if (summary.skipped > summary.warnings.size())
+        err << "Bandage warning: " << summary.skipped - summary.warnings.size() << " more records were skipped" << Qt::endl;
+
+    return 0;
+}
+
+
+//This function does the work of Bandage gafseq on a loaded graph.  Records
+//which can't be resolved against the graph are skipped and counted in the
+//summary; the function only fails if a file can't be read or written.
+bool extractGafSequences(AssemblyGraph * assemblyGraph, QString gafFilename,
+                         QString outputFilename, const GafSeqOptions & options,
+                         GafSeqSummary * summary, QString * error,
+                         QTextStream * progressOut)
+{
+    summary->records = 0;
+    summary->sequences = 0;
+    summary->skipped = 0;
+    summary->bases = 0;
+    summary->milliseconds = 0.0;
+    summary->warnings.clear();
+
+    QFile gafFile(gafFilename);
+    if (!gafFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        *error = "could not open " + gafFilename;
+        return false;
+    }
+    QFile outputFile(outputFilename);
+    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Unbuffered))
+    {
+        *error = "could not write " + outputFilename;
+        return false;
+    }
+
+    //Node sequences kept in a separate FASTA file are loaded the first time
+    //one is needed, which isn't safe to do from the workers.
+    QMapIterator<QString, DeBruijnNode*> i(assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        if (i.value()->sequenceIsMissing())
+        {
+            assemblyGraph->attemptToLoadSequencesFromFasta();
+            break;
+        }
+    }
+
+    GafSequenceExtractor extractor(assemblyGraph, options, &outputFile, progressOut);
+    if (!extractor.run(&gafFile, summary))
+    {
+        *error = "could not write " + outputFilename;
+        return false;
+    }
+    return true;
+}
+
+
+
+void printGafSeqUsage(QTextStream * out, bool all)
+{
+    QStringList text;
+
+    text << "Bandage gafseq extracts the graph sequence for each alignment in a GAF file. Each alignment's walk is followed through the graph and trimmed to the path start and end (columns 8 and 9). Alignments on the minus strand are reverse complemented, so every sequence is in the orientation of its query.";
+    text << "";
+    text << "The GAF file is streamed and processed in parallel, with the sequences written in the same order as the alignments. Memory use depends on the number of threads, not on the size of the GAF file. Alignments which cannot be followed through the graph are skipped with a warning.";
+    text << "";
+    text << "Usage:    Bandage gafseq <graph> <gaf> <output> [options]";
+    text << "";
+    text << "Positional parameters:";
+    text << "<graph>             A graph file of any type supported by Bandage";
+    text << "<gaf>               A GAF file of alignments to the graph";
+    text << "<output>            The FASTA (or FASTQ) file of sequences to create";
+    text << "";
+    text << "Options:  --threads <int>     Number of worker threads " + getRangeAndDefault(1, 1024, QThread::idealThreadCount());
+    text << "--fastq             Save sequences in FASTQ format (every base is given the quality 'I')";
+    text << "--untrimmed         Save the whole sequence of each walk, not just the aligned part";
+    text << "";
+
+    getCommonHelp(&text);
+    if (all)
+        getSettingsUsage(&text);
+    getOnlineHelpMessage(&text);
+
+    outputText(text, out);
+}
+
+
+
+QString checkForInvalidGafSeqOptions(QStringList arguments)
+{
+    QString error = checkOptionForInt("--threads", &arguments, IntSetting(1, 1, 1024), false);
+    if (error.length() > 0) return error;
+
+    checkOptionWithoutValue("--fastq", &arguments);
+    checkOptionWithoutValue("--untrimmed", &arguments);
+
+    return checkForInvalidOrExcessSettings(&arguments);
+}
+
+
+
+//This function parses the command line options.  It assumes that the options
+//have already been checked for correctness.
+void parseGafSeqOptions(QStringList arguments, GafSeqOptions * options)
+{
+    if (isOptionPresent("--threads", &arguments))
+        options->threads = getIntOption("--threads", &arguments);
+
+    options->fastq = isOptionPresent("--fastq", &arguments);
+    options->untrimmed = isOptionPresent("--untrimmed", &arguments);
+
+    parseSettings(arguments);
+}
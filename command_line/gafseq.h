@@ -0,0 +1,54 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GAFSEQ_H
+#define GAFSEQ_H
+
+#include <QStringList>
+#include <QString>
+#include <QTextStream>
+
+class AssemblyGraph;
+
+struct GafSeqOptions
+{
+    int threads;
+    bool fastq;
+    bool untrimmed;
+};
+
+struct GafSeqSummary
+{
+    long long records;
+    long long sequences;
+    long long skipped;
+    long long bases;
+    double milliseconds;
+    QStringList warnings;
+};
+
+int bandageGafSeq(QStringList arguments);
+void printGafSeqUsage(QTextStream * out, bool all);
+QString checkForInvalidGafSeqOptions(QStringList arguments);
+void parseGafSeqOptions(QStringList arguments, GafSeqOptions * options);
+bool extractGafSequences(AssemblyGraph * assemblyGraph, QString gafFilename,
+                         QString outputFilename, const GafSeqOptions & options,
+                         GafSeqSummary * summary, QString * error,
+                         QTextStream * progressOut = 0);
+
+#endif // GAFSEQ_H
@@ -163,8 +163,33 @@ int bandageImage(QStringList arguments)
     g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
     g_assemblyGraph->layoutGraph();
 
+    bool success = saveGraphImage(g_assemblyGraph.data(), imageSaveFilename, pixelImage, width, height);
+
+    int returnCode;
+    if (!success)
+    {
+        out << "There was an error writing the image to file." << Qt::endl;
+        returnCode = 1;
+    }
+    else
+        returnCode = 0;
+
+    if (blastUsed)
+        deleteBlastTempDirectory();
+
+    return returnCode;
+}
+
+
+//This function draws a graph which has already been laid out and saves it to
+//an image file.  If only one of the width and height is given, the other is
+//set using the graph's aspect ratio, and if neither is given, the height is
+//1000.  It returns whether the image was saved.
+bool saveGraphImage(AssemblyGraph * assemblyGraph, QString imageSaveFilename, bool pixelImage,
+                    int width, int height)
+{
     MyGraphicsScene scene;
-    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+    assemblyGraph->addGraphicsItemsToScene(&scene);
     scene.setSceneRectangle();
     double sceneRectAspectRatio = scene.sceneRect().width() / scene.sceneRect().height();
 
@@ -206,19 +231,7 @@ int bandageImage(QStringList arguments)
         painter.end();
     }
 
-    int returnCode;
-    if (!success)
-    {
-        out << "There was an error writing the image to file." << Qt::endl;
-        returnCode = 1;
-    }
-    else
-        returnCode = 0;
-
-    if (blastUsed)
-        deleteBlastTempDirectory();
-
-    return returnCode;
+    return success;
 }
 
 
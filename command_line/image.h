@@ -29,5 +29,7 @@ void printImageUsage(QTextStream * out, bool all);
 QString checkForInvalidImageOptions(QStringList arguments);
 void parseImageOptions(QStringList arguments, int * width, int * height);
 QString parseColorsOption(QStringList arguments);
+bool saveGraphImage(AssemblyGraph * assemblyGraph, QString imageSaveFilename, bool pixelImage,
+                    int width, int height);
 
 #endif // IMAGE_H
@@ -19,7 +19,8 @@
 #include "info.h"
 #include "commoncommandlinefunctions.h"
 #include "../graph/assemblygraph.h"
-#include <QPair>
+#include "../program/gafcoverage.h"
+#include <QThread>
 
 
 
@@ -63,7 +64,9 @@ int bandageInfo(QStringList arguments)
     }
 
     bool tsv;
-    parseInfoOptions(arguments, &tsv);
+    QString gafFilename;
+    DepthSource depthSource;
+    parseInfoOptions(arguments, &tsv, &gafFilename, &depthSource);
 
     bool loadSuccess = g_assemblyGraph->loadGraphFromFile(graphFilename);
     if (!loadSuccess)
@@ -72,76 +75,36 @@ int bandageInfo(QStringList arguments)
         return 1;
     }
 
-    int nodeCount = g_assemblyGraph->m_nodeCount;
-    int edgeCount = g_assemblyGraph->m_edgeCount;
-    QPair<int, int> overlapRange = g_assemblyGraph->getOverlapRange();
-    int smallestOverlap = overlapRange.first;
-    int largestOverlap = overlapRange.second;
-    int totalLength = g_assemblyGraph->m_totalLength;
-    int totalLengthNoOverlaps = g_assemblyGraph->getTotalLengthMinusEdgeOverlaps();
-    int deadEnds = g_assemblyGraph->getDeadEndCount();
-    double percentageDeadEnds = 100.0 * double(deadEnds) / (2 * nodeCount);
-
-    int n50 = 0;
-    int shortestNode = 0;
-    int firstQuartile = 0;
-    int median = 0;
-    int thirdQuartile = 0;
-    int longestNode = 0;
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-
-    int componentCount = 0;
-    int largestComponentLength = 0;
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    long long totalLengthOrphanedNodes = g_assemblyGraph->getTotalLengthOrphanedNodes();
+    //If a GAF file was given, its coverage replaces the graph's depths for
+    //the depth statistics.
+    if (gafFilename != "")
+    {
+        QSharedPointer<GafCoverage> gafCoverage(new GafCoverage());
+        GafCoverageSummary summary;
+        if (!gafCoverage->load(g_assemblyGraph.data(), gafFilename, QThread::idealThreadCount(),
+                               &summary, &error))
+        {
+            outputText("Bandage error: " + error, &err);
+            return 1;
+        }
+        for (int i = 0; i < summary.warnings.size(); ++i)
+            err << "Bandage warning: " << summary.warnings[i] << Qt::endl;
+        if (summary.skipped > summary.warnings.size())
+            err << "Bandage warning: " << summary.skipped - summary.warnings.size() << " more records were skipped" << Qt::endl;
+
+        g_assemblyGraph->setGafCoverage(gafCoverage);
+        g_assemblyGraph->setDepthSource(depthSource);
+    }
 
-    double medianDepthByBase = g_assemblyGraph->getMedianDepthByBase();
-    long long estimatedSequenceLength = g_assemblyGraph->getEstimatedSequenceLength(medianDepthByBase);
+    QStringList values = getInfoValues(g_assemblyGraph.data());
 
     if (tsv)
-    {
-        out << graphFilename << "\t";
-        out << nodeCount << "\t";
-        out << edgeCount << "\t";
-        out << smallestOverlap << "\t";
-        out << largestOverlap << "\t";
-        out << totalLength << "\t";
-        out << totalLengthNoOverlaps << "\t";
-        out << deadEnds << "\t";
-        out << percentageDeadEnds << "%\t";
-        out << componentCount << "\t";
-        out << largestComponentLength << "\t";
-        out << totalLengthOrphanedNodes << "\t";
-        out << n50 << "\t";
-        out << shortestNode << "\t";
-        out << firstQuartile << "\t";
-        out << median << "\t";
-        out << thirdQuartile << "\t";
-        out << longestNode << "\t";
-        out << medianDepthByBase << "\t";
-        out << estimatedSequenceLength << "\n";
-    }
+        out << graphFilename << "\t" << values.join("\t") << "\n";
     else
     {
-        out << "Node count:                       " << nodeCount << "\n";
-        out << "Edge count:                       " << edgeCount << "\n";
-        out << "Smallest edge overlap (bp):       " << smallestOverlap << "\n";
-        out << "Largest edge overlap (bp):        " << largestOverlap << "\n";
-        out << "Total length (bp):                " << totalLength << "\n";
-        out << "Total length no overlaps (bp):    " << totalLengthNoOverlaps << "\n";
-        out << "Dead ends:                        " << deadEnds << "\n";
-        out << "Percentage dead ends:             " << percentageDeadEnds << "%\n";
-        out << "Connected components:             " << componentCount << "\n";
-        out << "Largest component (bp):           " << largestComponentLength << "\n";
-        out << "Total length orphaned nodes (bp): " << totalLengthOrphanedNodes << "\n";
-        out << "N50 (bp):                         " << n50 << "\n";
-        out << "Shortest node (bp):               " << shortestNode << "\n";
-        out << "Lower quartile node (bp):         " << firstQuartile << "\n";
-        out << "Median node (bp):                 " << median << "\n";
-        out << "Upper quartile node (bp):         " << thirdQuartile << "\n";
-        out << "Longest node (bp):                " << longestNode << "\n";
-        out << "Median depth:                     " << medianDepthByBase << "\n";
-        out << "Estimated sequence length (bp):   " << estimatedSequenceLength << "\n";
+        QStringList labels = getInfoLabels();
+        for (int i = 0; i < labels.size(); ++i)
+            out << QString(labels[i] + ":").leftJustified(34) << values[i] << "\n";
     }
 
     return 0;
@@ -180,6 +143,8 @@ void printInfoUsage(QTextStream * out, bool all)
     text << "<graph>             A graph file of any type supported by Bandage";
     text << "";
     text << "Options:  --tsv               Output the information in a single tab-delimited line starting with the graph file";
+    text << "--gaf <file>        Use coverage from the alignments in this GAF file as the node depths";
+    text << "--gafdepth <text>   The GAF coverage to use as depth: mean (mean per-base coverage) or reads (alignment count) (default: mean)";
     text << "";
 
     getCommonHelp(&text);
@@ -196,7 +161,15 @@ QString checkForInvalidInfoOptions(QStringList arguments)
 {
     checkOptionWithoutValue("--tsv", &arguments);
 
-    QString error = checkForInvalidOrExcessSettings(&arguments);
+    QString error = checkOptionForFile("--gaf", &arguments);
+    if (error.length() > 0) return error;
+
+    QStringList validGafDepthOptions;
+    validGafDepthOptions << "mean" << "reads";
+    error = checkOptionForString("--gafdepth", &arguments, validGafDepthOptions);
+    if (error.length() > 0) return error;
+
+    error = checkForInvalidOrExcessSettings(&arguments);
     if (error.length() > 0) return error;
 
     return checkForInvalidOrExcessSettings(&arguments);
@@ -204,8 +177,79 @@ QString checkForInvalidInfoOptions(QStringList arguments)
 
 
 
-void parseInfoOptions(QStringList arguments, bool * tsv)
+void parseInfoOptions(QStringList arguments, bool * tsv, QString * gafFilename,
+                      DepthSource * depthSource)
 {
     int tsvIndex = arguments.indexOf("--tsv");
     *tsv = (tsvIndex > -1);
+
+    *gafFilename = "";
+    if (isOptionPresent("--gaf", &arguments))
+        *gafFilename = getStringOption("--gaf", &arguments);
+
+    *depthSource = GAF_MEAN_COVERAGE;
+    if (isOptionAndValuePresent("--gafdepth", "reads", &arguments))
+        *depthSource = GAF_READ_COUNT;
+}
+
+
+
+//These are the names of the values given by getInfoValues, in the same order.
+QStringList getInfoLabels()
+{
+    QStringList labels;
+    labels << "Node count" << "Edge count" << "Smallest edge overlap (bp)" << "Largest edge overlap (bp)"
+           << "Total length (bp)" << "Total length no overlaps (bp)" << "Dead ends" << "Percentage dead ends"
+           << "Connected components" << "Largest component (bp)" << "Total length orphaned nodes (bp)"
+           << "N50 (bp)" << "Shortest node (bp)" << "Lower quartile node (bp)" << "Median node (bp)"
+           << "Upper quartile node (bp)" << "Longest node (bp)" << "Median depth"
+           << "Estimated sequence length (bp)";
+    return labels;
+}
+
+
+
+//This function gets the Bandage info statistics for a loaded graph.  It takes
+//the graph as a parameter so it can be used for graphs other than the global
+//one (e.g. in Bandage batch).
+QStringList getInfoValues(const AssemblyGraph * assemblyGraph)
+{
+    const GraphStatistics & stats = assemblyGraph->getGraphStatistics();
+
+    int nodeCount = assemblyGraph->m_nodeCount;
+    int edgeCount = assemblyGraph->m_edgeCount;
+    int smallestOverlap = stats.smallestOverlap;
+    int largestOverlap = stats.largestOverlap;
+    long long totalLength = assemblyGraph->m_totalLength;
+    long long totalLengthNoOverlaps = stats.totalLengthNoOverlaps;
+    int deadEnds = stats.deadEnds;
+    double percentageDeadEnds = 100.0 * double(deadEnds) / (2 * nodeCount);
+
+    int n50 = 0;
+    int shortestNode = 0;
+    int firstQuartile = 0;
+    int median = 0;
+    int thirdQuartile = 0;
+    int longestNode = 0;
+    assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
+
+    int componentCount = stats.componentCount;
+    long long largestComponentLength = stats.largestComponentLength;
+    long long totalLengthOrphanedNodes = stats.totalLengthOrphanedNodes;
+
+    double medianDepthByBase = assemblyGraph->getMedianDepthByBase();
+    long long estimatedSequenceLength = assemblyGraph->getEstimatedSequenceLength();
+
+    QStringList values;
+    values << QString::number(nodeCount) << QString::number(edgeCount)
+           << QString::number(smallestOverlap) << QString::number(largestOverlap)
+           << QString::number(totalLength) << QString::number(totalLengthNoOverlaps)
+           << QString::number(deadEnds) << QString::number(percentageDeadEnds) + "%"
+           << QString::number(componentCount) << QString::number(largestComponentLength)
+           << QString::number(totalLengthOrphanedNodes) << QString::number(n50)
+           << QString::number(shortestNode) << QString::number(firstQuartile)
+           << QString::number(median) << QString::number(thirdQuartile)
+           << QString::number(longestNode) << QString::number(medianDepthByBase)
+           << QString::number(estimatedSequenceLength);
+    return values;
 }
@@ -21,11 +21,17 @@
 
 #include <QStringList>
 #include <QTextStream>
+#include "../program/globals.h"
+
+class AssemblyGraph;
 
 
 int bandageInfo(QStringList arguments);
 void printInfoUsage(QTextStream * out, bool all);
 QString checkForInvalidInfoOptions(QStringList arguments);
-void parseInfoOptions(QStringList arguments, bool * tsv);
+void parseInfoOptions(QStringList arguments, bool * tsv, QString * gafFilename,
+                      DepthSource * depthSource);
+QStringList getInfoLabels();
+QStringList getInfoValues(const AssemblyGraph * assemblyGraph);
 
 #endif // INFO_H
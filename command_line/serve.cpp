@@ -0,0 +1,716 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "serve.h"
+#include "commoncommandlinefunctions.h"
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../program/gafparser.h"
+#include "../graph/assemblygraph.h"
+#include "../graph/debruijnnode.h"
+#include "../graph/path.h"
+#include <QApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QRunnable>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThread>
+#include <algorithm>
+
+namespace
+{
+
+//The number of recent latencies kept for each type of request.
+const size_t latencySampleCount = 1000;
+
+double getMilliseconds(const QElapsedTimer & timer)
+{
+    return timer.nsecsElapsed() / 1000000.0;
+}
+
+
+//This answers one request in the server's thread pool and then hands the
+//response back to the main thread, which owns the socket.  If the client has
+//disconnected in the meantime, the response is dropped.
+class ServeRequestTask : public QRunnable
+{
+public:
+    ServeRequestTask(GraphServer * server, QLocalSocket * socket, QByteArray requestLine) :
+        m_server(server), m_socket(socket), m_requestLine(requestLine) {}
+
+    void run()
+    {
+        bool shutdown = false;
+        QByteArray response = m_server->handleRequestLine(m_requestLine, &shutdown);
+        GraphServer * server = m_server;
+        QPointer<QLocalSocket> socket = m_socket;
+        QMetaObject::invokeMethod(m_server, [server, socket, response, shutdown]()
+        {
+            if (!socket.isNull())
+            {
+                socket->write(response);
+                socket->flush();
+            }
+            if (shutdown)
+                emit server->shutdownRequested();
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    GraphServer * m_server;
+    QPointer<QLocalSocket> m_socket;
+    QByteArray m_requestLine;
+};
+
+
+double getPercentile(std::vector<double> values, double fraction)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = size_t(fraction * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+
+QJsonObject makeError(QString error)
+{
+    QJsonObject response;
+    response["ok"] = false;
+    response["error"] = error;
+    return response;
+}
+
+
+//This function reads a non-negative integer from a request, using the default
+//if the request does not have it.
+bool getRequestInt(const QJsonObject & request, QString key, int defaultValue, int * value)
+{
+    if (!request.contains(key))
+    {
+        *value = defaultValue;
+        return true;
+    }
+    QJsonValue jsonValue = request[key];
+    if (!jsonValue.isDouble() || jsonValue.toDouble() < 0.0 ||
+            jsonValue.toDouble() != double(jsonValue.toInt()))
+        return false;
+    *value = jsonValue.toInt();
+    return true;
+}
+
+}
+
+
+
+GraphServer::GraphServer(int threads, QObject * parent) :
+    QObject(parent), m_server(new QLocalServer(this))
+{
+    m_threadPool.setMaxThreadCount(threads);
+    connect(m_server, SIGNAL(newConnection()), this, SLOT(acceptConnections()));
+}
+
+
+GraphServer::~GraphServer()
+{
+    m_server->close();
+    m_threadPool.waitForDone();
+    for (size_t i = 0; i < m_graphs.size(); ++i)
+        m_graphs[i].assemblyGraph->cleanUp();
+}
+
+
+//Each graph is loaded with its own copy of the settings, so settings given on
+//the command line apply to all of the graphs.  Graphs are named after their
+//file, and a number is added if two files have the same name.
+bool GraphServer::addGraph(QString filename, QString * error)
+{
+    ServedGraph graph;
+    graph.filename = filename;
+    graph.assemblyGraph.reset(new AssemblyGraph(QSharedPointer<Settings>(new Settings(*g_settings))));
+    graph.lock.reset(new QReadWriteLock());
+
+    if (!checkIfFileExists(filename) || !graph.assemblyGraph->loadGraphFromFile(filename))
+    {
+        *error = "could not load " + filename;
+        return false;
+    }
+
+    graph.name = QFileInfo(filename).completeBaseName();
+    for (size_t i = 0; i < m_graphs.size(); ++i)
+    {
+        if (m_graphs[i].name == graph.name)
+        {
+            graph.name += "_" + QString::number(m_graphs.size() + 1);
+            break;
+        }
+    }
+
+    //The sequences from a separate FASTA file and the node and sequence
+    //indices are normally made the first time they are needed.  They are made
+    //now, so the requests running at the same time never change the graph.
+    graph.assemblyGraph->attemptToLoadSequencesFromFasta();
+    graph.assemblyGraph->getIndexedNodes();
+    graph.assemblyGraph->getNodeNameIndex();
+    graph.assemblyGraph->getSequenceIndex();
+
+    m_graphs.push_back(graph);
+    return true;
+}
+
+
+bool GraphServer::listen(QString socketName, QString * error)
+{
+    //A socket left behind by a server which did not shut down cleanly would
+    //stop the new server from listening.
+    QLocalServer::removeServer(socketName);
+    if (!m_server->listen(socketName))
+    {
+        *error = "could not listen on " + socketName + ": " + m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+
+void GraphServer::acceptConnections()
+{
+    while (m_server->hasPendingConnections())
+    {
+        QLocalSocket * socket = m_server->nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequests()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+
+void GraphServer::readRequests()
+{
+    QLocalSocket * socket = qobject_cast<QLocalSocket *>(sender());
+    if (socket == 0)
+        return;
+
+    while (socket->canReadLine())
+    {
+        QByteArray requestLine = socket->readLine().trimmed();
+        if (!requestLine.isEmpty())
+            m_threadPool.start(new ServeRequestTask(this, socket, requestLine));
+    }
+}
+
+
+//This function takes one line of JSON and returns the response line.  It is
+//safe to call from many threads at once.  A shutdown request sets shutdown,
+//so the caller can stop the server once the response is sent.
+QByteArray GraphServer::handleRequestLine(QByteArray requestLine, bool * shutdown)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QJsonParseError parseError;
+    QJsonDocument requestDocument = QJsonDocument::fromJson(requestLine, &parseError);
+    QJsonObject request = requestDocument.object();
+    QString operation = request["op"].toString();
+
+    QJsonObject response;
+    if (parseError.error != QJsonParseError::NoError || !requestDocument.isObject())
+    {
+        operation = "invalid";
+        response = makeError("the request is not a JSON object");
+    }
+    else
+        response = handleRequest(request, operation);
+
+    if (!response.contains("ok"))
+        response["ok"] = true;
+    if (request.contains("id"))
+        response["id"] = request["id"];
+
+    double milliseconds = getMilliseconds(timer);
+    response["ms"] = milliseconds;
+    recordLatency(operation, milliseconds, response["ok"].toBool());
+
+    if (shutdown != 0)
+        *shutdown = (operation == "shutdown");
+
+    return QJsonDocument(response).toJson(QJsonDocument::Compact) + "\n";
+}
+
+
+QJsonObject GraphServer::handleRequest(const QJsonObject & request, QString operation)
+{
+    if (operation == "graphs")
+        return getGraphList();
+    if (operation == "stats")
+        return getLatencyStats();
+    if (operation == "shutdown")
+        return QJsonObject();
+
+    QString error;
+    const ServedGraph * graph = findGraph(request, &error);
+    if (graph == 0)
+        return makeError(error);
+
+    if (operation == "node")
+        return getNodes(graph, request);
+    if (operation == "neighbourhood")
+        return getNeighbourhood(graph, request);
+    if (operation == "path")
+        return getPath(graph, request);
+    if (operation == "find")
+        return findSequence(graph, request);
+    if (operation == "subgraph")
+        return getSubgraph(graph, request);
+
+    if (operation.isEmpty())
+        return makeError("the request has no \"op\"");
+    return makeError(operation + " is not a valid operation");
+}
+
+
+//A request can leave out the graph when only one graph is loaded.
+const ServedGraph * GraphServer::findGraph(const QJsonObject & request, QString * error) const
+{
+    QString graphName = request["graph"].toString();
+    if (graphName.isEmpty())
+    {
+        if (m_graphs.size() == 1)
+            return &m_graphs[0];
+        *error = "the request must name a graph when more than one is loaded";
+        return 0;
+    }
+
+    for (size_t i = 0; i < m_graphs.size(); ++i)
+    {
+        if (m_graphs[i].name == graphName)
+            return &m_graphs[i];
+    }
+    *error = graphName + " is not a loaded graph";
+    return 0;
+}
+
+
+QJsonObject GraphServer::getGraphList() const
+{
+    QJsonArray graphs;
+    for (size_t i = 0; i < m_graphs.size(); ++i)
+    {
+        const AssemblyGraph * assemblyGraph = m_graphs[i].assemblyGraph.data();
+        QJsonObject graph;
+        graph["graph"] = m_graphs[i].name;
+        graph["file"] = m_graphs[i].filename;
+        graph["nodes"] = assemblyGraph->m_nodeCount;
+        graph["edges"] = assemblyGraph->m_edgeCount;
+        graph["total_length"] = double(assemblyGraph->m_totalLength);
+        graphs.append(graph);
+    }
+
+    QJsonObject response;
+    response["graphs"] = graphs;
+    return response;
+}
+
+
+//Nodes are given the same way as for the --nodes option.  Names without a +/-
+//return both nodes in the pair, and "exact": false allows partial matches.
+QJsonObject GraphServer::getNodes(const ServedGraph * graph, const QJsonObject & request)
+{
+    QReadLocker locker(graph->lock.data());
+
+    std::vector<QString> nodesNotInGraph;
+    std::vector<DeBruijnNode *> nodes = graph->assemblyGraph->getNodesFromString(request["nodes"].toString(),
+                                                                                 request["exact"].toBool(true),
+                                                                                 &nodesNotInGraph);
+    if (nodes.empty())
+        return makeError("no nodes were found");
+
+    QJsonArray nodeArray;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        QJsonObject node;
+        node["name"] = nodes[i]->getName();
+        node["length"] = nodes[i]->getLength();
+        node["depth"] = nodes[i]->getDepth();
+        node["sequence"] = QString::fromLatin1(nodes[i]->getSequence());
+        nodeArray.append(node);
+    }
+
+    QJsonArray notFound;
+    for (size_t i = 0; i < nodesNotInGraph.size(); ++i)
+        notFound.append(nodesNotInGraph[i]);
+
+    QJsonObject response;
+    response["nodes"] = nodeArray;
+    response["not_found"] = notFound;
+    return response;
+}
+
+
+//This returns every node within the given number of edges of the starting
+//nodes, with its distance.  The distance defaults to --distance.
+QJsonObject GraphServer::getNeighbourhood(const ServedGraph * graph, const QJsonObject & request)
+{
+    QReadLocker locker(graph->lock.data());
+    const AssemblyGraph * assemblyGraph = graph->assemblyGraph.data();
+
+    int distance;
+    if (!getRequestInt(request, "distance", assemblyGraph->m_settings->nodeDistance, &distance))
+        return makeError("the distance must be a non-negative integer");
+
+    std::vector<DeBruijnNode *> startingNodes = graph->assemblyGraph->getNodesFromString(request["nodes"].toString(),
+                                                                                         request["exact"].toBool(true));
+    if (startingNodes.empty())
+        return makeError("no nodes were found");
+
+    const std::vector<DeBruijnNode *> & nodes = assemblyGraph->getIndexedNodes();
+    std::vector<int> distances = assemblyGraph->getNodeDistances(startingNodes, distance);
+
+    std::vector<std::pair<int, DeBruijnNode *> > foundNodes;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (distances[i] != -1)
+            foundNodes.push_back(std::make_pair(distances[i], nodes[i]));
+    }
+    std::stable_sort(foundNodes.begin(), foundNodes.end(),
+                     [](const std::pair<int, DeBruijnNode *> & a, const std::pair<int, DeBruijnNode *> & b)
+                     {return a.first < b.first;});
+
+    QJsonArray nodeArray;
+    for (size_t i = 0; i < foundNodes.size(); ++i)
+    {
+        QJsonObject node;
+        node["name"] = foundNodes[i].second->getName();
+        node["distance"] = foundNodes[i].first;
+        nodeArray.append(node);
+    }
+
+    QJsonObject response;
+    response["nodes"] = nodeArray;
+    return response;
+}
+
+
+//The path is given either as a Bandage path ("path": "1+, 2-") or as a GAF
+//walk ("gaf": ">1<2").
+QJsonObject GraphServer::getPath(const ServedGraph * graph, const QJsonObject & request)
+{
+    QReadLocker locker(graph->lock.data());
+
+    QString pathString = request["path"].toString();
+    if (request.contains("gaf"))
+    {
+        QString gafError;
+        QStringList nodeNames = parseGafPath(request["gaf"].toString(), &gafError);
+        if (nodeNames.isEmpty())
+            return makeError("the GAF path could not be read: " + gafError);
+        pathString = nodeNames.join(", ");
+    }
+    if (pathString.isEmpty())
+        return makeError("the request has no \"path\" or \"gaf\"");
+
+    QString pathStringFailure;
+    Path path = Path::makeFromString(pathString, request["circular"].toBool(false),
+                                     &pathStringFailure, graph->assemblyGraph.data());
+    if (path.isEmpty())
+        return makeError("the path is not valid: " + pathStringFailure);
+
+    QJsonObject response;
+    response["path"] = path.getString(true);
+    response["length"] = path.getLength();
+    response["sequence"] = QString::fromLatin1(path.getPathSequence());
+    return response;
+}
+
+
+//This looks up a sequence in the graph's k-mer index.  Matches can span more
+//than one node, and can have up to "mismatches" mismatches.  Each hit gives
+//the path it follows, with its start in the first node and its end in the
+//last node.
+QJsonObject GraphServer::findSequence(const ServedGraph * graph, const QJsonObject & request)
+{
+    QReadLocker locker(graph->lock.data());
+
+    QByteArray query = request["sequence"].toString().trimmed().toUpper().toLatin1();
+    if (query.isEmpty())
+        return makeError("the request has no \"sequence\"");
+
+    int maxHits;
+    if (!getRequestInt(request, "max_hits", 100, &maxHits))
+        return makeError("max_hits must be a non-negative integer");
+    int mismatches;
+    if (!getRequestInt(request, "mismatches", 0, &mismatches))
+        return makeError("mismatches must be a non-negative integer");
+
+    bool truncated = false;
+    std::vector<SequenceMatch> matches = graph->assemblyGraph->getSequenceIndex().findSequence(query, mismatches,
+                                                                                            maxHits, &truncated);
+    QJsonArray hits;
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        QJsonObject hit;
+        hit["node"] = matches[i].path.getStartLocation().getNode()->getName();
+        hit["start"] = matches[i].path.getStartLocation().getPosition();
+        hit["end"] = matches[i].path.getEndLocation().getPosition();
+        hit["path"] = matches[i].path.getString(true);
+        hit["mismatches"] = matches[i].mismatches;
+        hits.append(hit);
+    }
+
+    QJsonObject response;
+    response["hits"] = hits;
+    response["truncated"] = truncated;
+    return response;
+}
+
+
+//This saves the nodes around the starting nodes as a GFA, the same as Bandage
+//reduce.  The GFA goes to "output" if given, otherwise it is returned in the
+//response.  It marks nodes as drawn, so it has the graph to itself.
+QJsonObject GraphServer::getSubgraph(const ServedGraph * graph, const QJsonObject & request)
+{
+    QWriteLocker locker(graph->lock.data());
+    AssemblyGraph * assemblyGraph = graph->assemblyGraph.data();
+
+    int distance;
+    if (!getRequestInt(request, "distance", assemblyGraph->m_settings->nodeDistance, &distance))
+        return makeError("the distance must be a non-negative integer");
+
+    std::vector<DeBruijnNode *> startingNodes = assemblyGraph->getNodesFromString(request["nodes"].toString(),
+                                                                                  request["exact"].toBool(true));
+    if (startingNodes.empty())
+        return makeError("no nodes were found");
+
+    assemblyGraph->clearOgdfGraphAndResetNodes();
+    assemblyGraph->markNodesAroundStartingNodesAsDrawn(startingNodes, distance);
+
+    QJsonObject response;
+    response["nodes"] = assemblyGraph->getDrawnNodeCount();
+
+    QString output = request["output"].toString();
+    if (!output.isEmpty())
+    {
+        if (!assemblyGraph->saveVisibleGraphToGfa(output))
+            return makeError("could not save " + output);
+        response["output"] = output;
+        return response;
+    }
+
+    QTemporaryFile gfaFile;
+    if (!gfaFile.open() || !assemblyGraph->saveVisibleGraphToGfa(gfaFile.fileName()))
+        return makeError("could not save the subgraph");
+    QFile savedGfa(gfaFile.fileName());
+    if (!savedGfa.open(QIODevice::ReadOnly | QIODevice::Text))
+        return makeError("could not save the subgraph");
+    response["gfa"] = QString::fromUtf8(savedGfa.readAll());
+    return response;
+}
+
+
+QJsonObject GraphServer::getLatencyStats()
+{
+    QMutexLocker locker(&m_latencyMutex);
+
+    QJsonObject operations;
+    QMapIterator<QString, ServeLatency> i(m_latencies);
+    while (i.hasNext())
+    {
+        i.next();
+        const ServeLatency & latency = i.value();
+        QJsonObject stats;
+        stats["count"] = double(latency.count);
+        stats["errors"] = double(latency.errorCount);
+        stats["mean_ms"] = latency.totalMilliseconds / latency.count;
+        stats["max_ms"] = latency.maxMilliseconds;
+        stats["p50_ms"] = getPercentile(latency.recentMilliseconds, 0.5);
+        stats["p95_ms"] = getPercentile(latency.recentMilliseconds, 0.95);
+        stats["p99_ms"] = getPercentile(latency.recentMilliseconds, 0.99);
+        operations[i.key()] = stats;
+    }
+
+    QJsonObject response;
+    response["operations"] = operations;
+    response["threads"] = m_threadPool.maxThreadCount();
+    return response;
+}
+
+
+void GraphServer::recordLatency(QString operation, double milliseconds, bool success)
+{
+    if (operation.isEmpty())
+        operation = "invalid";
+
+    QMutexLocker locker(&m_latencyMutex);
+    ServeLatency & latency = m_latencies[operation];
+    ++latency.count;
+    if (!success)
+        ++latency.errorCount;
+    latency.totalMilliseconds += milliseconds;
+    latency.maxMilliseconds = std::max(latency.maxMilliseconds, milliseconds);
+
+    if (latency.recentMilliseconds.size() < latencySampleCount)
+        latency.recentMilliseconds.push_back(milliseconds);
+    else
+        latency.recentMilliseconds[latency.nextSample] = milliseconds;
+    latency.nextSample = (latency.nextSample + 1) % latencySampleCount;
+}
+
+
+
+int bandageServe(QStringList arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (checkForHelp(arguments))
+    {
+        printServeUsage(&out, false);
+        return 0;
+    }
+
+    if (checkForHelpAll(arguments))
+    {
+        printServeUsage(&out, true);
+        return 0;
+    }
+
+    if (arguments.size() < 2)
+    {
+        printServeUsage(&err, false);
+        return 1;
+    }
+
+    QString socketName = arguments.at(0);
+    arguments.pop_front();
+
+    QStringList graphFilenames;
+    while (!arguments.isEmpty() && !arguments.at(0).startsWith("--"))
+    {
+        graphFilenames << arguments.at(0);
+        arguments.pop_front();
+    }
+    if (graphFilenames.isEmpty())
+    {
+        outputText("Bandage error: at least one graph file is required", &err);
+        return 1;
+    }
+
+    QString error = checkForInvalidServeOptions(arguments);
+    if (error.length() > 0)
+    {
+        outputText("Bandage error: " + error, &err);
+        return 1;
+    }
+
+    int threads = QThread::idealThreadCount();
+    parseServeOptions(arguments, &threads);
+
+    GraphServer server(threads);
+    for (int i = 0; i < graphFilenames.size(); ++i)
+    {
+        if (!server.addGraph(graphFilenames[i], &error))
+        {
+            outputText("Bandage error: " + error, &err);
+            return 1;
+        }
+    }
+
+    if (!server.listen(socketName, &error))
+    {
+        outputText("Bandage error: " + error, &err);
+        return 1;
+    }
+
+    QObject::connect(&server, SIGNAL(shutdownRequested()), qApp, SLOT(quit()));
+    err << "Bandage serve: " << server.getGraphCount() << " graph(s) loaded, listening on " << socketName << Qt::endl;
+    return QApplication::exec();
+}
+
+
+
+void printServeUsage(QTextStream * out, bool all)
+{
+    QStringList text;
+
+    text << "Bandage serve loads graphs once and answers requests about them over a local socket, so other tools can ask many questions without reloading the graph each time.";
+    text << "";
+    text << "Requests and responses are JSON objects, one per line. Each request has an \"op\" and, if more than one graph is loaded, a \"graph\" (the graph file's name without its extension). A request's \"id\", if given, is included in its response. Requests are answered in parallel, so responses may arrive in a different order than their requests. Each response has \"ok\", an \"error\" if it failed, and \"ms\", the time taken to answer it.";
+    text << "";
+    text << "Operations:";
+    text << "graphs: list the loaded graphs";
+    text << "node: sequences of \"nodes\" (a comma-delimited list, as for --nodes)";
+    text << "neighbourhood: nodes within \"distance\" edges of \"nodes\"";
+    text << "path: sequence of a \"path\" (e.g. \"1+, 2-\") or a GAF walk \"gaf\" (e.g. \">1<2\")";
+    text << "find: matches of a \"sequence\" in the graph, which can span nodes (at most \"max_hits\", with up to \"mismatches\" mismatches)";
+    text << "subgraph: GFA of the nodes within \"distance\" edges of \"nodes\", saved to \"output\" or returned";
+    text << "stats: request counts and latencies for each operation";
+    text << "shutdown: stop the server";
+    text << "";
+    text << "Usage:    Bandage serve <socket> <graphs> [options]";
+    text << "";
+    text << "Positional parameters:";
+    text << "<socket>            Name or path of the local socket to listen on";
+    text << "<graphs>            One or more graph files (any format that Bandage can load)";
+    text << "";
+    text << "Options:  --threads <int>     Number of requests answered at once " + getRangeAndDefault(1, 1024, QThread::idealThreadCount());
+    text << "";
+
+    getCommonHelp(&text);
+    if (all)
+        getSettingsUsage(&text);
+    else
+    {
+        int nextLineIndex = text.size();
+        getGraphScopeOptions(&text);
+        text[nextLineIndex] = "Settings: " + text[nextLineIndex];
+    }
+    text << "";
+    getOnlineHelpMessage(&text);
+
+    outputText(text, out);
+}
+
+
+
+QString checkForInvalidServeOptions(QStringList arguments)
+{
+    if (isOptionPresent("--query", &arguments))
+        return "Bandage serve does not support BLAST queries";
+
+    QString error = checkOptionForInt("--threads", &arguments, IntSetting(1, 1, 1024), false);
+    if (error.length() > 0) return error;
+
+    return checkForInvalidOrExcessSettings(&arguments);
+}
+
+
+
+//This function parses the command line options.  It assumes that the options
+//have already been checked for correctness.
+void parseServeOptions(QStringList arguments, int * threads)
+{
+    if (isOptionPresent("--threads", &arguments))
+        *threads = getIntOption("--threads", &arguments);
+
+    parseSettings(arguments);
+}
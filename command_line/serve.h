@@ -0,0 +1,110 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SERVE_H
+#define SERVE_H
+
+#include <QObject>
+#include <QStringList>
+#include <QString>
+#include <QTextStream>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <vector>
+
+class AssemblyGraph;
+class QLocalServer;
+
+int bandageServe(QStringList arguments);
+void printServeUsage(QTextStream * out, bool all);
+QString checkForInvalidServeOptions(QStringList arguments);
+void parseServeOptions(QStringList arguments, int * threads);
+
+//A graph loaded by the server.  Requests which only read the graph share its
+//lock, while subgraph requests (which change which nodes are drawn) hold it
+//on their own.
+struct ServedGraph
+{
+    QString name;
+    QString filename;
+    QSharedPointer<AssemblyGraph> assemblyGraph;
+    QSharedPointer<QReadWriteLock> lock;
+};
+
+//Latency figures for one type of request.  Only the most recent latencies are
+//kept for the percentiles, so a long-running server doesn't grow.
+struct ServeLatency
+{
+    ServeLatency() : count(0), errorCount(0), totalMilliseconds(0.0),
+        maxMilliseconds(0.0), nextSample(0) {}
+    long long count;
+    long long errorCount;
+    double totalMilliseconds;
+    double maxMilliseconds;
+    std::vector<double> recentMilliseconds;
+    size_t nextSample;
+};
+
+//This class answers JSON-lines requests about one or more loaded graphs.
+//Connections are handled in the main thread, but each request is answered in
+//a thread pool, so requests (from one or many clients) run concurrently and
+//their responses can arrive out of order.  Responses echo the request's "id".
+class GraphServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GraphServer(int threads, QObject * parent = 0);
+    ~GraphServer();
+
+    bool addGraph(QString filename, QString * error);
+    bool listen(QString socketName, QString * error);
+    QByteArray handleRequestLine(QByteArray requestLine, bool * shutdown = 0);
+    int getGraphCount() const {return int(m_graphs.size());}
+
+private:
+    QLocalServer * m_server;
+    QThreadPool m_threadPool;
+    std::vector<ServedGraph> m_graphs;
+    QMutex m_latencyMutex;
+    QMap<QString, ServeLatency> m_latencies;
+
+    QJsonObject handleRequest(const QJsonObject & request, QString operation);
+    const ServedGraph * findGraph(const QJsonObject & request, QString * error) const;
+    QJsonObject getGraphList() const;
+    QJsonObject getNodes(const ServedGraph * graph, const QJsonObject & request);
+    QJsonObject getNeighbourhood(const ServedGraph * graph, const QJsonObject & request);
+    QJsonObject getPath(const ServedGraph * graph, const QJsonObject & request);
+    QJsonObject findSequence(const ServedGraph * graph, const QJsonObject & request);
+    QJsonObject getSubgraph(const ServedGraph * graph, const QJsonObject & request);
+    QJsonObject getLatencyStats();
+    void recordLatency(QString operation, double milliseconds, bool success);
+
+private slots:
+    void acceptConnections();
+    void readRequests();
+
+signals:
+    void shutdownRequested();
+};
+
+#endif // SERVE_H
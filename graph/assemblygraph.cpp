@@ -31,6 +31,7 @@
 #include "../graph/graphicsitemedge.h"
 #include "../blast/blastsearch.h"
 #include "../ogdf/energybased/FMMMLayout.h"
+#include "../ogdf/basic/simple_graph_alg.h"
 #include "../program/graphlayoutworker.h"
 #include "../program/memory.h"
 #include "path.h"
@@ -40,15 +41,27 @@
 #include <QQueue>
 #include <QList>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <QLineF>
 #include <QFileInfo>
 #include <QDir>
 #include <QRegularExpression>
 #include "ogdfnode.h"
+#include "unitigcompactor.h"
+#include "graphwriter.h"
+#include "../program/parallel.h"
+#include "../program/gafcoverage.h"
 #include "../command_line/commoncommandlinefunctions.h"
 
-AssemblyGraph::AssemblyGraph() :
-    m_kmer(0), m_contiguitySearchDone(false),
-    m_sequencesLoadedFromFasta(NOT_READY)
+AssemblyGraph::AssemblyGraph(QSharedPointer<Settings> settings) :
+    m_settings(settings), m_kmer(0), m_contiguitySearchDone(false),
+    m_sequencesLoadedFromFasta(NOT_READY), m_modificationCount(1),
+    m_indexedNodesModificationCount(0), m_graphStatisticsModificationCount(0),
+    m_nodeNameIndexModificationCount(0), m_sequenceIndexModificationCount(0),
+    m_ogdfGraphModificationCount(0), m_ogdfGraphNodeDistance(0),
+    m_loadCancelled(false), m_loadProgressLineCount(0), m_loadBytesRead(0), m_loadTotalBytes(0),
+    m_depthSource(GRAPH_DEPTH)
 {
     m_ogdfGraph = new ogdf::Graph();
     m_edgeArray = new ogdf::EdgeArray<double>(*m_ogdfGraph);
@@ -85,7 +98,192 @@ void AssemblyGraph::cleanUp()
 
     m_contiguitySearchDone = false;
 
+    m_gafCoverage.reset();
+    m_depthSource = GRAPH_DEPTH;
+    m_graphDepths.clear();
+    m_csvTable.clear();
+
     clearGraphInfo();
+    markModified();
+}
+
+
+
+//This function returns all of the graph's nodes in a vector, with each
+//node's ID set to its index.  This allows per-node data to be stored in
+//plain arrays and lets the nodes be processed in parallel.  The vector is
+//only rebuilt if the graph has been modified since it was last made.
+const std::vector<DeBruijnNode *> & AssemblyGraph::getIndexedNodes() const
+{
+    if (m_indexedNodesModificationCount == m_modificationCount)
+        return m_indexedNodes;
+
+    m_indexedNodes.clear();
+    m_indexedNodes.reserve(m_deBruijnGraphNodes.size());
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        node->setId(int(m_indexedNodes.size()));
+        m_indexedNodes.push_back(node);
+    }
+
+    m_indexedNodesModificationCount = m_modificationCount;
+    return m_indexedNodes;
+}
+
+
+
+//This function does a breadth-first search outwards from the starting nodes
+//(following edges in either direction) and returns each node's distance from
+//the nearest starting node, indexed by node ID.  Nodes further away than
+//maxDistance have a distance of -1.  When a frontier is large, its nodes'
+//neighbours are gathered in parallel and then merged on this thread, so the
+//result is the same either way.
+std::vector<int> AssemblyGraph::getNodeDistances(const std::vector<DeBruijnNode *> & startingNodes,
+                                                 int maxDistance) const
+{
+    const std::vector<DeBruijnNode *> & nodes = getIndexedNodes();
+    std::vector<int> distances(nodes.size(), -1);
+
+    std::vector<int> frontier;
+    for (size_t i = 0; i < startingNodes.size(); ++i)
+    {
+        int id = startingNodes[i]->getId();
+        if (distances[id] == -1)
+        {
+            distances[id] = 0;
+            frontier.push_back(id);
+        }
+    }
+
+    std::vector<int> nextFrontier;
+    for (int distance = 1; distance <= maxDistance && !frontier.empty(); ++distance)
+    {
+        nextFrontier.clear();
+        int chunkCount = getParallelThreadCount(frontier.size(), 5000);
+        if (chunkCount == 1)
+        {
+            for (size_t i = 0; i < frontier.size(); ++i)
+            {
+                const std::vector<DeBruijnEdge *> * edges = nodes[frontier[i]]->getEdgesPointer();
+                for (size_t j = 0; j < edges->size(); ++j)
+                {
+                    int otherId = (*edges)[j]->getOtherNode(nodes[frontier[i]])->getId();
+                    if (distances[otherId] == -1)
+                    {
+                        distances[otherId] = distance;
+                        nextFrontier.push_back(otherId);
+                    }
+                }
+            }
+        }
+        else
+        {
+            //The distances are only read while the threads run, so each
+            //thread's candidates may contain nodes also found by another.
+            std::vector<std::vector<int> > candidates(chunkCount);
+            parallelForChunks(frontier.size(), [&](int chunk, long long begin, long long end)
+            {
+                for (long long i = begin; i < end; ++i)
+                {
+                    const std::vector<DeBruijnEdge *> * edges = nodes[frontier[i]]->getEdgesPointer();
+                    for (size_t j = 0; j < edges->size(); ++j)
+                    {
+                        int otherId = (*edges)[j]->getOtherNode(nodes[frontier[i]])->getId();
+                        if (distances[otherId] == -1)
+                            candidates[chunk].push_back(otherId);
+                    }
+                }
+            }, 5000);
+
+            for (int chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                for (size_t i = 0; i < candidates[chunk].size(); ++i)
+                {
+                    int otherId = candidates[chunk][i];
+                    if (distances[otherId] == -1)
+                    {
+                        distances[otherId] = distance;
+                        nextFrontier.push_back(otherId);
+                    }
+                }
+            }
+        }
+        frontier.swap(nextFrontier);
+    }
+
+    return distances;
+}
+
+
+//This function marks every node within nodeDistance of the starting nodes as
+//drawn.  In single mode, the search starts from the positive version of each
+//starting node and the positive version of each node found is drawn.
+void AssemblyGraph::markNodesAroundStartingNodesAsDrawn(std::vector<DeBruijnNode *> startingNodes,
+                                                        int nodeDistance)
+{
+    for (size_t i = 0; i < startingNodes.size(); ++i)
+    {
+        if (!m_settings->doubleMode && startingNodes[i]->isNegativeNode())
+            startingNodes[i] = startingNodes[i]->getReverseComplement();
+    }
+
+    const std::vector<DeBruijnNode *> & nodes = getIndexedNodes();
+    std::vector<int> distances = getNodeDistances(startingNodes, nodeDistance);
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (distances[i] == -1)
+            continue;
+        DeBruijnNode * node = nodes[i];
+        if (!m_settings->doubleMode && node->isNegativeNode())
+            node = node->getReverseComplement();
+        node->setAsDrawn();
+    }
+}
+
+
+
+//This function returns the statistics shown by Bandage info and the graph
+//information dialog.  They are calculated together and kept until the graph
+//is next modified.
+const GraphStatistics & AssemblyGraph::getGraphStatistics() const
+{
+    if (m_graphStatisticsModificationCount != m_modificationCount)
+    {
+        m_graphStatistics.calculate(getIndexedNodes());
+        m_graphStatisticsModificationCount = m_modificationCount;
+    }
+    return m_graphStatistics;
+}
+
+
+//This function returns the index used for partial node name searches.  It is
+//made the first time it is needed and kept until the graph is next modified
+//(e.g. by renaming or merging nodes).
+const NodeNameIndex & AssemblyGraph::getNodeNameIndex() const
+{
+    if (m_nodeNameIndexModificationCount != m_modificationCount)
+    {
+        m_nodeNameIndex.build(getIndexedNodes());
+        m_nodeNameIndexModificationCount = m_modificationCount;
+    }
+    return m_nodeNameIndex;
+}
+
+
+//This function returns the k-mer index used to find sequences in the graph.
+//Like the node name index, it is made the first time it is needed and kept
+//until the graph is next modified.
+const SequenceIndex & AssemblyGraph::getSequenceIndex() const
+{
+    if (m_sequenceIndexModificationCount != m_modificationCount)
+    {
+        m_sequenceIndex.build(getIndexedNodes());
+        m_sequenceIndexModificationCount = m_modificationCount;
+    }
+    return m_sequenceIndex;
 }
 
 
@@ -150,6 +348,8 @@ void AssemblyGraph::createDeBruijnEdge(QString node1Name, QString node2Name,
     node2->addEdge(forwardEdge);
     negNode1->addEdge(backwardEdge);
     negNode2->addEdge(backwardEdge);
+
+    markModified();
 }
 
 
@@ -166,6 +366,9 @@ void AssemblyGraph::clearOgdfGraphAndResetNodes()
 
     m_ogdfGraph->clear();
     m_edgeArray->init(*m_ogdfGraph);
+
+    m_ogdfGraphModificationCount = 0;
+    m_pinnedOgdfPositions.clear();
 }
 
 
@@ -354,6 +557,8 @@ void AssemblyGraph::clearAllBlastHitPointers()
 
 void AssemblyGraph::determineGraphInfo()
 {
+    markModified();
+
     m_shortestContig = std::numeric_limits<long long>::max();
     m_longestContig = 0;
     int nodeCount = 0;
@@ -398,52 +603,26 @@ void AssemblyGraph::determineGraphInfo()
     m_totalLength = totalLength;
     m_meanDepth = getMeanDepth();
 
-    std::sort(nodeDepths.begin(), nodeDepths.end());
-
     double firstQuartileIndex = (nodeDepths.size() - 1) / 4.0;
     double medianIndex = (nodeDepths.size() - 1) / 2.0;
     double thirdQuartileIndex = (nodeDepths.size() - 1) * 3.0 / 4.0;
 
-    m_firstQuartileDepth = getValueUsingFractionalIndex(&nodeDepths, firstQuartileIndex);
-    m_medianDepth = getValueUsingFractionalIndex(&nodeDepths, medianIndex);
-    m_thirdQuartileDepth = getValueUsingFractionalIndex(&nodeDepths, thirdQuartileIndex);
+    m_firstQuartileDepth = GraphStatistics::getValueUsingFractionalIndex(&nodeDepths, firstQuartileIndex);
+    m_medianDepth = GraphStatistics::getValueUsingFractionalIndex(&nodeDepths, medianIndex);
+    m_thirdQuartileDepth = GraphStatistics::getValueUsingFractionalIndex(&nodeDepths, thirdQuartileIndex);
 
     //Set the auto node length setting. This is determined by aiming for a
     //target average node length. But if the graph is small, the value will be
     //increased (to avoid having an overly small and simple graph layout).
-    double targetDrawnGraphLength = std::max(m_nodeCount * g_settings->meanNodeLength,
-                                             g_settings->minTotalGraphLength);
+    double targetDrawnGraphLength = std::max(m_nodeCount * m_settings->meanNodeLength,
+                                             m_settings->minTotalGraphLength);
     double megabases = totalLength / 1000000.0;
     if (megabases > 0.0)
-        g_settings->autoNodeLengthPerMegabase = targetDrawnGraphLength / megabases;
+        m_settings->autoNodeLengthPerMegabase = targetDrawnGraphLength / megabases;
     else
-        g_settings->autoNodeLengthPerMegabase = 10000.0;
-}
-
-template<typename T> double AssemblyGraph::getValueUsingFractionalIndex(std::vector<T> * v, double index) const
-{
-    if (v->size() == 0)
-        return 0.0;
-    if (v->size() == 1)
-        return double((*v)[0]);
-
-    int wholePart = floor(index);
-
-    if (wholePart < 0)
-        return double((*v)[0]);
-    if (wholePart >= int(v->size()) - 1)
-        return double((*v)[v->size() - 1]);
-
-    double fractionalPart = index - wholePart;
-
-    double piece1 = double((*v)[wholePart]);
-    double piece2 = double((*v)[wholePart+1]);
-
-    return piece1 * (1.0 - fractionalPart) + piece2 * fractionalPart;
+        m_settings->autoNodeLengthPerMegabase = 10000.0;
 }
 
-
-
 void AssemblyGraph::clearGraphInfo()
 {
     m_totalLength = 0;
@@ -474,7 +653,7 @@ void AssemblyGraph::buildDeBruijnGraphFromLastGraph(QString fullFileName)
         QTextStream in(&inputFile);
         while (!in.atEnd())
         {
-            QApplication::processEvents();
+            reportLoadProgress(&inputFile);
             QString line = in.readLine();
 
             if (firstLine)
@@ -507,8 +686,8 @@ void AssemblyGraph::buildDeBruijnGraphFromLastGraph(QString fullFileName)
                 QByteArray sequence = in.readLine().toLocal8Bit();
                 QByteArray revCompSequence = in.readLine().toLocal8Bit();
 
-                DeBruijnNode * node = new DeBruijnNode(posNodeName, nodeDepth, sequence);
-                DeBruijnNode * reverseComplementNode = new DeBruijnNode(negNodeName, nodeDepth, revCompSequence);
+                DeBruijnNode * node = new DeBruijnNode(this, posNodeName, nodeDepth, sequence);
+                DeBruijnNode * reverseComplementNode = new DeBruijnNode(this, negNodeName, nodeDepth, revCompSequence);
                 node->setReverseComplement(reverseComplementNode);
                 reverseComplementNode->setReverseComplement(node);
                 m_deBruijnGraphNodes.insert(posNodeName, node);
@@ -561,8 +740,14 @@ QString AssemblyGraph::convertNormalNumberStringToBandageNodeName(QString number
 //This function loads a graph from a GFA file.  It reports whether or not it
 //encountered an unsupported CIGAR string, whether the GFA has custom labels
 //and whether it has custom colours.
+//Bandage options in the GFA header are applied to this graph's own settings
+//straight away, unless bandageOptionsToApply is given.  Then they are returned
+//for the caller to apply once the graph has replaced the current one.  The
+//global settings are never changed here, as the graph may be loading in a
+//different thread.
 void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupportedCigar,
-                                              bool *customLabels, bool *customColours, QString *bandageOptionsError)
+                                              bool *customLabels, bool *customColours, QString *bandageOptionsError,
+                                              QStringList * bandageOptionsToApply)
 {
     m_graphFileType = GFA;
     m_filename = fullFileName;
@@ -583,7 +768,7 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
 
         QTextStream in(&inputFile);
         while (!in.atEnd()) {
-            QApplication::processEvents();
+            reportLoadProgress(&inputFile);
             QString line = in.readLine();
 
             QStringList lineParts = line.split(QRegularExpression("\t"));
@@ -605,8 +790,12 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
                     QStringList bandageOptions = bandageOptionsString.split(' ', Qt::SkipEmptyParts);
                     QStringList bandageOptionsCopy = bandageOptions;
                     *bandageOptionsError = checkForInvalidOrExcessSettings(&bandageOptionsCopy);
-                    if (bandageOptionsError->length() == 0)
-                        parseSettings(bandageOptions);
+                    if (bandageOptionsError->length() > 0)
+                        continue;
+                    if (bandageOptionsToApply != 0)
+                        *bandageOptionsToApply += bandageOptions;
+                    else
+                        parseSettings(bandageOptions, m_settings.data());
                 }
             }
 
@@ -743,7 +932,7 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
                     labels.insert(getOppositeNodeName(nodeName), l2);
                 }
 
-                DeBruijnNode * node = new DeBruijnNode(nodeName, nodeDepth, sequence, length);
+                DeBruijnNode * node = new DeBruijnNode(this, nodeName, nodeDepth, sequence, length);
                 if (rdFound)
                     node->setReadSupportCount(rd);
                 m_deBruijnGraphNodes.insert(nodeName, node);
@@ -838,7 +1027,7 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
 
             QTextStream in(&readToTigFile);
             while (!in.atEnd()) {
-                QApplication::processEvents();
+                reportLoadProgress(&readToTigFile);
                 QString line = in.readLine();
                 QStringList lineParts = line.split(QRegularExpression("\t"));
                 if (lineParts.length() >= 5) {
@@ -950,7 +1139,7 @@ void AssemblyGraph::buildDeBruijnGraphFromFastg(QString fullFileName)
         QTextStream in(&inputFile);
         while (!in.atEnd())
         {
-            QApplication::processEvents();
+            reportLoadProgress(&inputFile);
 
             QString nodeName;
             double nodeDepth;
@@ -992,7 +1181,7 @@ void AssemblyGraph::buildDeBruijnGraphFromFastg(QString fullFileName)
                 nodeDepth = nodeDepthString.toDouble();
 
                 //Make the node
-                node = new DeBruijnNode(nodeName, nodeDepth, ""); //Sequence string is currently empty - will be added to on subsequent lines of the fastg file
+                node = new DeBruijnNode(this, nodeName, nodeDepth, ""); //Sequence string is currently empty - will be added to on subsequent lines of the fastg file
                 m_deBruijnGraphNodes.insert(nodeName, node);
 
                 //The second part of nodeDetails is a comma-delimited list of edge nodes.
@@ -1083,7 +1272,7 @@ void AssemblyGraph::makeReverseComplementNodeIfNecessary(DeBruijnNode * node)
             nodeSequence = "*";
         else
             nodeSequence = node->getSequence();
-        DeBruijnNode * newNode = new DeBruijnNode(reverseComplementName, node->getDepth(),
+        DeBruijnNode * newNode = new DeBruijnNode(this, reverseComplementName, node->getDepth(),
                                                   getReverseComplement(nodeSequence),
                                                   node->getLength());
         newNode->setReadSupportCount(node->getReadSupportCount());
@@ -1123,14 +1312,14 @@ void AssemblyGraph::buildDeBruijnGraphFromTrinityFasta(QString fullFileName)
 
     std::vector<QString> names;
     std::vector<QByteArray> sequences;
-    readFastaFile(fullFileName, &names, &sequences);
+    readFastaFile(fullFileName, &names, &sequences, this);
 
     std::vector<QString> edgeStartingNodeNames;
     std::vector<QString> edgeEndingNodeNames;
 
     for (size_t i = 0; i < names.size(); ++i)
     {
-        QApplication::processEvents();
+        reportLoadProgress();
 
         QString name = names[i];
         QByteArray sequence = sequences[i];
@@ -1208,7 +1397,7 @@ void AssemblyGraph::buildDeBruijnGraphFromTrinityFasta(QString fullFileName)
                 int nodeLength = nodeRangeEnd - nodeRangeStart + 1;
 
                 QByteArray nodeSequence = sequence.mid(nodeRangeStart, nodeLength);
-                DeBruijnNode * node = new DeBruijnNode(nodeName, 1.0, nodeSequence);
+                DeBruijnNode * node = new DeBruijnNode(this, nodeName, 1.0, nodeSequence);
                 m_deBruijnGraphNodes.insert(nodeName, node);
             }
 
@@ -1273,7 +1462,7 @@ int AssemblyGraph::buildDeBruijnGraphFromAsqg(QString fullFileName)
         QTextStream in(&inputFile);
         while (!in.atEnd())
         {
-            QApplication::processEvents();
+            reportLoadProgress(&inputFile);
             QString line = in.readLine();
 
             QStringList lineParts = line.split(QRegularExpression("\t"));
@@ -1299,7 +1488,7 @@ int AssemblyGraph::buildDeBruijnGraphFromAsqg(QString fullFileName)
                 //ASQG files don't seem to include depth, so just set this to one for every node.
                 double nodeDepth = 1.0;
 
-                DeBruijnNode * node = new DeBruijnNode(nodeName, nodeDepth, sequence, length);
+                DeBruijnNode * node = new DeBruijnNode(this, nodeName, nodeDepth, sequence, length);
                 m_deBruijnGraphNodes.insert(nodeName, node);
             }
 
@@ -1403,12 +1592,12 @@ void AssemblyGraph::buildDeBruijnGraphFromPlainFasta(QString fullFileName)
 
     std::vector<QString> names;
     std::vector<QByteArray> sequences;
-    readFastaFile(fullFileName, &names, &sequences);
+    readFastaFile(fullFileName, &names, &sequences, this);
 
     std::vector<QString> circularNodeNames;
     for (size_t i = 0; i < names.size(); ++i)
     {
-        QApplication::processEvents();
+        reportLoadProgress();
 
         QString name = names[i];
         QString lowerName = name.toLower();
@@ -1466,7 +1655,7 @@ void AssemblyGraph::buildDeBruijnGraphFromPlainFasta(QString fullFileName)
         if (name.length() < 1)
             throw "load error";
 
-        DeBruijnNode * node = new DeBruijnNode(name, depth, sequence);
+        DeBruijnNode * node = new DeBruijnNode(this, name, depth, sequence);
         m_deBruijnGraphNodes.insert(name, node);
         makeReverseComplementNodeIfNecessary(node);
     }
@@ -1579,19 +1768,14 @@ bool AssemblyGraph::checkFirstLineOfFile(QString fullFileName, QString regExp)
  */
 QStringList AssemblyGraph::splitCsv(QString line, QString sep)
 {
-    QRegularExpression rx(R"(("(?:[^"]|"")*"|[^)" + sep + "]*)");
-    QStringList list;
-
-    auto it = rx.globalMatch(line);
-    while (it.hasNext()) {
-        auto match = it.next();
-        QString field = match.captured().replace("\"\"", "\"");
-        if (field.length() >= 2 && field[0] == '"' && field[field.length() - 1] == '"') {
-            field = field.mid(1, field.length() - 2);
-        }
-        list << field;
-    }
+    QByteArray bytes = line.toUtf8();
+    char separator = sep.isEmpty() ? ',' : sep.at(0).toLatin1();
+    std::vector<QByteArray> fields;
+    CsvTable::splitLine(bytes.constData(), bytes.constData() + bytes.size(), separator, &fields);
 
+    QStringList list;
+    for (size_t i = 0; i < fields.size(); ++i)
+        list << QString::fromUtf8(fields[i]);
     return list;
 }
 
@@ -1606,6 +1790,8 @@ QStringList AssemblyGraph::splitCsv(QString line, QString sep)
  */
 bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * errormsg, bool * coloursLoaded)
 {
+    //Nodes matched by an earlier CSV lose their rows first, as those rows
+    //would otherwise point into this file's table.
     clearAllCsvData();
 
     QFile inputFile(filename);
@@ -1614,8 +1800,12 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
         *errormsg = "Unable to read from specified file.";
         return false;
     }
-    QTextStream in(&inputFile);
-    QString line = in.readLine();
+    QByteArray headerLine = inputFile.readLine();
+    if (headerLine.startsWith("\xEF\xBB\xBF"))
+        headerLine.remove(0, 3);
+    while (headerLine.endsWith('\n') || headerLine.endsWith('\r'))
+        headerLine.chop(1);
+    QString line = QString::fromUtf8(headerLine);
 
     // guess at separator; this assumes that any tab in the first line means
     // we have a tab separated file
@@ -1630,8 +1820,6 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
         }
     }
 
-    int unmatched_nodes = 0; // keep a counter for lines in file that can't be matched to nodes
-
     QStringList headers = splitCsv(line, sep);
     if (headers.size() < 2)
     {
@@ -1675,61 +1863,119 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
 
     *columns = filteredHeaders;
     int columnCount = filteredHeaders.size();
-    QMap<QString, QColor> colourCategories;
-    std::vector<QColor> presetColours = getPresetColours();
-
-    while (!in.atEnd())
+    char separator = sep.at(0).toLatin1();
+    m_csvTable.setHeaders(filteredHeaders);
+
+    //The rest of the file is read in large blocks of whole lines.  The lines
+    //of a block are split and matched to nodes in parallel, and then the
+    //block's values are added to the table.  Every line gets a row, even if
+    //it doesn't match a node, and the matching is applied to the nodes at the
+    //end.
+    const qint64 blockSize = 16 * 1024 * 1024;
+    std::vector<DeBruijnNode *> rowNodes;
+    QByteArray leftover;
+    while (true)
     {
         QApplication::processEvents();
 
-        QStringList cols = splitCsv(in.readLine(), sep);
-        if (cols.isEmpty())
-            continue;
-        QString nodeName = getNodeNameFromString(cols[0]);
-
-        //Get rid of the node name - no need to save that.
-        cols.pop_front();
+        QByteArray block = inputFile.read(blockSize);
+        bool lastBlock = block.isEmpty() || inputFile.atEnd();
+        block.prepend(leftover);
+        leftover.clear();
+        if (!lastBlock)
+        {
+            int lastNewline = block.lastIndexOf('\n');
+            if (lastNewline < 0)
+            {
+                leftover = block;
+                continue;
+            }
+            leftover = block.mid(lastNewline + 1);
+            block.truncate(lastNewline + 1);
+        }
 
-        QStringList filteredCols;
-        filteredCols.reserve(columnCount);
-        for (int i = 0; i < headerIndices.size(); ++i)
+        const char * data = block.constData();
+        int blockLength = block.size();
+        std::vector<int> lineStarts;
+        std::vector<int> lineEnds;
+        int start = 0;
+        while (start < blockLength)
         {
-            int index = headerIndices[i];
-            if (index < cols.size())
-                filteredCols.push_back(cols[index]);
-            else
-                filteredCols.push_back("");
+            const char * newline = (const char *)memchr(data + start, '\n', blockLength - start);
+            int end = (newline != 0) ? int(newline - data) : blockLength;
+            lineStarts.push_back(start);
+            lineEnds.push_back((end > start && data[end - 1] == '\r') ? end - 1 : end);
+            start = end + 1;
         }
 
-        //If one of the columns holds colour data, get the colour from that one.
-        //Acceptable colour formats: 6-digit hex colour (e.g. #FFB6C1), an 8-digit hex colour (e.g. #7FD2B48C) or a
-        //standard colour name (e.g. skyblue).
-        //If the colour value is something other than one of these, a colour will be assigned to the value.  That way
-        //categorical names can be used and automatically given colours.
-        QColor colour;
-        if (colourCol != -1 && filteredCols.size() > colourCol)
+        int lineCount = int(lineStarts.size());
+        std::vector<QByteArray> values(size_t(lineCount) * columnCount);
+        std::vector<DeBruijnNode *> lineNodes(lineCount, 0);
+        parallelForChunks(lineCount, [&](int, long long begin, long long end)
         {
-            QString colourString = filteredCols[colourCol];
-            colour = QColor(colourString);
-            if (!colour.isValid())
+            std::vector<QByteArray> fields;
+            for (long long i = begin; i < end; ++i)
             {
-                if (!colourCategories.contains(colourString))
+                CsvTable::splitLine(data + lineStarts[i], data + lineEnds[i], separator, &fields);
+
+                //The first column is the node name - no need to save that.
+                //Finding the node only reads the node map, so it is safe to
+                //do on several threads at once.
+                QString nodeName = getNodeNameFromString(QString::fromUtf8(fields[0]));
+                if (nodeName != "")
+                    lineNodes[i] = m_deBruijnGraphNodes.value(nodeName, 0);
+
+                for (int j = 0; j < columnCount; ++j)
                 {
-                    int nextColourIndex = colourCategories.size();
-                    colourCategories[colourString] = presetColours[nextColourIndex];
+                    int index = headerIndices[j] + 1;
+                    if (index < int(fields.size()))
+                        values[i * columnCount + j] = fields[index];
                 }
-                colour = colourCategories[colourString];
             }
-        }
+        }, 1000);
+
+        m_csvTable.addRows(values, lineCount);
+        rowNodes.insert(rowNodes.end(), lineNodes.begin(), lineNodes.end());
 
-        if (nodeName != "" && m_deBruijnGraphNodes.contains(nodeName))
+        if (lastBlock)
+            break;
+    }
+    m_csvTable.finishLoading();
+
+    //If one of the columns holds colour data, get the colour from that one.
+    //Acceptable colour formats: 6-digit hex colour (e.g. #FFB6C1), an 8-digit hex colour (e.g. #7FD2B48C) or a
+    //standard colour name (e.g. skyblue).
+    //If the colour value is something other than one of these, a colour will be assigned to the value.  That way
+    //categorical names can be used and automatically given colours.
+    //The colour is worked out once for each distinct value, in the order the
+    //values first appear.
+    std::vector<QColor> valueColours;
+    if (colourCol != -1)
+    {
+        std::vector<QColor> presetColours = getPresetColours();
+        const std::vector<QString> & colourStrings = m_csvTable.getDistinctValues(colourCol);
+        int categoryCount = 0;
+        for (size_t i = 0; i < colourStrings.size(); ++i)
         {
-            m_deBruijnGraphNodes[nodeName]->setCsvData(filteredCols);
-            if (colour.isValid())
-                m_deBruijnGraphNodes[nodeName]->setCustomColour(colour);
+            QColor colour(colourStrings[i]);
+            if (!colour.isValid())
+                colour = presetColours[categoryCount++ % presetColours.size()];
+            valueColours.push_back(colour);
         }
-        else
+    }
+
+    int unmatched_nodes = 0; // keep a counter for lines in file that can't be matched to nodes
+    for (size_t i = 0; i < rowNodes.size(); ++i)
+    {
+        DeBruijnNode * node = rowNodes[i];
+        if (node == 0)
+        {
             ++unmatched_nodes;
+            continue;
+        }
+        node->setCsvRow(int(i));
+        if (colourCol != -1)
+            node->setCustomColour(valueColours[m_csvTable.getValueId(int(i), colourCol)]);
     }
 
     if (unmatched_nodes)
@@ -1832,17 +2078,50 @@ bool AssemblyGraph::loadGraphFromFile(QString filename)
     }
 
     determineGraphInfo();
-    g_memory->clearGraphSpecificMemory();
+
+    //The remembered paths and searches refer to nodes in the global graph, so
+    //they are only cleared when it is the global graph being loaded.
+    if (this == g_assemblyGraph.data())
+        g_memory->clearGraphSpecificMemory();
     return true;
 }
 
 
 
+//This function is called for each line read while loading a graph, so it does
+//nothing for most lines.  Every 1024th line, it stops the load (by throwing)
+//if the load has been cancelled and, if it has been long enough since the
+//last report, reports how much of the file has been read.  It can be called
+//without a file when the loader is working through sequences already read,
+//in which case the last amount read is reported again.
+void AssemblyGraph::reportLoadProgress(const QFile * file)
+{
+    if (++m_loadProgressLineCount % 1024 != 0)
+        return;
+
+    if (m_loadCancelled)
+        throw "load cancelled";
+
+    if (m_loadProgressTimer.isValid() && m_loadProgressTimer.elapsed() < 100)
+        return;
+    m_loadProgressTimer.start();
+
+    if (file != 0)
+    {
+        m_loadBytesRead = file->pos();
+        m_loadTotalBytes = file->size();
+    }
+    emit loadProgress(m_loadBytesRead, m_loadTotalBytes,
+                      m_deBruijnGraphNodes.size(), m_deBruijnGraphEdges.size());
+}
+
+
+
 //The startingNodes and nodeDistance parameters are only used if the graph scope
 //is not WHOLE_GRAPH.
 void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *> startingNodes, int nodeDistance)
 {
-    if (g_settings->graphScope == WHOLE_GRAPH)
+    if (m_settings->graphScope == WHOLE_GRAPH)
     {
         QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
         while (i.hasNext())
@@ -1851,7 +2130,7 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
 
             //If double mode is off, only positive nodes are drawn.  If it's
             //on, all nodes are drawn.
-            if (i.value()->isPositiveNode() || g_settings->doubleMode)
+            if (i.value()->isPositiveNode() || m_settings->doubleMode)
                 i.value()->setAsDrawn();
         }
     }
@@ -1859,7 +2138,7 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
     {
         //Distance is only used for around nodes and around blast scopes, not
         //for the depth range scope.
-        if (g_settings->graphScope == DEPTH_RANGE)
+        if (m_settings->graphScope == DEPTH_RANGE)
             nodeDistance = 0;
 
         for (size_t i = 0; i < startingNodes.size(); ++i)
@@ -1867,17 +2146,17 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
             DeBruijnNode * node = startingNodes[i];
 
             //If we are in single mode, make sure that each node is positive.
-            if (!g_settings->doubleMode && node->isNegativeNode())
+            if (!m_settings->doubleMode && node->isNegativeNode())
                 node = node->getReverseComplement();
 
             node->setAsDrawn();
             node->setAsSpecial();
-            node->labelNeighbouringNodesAsDrawn(nodeDistance, 0);
         }
+        markNodesAroundStartingNodesAsDrawn(startingNodes, nodeDistance);
     }
 
     // If performing a linear layout, we first sort the drawn nodes and add them left-to-right.
-    if (g_settings->linearLayout) {
+    if (m_settings->linearLayout) {
         QList<DeBruijnNode *> sortedDrawnNodes;
 
         // We first try to sort the nodes numerically.
@@ -1937,12 +2216,12 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
                 else
                     lastXPos = std::max(lastXPos, upstreamEndPos);
             }
-            double xPos = lastXPos + g_settings->edgeLength;
+            double xPos = lastXPos + m_settings->edgeLength;
             double yPos = 0.0;
             long long intXPos = (long long)(xPos * 100.0);
             long long intYPos = (long long)(yPos * 100.0);
             while (usedStartPositions.contains(QPair<long long, long long>(intXPos, intYPos))) {
-                yPos += g_settings->edgeLength;
+                yPos += m_settings->edgeLength;
                 intYPos = (long long)(yPos * 100.0);
             }
             node->addToOgdfGraph(m_ogdfGraph, m_graphAttributes, m_edgeArray, xPos, yPos);
@@ -1973,152 +2252,604 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
         if (edge->isDrawn())
             edge->addToOgdfGraph(m_ogdfGraph, m_edgeArray);
     }
+
+    recordOgdfGraphScope(startingNodes, nodeDistance);
 }
 
 
 
-void AssemblyGraph::addGraphicsItemsToScene(MyGraphicsScene * scene)
+//This function returns true if the OGDF graph can be expanded to the given
+//scope instead of being built again.  That is only possible if the graph has
+//not been modified since it was drawn, no setting that affects the layout has
+//changed, the starting nodes are the same and the node distance has grown.
+bool AssemblyGraph::canExpandOgdfGraph(std::vector<DeBruijnNode *> startingNodes, int nodeDistance) const
 {
-    scene->clear();
+    if (m_ogdfGraphModificationCount == 0 || m_ogdfGraphModificationCount != m_modificationCount)
+        return false;
+    if (m_settings->graphScope != AROUND_NODE && m_settings->graphScope != AROUND_BLAST_HITS)
+        return false;
+    if (useLinearLayout())
+        return false;
+    if (nodeDistance <= m_ogdfGraphNodeDistance)
+        return false;
+    if (getOgdfGraphLayoutSettings() != m_ogdfGraphLayoutSettings)
+        return false;
+    return getScopeStartingNodes(startingNodes) == m_ogdfGraphStartingNodes;
+}
 
-    double meanDrawnDepth = getMeanDepth(true);
 
-    //First make the GraphicsItemNode objects
+
+//This function adds the nodes and edges which come into scope with a larger
+//node distance to the existing OGDF graph.  The nodes which were already
+//drawn keep their current positions (including any changes the user made by
+//dragging them) and are pinned there, while the new nodes start next to the
+//drawn nodes they connect to.  The layout should then be run with the pinned
+//nodes fixed, so only the new nodes move, followed by
+//restorePinnedOgdfPositions.
+void AssemblyGraph::expandOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *> startingNodes, int nodeDistance)
+{
+    pinOgdfPositionsFromGraphicsItems();
+    markNodesAroundStartingNodesAsDrawn(startingNodes, nodeDistance);
+
+    std::vector<DeBruijnNode *> newNodes;
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
         DeBruijnNode * node = i.value();
-
-        if (node->isDrawn())
+        if (node->isDrawn() && node->thisOrReverseComplementNotInOgdf())
         {
-            if (meanDrawnDepth == 0)
-                node->setDepthRelativeToMeanDrawnDepth(1.0);
-            else
-                node->setDepthRelativeToMeanDrawnDepth(node->getDepth() / meanDrawnDepth);
-            GraphicsItemNode * graphicsItemNode = new GraphicsItemNode(node, m_graphAttributes);
-            node->setGraphicsItemNode(graphicsItemNode);
-            graphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
-            graphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
+            node->addToOgdfGraph(m_ogdfGraph, m_graphAttributes, m_edgeArray, 0.0, 0.0);
+            newNodes.push_back(node);
         }
     }
+    placeNewOgdfNodesNearNeighbours(newNodes);
 
-    resetAllNodeColours();
-
-    //Then make the GraphicsItemEdge objects and add them to the scene first
-    //so they are drawn underneath
+    //Edges which were already drawn are already in the OGDF graph, so only
+    //the others need to be checked.
     QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
     while (j.hasNext())
     {
         j.next();
         DeBruijnEdge * edge = j.value();
-
         if (edge->isDrawn())
-        {
-            GraphicsItemEdge * graphicsItemEdge = new GraphicsItemEdge(edge);
-            edge->setGraphicsItemEdge(graphicsItemEdge);
-            graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
-            scene->addItem(graphicsItemEdge);
-        }
+            continue;
+        edge->determineIfDrawn();
+        if (edge->isDrawn())
+            edge->addToOgdfGraph(m_ogdfGraph, m_edgeArray);
     }
 
-    //Now add the GraphicsItemNode objects to the scene so they are drawn
-    //on top
-    QMapIterator<QString, DeBruijnNode*> k(m_deBruijnGraphNodes);
-    while (k.hasNext())
-    {
-        k.next();
-        DeBruijnNode * node = k.value();
-        if (node->hasGraphicsItem())
-            scene->addItem(node->getGraphicsItemNode());
-    }
+    recordOgdfGraphScope(startingNodes, nodeDistance);
 }
 
 
 
-
-std::vector<DeBruijnNode *> AssemblyGraph::getStartingNodes(QString * errorTitle, QString * errorMessage, bool doubleMode,
-                                                            QString nodesList, QString blastQueryName)
+//If the pinned nodes were held fixed, the layout left them where they were.
+//But a linear layout runs FMMM over the whole graph, which will have moved,
+//scaled and perhaps rotated it.  This function puts each pinned node back
+//where it was and moves the new nodes with it: for each connected component,
+//the similarity transform that best maps the pinned nodes' laid out positions
+//back to their original positions is applied to the component's new nodes.
+void AssemblyGraph::restorePinnedOgdfPositions()
 {
-    std::vector<DeBruijnNode *> startingNodes;
+    if (m_pinnedOgdfPositions.empty())
+        return;
 
-    if (g_settings->graphScope == AROUND_NODE)
-    {
-        if (checkIfStringHasNodes(nodesList))
-        {
-            *errorTitle = "No starting nodes";
-            *errorMessage = "Please enter at least one node when drawing the graph using the 'Around node(s)' scope. "
-                            "Separate multiple nodes with commas.";
-            return startingNodes;
-        }
+    ogdf::NodeArray<int> component(*m_ogdfGraph);
+    int componentCount = ogdf::connectedComponents(*m_ogdfGraph, component);
 
-        //Make sure the nodes the user typed in are actually in the graph.
-        std::vector<QString> nodesNotInGraph;
-        std::vector<DeBruijnNode *> nodesInGraph = getNodesFromString(nodesList,
-                                                                      g_settings->startingNodesExactMatch,
-                                                                      &nodesNotInGraph);
-        if (nodesNotInGraph.size() > 0)
-        {
-            *errorTitle = "Nodes not found";
-            *errorMessage = generateNodesNotFoundErrorMessage(nodesNotInGraph, g_settings->startingNodesExactMatch);
-            if (nodesInGraph.size() == 0)
-                return startingNodes;
-        }
+    std::vector<int> pinnedCount(componentCount, 0);
+    std::vector<QPointF> laidOutCentre(componentCount);
+    std::vector<QPointF> pinnedCentre(componentCount);
+    for (size_t i = 0; i < m_pinnedOgdfPositions.size(); ++i)
+    {
+        ogdf::node ogdfNode = m_pinnedOgdfPositions[i].first;
+        int c = component[ogdfNode];
+        ++pinnedCount[c];
+        laidOutCentre[c] += QPointF(m_graphAttributes->x(ogdfNode), m_graphAttributes->y(ogdfNode));
+        pinnedCentre[c] += m_pinnedOgdfPositions[i].second;
     }
-
-    else if (g_settings->graphScope == AROUND_BLAST_HITS)
+    for (int c = 0; c < componentCount; ++c)
     {
-        std::vector<DeBruijnNode *> startingNodes = getNodesFromBlastHits(blastQueryName);
-
-        if (startingNodes.size() == 0)
-        {
-            *errorTitle = "No BLAST hits";
-            *errorMessage = "To draw the graph around BLAST hits, you must first conduct a BLAST search.";
-            return startingNodes;
-        }
+        if (pinnedCount[c] == 0)
+            continue;
+        laidOutCentre[c] /= pinnedCount[c];
+        pinnedCentre[c] /= pinnedCount[c];
     }
 
-    else if (g_settings->graphScope == DEPTH_RANGE)
+    //Treating the points as complex numbers, the best rotation and scale is
+    //sum(conj(a) * b) / sum(|a|^2), where a and b are the laid out and pinned
+    //positions relative to their centres.
+    std::vector<double> dotSum(componentCount, 0.0);
+    std::vector<double> crossSum(componentCount, 0.0);
+    std::vector<double> normSum(componentCount, 0.0);
+    for (size_t i = 0; i < m_pinnedOgdfPositions.size(); ++i)
     {
-        if (g_settings->minDepthRange > g_settings->maxDepthRange)
-        {
-            *errorTitle = "Invalid depth range";
-            *errorMessage = "The maximum depth must be greater than or equal to the minimum depth.";
-            return startingNodes;
-        }
+        ogdf::node ogdfNode = m_pinnedOgdfPositions[i].first;
+        int c = component[ogdfNode];
+        QPointF a = QPointF(m_graphAttributes->x(ogdfNode), m_graphAttributes->y(ogdfNode)) - laidOutCentre[c];
+        QPointF b = m_pinnedOgdfPositions[i].second - pinnedCentre[c];
+        dotSum[c] += a.x() * b.x() + a.y() * b.y();
+        crossSum[c] += a.x() * b.y() - a.y() * b.x();
+        normSum[c] += a.x() * a.x() + a.y() * a.y();
+    }
 
-        std::vector<DeBruijnNode *> startingNodes = getNodesInDepthRange(g_settings->minDepthRange,
-                                                                             g_settings->maxDepthRange);
+    ogdf::node ogdfNode;
+    forall_nodes(ogdfNode, *m_ogdfGraph)
+    {
+        int c = component[ogdfNode];
+        if (pinnedCount[c] == 0)
+            continue;
 
-        if (startingNodes.size() == 0)
+        double cosine = 1.0, sine = 0.0;
+        if (normSum[c] > 0.0)
         {
-            *errorTitle = "No nodes in range";
-            *errorMessage = "There are no nodes with depths in the specified range.";
-            return startingNodes;
+            cosine = dotSum[c] / normSum[c];
+            sine = crossSum[c] / normSum[c];
         }
+        double x = m_graphAttributes->x(ogdfNode) - laidOutCentre[c].x();
+        double y = m_graphAttributes->y(ogdfNode) - laidOutCentre[c].y();
+        m_graphAttributes->x(ogdfNode) = pinnedCentre[c].x() + cosine * x - sine * y;
+        m_graphAttributes->y(ogdfNode) = pinnedCentre[c].y() + sine * x + cosine * y;
     }
 
-    g_settings->doubleMode = doubleMode;
-    clearOgdfGraphAndResetNodes();
-
-    if (g_settings->graphScope == AROUND_NODE)
-        startingNodes = getNodesFromString(nodesList, g_settings->startingNodesExactMatch);
-    else if (g_settings->graphScope == AROUND_BLAST_HITS)
-        startingNodes = getNodesFromBlastHits(blastQueryName);
-    else if (g_settings->graphScope == DEPTH_RANGE)
-        startingNodes = getNodesInDepthRange(g_settings->minDepthRange,
-                                                 g_settings->maxDepthRange);
+    for (size_t i = 0; i < m_pinnedOgdfPositions.size(); ++i)
+    {
+        ogdf::node pinnedNode = m_pinnedOgdfPositions[i].first;
+        m_graphAttributes->x(pinnedNode) = m_pinnedOgdfPositions[i].second.x();
+        m_graphAttributes->y(pinnedNode) = m_pinnedOgdfPositions[i].second.y();
+    }
 
-    return startingNodes;
+    m_pinnedOgdfPositions.clear();
 }
 
 
-bool AssemblyGraph::checkIfStringHasNodes(QString nodesString)
+
+std::vector<ogdf::node> AssemblyGraph::getPinnedOgdfNodes() const
 {
-    nodesString = nodesString.simplified();
-    QStringList nodesList = nodesString.split(",");
-    nodesList = removeNullStringsFromList(nodesList);
-    return (nodesList.size() == 0);
+    std::vector<ogdf::node> pinnedNodes;
+    pinnedNodes.reserve(m_pinnedOgdfPositions.size());
+    for (size_t i = 0; i < m_pinnedOgdfPositions.size(); ++i)
+        pinnedNodes.push_back(m_pinnedOgdfPositions[i].first);
+    return pinnedNodes;
+}
+
+
+
+//This function returns the OGDF nodes which make up each drawn node, in
+//order along the node, for use by the coarse-then-refine layout.
+std::vector<std::vector<ogdf::node> > AssemblyGraph::getOgdfSegmentChains() const
+{
+    std::vector<std::vector<ogdf::node> > segmentChains;
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        if (node->inOgdf())
+            segmentChains.push_back(node->getOgdfNode()->m_ogdfNodes);
+    }
+    return segmentChains;
+}
+
+
+void AssemblyGraph::recordOgdfGraphScope(std::vector<DeBruijnNode *> startingNodes, int nodeDistance)
+{
+    m_ogdfGraphModificationCount = m_modificationCount;
+    m_ogdfGraphStartingNodes = getScopeStartingNodes(startingNodes);
+    m_ogdfGraphNodeDistance = nodeDistance;
+    m_ogdfGraphLayoutSettings = getOgdfGraphLayoutSettings();
+}
+
+
+//This function returns the starting nodes as they are used to define the
+//scope: sorted, without duplicates and, in single mode, all positive.
+std::vector<DeBruijnNode *> AssemblyGraph::getScopeStartingNodes(std::vector<DeBruijnNode *> startingNodes) const
+{
+    for (size_t i = 0; i < startingNodes.size(); ++i)
+    {
+        if (!m_settings->doubleMode && startingNodes[i]->isNegativeNode())
+            startingNodes[i] = startingNodes[i]->getReverseComplement();
+    }
+    std::sort(startingNodes.begin(), startingNodes.end());
+    startingNodes.erase(std::unique(startingNodes.begin(), startingNodes.end()), startingNodes.end());
+    return startingNodes;
+}
+
+
+//These are the settings which determine how the OGDF graph is built and how
+//its positions become graphics items.  If any of them change, the graph must
+//be drawn again from scratch.
+std::vector<double> AssemblyGraph::getOgdfGraphLayoutSettings() const
+{
+    std::vector<double> layoutSettings;
+    layoutSettings.push_back(m_settings->graphScope);
+    layoutSettings.push_back(m_settings->doubleMode);
+    layoutSettings.push_back(m_settings->linearLayout);
+    layoutSettings.push_back(m_settings->nodeLengthMode);
+    layoutSettings.push_back(m_settings->autoNodeLengthPerMegabase);
+    layoutSettings.push_back(m_settings->manualNodeLengthPerMegabase);
+    layoutSettings.push_back(m_settings->minimumNodeLength);
+    layoutSettings.push_back(m_settings->nodeSegmentLength);
+    layoutSettings.push_back(m_settings->edgeLength);
+    layoutSettings.push_back(m_settings->doubleModeNodeSeparation);
+    return layoutSettings;
+}
+
+
+//This function copies the positions of the drawn nodes from their graphics
+//items into the OGDF graph, so any dragging the user has done is kept, and
+//records them as pinned.  In double mode, a node and its reverse complement
+//are drawn shifted to either side of their shared OGDF positions, so the
+//average of the two is used.
+void AssemblyGraph::pinOgdfPositionsFromGraphicsItems()
+{
+    m_pinnedOgdfPositions.clear();
+
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        if (!node->inOgdf())
+            continue;
+
+        std::vector<ogdf::node> & ogdfNodes = node->getOgdfNode()->m_ogdfNodes;
+        size_t pointCount = ogdfNodes.size();
+        GraphicsItemNode * graphicsItemNode = node->getGraphicsItemNode();
+        GraphicsItemNode * rcGraphicsItemNode = node->getReverseComplement()->getGraphicsItemNode();
+        if (graphicsItemNode != 0 && graphicsItemNode->m_linePoints.size() != pointCount)
+            graphicsItemNode = 0;
+        if (rcGraphicsItemNode != 0 && rcGraphicsItemNode->m_linePoints.size() != pointCount)
+            rcGraphicsItemNode = 0;
+
+        for (size_t j = 0; j < pointCount; ++j)
+        {
+            ogdf::node ogdfNode = ogdfNodes[j];
+            QPointF point(m_graphAttributes->x(ogdfNode), m_graphAttributes->y(ogdfNode));
+            if (graphicsItemNode != 0 && rcGraphicsItemNode != 0)
+                point = (graphicsItemNode->m_linePoints[j] + rcGraphicsItemNode->m_linePoints[pointCount - 1 - j]) / 2.0;
+            else if (graphicsItemNode != 0)
+                point = graphicsItemNode->m_linePoints[j];
+            else if (rcGraphicsItemNode != 0)
+                point = rcGraphicsItemNode->m_linePoints[pointCount - 1 - j];
+
+            m_graphAttributes->x(ogdfNode) = point.x();
+            m_graphAttributes->y(ogdfNode) = point.y();
+            m_pinnedOgdfPositions.push_back(std::pair<ogdf::node, QPointF>(ogdfNode, point));
+        }
+    }
+}
+
+
+namespace
+{
+
+//This function returns the node (either the given node or its reverse
+//complement) which holds the OGDF node for the pair.
+DeBruijnNode * getOgdfOwner(DeBruijnNode * node)
+{
+    if (node->inOgdf())
+        return node;
+    return node->getReverseComplement();
+}
+
+//This function returns the OGDF node at which the given edge joins the given
+//node, following the same logic as DeBruijnEdge::addToOgdfGraph.
+ogdf::node getOgdfAttachmentPoint(const DeBruijnEdge * edge, DeBruijnNode * node)
+{
+    bool nodeStartsEdge = (edge->getStartingNode() == node);
+    if (node->inOgdf())
+        return nodeStartsEdge ? node->getOgdfNode()->getLast() : node->getOgdfNode()->getFirst();
+    OgdfNode * rcOgdfNode = node->getReverseComplement()->getOgdfNode();
+    return nodeStartsEdge ? rcOgdfNode->getFirst() : rcOgdfNode->getLast();
+}
+
+}
+
+
+//This function gives initial positions to newly added OGDF nodes.  Working
+//outwards from the pinned nodes, each new node is laid in a line leading
+//away from the node it connects to, so the layout only needs to relax the
+//new frontier rather than untangle nodes placed at random.
+void AssemblyGraph::placeNewOgdfNodesNearNeighbours(const std::vector<DeBruijnNode *> & newNodes)
+{
+    QSet<DeBruijnNode *> unplaced;
+    for (size_t i = 0; i < newNodes.size(); ++i)
+        unplaced.insert(getOgdfOwner(newNodes[i]));
+
+    QQueue<DeBruijnNode *> queue;
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        if (node->inOgdf() && !unplaced.contains(node))
+            queue.enqueue(node);
+    }
+
+    while (!queue.isEmpty())
+    {
+        DeBruijnNode * placedNode = queue.dequeue();
+        DeBruijnNode * strands[2] = {placedNode, placedNode->getReverseComplement()};
+        for (int s = 0; s < 2; ++s)
+        {
+            const std::vector<DeBruijnEdge *> * edges = strands[s]->getEdgesPointer();
+            for (size_t j = 0; j < edges->size(); ++j)
+            {
+                DeBruijnEdge * edge = (*edges)[j];
+                DeBruijnNode * otherNode = edge->getOtherNode(strands[s]);
+                if (!otherNode->thisOrReverseComplementInOgdf())
+                    continue;
+                DeBruijnNode * newNode = getOgdfOwner(otherNode);
+                if (!unplaced.contains(newNode))
+                    continue;
+
+                //Lead away from the placed node along the direction of its
+                //end segment, with some random spread so siblings separate.
+                ogdf::node anchor = getOgdfAttachmentPoint(edge, strands[s]);
+                OgdfNode * placedOgdfNode = placedNode->getOgdfNode();
+                ogdf::node behindAnchor = (anchor == placedOgdfNode->getFirst()) ?
+                            placedOgdfNode->getSecond() : placedOgdfNode->getSecondLast();
+                QPointF anchorPoint(m_graphAttributes->x(anchor), m_graphAttributes->y(anchor));
+                QLineF direction(QPointF(0.0, 0.0), QPointF(1.0, 0.0));
+                if (behindAnchor != 0)
+                {
+                    QPointF behindPoint(m_graphAttributes->x(behindAnchor), m_graphAttributes->y(behindAnchor));
+                    if (behindPoint != anchorPoint)
+                        direction = QLineF(behindPoint, anchorPoint);
+                }
+                direction.setAngle(direction.angle() + (rand() % 121) - 60.0);
+
+                //Lay the new node's segments out starting from the end which
+                //the edge joins.
+                ogdf::node newNodeEnd = getOgdfAttachmentPoint(edge, otherNode);
+                std::vector<ogdf::node> ogdfNodes = newNode->getOgdfNode()->m_ogdfNodes;
+                if (newNodeEnd != ogdfNodes.front())
+                    std::reverse(ogdfNodes.begin(), ogdfNodes.end());
+                for (size_t k = 0; k < ogdfNodes.size(); ++k)
+                {
+                    direction.setLength(m_settings->edgeLength + k * m_settings->nodeSegmentLength);
+                    QPointF point = anchorPoint + (direction.p2() - direction.p1());
+                    m_graphAttributes->x(ogdfNodes[k]) = point.x();
+                    m_graphAttributes->y(ogdfNodes[k]) = point.y();
+                }
+
+                unplaced.remove(newNode);
+                queue.enqueue(newNode);
+            }
+        }
+    }
+
+    //Any new nodes not connected to the existing drawing (which shouldn't
+    //happen when only the distance grows) are spread from the origin.
+    QSetIterator<DeBruijnNode *> j(unplaced);
+    while (j.hasNext())
+    {
+        std::vector<ogdf::node> & ogdfNodes = j.next()->getOgdfNode()->m_ogdfNodes;
+        QLineF direction(QPointF(0.0, 0.0), QPointF(1.0, 0.0));
+        direction.setAngle(rand() % 360);
+        for (size_t k = 0; k < ogdfNodes.size(); ++k)
+        {
+            direction.setLength(k * m_settings->nodeSegmentLength);
+            m_graphAttributes->x(ogdfNodes[k]) = direction.p2().x();
+            m_graphAttributes->y(ogdfNodes[k]) = direction.p2().y();
+        }
+    }
+}
+
+
+
+void AssemblyGraph::addGraphicsItemsToScene(MyGraphicsScene * scene)
+{
+    scene->clear();
+
+    double meanDrawnDepth = getMeanDepth(true);
+
+    //First make the GraphicsItemNode objects
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+
+        if (node->isDrawn())
+        {
+            if (meanDrawnDepth == 0)
+                node->setDepthRelativeToMeanDrawnDepth(1.0);
+            else
+                node->setDepthRelativeToMeanDrawnDepth(node->getDepth() / meanDrawnDepth);
+            GraphicsItemNode * graphicsItemNode = new GraphicsItemNode(node, m_graphAttributes);
+            node->setGraphicsItemNode(graphicsItemNode);
+            graphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
+            graphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
+        }
+    }
+
+    resetAllNodeColours();
+
+    //Then make the GraphicsItemEdge objects and add them to the scene first
+    //so they are drawn underneath
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
+    while (j.hasNext())
+    {
+        j.next();
+        DeBruijnEdge * edge = j.value();
+
+        if (edge->isDrawn())
+        {
+            GraphicsItemEdge * graphicsItemEdge = new GraphicsItemEdge(edge);
+            edge->setGraphicsItemEdge(graphicsItemEdge);
+            graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
+            scene->addItem(graphicsItemEdge);
+        }
+    }
+
+    //Now add the GraphicsItemNode objects to the scene so they are drawn
+    //on top
+    QMapIterator<QString, DeBruijnNode*> k(m_deBruijnGraphNodes);
+    while (k.hasNext())
+    {
+        k.next();
+        DeBruijnNode * node = k.value();
+        if (node->hasGraphicsItem())
+            scene->addItem(node->getGraphicsItemNode());
+    }
+}
+
+
+//This function is used after the OGDF graph has been expanded.  It makes
+//graphics items only for the nodes and edges which don't already have them,
+//leaving the existing items (and the user's view of them) in place.
+void AssemblyGraph::addNewGraphicsItemsToScene(MyGraphicsScene * scene)
+{
+    //The mean drawn depth has changed, so the existing nodes' widths are
+    //updated too.
+    recalculateAllDepthsRelativeToDrawnMean();
+    recalculateAllNodeWidths();
+
+    std::vector<GraphicsItemNode *> newGraphicsItemNodes;
+    std::vector<GraphicsItemNode *> shiftedGraphicsItemNodes;
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        if (node->isNotDrawn() || node->hasGraphicsItem())
+            continue;
+
+        GraphicsItemNode * graphicsItemNode = new GraphicsItemNode(node, m_graphAttributes);
+        graphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
+        graphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
+        graphicsItemNode->setNodeColour();
+        newGraphicsItemNodes.push_back(graphicsItemNode);
+
+        //In double mode, if this node's reverse complement was already drawn
+        //on its own, it now needs to move aside to make room for this node.
+        GraphicsItemNode * rcGraphicsItemNode = node->getReverseComplement()->getGraphicsItemNode();
+        if (m_settings->doubleMode && rcGraphicsItemNode != 0 &&
+                std::find(newGraphicsItemNodes.begin(), newGraphicsItemNodes.end(), rcGraphicsItemNode) == newGraphicsItemNodes.end())
+        {
+            rcGraphicsItemNode->shiftPointsLeft();
+            shiftedGraphicsItemNodes.push_back(rcGraphicsItemNode);
+        }
+
+        node->setGraphicsItemNode(graphicsItemNode);
+    }
+
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
+    while (j.hasNext())
+    {
+        j.next();
+        DeBruijnEdge * edge = j.value();
+        if (edge->isDrawn() && edge->getGraphicsItemEdge() == 0)
+        {
+            GraphicsItemEdge * graphicsItemEdge = new GraphicsItemEdge(edge);
+            graphicsItemEdge->setZValue(-1.0);
+            edge->setGraphicsItemEdge(graphicsItemEdge);
+            graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
+            scene->addItem(graphicsItemEdge);
+        }
+    }
+
+    if (!shiftedGraphicsItemNodes.empty())
+        shiftedGraphicsItemNodes[0]->fixEdgePaths(&shiftedGraphicsItemNodes);
+
+    for (size_t k = 0; k < newGraphicsItemNodes.size(); ++k)
+        scene->addItem(newGraphicsItemNodes[k]);
+}
+
+
+
+
+//If resetDrawnGraph is false, the currently drawn nodes and OGDF graph are
+//left alone, which lets the caller try expanding the existing layout.  In
+//that case the caller must call clearOgdfGraphAndResetNodes itself before
+//building a new OGDF graph.
+std::vector<DeBruijnNode *> AssemblyGraph::getStartingNodes(QString * errorTitle, QString * errorMessage, bool doubleMode,
+                                                            QString nodesList, QString blastQueryName,
+                                                            bool resetDrawnGraph)
+{
+    std::vector<DeBruijnNode *> startingNodes;
+
+    if (m_settings->graphScope == AROUND_NODE)
+    {
+        if (checkIfStringHasNodes(nodesList))
+        {
+            *errorTitle = "No starting nodes";
+            *errorMessage = "Please enter at least one node when drawing the graph using the 'Around node(s)' scope. "
+                            "Separate multiple nodes with commas.";
+            return startingNodes;
+        }
+
+        //Make sure the nodes the user typed in are actually in the graph.
+        std::vector<QString> nodesNotInGraph;
+        std::vector<DeBruijnNode *> nodesInGraph = getNodesFromString(nodesList,
+                                                                      m_settings->startingNodesExactMatch,
+                                                                      &nodesNotInGraph);
+        if (nodesNotInGraph.size() > 0)
+        {
+            *errorTitle = "Nodes not found";
+            *errorMessage = generateNodesNotFoundErrorMessage(nodesNotInGraph, m_settings->startingNodesExactMatch);
+            if (nodesInGraph.size() == 0)
+                return startingNodes;
+        }
+    }
+
+    else if (m_settings->graphScope == AROUND_BLAST_HITS)
+    {
+        std::vector<DeBruijnNode *> startingNodes = getNodesFromBlastHits(blastQueryName);
+
+        if (startingNodes.size() == 0)
+        {
+            *errorTitle = "No BLAST hits";
+            *errorMessage = "To draw the graph around BLAST hits, you must first conduct a BLAST search.";
+            return startingNodes;
+        }
+    }
+
+    else if (m_settings->graphScope == DEPTH_RANGE)
+    {
+        if (m_settings->minDepthRange > m_settings->maxDepthRange)
+        {
+            *errorTitle = "Invalid depth range";
+            *errorMessage = "The maximum depth must be greater than or equal to the minimum depth.";
+            return startingNodes;
+        }
+
+        std::vector<DeBruijnNode *> startingNodes = getNodesInDepthRange(m_settings->minDepthRange,
+                                                                             m_settings->maxDepthRange);
+
+        if (startingNodes.size() == 0)
+        {
+            *errorTitle = "No nodes in range";
+            *errorMessage = "There are no nodes with depths in the specified range.";
+            return startingNodes;
+        }
+    }
+
+    m_settings->doubleMode = doubleMode;
+    if (resetDrawnGraph)
+        clearOgdfGraphAndResetNodes();
+
+    if (m_settings->graphScope == AROUND_NODE)
+        startingNodes = getNodesFromString(nodesList, m_settings->startingNodesExactMatch);
+    else if (m_settings->graphScope == AROUND_BLAST_HITS)
+        startingNodes = getNodesFromBlastHits(blastQueryName);
+    else if (m_settings->graphScope == DEPTH_RANGE)
+        startingNodes = getNodesInDepthRange(m_settings->minDepthRange,
+                                                 m_settings->maxDepthRange);
+
+    return startingNodes;
+}
+
+
+bool AssemblyGraph::checkIfStringHasNodes(QString nodesString)
+{
+    nodesString = nodesString.simplified();
+    QStringList nodesList = nodesString.split(",");
+    nodesList = removeNullStringsFromList(nodesList);
+    return (nodesList.size() == 0);
 }
 
 
@@ -2175,7 +2906,7 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListExact(QStringList nod
         if (lastChar == '+' || lastChar == '-')
         {
             if (m_deBruijnGraphNodes.contains(nodeName))
-                returnVector.push_back(m_deBruijnGraphNodes[nodeName]);
+                returnVector.push_back(m_deBruijnGraphNodes.value(nodeName));
             else if (nodesNotInGraph != 0)
                 nodesNotInGraph->push_back(nodesList.at(i).trimmed());
         }
@@ -2187,14 +2918,14 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListExact(QStringList nod
             bool posNodeFound = false;
             if (m_deBruijnGraphNodes.contains(posNodeName))
             {
-                returnVector.push_back(m_deBruijnGraphNodes[posNodeName]);
+                returnVector.push_back(m_deBruijnGraphNodes.value(posNodeName));
                 posNodeFound = true;
             }
 
             bool negNodeFound = false;
             if (m_deBruijnGraphNodes.contains(negNodeName))
             {
-                returnVector.push_back(m_deBruijnGraphNodes[negNodeName]);
+                returnVector.push_back(m_deBruijnGraphNodes.value(negNodeName));
                 negNodeFound = true;
             }
 
@@ -2210,6 +2941,7 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListPartial(QStringList n
                                                                    std::vector<QString> * nodesNotInGraph)
 {
     std::vector<DeBruijnNode *> returnVector;
+    const NodeNameIndex & nodeNameIndex = getNodeNameIndex();
 
     for (int i = 0; i < nodesList.size(); ++i)
     {
@@ -2217,21 +2949,10 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListPartial(QStringList n
         if (queryName == "")
             continue;
 
-        bool found = false;
-        QMapIterator<QString, DeBruijnNode*> j(m_deBruijnGraphNodes);
-        while (j.hasNext())
-        {
-            j.next();
-            QString nodeName = j.value()->getName();
-
-            if (nodeName.contains(queryName))
-            {
-                found = true;
-                returnVector.push_back(j.value());
-            }
-        }
+        std::vector<DeBruijnNode *> found = nodeNameIndex.findNodes(queryName);
+        returnVector.insert(returnVector.end(), found.begin(), found.end());
 
-        if (!found && nodesNotInGraph != 0)
+        if (found.empty() && nodesNotInGraph != 0)
             nodesNotInGraph->push_back(queryName.trimmed());
     }
 
@@ -2255,15 +2976,15 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromBlastHits(QString queryNa
     else
         queries.push_back(g_blastSearch->m_blastQueries.getQueryFromName(queryName));
 
-    //Add pointers to nodes that have a hit for the selected target(s).
+    //Add pointers to nodes that have a hit for the selected target(s).  Each
+    //query holds its own hits, so only those need to be looked at.
     for (size_t i = 0; i < queries.size(); ++i)
     {
-        BlastQuery * currentQuery = queries[i];
-        for (int j = 0; j < g_blastSearch->m_allHits.size(); ++j)
-        {
-            if (g_blastSearch->m_allHits[j]->m_query == currentQuery)
-                returnVector.push_back(g_blastSearch->m_allHits[j]->m_node);
-        }
+        if (queries[i] == 0)
+            continue;
+        QList< QSharedPointer<BlastHit> > queryHits = queries[i]->getHits();
+        for (int j = 0; j < queryHits.size(); ++j)
+            returnVector.push_back(queryHits[j]->m_node);
     }
 
     return returnVector;
@@ -2305,11 +3026,16 @@ QStringList AssemblyGraph::removeNullStringsFromList(QStringList in)
 void AssemblyGraph::layoutGraph()
 {
     ogdf::FMMMLayout fmmm;
-    GraphLayoutWorker * graphLayoutWorker = new GraphLayoutWorker(&fmmm, m_graphAttributes, m_edgeArray,
-                                                                  g_settings->graphLayoutQuality,
-                                                                  useLinearLayout(),
-                                                                  g_settings->componentSeparation);
-    graphLayoutWorker->layoutGraph();
+    GraphLayoutWorker graphLayoutWorker(&fmmm, m_graphAttributes, m_edgeArray,
+                                        m_settings->graphLayoutQuality,
+                                        useLinearLayout(),
+                                        hasPinnedOgdfPositions(),
+                                        m_settings->componentSeparation);
+    if (m_settings->coarseLayout)
+        graphLayoutWorker.setSegmentChains(getOgdfSegmentChains());
+    graphLayoutWorker.setFixedNodes(getPinnedOgdfNodes());
+    graphLayoutWorker.layoutGraph();
+    restorePinnedOgdfPositions();
 }
 
 
@@ -2321,6 +3047,8 @@ void AssemblyGraph::setAllEdgesExactOverlap(int overlap)
         i.next();
         i.value()->setExactOverlap(overlap);
     }
+
+    markModified();
 }
 
 
@@ -2394,6 +3122,8 @@ void AssemblyGraph::autoDetermineAllEdgesExactOverlap()
             }
         }
     }
+
+    markModified();
 }
 
 
@@ -2453,7 +3183,8 @@ void AssemblyGraph::readFastaOrFastqFile(QString filename, std::vector<QString>
 
 
 
-void AssemblyGraph::readFastaFile(QString filename, std::vector<QString> * names, std::vector<QByteArray> * sequences)
+void AssemblyGraph::readFastaFile(QString filename, std::vector<QString> * names, std::vector<QByteArray> * sequences,
+                                  AssemblyGraph * loadingGraph)
 {
     QFile inputFile(filename);
     if (inputFile.open(QIODevice::ReadOnly))
@@ -2464,7 +3195,8 @@ void AssemblyGraph::readFastaFile(QString filename, std::vector<QString> * names
         QTextStream in(&inputFile);
         while (!in.atEnd())
         {
-            QApplication::processEvents();
+            if (loadingGraph != 0)
+                loadingGraph->reportLoadProgress(&inputFile);
 
             QString line = in.readLine();
 
@@ -2509,8 +3241,6 @@ void AssemblyGraph::readFastqFile(QString filename, std::vector<QString> * names
         QTextStream in(&inputFile);
         while (!in.atEnd())
         {
-            QApplication::processEvents();
-
             QString name = in.readLine().simplified();
             QByteArray sequence = in.readLine().simplified().toLocal8Bit();
             in.readLine();  // separator
@@ -2573,6 +3303,7 @@ void AssemblyGraph::clearAllCsvData()
         i.next();
         i.value()->clearCsvData();
     }
+    m_csvTable.clear();
 }
 
 
@@ -2598,19 +3329,27 @@ void AssemblyGraph::deleteNodes(std::vector<DeBruijnNode *> * nodes)
 {
     //Build a list of nodes to delete.
     QList<DeBruijnNode *> nodesToDelete;
+    QSet<DeBruijnNode *> nodesToDeleteSet;
     for (size_t i = 0; i < nodes->size(); ++i)
     {
         DeBruijnNode * node = (*nodes)[i];
         DeBruijnNode * rcNode = node->getReverseComplement();
 
-        if (!nodesToDelete.contains(node))
+        if (!nodesToDeleteSet.contains(node))
+        {
             nodesToDelete.push_back(node);
-        if (!nodesToDelete.contains(rcNode))
+            nodesToDeleteSet.insert(node);
+        }
+        if (!nodesToDeleteSet.contains(rcNode))
+        {
             nodesToDelete.push_back(rcNode);
+            nodesToDeleteSet.insert(rcNode);
+        }
     }
 
     //Build a list of edges to delete.
     std::vector<DeBruijnEdge *> edgesToDelete;
+    QSet<DeBruijnEdge *> edgesToDeleteSet;
     for (int i = 0; i < nodesToDelete.size(); ++i)
     {
         DeBruijnNode * node = nodesToDelete[i];
@@ -2618,9 +3357,11 @@ void AssemblyGraph::deleteNodes(std::vector<DeBruijnNode *> * nodes)
         for (size_t j = 0; j < nodeEdges->size(); ++j)
         {
             DeBruijnEdge * edge = (*nodeEdges)[j];
-            bool alreadyAdded = std::find(edgesToDelete.begin(), edgesToDelete.end(), edge) != edgesToDelete.end();
-            if (!alreadyAdded)
+            if (!edgesToDeleteSet.contains(edge))
+            {
                 edgesToDelete.push_back(edge);
+                edgesToDeleteSet.insert(edge);
+            }
         }
     }
 
@@ -2635,32 +3376,44 @@ void AssemblyGraph::deleteNodes(std::vector<DeBruijnNode *> * nodes)
     //Remove the edges from the graph,
     deleteEdges(&edgesToDelete);
 
-    //Remove the nodes from the graph.
+    //Remove the nodes from the graph.  A merged node can take the name of a
+    //node it replaces, so a name is only removed if it is still this node's.
     for (int i = 0; i < nodesNamesToDelete.size(); ++i)
     {
         QString nodeName = nodesNamesToDelete[i];
-        m_deBruijnGraphNodes.remove(nodeName);
+        if (m_deBruijnGraphNodes.value(nodeName) == nodesToDelete[i])
+            m_deBruijnGraphNodes.remove(nodeName);
+        m_graphDepths.remove(nodeName);
     }
     for (int i = 0; i < nodesToDelete.size(); ++i)
     {
         DeBruijnNode * node = nodesToDelete[i];
         delete node;
     }
+
+    markModified();
 }
 
 void AssemblyGraph::deleteEdges(std::vector<DeBruijnEdge *> * edges)
 {
     //Build a list of edges to delete.
     QList<DeBruijnEdge *> edgesToDelete;
+    QSet<DeBruijnEdge *> edgesToDeleteSet;
     for (size_t i = 0; i < edges->size(); ++i)
     {
         DeBruijnEdge * edge = (*edges)[i];
         DeBruijnEdge * rcEdge = edge->getReverseComplement();
 
-        if (!edgesToDelete.contains(edge))
+        if (!edgesToDeleteSet.contains(edge))
+        {
             edgesToDelete.push_back(edge);
-        if (!edgesToDelete.contains(rcEdge))
+            edgesToDeleteSet.insert(edge);
+        }
+        if (!edgesToDeleteSet.contains(rcEdge))
+        {
             edgesToDelete.push_back(rcEdge);
+            edgesToDeleteSet.insert(rcEdge);
+        }
     }
 
     //Remove the edges from the graph,
@@ -2676,6 +3429,8 @@ void AssemblyGraph::deleteEdges(std::vector<DeBruijnEdge *> * edges)
 
         delete edge;
     }
+
+    markModified();
 }
 
 
@@ -2695,8 +3450,8 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * sce
     double newDepth = node->getDepth() / 2.0;
 
     //Create the new nodes.
-    DeBruijnNode * newPosNode = new DeBruijnNode(newPosNodeName, newDepth, originalPosNode->getSequence());
-    DeBruijnNode * newNegNode = new DeBruijnNode(newNegNodeName, newDepth, originalNegNode->getSequence());
+    DeBruijnNode * newPosNode = new DeBruijnNode(this, newPosNodeName, newDepth, originalPosNode->getSequence());
+    DeBruijnNode * newNegNode = new DeBruijnNode(this, newNegNodeName, newDepth, originalNegNode->getSequence());
     newPosNode->setReverseComplement(newNegNode);
     newNegNode->setReverseComplement(newPosNode);
 
@@ -2705,8 +3460,8 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * sce
     newNegNode->setCustomColour(originalNegNode->getCustomColour());
     newPosNode->setCustomLabel(originalPosNode->getCustomLabel());
     newNegNode->setCustomLabel(originalNegNode->getCustomLabel());
-    newPosNode->setCsvData(originalPosNode->getAllCsvData());
-    newNegNode->setCsvData(originalNegNode->getAllCsvData());
+    newPosNode->setCsvRow(originalPosNode->getCsvRow());
+    newNegNode->setCsvRow(originalNegNode->getCsvRow());
 
     m_deBruijnGraphNodes.insert(newPosNodeName, newPosNode);
     m_deBruijnGraphNodes.insert(newNegNodeName, newNegNode);
@@ -2731,6 +3486,7 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * sce
 
     originalPosNode->setDepth(newDepth);
     originalNegNode->setDepth(newDepth);
+    markModified();
 
     double meanDrawnDepth = getMeanDepth(true);
     double depthRelativeToMeanDrawnDepth;
@@ -2894,8 +3650,8 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, MyGraphicsScene * sc
     QString newPosNodeName = newNodeBaseName + "+";
     QString newNegNodeName = newNodeBaseName + "-";
 
-    DeBruijnNode * newPosNode = new DeBruijnNode(newPosNodeName, mergedNodeDepth, mergedNodePosSequence);
-    DeBruijnNode * newNegNode = new DeBruijnNode(newNegNodeName, mergedNodeDepth, mergedNodeNegSequence);
+    DeBruijnNode * newPosNode = new DeBruijnNode(this, newPosNodeName, mergedNodeDepth, mergedNodePosSequence);
+    DeBruijnNode * newNegNode = new DeBruijnNode(this, newNegNodeName, mergedNodeDepth, mergedNodeNegSequence);
 
     newPosNode->setReverseComplement(newNegNode);
     newNegNode->setReverseComplement(newPosNode);
@@ -3003,7 +3759,7 @@ void AssemblyGraph::mergeGraphicsNodes(QList<DeBruijnNode *> * originalNodes,
     if (success)
         newNode->setAsDrawn();
 
-    if (g_settings->doubleMode) {
+    if (m_settings->doubleMode) {
         DeBruijnNode * newRevComp = newNode->getReverseComplement();
         bool revCompSuccess = mergeGraphicsNodes2(revCompOriginalNodes, newRevComp, scene);
         if (revCompSuccess)
@@ -3017,9 +3773,23 @@ void AssemblyGraph::mergeGraphicsNodes(QList<DeBruijnNode *> * originalNodes,
 }
 
 
-bool AssemblyGraph::mergeGraphicsNodes2(QList<DeBruijnNode *> * originalNodes,
-                                        DeBruijnNode * newNode,
-                                        MyGraphicsScene * scene)
+bool AssemblyGraph::mergeGraphicsNodes2(QList<DeBruijnNode *> * originalNodes,
+                                        DeBruijnNode * newNode,
+                                        MyGraphicsScene * scene)
+{
+    bool success = makeMergedGraphicsItemNode(originalNodes, newNode, scene);
+    if (success)
+        addGraphicsItemEdges(newNode, scene);
+    return success;
+}
+
+
+//This function makes a graphics item for a merged node, using the line points
+//of the original nodes.  It fails (returning false) if any of the original
+//nodes aren't drawn.
+bool AssemblyGraph::makeMergedGraphicsItemNode(QList<DeBruijnNode *> * originalNodes,
+                                               DeBruijnNode * newNode,
+                                               MyGraphicsScene * scene)
 {
     bool success = true;
     std::vector<QPointF> linePoints;
@@ -3031,7 +3801,7 @@ bool AssemblyGraph::mergeGraphicsNodes2(QList<DeBruijnNode *> * originalNodes,
         //If we are in single mode, then we should check for a GraphicsItemNode only
         //in the positive nodes.
         bool opposite = false;
-        if (!g_settings->doubleMode && node->isNegativeNode())
+        if (!m_settings->doubleMode && node->isNegativeNode())
         {
             node = node->getReverseComplement();
             opposite = true;
@@ -3071,22 +3841,30 @@ bool AssemblyGraph::mergeGraphicsNodes2(QList<DeBruijnNode *> * originalNodes,
         newGraphicsItemNode->setNodeColour();
 
         scene->addItem(newGraphicsItemNode);
-
-        const std::vector<DeBruijnEdge *> * newEdges = newNode->getEdgesPointer();
-        for (size_t i = 0; i < newEdges->size(); ++i)
-        {
-            DeBruijnEdge * newEdge = (*newEdges)[i];
-            GraphicsItemEdge * graphicsItemEdge = new GraphicsItemEdge(newEdge);
-            graphicsItemEdge->setZValue(-1.0);
-            newEdge->setGraphicsItemEdge(graphicsItemEdge);
-            graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
-            scene->addItem(graphicsItemEdge);
-        }
     }
     return success;
 }
 
 
+//This function adds graphics items for any of the node's edges that don't
+//already have one.
+void AssemblyGraph::addGraphicsItemEdges(DeBruijnNode * node, MyGraphicsScene * scene)
+{
+    const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+    for (size_t i = 0; i < edges->size(); ++i)
+    {
+        DeBruijnEdge * edge = (*edges)[i];
+        if (edge->getGraphicsItemEdge() != 0)
+            continue;
+        GraphicsItemEdge * graphicsItemEdge = new GraphicsItemEdge(edge);
+        graphicsItemEdge->setZValue(-1.0);
+        edge->setGraphicsItemEdge(graphicsItemEdge);
+        graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
+        scene->addItem(graphicsItemEdge);
+    }
+}
+
+
 
 //If reverseComplement is true, this function will also remove the graphics items for reverse complements of the nodes.
 void AssemblyGraph::removeGraphicsItemNodes(const std::vector<DeBruijnNode *> * nodes,
@@ -3188,155 +3966,265 @@ void AssemblyGraph::removeGraphicsItemEdges(const std::vector<DeBruijnEdge *> *
 int AssemblyGraph::mergeAllPossible(MyGraphicsScene * scene,
                                     MyProgressDialog * progressDialog)
 {
-    //Create a set of all nodes.
-    QSet<DeBruijnNode *> uncheckedNodes;
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
+    const std::vector<DeBruijnNode *> & nodes = getIndexedNodes();
+
+    //The merged sequences are built on multiple threads, so if any sequences
+    //need to come from a FASTA file, they are loaded now.
+    for (size_t i = 0; i < nodes.size(); ++i)
     {
-        i.next();
-        uncheckedNodes.insert(i.value());
+        if (nodes[i]->sequenceIsMissing())
+        {
+            nodes[i]->getSequence();
+            break;
+        }
     }
 
-    //Create a list of all merges to be done.
-    QList< QList<DeBruijnNode *> > allMerges;
-    QMapIterator<QString, DeBruijnNode*> j(m_deBruijnGraphNodes);
-    while (j.hasNext())
+    UnitigCompactor compactor(nodes);
+    compactor.findChains();
+    int mergeCount = compactor.getChainCount();
+
+    //The sequences are built in blocks so the progress dialog can update.
+    //Nothing in the graph changes until all of them are done, so cancelling
+    //leaves the graph as it was.
+    QApplication::processEvents();
+    emit setMergeTotalCount(mergeCount);
+    int blockSize = std::max(1000, mergeCount / 100);
+    for (int i = 0; i < mergeCount; i += blockSize)
     {
-        j.next();
-        DeBruijnNode * node = j.value();
+        if (progressDialog != 0 && progressDialog->wasCancelled())
+            return 0;
+
+        int blockEnd = std::min(mergeCount, i + blockSize);
+        compactor.buildMergedSequences(i, blockEnd);
+        emit setMergeCompletedCount(blockEnd);
+        QApplication::processEvents();
+    }
+
+    if (progressDialog != 0 && progressDialog->wasCancelled())
+        return 0;
+
+    applyUnitigMerges(&compactor, scene);
+
+    recalculateAllDepthsRelativeToDrawnMean();
+    recalculateAllNodeWidths();
+
+    return mergeCount;
+}
 
-        //If the current node isn't checked, then we will find the longest
-        //possible mergable sequence containing this node.
-        if (uncheckedNodes.contains(node))
+
+//This function makes all of the merged nodes found by a UnitigCompactor.
+//The end result is the same as calling mergeNodes on each chain in turn, but
+//the old nodes are only deleted once, at the end.
+void AssemblyGraph::applyUnitigMerges(const UnitigCompactor * compactor,
+                                      MyGraphicsScene * scene)
+{
+    const std::vector<DeBruijnNode *> & nodes = getIndexedNodes();
+    int chainCount = compactor->getChainCount();
+
+    //For each old node, these record which chain it is in (in either
+    //orientation) and which new node takes over its leaving/entering edges.
+    std::vector<int> chainOfNode(nodes.size(), -1);
+    std::vector<DeBruijnNode *> exitReplacements(nodes.size(), 0);
+    std::vector<DeBruijnNode *> entryReplacements(nodes.size(), 0);
+    std::vector<DeBruijnNode *> newPosNodes(chainCount, 0);
+
+    //Names are checked against the graph as it would be if the earlier
+    //merges had already deleted their nodes.
+    QSet<QString> removedNames;
+    for (int c = 0; c < chainCount; ++c)
+    {
+        std::vector<DeBruijnNode *> chain = compactor->getChain(c);
+
+        QString newNodeBaseName;
+        for (size_t i = 0; i < chain.size(); ++i)
         {
-            QList<DeBruijnNode *> nodesToMerge;
-            nodesToMerge.push_back(node);
+            newNodeBaseName += chain[i]->getNameWithoutSign();
+            if (i < chain.size() - 1)
+                newNodeBaseName += "_";
+        }
+        QString uniqueName = newNodeBaseName;
+        int suffix = 1;
+        while (m_deBruijnGraphNodes.contains(uniqueName + "+") && !removedNames.contains(uniqueName + "+"))
+        {
+            ++suffix;
+            uniqueName = newNodeBaseName + "_" + QString::number(suffix);
+        }
 
-            uncheckedNodes.remove(node);
-            uncheckedNodes.remove(node->getReverseComplement());
+        double depth = compactor->getMergedDepth(c);
+        DeBruijnNode * newPosNode = new DeBruijnNode(this, uniqueName + "+", depth, compactor->getMergedSequence(c));
+        DeBruijnNode * newNegNode = new DeBruijnNode(this, uniqueName + "-", depth, compactor->getMergedReverseComplementSequence(c));
+        newPosNode->setReverseComplement(newNegNode);
+        newNegNode->setReverseComplement(newPosNode);
+        newPosNode->setDepthRelativeToMeanDrawnDepth(1.0);
+        newNegNode->setDepthRelativeToMeanDrawnDepth(1.0);
+        m_deBruijnGraphNodes.insert(newPosNode->getName(), newPosNode);
+        m_deBruijnGraphNodes.insert(newNegNode->getName(), newNegNode);
+        removedNames.remove(newPosNode->getName());
+        removedNames.remove(newNegNode->getName());
+        newPosNodes[c] = newPosNode;
 
-            //Extend forward as much as possible.
-            bool extended;
-            do
-            {
-                extended = false;
-                DeBruijnNode * last = nodesToMerge.back();
-                std::vector<DeBruijnEdge *> outgoingEdges = last->getLeavingEdges();
-                if (outgoingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = outgoingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getEndingNode();
-                    std::vector<DeBruijnEdge *> edgesEnteringPotentialNode = potentialNode->getEnteringEdges();
-                    if (edgesEnteringPotentialNode.size() == 1 &&
-                            edgesEnteringPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_back(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+        for (size_t i = 0; i < chain.size(); ++i)
+        {
+            DeBruijnNode * node = chain[i];
+            chainOfNode[node->getId()] = c;
+            chainOfNode[node->getReverseComplement()->getId()] = c;
+            removedNames.insert(node->getName());
+            removedNames.insert(node->getReverseComplement()->getName());
+        }
+        exitReplacements[chain.back()->getId()] = newPosNode;
+        exitReplacements[chain.front()->getReverseComplement()->getId()] = newNegNode;
+        entryReplacements[chain.front()->getId()] = newPosNode;
+        entryReplacements[chain.back()->getReverseComplement()->getId()] = newNegNode;
+    }
+
+    //Edges leaving a chain's last node and entering its first node are moved
+    //to the new node.  An edge from the last node back to the first becomes a
+    //loop on the new node, and an edge from an end of the chain to its own
+    //reverse complement (in a chain which is its own reverse complement)
+    //joins the new node to its reverse complement.  Other edges within a
+    //chain are dropped.  The new edges are all found before any are made, so
+    //only old edges are seen.
+    std::vector<DeBruijnEdge *> movedEdges;
+    std::vector<DeBruijnNode *> movedEdgeStarts;
+    std::vector<DeBruijnNode *> movedEdgeEnds;
+    for (int c = 0; c < chainCount; ++c)
+    {
+        std::vector<DeBruijnNode *> chain = compactor->getChain(c);
+        DeBruijnNode * newPosNode = newPosNodes[c];
 
-            //Extend backward as much as possible.
-            do
+        const std::vector<DeBruijnEdge *> * lastNodeEdges = chain.back()->getEdgesPointer();
+        for (size_t i = 0; i < lastNodeEdges->size(); ++i)
+        {
+            DeBruijnEdge * edge = (*lastNodeEdges)[i];
+            if (edge->getStartingNode() != chain.back())
+                continue;
+            DeBruijnNode * endingNode = edge->getEndingNode();
+            if (chainOfNode[endingNode->getId()] != -1)
+                endingNode = entryReplacements[endingNode->getId()];
+            if (endingNode != 0)
             {
-                extended = false;
-                DeBruijnNode * first = nodesToMerge.front();
-                std::vector<DeBruijnEdge *> incomingEdges = first->getEnteringEdges();
-                if (incomingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = incomingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getStartingNode();
-                    std::vector<DeBruijnEdge *> edgesLeavingPotentialNode = potentialNode->getLeavingEdges();
-                    if (edgesLeavingPotentialNode.size() == 1 &&
-                            edgesLeavingPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_front(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+                movedEdges.push_back(edge);
+                movedEdgeStarts.push_back(newPosNode);
+                movedEdgeEnds.push_back(endingNode);
+            }
+        }
 
-            if (nodesToMerge.size() > 1)
-                allMerges.push_back(nodesToMerge);
+        const std::vector<DeBruijnEdge *> * firstNodeEdges = chain.front()->getEdgesPointer();
+        for (size_t i = 0; i < firstNodeEdges->size(); ++i)
+        {
+            DeBruijnEdge * edge = (*firstNodeEdges)[i];
+            if (edge->getEndingNode() != chain.front())
+                continue;
+            DeBruijnNode * startingNode = edge->getStartingNode();
+            if (startingNode == chain.back())
+                continue;
+            if (chainOfNode[startingNode->getId()] != -1)
+                startingNode = exitReplacements[startingNode->getId()];
+            if (startingNode != 0)
+            {
+                movedEdges.push_back(edge);
+                movedEdgeStarts.push_back(startingNode);
+                movedEdgeEnds.push_back(newPosNode);
+            }
         }
     }
+    for (size_t i = 0; i < movedEdges.size(); ++i)
+        createDeBruijnEdge(movedEdgeStarts[i]->getName(), movedEdgeEnds[i]->getName(),
+                           movedEdges[i]->getOverlap(), movedEdges[i]->getOverlapType());
 
-    //Now do the actual merges.
-    QApplication::processEvents();
-    emit setMergeTotalCount(allMerges.size());
-    for (int i = 0; i < allMerges.size(); ++i)
+    //If the graph is drawn, the new nodes take over the old nodes' line
+    //points.  All graphics nodes are made before any graphics edges, so the
+    //edges between two merged nodes have both ends in place.
+    if (scene != 0)
     {
-        if (progressDialog != 0 && progressDialog->wasCancelled())
-            break;
+        std::vector<DeBruijnNode *> nodesWithGraphicsEdges;
+        for (int c = 0; c < chainCount; ++c)
+        {
+            std::vector<DeBruijnNode *> chain = compactor->getChain(c);
+            QList<DeBruijnNode *> originalNodes;
+            QList<DeBruijnNode *> revCompOriginalNodes;
+            for (size_t i = 0; i < chain.size(); ++i)
+            {
+                originalNodes.push_back(chain[i]);
+                revCompOriginalNodes.push_front(chain[i]->getReverseComplement());
+            }
 
-        mergeNodes(allMerges[i], scene, false);
-        emit setMergeCompletedCount(i+1);
-        QApplication::processEvents();
-    }
+            DeBruijnNode * newPosNode = newPosNodes[c];
+            if (makeMergedGraphicsItemNode(&originalNodes, newPosNode, scene))
+            {
+                newPosNode->setAsDrawn();
+                nodesWithGraphicsEdges.push_back(newPosNode);
+            }
+            if (m_settings->doubleMode)
+            {
+                DeBruijnNode * newNegNode = newPosNode->getReverseComplement();
+                if (makeMergedGraphicsItemNode(&revCompOriginalNodes, newNegNode, scene))
+                {
+                    newNegNode->setAsDrawn();
+                    nodesWithGraphicsEdges.push_back(newNegNode);
+                }
+            }
+        }
 
-    recalculateAllDepthsRelativeToDrawnMean();
-    recalculateAllNodeWidths();
+        std::vector<DeBruijnNode *> allChainNodes = compactor->getAllChainNodes();
+        removeGraphicsItemNodes(&allChainNodes, true, scene);
+
+        for (size_t i = 0; i < nodesWithGraphicsEdges.size(); ++i)
+            addGraphicsItemEdges(nodesWithGraphicsEdges[i], scene);
+    }
 
-    return allMerges.size();
+    std::vector<DeBruijnNode *> nodesToDelete = compactor->getAllChainNodes();
+    deleteNodes(&nodesToDelete);
 }
 
 void AssemblyGraph::saveEntireGraphToFasta(QString filename)
 {
-    QFile file(filename);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file);
-
+    std::vector<DeBruijnNode *> nodesToSave;
+    nodesToSave.reserve(m_deBruijnGraphNodes.size());
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
-        out << i.value()->getFasta(true);
+        nodesToSave.push_back(i.value());
     }
+
+    GraphWriter writer;
+    if (writer.open(filename))
+        writer.writeFasta(nodesToSave, true);
 }
 
 void AssemblyGraph::saveEntireGraphToFastaOnlyPositiveNodes(QString filename)
 {
-    QFile file(filename);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file);
-
+    std::vector<DeBruijnNode *> nodesToSave;
+    nodesToSave.reserve(m_deBruijnGraphNodes.size() / 2);
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
         DeBruijnNode * node = i.value();
         if (node->isPositiveNode())
-            out << node->getFasta(false);
+            nodesToSave.push_back(node);
     }
+
+    GraphWriter writer;
+    if (writer.open(filename))
+        writer.writeFasta(nodesToSave, false);
 }
 
 bool AssemblyGraph::saveEntireGraphToGfa(QString filename)
 {
-    QFile file(filename);
-    bool success = file.open(QIODevice::WriteOnly | QIODevice::Text);
-    if (!success)
-        return false;
-
-    QTextStream out(&file);
-
+    std::vector<DeBruijnNode *> nodesToSave;
+    nodesToSave.reserve(m_deBruijnGraphNodes.size() / 2);
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
         DeBruijnNode * node = i.value();
         if (node->isPositiveNode())
-            out << node->getGfaSegmentLine(m_depthTag);
+            nodesToSave.push_back(node);
     }
 
-    QList<DeBruijnEdge*> edgesToSave;
+    std::vector<DeBruijnEdge *> edgesToSave;
     QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
     while (j.hasNext())
     {
@@ -3348,31 +4236,22 @@ bool AssemblyGraph::saveEntireGraphToGfa(QString filename)
 
     std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
 
-    for (int i = 0; i < edgesToSave.size(); ++i)
-        out << edgesToSave[i]->getGfaLinkLine();
-
-    return true;
+    return saveGfa(filename, nodesToSave, edgesToSave);
 }
 
 bool AssemblyGraph::saveVisibleGraphToGfa(QString filename)
 {
-    QFile file(filename);
-    bool success = file.open(QIODevice::WriteOnly | QIODevice::Text);
-    if (!success)
-        return false;
-
-    QTextStream out(&file);
-
+    std::vector<DeBruijnNode *> nodesToSave;
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
         DeBruijnNode * node = i.value();
         if (node->thisNodeOrReverseComplementIsDrawn() && node->isPositiveNode())
-            out << node->getGfaSegmentLine(m_depthTag);
+            nodesToSave.push_back(node);
     }
 
-    QList<DeBruijnEdge*> edgesToSave;
+    std::vector<DeBruijnEdge *> edgesToSave;
     QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
     while (j.hasNext())
     {
@@ -3386,10 +4265,20 @@ bool AssemblyGraph::saveVisibleGraphToGfa(QString filename)
 
     std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
 
-    for (int i = 0; i < edgesToSave.size(); ++i)
-        out << edgesToSave[i]->getGfaLinkLine();
+    return saveGfa(filename, nodesToSave, edgesToSave);
+}
 
-    return true;
+//The segment lines come first, in node name order, followed by the link lines.
+bool AssemblyGraph::saveGfa(QString filename, const std::vector<DeBruijnNode *> & nodesToSave,
+                            const std::vector<DeBruijnEdge *> & edgesToSave)
+{
+    GraphWriter writer;
+    if (!writer.open(filename))
+        return false;
+
+    writer.writeGfaSegments(nodesToSave, m_depthTag);
+    writer.writeGfaLinks(edgesToSave);
+    return writer.close();
 }
 
 
@@ -3422,8 +4311,15 @@ void AssemblyGraph::changeNodeName(QString oldName, QString newName)
     posNode->setName(posNewNodeName);
     negNode->setName(negNewNodeName);
 
+    if (m_graphDepths.contains(posOldNodeName))
+        m_graphDepths.insert(posNewNodeName, m_graphDepths.take(posOldNodeName));
+    if (m_graphDepths.contains(negOldNodeName))
+        m_graphDepths.insert(negNewNodeName, m_graphDepths.take(negOldNodeName));
+
     m_deBruijnGraphNodes.insert(posNewNodeName, posNode);
     m_deBruijnGraphNodes.insert(negNewNodeName, negNode);
+
+    markModified();
 }
 
 
@@ -3464,6 +4360,18 @@ void AssemblyGraph::changeNodeDepth(std::vector<DeBruijnNode *> * nodes,
         (*nodes)[i]->getReverseComplement()->setDepth(newDepth);
     }
 
+    //If GAF depths are shown, the new depth also replaces the saved graph
+    //depth, so it isn't lost when switching back.
+    if (m_depthSource != GRAPH_DEPTH)
+    {
+        for (size_t i = 0; i < nodes->size(); ++i)
+        {
+            m_graphDepths.insert((*nodes)[i]->getName(), newDepth);
+            m_graphDepths.insert((*nodes)[i]->getReverseComplement()->getName(), newDepth);
+        }
+    }
+    markModified();
+
     //If this graph does not already have a depthTag, give it a depthTag of KC
     //so the depth info will be saved.
     if (m_depthTag == "")
@@ -3472,6 +4380,53 @@ void AssemblyGraph::changeNodeDepth(std::vector<DeBruijnNode *> * nodes,
 
 
 
+//This function replaces the graph's GAF coverage.  The graph's own depths
+//are put back first, as any GAF depths in use came from the old coverage.
+void AssemblyGraph::setGafCoverage(QSharedPointer<GafCoverage> gafCoverage)
+{
+    setDepthSource(GRAPH_DEPTH);
+    m_gafCoverage = gafCoverage;
+}
+
+
+//This function sets every node's depth from the given source.  The graph's
+//own depths are saved when switching away from them, and nodes which aren't
+//in the saved depths (e.g. made by a merge) keep their current depth when
+//switching back.  It returns false if there is no GAF coverage to use.
+bool AssemblyGraph::setDepthSource(DepthSource depthSource)
+{
+    if (depthSource == m_depthSource)
+        return true;
+    if (depthSource != GRAPH_DEPTH && (m_gafCoverage.isNull() || m_gafCoverage->isEmpty()))
+        return false;
+
+    const std::vector<DeBruijnNode *> & nodes = getIndexedNodes();
+    if (m_depthSource == GRAPH_DEPTH)
+    {
+        m_graphDepths.clear();
+        m_graphDepths.reserve(int(nodes.size()));
+        for (size_t i = 0; i < nodes.size(); ++i)
+            m_graphDepths.insert(nodes[i]->getName(), nodes[i]->getDepth());
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        DeBruijnNode * node = nodes[i];
+        if (depthSource == GRAPH_DEPTH)
+            node->setDepth(m_graphDepths.value(node->getName(), node->getDepth()));
+        else
+            node->setDepth(m_gafCoverage->getDepth(node, depthSource));
+    }
+    if (depthSource == GRAPH_DEPTH)
+        m_graphDepths.clear();
+
+    m_depthSource = depthSource;
+    determineGraphInfo();
+    return true;
+}
+
+
+
 //This function is used when making FASTA outputs - it breaks a sequence into
 //separate lines.  The default interval is 70, as that seems to be what NCBI
 //uses.
@@ -3480,19 +4435,8 @@ QByteArray AssemblyGraph::addNewlinesToSequence(QByteArray sequence,
                                                 int interval)
 {
     QByteArray output;
-
-    int charactersRemaining = sequence.length();
-    int currentIndex = 0;
-    while (charactersRemaining > interval)
-    {
-        output += sequence.mid(currentIndex, interval);
-        output += "\n";
-        charactersRemaining -= interval;
-        currentIndex += interval;
-    }
-    output += sequence.mid(currentIndex);
-    output += "\n";
-
+    output.reserve(int(sequence.length() + sequence.length() / std::max(1, interval) + 1));
+    GraphWriter::appendSequenceWithNewlines(&output, sequence, interval);
     return output;
 }
 
@@ -3505,18 +4449,7 @@ QByteArray AssemblyGraph::addNewlinesToSequence(QByteArray sequence,
 //the positive node count).
 int AssemblyGraph::getDeadEndCount() const
 {
-    int deadEndCount = 0;
-
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
-    {
-        i.next();
-        DeBruijnNode * node = i.value();
-        if (node->isPositiveNode())
-            deadEndCount += node->getDeadEndCount();
-    }
-
-    return deadEndCount;
+    return getGraphStatistics().deadEnds;
 }
 
 
@@ -3526,180 +4459,43 @@ void AssemblyGraph::getNodeStats(int * n50, int * shortestNode, int * firstQuart
     if (m_totalLength == 0.0)
         return;
 
-    std::vector<int> nodeLengths;
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
-    {
-        i.next();
-        DeBruijnNode * node = i.value();
-        if (node->isPositiveNode())
-            nodeLengths.push_back(node->getLength());
-    }
-
-    if (nodeLengths.size() == 0)
+    const GraphStatistics & stats = getGraphStatistics();
+    if (stats.nodeCount == 0)
         return;
 
-    std::sort(nodeLengths.begin(), nodeLengths.end());
-
-    *shortestNode = nodeLengths.front();
-    *longestNode = nodeLengths.back();
-
-    double firstQuartileIndex = (nodeLengths.size() - 1) / 4.0;
-    double medianIndex = (nodeLengths.size() - 1) / 2.0;
-    double thirdQuartileIndex = (nodeLengths.size() - 1) * 3.0 / 4.0;
-
-    *firstQuartile = round(getValueUsingFractionalIndex(&nodeLengths, firstQuartileIndex));
-    *median = round(getValueUsingFractionalIndex(&nodeLengths, medianIndex));
-    *thirdQuartile = round(getValueUsingFractionalIndex(&nodeLengths, thirdQuartileIndex));
-
-    double halfTotalLength = m_totalLength / 2.0;
-    long long totalSoFar = 0;
-    for (int i = int(nodeLengths.size()) - 1; i >= 0 ; --i)
-    {
-        totalSoFar += nodeLengths[i];
-        if (totalSoFar >= halfTotalLength)
-        {
-            *n50 = nodeLengths[i];
-            break;
-        }
-    }
+    *n50 = stats.n50;
+    *shortestNode = stats.shortestNode;
+    *firstQuartile = stats.firstQuartile;
+    *median = stats.median;
+    *thirdQuartile = stats.thirdQuartile;
+    *longestNode = stats.longestNode;
 }
 
 
 
-//This function uses an algorithm adapted from: http://math.hws.edu/eck/cs327_s04/chapter9.pdf
 void AssemblyGraph::getGraphComponentCountAndLargestComponentSize(int * componentCount, int * largestComponentLength) const
 {
-    *componentCount = 0;
-    *largestComponentLength = 0;
-
-    QSet<DeBruijnNode *> visitedNodes;
-    QList< QList<DeBruijnNode *> > connectedComponents;
-    
-    //Loop through all positive nodes.
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
-    {
-        i.next();
-        DeBruijnNode * v = i.value();
-        if (v->isNegativeNode())
-            continue;
-        
-        //If the node has not yet been visited, then it must be the start of a new connected component.
-        if (!visitedNodes.contains(v))
-        {
-            QList<DeBruijnNode *> connectedComponent;
-            
-            QQueue<DeBruijnNode *> q;
-            q.enqueue(v);
-            visitedNodes.insert(v);
-
-            while (!q.isEmpty())
-            {
-                DeBruijnNode * w = q.dequeue();
-                connectedComponent.push_back(w);
-
-                std::vector<DeBruijnNode *> connectedNodes = w->getAllConnectedPositiveNodes();
-                for (size_t j = 0; j < connectedNodes.size(); ++j)
-                {
-                    DeBruijnNode * k = connectedNodes[j];
-                    if (!visitedNodes.contains(k))
-                    {
-                        visitedNodes.insert(k);
-                        q.enqueue(k);
-                    }
-                }
-            }
-
-            connectedComponents.push_back(connectedComponent);
-        }  
-    }
-    
-    //Now that the list of connected components is built, we look for the
-    //largest one (as measured by total node length).
-    *componentCount = connectedComponents.size();
-    for (int i = 0; i < *componentCount; ++i)
-    {
-        int componentLength = 0;
-        for (int j = 0; j < connectedComponents[i].size(); ++j)
-            componentLength += connectedComponents[i][j]->getLength();
-
-        if (componentLength > *largestComponentLength)
-            *largestComponentLength = componentLength;
-    }
+    const GraphStatistics & stats = getGraphStatistics();
+    *componentCount = stats.componentCount;
+    *largestComponentLength = int(stats.largestComponentLength);
 }
 
-bool compareNodeDepth(DeBruijnNode * a, DeBruijnNode * b) {return (a->getDepth() < b->getDepth());}
-
 
 
 double AssemblyGraph::getMedianDepthByBase() const
 {
     if (m_totalLength == 0)
         return 0.0;
-
-    //Make a list of all nodes.
-    long long totalLength = 0;
-    QList<DeBruijnNode *> nodeList;
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
-    {
-        i.next();
-        DeBruijnNode * node = i.value();
-        if (node->isPositiveNode())
-        {
-            nodeList.push_back(node);
-            totalLength += node->getLength();
-        }
-    }
-
-    //If there is only one node, then its depth is the median.
-    if (nodeList.size() == 1)
-        return nodeList[0]->getDepth();
-
-    //Sort the node list from low to high depth.
-    std::sort(nodeList.begin(), nodeList.end(), compareNodeDepth);
-
-    if (totalLength % 2 == 0) //Even total length
-    {
-        long long medianIndex2 = totalLength / 2;
-        long long medianIndex1 = medianIndex2 - 1;
-        double depth1 = findDepthAtIndex(&nodeList, medianIndex1);
-        double depth2 = findDepthAtIndex(&nodeList, medianIndex2);
-        return (depth1 + depth2) / 2.0;
-    }
-    else //Odd total length
-    {
-        long long medianIndex = (totalLength - 1) / 2;
-        return findDepthAtIndex(&nodeList, medianIndex);
-    }
-}
-
-
-
-//This function takes a node list sorted by depth and a target index (in terms of
-//the whole sequence length).  It returns the depth at that index.
-double AssemblyGraph::findDepthAtIndex(QList<DeBruijnNode *> * nodeList, long long targetIndex) const
-{
-    long long lengthSoFar = 0;
-    for (int i = 0; i < nodeList->size(); ++i)
-    {
-        DeBruijnNode * node = (*nodeList)[i];
-
-        lengthSoFar += node->getLength();
-        long long currentIndex = lengthSoFar - 1;
-
-        if (currentIndex >= targetIndex)
-            return node->getDepth();
-    }
-    return 0.0;
+    return getGraphStatistics().medianDepthByBase;
 }
 
 
 
 long long AssemblyGraph::getEstimatedSequenceLength() const
 {
-    return getEstimatedSequenceLength(getMedianDepthByBase());
+    if (m_totalLength == 0)
+        return 0;
+    return getGraphStatistics().estimatedSequenceLength;
 }
 
 
@@ -3735,47 +4531,14 @@ long long AssemblyGraph::getEstimatedSequenceLength(double medianDepthByBase) co
 
 long long AssemblyGraph::getTotalLengthMinusEdgeOverlaps() const
 {
-    long long totalLength = 0;
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
-    {
-        i.next();
-        DeBruijnNode * node = i.value();
-        if (node->isPositiveNode())
-        {
-            totalLength += node->getLength();
-            const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
-            int maxOverlap = 0;
-            for (size_t j = 0; j < edges->size(); ++j)
-            {
-                int edgeOverlap = (*edges)[j]->getOverlap();
-                maxOverlap = std::max(maxOverlap, edgeOverlap);
-            }
-            totalLength -= maxOverlap;
-        }
-    }
-
-    return totalLength;
+    return getGraphStatistics().totalLengthNoOverlaps;
 }
 
 
 QPair<int, int> AssemblyGraph::getOverlapRange() const
 {
-    int smallestOverlap = std::numeric_limits<int>::max();
-    int largestOverlap = 0;
-    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> i(m_deBruijnGraphEdges);
-    while (i.hasNext())
-    {
-        i.next();
-        int overlap = i.value()->getOverlap();
-        if (overlap < smallestOverlap)
-            smallestOverlap = overlap;
-        if (overlap > largestOverlap)
-            largestOverlap = overlap;
-    }
-    if (smallestOverlap == std::numeric_limits<int>::max())
-        smallestOverlap = 0;
-    return QPair<int, int>(smallestOverlap, largestOverlap);
+    const GraphStatistics & stats = getGraphStatistics();
+    return QPair<int, int>(stats.smallestOverlap, stats.largestOverlap);
 }
 
 
@@ -3833,6 +4596,9 @@ bool AssemblyGraph::attemptToLoadSequencesFromFasta()
         }
     }
 
+    if (atLeastOneNodeSequenceLoaded)
+        markModified();
+
     return atLeastOneNodeSequenceLoaded;
 }
 
@@ -3875,16 +4641,7 @@ QString AssemblyGraph::simplifyCanuNodeName(QString oldName) const
 }
 
 long long AssemblyGraph::getTotalLengthOrphanedNodes() const {
-    long long total = 0;
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
-    {
-        i.next();
-        DeBruijnNode * node = i.value();
-        if (node->isPositiveNode() && node->getDeadEndCount() == 2)
-            total += node->getLength();
-    }
-    return total;
+    return getGraphStatistics().totalLengthOrphanedNodes;
 }
 
 
@@ -3893,5 +4650,5 @@ bool AssemblyGraph::useLinearLayout() const {
     if (m_edgeCount == 0)
         return true;
     else
-        return g_settings->linearLayout;
+        return m_settings->linearLayout;
 }
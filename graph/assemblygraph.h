@@ -26,23 +26,40 @@
 #include "../ogdf/basic/GraphAttributes.h"
 #include <QString>
 #include <QMap>
+#include <QHash>
 #include "../program/globals.h"
 #include "../ui/mygraphicsscene.h"
 #include "path.h"
+#include "graphstatistics.h"
+#include "nodenameindex.h"
+#include "sequenceindex.h"
+#include "csvtable.h"
 #include <QPair>
+#include <QPointF>
+#include <QElapsedTimer>
+#include <atomic>
 
 class DeBruijnNode;
 class DeBruijnEdge;
 class MyProgressDialog;
+class UnitigCompactor;
+class GafCoverage;
+class QFile;
 
 class AssemblyGraph : public QObject
 {
     Q_OBJECT
 
 public:
-    AssemblyGraph();
+    AssemblyGraph(QSharedPointer<Settings> settings = g_settings);
     ~AssemblyGraph();
 
+    //The settings this graph uses.  This is normally the global settings
+    //object, but a graph worked on in another thread (or one of several graphs
+    //in a process) can be given its own copy so it isn't affected by changes
+    //made elsewhere.
+    QSharedPointer<Settings> m_settings;
+
     //Nodes are stored in a map with a key of the node's name.
     QMap<QString, DeBruijnNode*> m_deBruijnGraphNodes;
 
@@ -71,6 +88,15 @@ public:
     SequencesLoadedFromFasta m_sequencesLoadedFromFasta;
 
     void cleanUp();
+    void markModified() {++m_modificationCount;}
+    const std::vector<DeBruijnNode *> & getIndexedNodes() const;
+    const GraphStatistics & getGraphStatistics() const;
+    const NodeNameIndex & getNodeNameIndex() const;
+    const SequenceIndex & getSequenceIndex() const;
+    std::vector<int> getNodeDistances(const std::vector<DeBruijnNode *> & startingNodes,
+                                      int maxDistance) const;
+    void markNodesAroundStartingNodesAsDrawn(std::vector<DeBruijnNode *> startingNodes,
+                                             int nodeDistance);
     void createDeBruijnEdge(QString node1Name, QString node2Name,
                             int overlap = 0,
                             EdgeOverlapType overlapType = UNKNOWN_OVERLAP);
@@ -87,7 +113,8 @@ public:
     void clearGraphInfo();
     void buildDeBruijnGraphFromLastGraph(QString fullFileName);
     void buildDeBruijnGraphFromGfa(QString fullFileName, bool * unsupportedCigar, bool * customLabels,
-                                   bool * customColours, QString *bandageOptionsError);
+                                   bool * customColours, QString *bandageOptionsError,
+                                   QStringList * bandageOptionsToApply = 0);
     void buildDeBruijnGraphFromFastg(QString fullFileName);
     void buildDeBruijnGraphFromTrinityFasta(QString fullFileName);
     int buildDeBruijnGraphFromAsqg(QString fullFileName);
@@ -105,9 +132,19 @@ public:
     bool checkFirstLineOfFile(QString fullFileName, QString regExp);
 
     bool loadGraphFromFile(QString filename);
+    bool wasLoadCancelled() const {return m_loadCancelled;}
     void buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *> startingNodes,
                                          int nodeDistance);
+    bool canExpandOgdfGraph(std::vector<DeBruijnNode *> startingNodes,
+                            int nodeDistance) const;
+    void expandOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *> startingNodes,
+                                          int nodeDistance);
+    bool hasPinnedOgdfPositions() const {return !m_pinnedOgdfPositions.empty();}
+    std::vector<ogdf::node> getPinnedOgdfNodes() const;
+    void restorePinnedOgdfPositions();
+    std::vector<std::vector<ogdf::node> > getOgdfSegmentChains() const;
     void addGraphicsItemsToScene(MyGraphicsScene * scene);
+    void addNewGraphicsItemsToScene(MyGraphicsScene * scene);
 
     QStringList splitCsv(QString line, QString sep=",");
     bool loadCSV(QString filename, QStringList * columns, QString * errormsg, bool * coloursLoaded);
@@ -115,7 +152,8 @@ public:
                                                  QString * errorMessage,
                                                  bool doubleMode,
                                                  QString nodesList,
-                                                 QString blastQueryName);
+                                                 QString blastQueryName,
+                                                 bool resetDrawnGraph = true);
 
     bool checkIfStringHasNodes(QString nodesString);
     QString generateNodesNotFoundErrorMessage(std::vector<QString> nodesNotInGraph,
@@ -131,7 +169,8 @@ public:
     static void readFastaOrFastqFile(QString filename, std::vector<QString> * names,
                                      std::vector<QByteArray> * sequences);
     static void readFastaFile(QString filename, std::vector<QString> * names,
-                              std::vector<QByteArray> * sequences);
+                              std::vector<QByteArray> * sequences,
+                              AssemblyGraph * loadingGraph = 0);
     static void readFastqFile(QString filename, std::vector<QString> * names,
                               std::vector<QByteArray> * sequences);
 
@@ -172,10 +211,65 @@ public:
     long long getTotalLengthOrphanedNodes() const;
     bool useLinearLayout() const;
     void clearAllCsvData();
+    const CsvTable & getCsvTable() const {return m_csvTable;}
+    QSharedPointer<GafCoverage> getGafCoverage() const {return m_gafCoverage;}
+    void setGafCoverage(QSharedPointer<GafCoverage> gafCoverage);
+    DepthSource getDepthSource() const {return m_depthSource;}
+    bool setDepthSource(DepthSource depthSource);
 
 
 private:
-    template<typename T> double getValueUsingFractionalIndex(std::vector<T> * v, double index) const;
+    //Every modification of the graph increments this count, which lets the
+    //cached node index and statistics know when they are out of date.
+    unsigned long long m_modificationCount;
+    mutable std::vector<DeBruijnNode *> m_indexedNodes;
+    mutable unsigned long long m_indexedNodesModificationCount;
+    mutable GraphStatistics m_graphStatistics;
+    mutable unsigned long long m_graphStatisticsModificationCount;
+    mutable NodeNameIndex m_nodeNameIndex;
+    mutable unsigned long long m_nodeNameIndexModificationCount;
+    mutable SequenceIndex m_sequenceIndex;
+    mutable unsigned long long m_sequenceIndexModificationCount;
+
+    //The data loaded from a CSV file.  Each node with data holds the index of
+    //its row.
+    CsvTable m_csvTable;
+
+    //These describe what the current OGDF graph was built from, so a redraw
+    //that only increases the node distance can extend the existing layout
+    //instead of starting again from scratch.
+    unsigned long long m_ogdfGraphModificationCount;
+    std::vector<DeBruijnNode *> m_ogdfGraphStartingNodes;
+    int m_ogdfGraphNodeDistance;
+    std::vector<double> m_ogdfGraphLayoutSettings;
+
+    //When the OGDF graph is expanded, the positions of the nodes which were
+    //already drawn are stored here so they can be put back after layout.
+    std::vector<std::pair<ogdf::node, QPointF> > m_pinnedOgdfPositions;
+
+    //A graph can be loaded in a different thread, in which case the loader
+    //reports its progress every so often and stops if the load is cancelled.
+    std::atomic<bool> m_loadCancelled;
+    long long m_loadProgressLineCount;
+    QElapsedTimer m_loadProgressTimer;
+    qint64 m_loadBytesRead;
+    qint64 m_loadTotalBytes;
+
+    //Node depths can come from the graph file or from GAF coverage.  While
+    //GAF coverage is in use, the graph's own depths are kept here, by node
+    //name, so they can be put back.
+    QSharedPointer<GafCoverage> m_gafCoverage;
+    DepthSource m_depthSource;
+    QHash<QString, double> m_graphDepths;
+
+    void reportLoadProgress(const QFile * file = 0);
+    void recordOgdfGraphScope(std::vector<DeBruijnNode *> startingNodes, int nodeDistance);
+    std::vector<DeBruijnNode *> getScopeStartingNodes(std::vector<DeBruijnNode *> startingNodes) const;
+    std::vector<double> getOgdfGraphLayoutSettings() const;
+    void pinOgdfPositionsFromGraphicsItems();
+    void placeNewOgdfNodesNearNeighbours(const std::vector<DeBruijnNode *> & newNodes);
+    bool saveGfa(QString filename, const std::vector<DeBruijnNode *> & nodesToSave,
+                 const std::vector<DeBruijnEdge *> & edgesToSave);
     QString convertNormalNumberStringToBandageNodeName(QString number);
     void makeReverseComplementNodeIfNecessary(DeBruijnNode * node);
     void pointEachNodeToItsReverseComplement();
@@ -203,17 +297,24 @@ private:
                             DeBruijnNode * newNode, MyGraphicsScene * scene);
     bool mergeGraphicsNodes2(QList<DeBruijnNode *> * originalNodes,
                              DeBruijnNode * newNode, MyGraphicsScene * scene);
+    bool makeMergedGraphicsItemNode(QList<DeBruijnNode *> * originalNodes,
+                                    DeBruijnNode * newNode, MyGraphicsScene * scene);
+    void addGraphicsItemEdges(DeBruijnNode * node, MyGraphicsScene * scene);
+    void applyUnitigMerges(const UnitigCompactor * compactor, MyGraphicsScene * scene);
     void removeAllGraphicsEdgesFromNode(DeBruijnNode * node,
                                         bool reverseComplement,
                                         MyGraphicsScene * scene);
     QString cleanNodeName(QString name);
-    double findDepthAtIndex(QList<DeBruijnNode *> * nodeList, long long targetIndex) const;
     bool allNodesStartWith(QString start) const;
     QString simplifyCanuNodeName(QString oldName) const;
 
+public slots:
+    void cancelLoad() {m_loadCancelled = true;}
+
 signals:
     void setMergeTotalCount(int totalCount);
     void setMergeCompletedCount(int completedCount);
+    void loadProgress(qint64 bytesRead, qint64 totalBytes, int nodeCount, int edgeCount);
 };
 
 #endif // ASSEMBLYGRAPH_H
@@ -0,0 +1,458 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "contiguitysearch.h"
+#include "debruijnnode.h"
+#include "debruijnedge.h"
+#include <algorithm>
+
+namespace
+{
+void insertSorted(std::vector<int> * values, int value)
+{
+    std::vector<int>::iterator i = std::lower_bound(values->begin(), values->end(), value);
+    if (i == values->end() || *i != value)
+        values->insert(i, value);
+}
+
+void intersectSorted(std::vector<int> * values, const std::vector<int> & otherValues)
+{
+    std::vector<int> intersection;
+    std::set_intersection(values->begin(), values->end(), otherValues.begin(), otherValues.end(),
+                          std::back_inserter(intersection));
+    values->swap(intersection);
+}
+}
+
+
+ContiguitySearch::ContiguitySearch(const std::vector<DeBruijnNode *> & indexedNodes, int searchSteps,
+                                   long long visitBudget) :
+    m_nodes(indexedNodes), m_searchSteps(searchSteps), m_visitBudget(visitBudget), m_visitCount(0),
+    m_cancelled(false), m_budgetExceeded(false), m_timesInPath(indexedNodes.size(), 0),
+    m_inAnyPath(indexedNodes.size(), 0), m_pathStart(0), m_target(0), m_includeReverseComplement(false)
+{
+    //The search starts from the nodes' current statuses, as each search only
+    //upgrades statuses.
+    m_statuses.reserve(m_nodes.size());
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+        m_statuses.push_back(m_nodes[i]->getContiguityStatus());
+}
+
+
+ContiguityStatus ContiguitySearch::getContiguityStatus(const DeBruijnNode * node) const
+{
+    return m_statuses[node->getId()];
+}
+
+
+//This function must be called from the thread which owns the graph.
+void ContiguitySearch::applyStatuses() const
+{
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+        m_nodes[i]->upgradeContiguityStatus(m_statuses[i]);
+}
+
+
+void ContiguitySearch::upgradeStatus(int nodeId, ContiguityStatus newStatus)
+{
+    if (newStatus < m_statuses[nodeId])
+        m_statuses[nodeId] = newStatus;
+}
+
+
+//This function returns false if the search should stop.
+bool ContiguitySearch::visit()
+{
+    ++m_visitCount;
+    if (m_cancelled.load(std::memory_order_relaxed))
+        return false;
+    if (m_visitCount > m_visitBudget)
+    {
+        m_budgetExceeded = true;
+        return false;
+    }
+    return true;
+}
+
+
+//This function returns the number of times a node is in the current path and
+//records that the steps in progress depend on it.
+int ContiguitySearch::checkNode(int nodeId)
+{
+    m_checkedNodes.push_back(nodeId);
+    return m_timesInPath[nodeId];
+}
+
+
+std::vector<DeBruijnEdge *> ContiguitySearch::findNextEdges(const DeBruijnNode * node, bool forward)
+{
+    std::vector<DeBruijnEdge *> nextEdges;
+    const std::vector<DeBruijnEdge *> * nodeEdges = node->getEdgesPointer();
+    for (size_t i = 0; i < nodeEdges->size(); ++i)
+    {
+        DeBruijnEdge * edge = (*nodeEdges)[i];
+        if ((forward && edge->getStartingNode() == node) ||
+                (!forward && edge->getEndingNode() == node))
+            nextEdges.push_back(edge);
+    }
+    return nextEdges;
+}
+
+
+const ContiguitySearch::RememberedStep * ContiguitySearch::findRememberedStep(const StepKey & key) const
+{
+    std::unordered_map<StepKey, RememberedStep, StepKeyHash>::const_iterator i = m_rememberedSteps.find(key);
+    if (i == m_rememberedSteps.end())
+        return 0;
+
+    const std::vector<std::pair<int, int> > & dependencies = i->second.dependencies;
+    for (size_t j = 0; j < dependencies.size(); ++j)
+    {
+        if (m_timesInPath[dependencies[j].first] != dependencies[j].second)
+            return 0;
+    }
+    return &(i->second);
+}
+
+
+//The nodes checked since firstCheckedNode are the step's dependencies.  They
+//are deduplicated here, which also keeps m_checkedNodes from growing large.
+void ContiguitySearch::rememberStep(const StepKey & key, size_t firstCheckedNode, const RememberedStep & step)
+{
+    std::vector<int>::iterator first = m_checkedNodes.begin() + firstCheckedNode;
+    std::sort(first, m_checkedNodes.end());
+    m_checkedNodes.erase(std::unique(first, m_checkedNodes.end()), m_checkedNodes.end());
+
+    RememberedStep & rememberedStep = m_rememberedSteps[key];
+    rememberedStep = step;
+    rememberedStep.dependencies.clear();
+    rememberedStep.dependencies.reserve(m_checkedNodes.size() - firstCheckedNode);
+    for (size_t i = firstCheckedNode; i < m_checkedNodes.size(); ++i)
+    {
+        int nodeId = m_checkedNodes[i];
+        rememberedStep.dependencies.push_back(std::pair<int, int>(nodeId, m_timesInPath[nodeId]));
+    }
+}
+
+
+//This function finds the contiguity of nodes relative to the starting node,
+//upgrading the statuses held in this object.  It returns false if the search
+//was cancelled or ran out of budget.  Any statuses already found are still
+//correct, but others may be missing.
+bool ContiguitySearch::determineContiguity(DeBruijnNode * startingNode)
+{
+    upgradeStatus(startingNode->getId(), STARTING);
+
+    m_pathStart = startingNode;
+    m_rememberedSteps.clear();
+    for (size_t i = 0; i < m_nodesInAnyPath.size(); ++i)
+        m_inAnyPath[m_nodesInAnyPath[i]] = 0;
+    m_nodesInAnyPath.clear();
+
+    //For each path leaving this node, find all possible paths outward.  Nodes
+    //in any of the paths for an edge are MAYBE_CONTIGUOUS.  Nodes in all of
+    //the paths for an edge are CONTIGUOUS.
+    bool completed = true;
+    const std::vector<DeBruijnEdge *> * edges = startingNode->getEdgesPointer();
+    for (size_t i = 0; i < edges->size(); ++i)
+    {
+        DeBruijnEdge * edge = (*edges)[i];
+        bool outgoingEdge = (startingNode == edge->getStartingNode());
+
+        PathSummary summary;
+        m_checkedNodes.clear();
+        if (!findPathSummary(edge, outgoingEdge, m_searchSteps, &summary))
+        {
+            completed = false;
+            break;
+        }
+        if (!summary.hasPath)
+            continue;
+
+        for (size_t j = 0; j < summary.commonNodes.size(); ++j)
+            upgradeStatus(summary.commonNodes[j], CONTIGUOUS_STRAND_SPECIFIC);
+
+        //Nodes from the first path which are in all of the paths (when
+        //including reverse complement nodes) are CONTIGUOUS_EITHER_STRAND.
+        std::vector<int> commonNodesEitherStrand = summary.firstPathNodes;
+        intersectSorted(&commonNodesEitherStrand, summary.commonNodesEitherStrand);
+        for (size_t j = 0; j < commonNodesEitherStrand.size(); ++j)
+        {
+            DeBruijnNode * node = m_nodes[commonNodesEitherStrand[j]];
+            upgradeStatus(node->getId(), CONTIGUOUS_EITHER_STRAND);
+            upgradeStatus(node->getReverseComplement()->getId(), CONTIGUOUS_EITHER_STRAND);
+        }
+    }
+
+    std::vector<int> allCheckedNodes = m_nodesInAnyPath;
+    std::sort(allCheckedNodes.begin(), allCheckedNodes.end());
+    for (size_t i = 0; i < allCheckedNodes.size(); ++i)
+        upgradeStatus(allCheckedNodes[i], MAYBE_CONTIGUOUS);
+    if (!completed)
+        return false;
+
+    //For each node that was checked, then we check to see if any of its paths
+    //leads unambiguously back to the starting node.
+    for (size_t i = 0; i < allCheckedNodes.size(); ++i)
+    {
+        DeBruijnNode * node = m_nodes[allCheckedNodes[i]];
+        ContiguityStatus status = m_statuses[node->getId()];
+
+        //First check without reverse complement target for strand-specific
+        //contiguity.
+        bool leadsOnlyToNode;
+        if (status != CONTIGUOUS_STRAND_SPECIFIC)
+        {
+            if (!doesPathLeadOnlyToNode(node, startingNode, false, &leadsOnlyToNode))
+                return false;
+            if (leadsOnlyToNode)
+                upgradeStatus(node->getId(), CONTIGUOUS_STRAND_SPECIFIC);
+        }
+
+        //Now check including the reverse complement target for either strand
+        //contiguity.
+        if (status != CONTIGUOUS_STRAND_SPECIFIC && status != CONTIGUOUS_EITHER_STRAND)
+        {
+            if (!doesPathLeadOnlyToNode(node, startingNode, true, &leadsOnlyToNode))
+                return false;
+            if (leadsOnlyToNode)
+            {
+                upgradeStatus(node->getId(), CONTIGUOUS_EITHER_STRAND);
+                upgradeStatus(node->getReverseComplement()->getId(), CONTIGUOUS_EITHER_STRAND);
+            }
+        }
+    }
+
+    return true;
+}
+
+
+//This function gets the summary of all paths from an edge, using a
+//remembered one if possible.
+bool ContiguitySearch::findPathSummary(DeBruijnEdge * edge, bool forward, int stepsRemaining,
+                                       PathSummary * summary)
+{
+    StepKey key = {edge, stepsRemaining, forward};
+    const RememberedStep * rememberedStep = findRememberedStep(key);
+    if (rememberedStep != 0)
+    {
+        for (size_t i = 0; i < rememberedStep->dependencies.size(); ++i)
+            m_checkedNodes.push_back(rememberedStep->dependencies[i].first);
+        *summary = rememberedStep->summary;
+        return true;
+    }
+
+    size_t firstCheckedNode = m_checkedNodes.size();
+    RememberedStep step;
+    if (!tracePaths(edge, forward, stepsRemaining, &step.summary))
+        return false;
+    step.leadsOnlyToTarget = false;
+    rememberStep(key, firstCheckedNode, step);
+    *summary = step.summary;
+    return true;
+}
+
+
+//This function follows all possible paths from this edge, as far as the
+//search steps allow.  If forward is true, it looks in a forward direction
+//(starting nodes to ending nodes).  If forward is false, it looks in a
+//backward direction (ending nodes to starting nodes).
+//A path is complete when it runs out of steps, reaches a dead end or loops
+//back to the starting node.  A path which would include a node for a third
+//time is caught in a loop and is thrown out.
+bool ContiguitySearch::tracePaths(DeBruijnEdge * edge, bool forward, int stepsRemaining,
+                                  PathSummary * summary)
+{
+    if (!visit())
+        return false;
+
+    DeBruijnNode * nextNode = forward ? edge->getEndingNode() : edge->getStartingNode();
+    int nextNodeId = nextNode->getId();
+    ++m_timesInPath[nextNodeId];
+    --stepsRemaining;
+
+    std::vector<DeBruijnEdge *> nextEdges;
+    if (stepsRemaining > 0)
+        nextEdges = findNextEdges(nextNode, forward);
+
+    //Each complete path beyond this node narrows down the common nodes.  A
+    //path that ends here has no nodes beyond this one.
+    PathSummary pathEnd;
+    pathEnd.hasPath = true;
+    summary->hasPath = false;
+    if (nextEdges.size() == 0)
+        *summary = pathEnd;
+    for (size_t i = 0; i < nextEdges.size(); ++i)
+    {
+        DeBruijnEdge * nextEdge = nextEdges[i];
+        DeBruijnNode * nextNextNode = forward ? nextEdge->getEndingNode() : nextEdge->getStartingNode();
+
+        const PathSummary * nextSummary = &pathEnd;
+        PathSummary nextEdgeSummary;
+        if (nextNextNode != m_pathStart)
+        {
+            if (checkNode(nextNextNode->getId()) >= 2)
+                continue;
+            if (!findPathSummary(nextEdge, forward, stepsRemaining, &nextEdgeSummary))
+            {
+                --m_timesInPath[nextNodeId];
+                return false;
+            }
+            if (!nextEdgeSummary.hasPath)
+                continue;
+            nextSummary = &nextEdgeSummary;
+        }
+
+        if (!summary->hasPath)
+            *summary = *nextSummary;
+        else
+        {
+            intersectSorted(&summary->commonNodes, nextSummary->commonNodes);
+            intersectSorted(&summary->commonNodesEitherStrand, nextSummary->commonNodesEitherStrand);
+        }
+    }
+
+    --m_timesInPath[nextNodeId];
+
+    if (summary->hasPath)
+    {
+        insertSorted(&summary->commonNodes, nextNodeId);
+        insertSorted(&summary->commonNodesEitherStrand, nextNodeId);
+        insertSorted(&summary->commonNodesEitherStrand, nextNode->getReverseComplement()->getId());
+        insertSorted(&summary->firstPathNodes, nextNodeId);
+        if (!m_inAnyPath[nextNodeId])
+        {
+            m_inAnyPath[nextNodeId] = 1;
+            m_nodesInAnyPath.push_back(nextNodeId);
+        }
+    }
+    return true;
+}
+
+
+//This function checks whether this node has any path leading outward that
+//unambiguously leads to the target node.  If includeReverseComplement is
+//true, then paths may lead to either the target or its reverse complement.
+bool ContiguitySearch::doesPathLeadOnlyToNode(DeBruijnNode * node, DeBruijnNode * target,
+                                              bool includeReverseComplement, bool * result)
+{
+    m_pathStart = node;
+    m_target = target;
+    m_includeReverseComplement = includeReverseComplement;
+    m_rememberedSteps.clear();
+
+    *result = false;
+    ++m_timesInPath[node->getId()];
+    const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+    for (size_t i = 0; i < edges->size(); ++i)
+    {
+        DeBruijnEdge * edge = (*edges)[i];
+        bool outgoingEdge = (node == edge->getStartingNode());
+
+        m_checkedNodes.clear();
+        bool leadsOnlyToNode;
+        if (!findLeadsOnlyToTarget(edge, outgoingEdge, m_searchSteps, &leadsOnlyToNode))
+        {
+            --m_timesInPath[node->getId()];
+            return false;
+        }
+        if (leadsOnlyToNode)
+        {
+            *result = true;
+            break;
+        }
+    }
+    --m_timesInPath[node->getId()];
+    return true;
+}
+
+
+bool ContiguitySearch::findLeadsOnlyToTarget(DeBruijnEdge * edge, bool forward, int stepsRemaining,
+                                             bool * result)
+{
+    StepKey key = {edge, stepsRemaining, forward};
+    const RememberedStep * rememberedStep = findRememberedStep(key);
+    if (rememberedStep != 0)
+    {
+        for (size_t i = 0; i < rememberedStep->dependencies.size(); ++i)
+            m_checkedNodes.push_back(rememberedStep->dependencies[i].first);
+        *result = rememberedStep->leadsOnlyToTarget;
+        return true;
+    }
+
+    size_t firstCheckedNode = m_checkedNodes.size();
+    RememberedStep step;
+    if (!leadsOnlyToTarget(edge, forward, stepsRemaining, &step.leadsOnlyToTarget))
+        return false;
+    rememberStep(key, firstCheckedNode, step);
+    *result = step.leadsOnlyToTarget;
+    return true;
+}
+
+
+//A path from an edge leads only to the target if every way of continuing it
+//reaches the target within the search steps.  A path which loops back to its
+//start fails, because it could represent circular DNA without the target.
+bool ContiguitySearch::leadsOnlyToTarget(DeBruijnEdge * edge, bool forward, int stepsRemaining,
+                                         bool * result)
+{
+    if (!visit())
+        return false;
+
+    DeBruijnNode * nextNode = forward ? edge->getEndingNode() : edge->getStartingNode();
+    int nextNodeId = nextNode->getId();
+    ++m_timesInPath[nextNodeId];
+    --stepsRemaining;
+
+    if (nextNode == m_pathStart)
+        *result = false;
+    else if (nextNode == m_target)
+        *result = true;
+    else if (m_includeReverseComplement && nextNode->getReverseComplement() == m_target)
+        *result = true;
+    else if (stepsRemaining == 0)
+        *result = false;
+    else
+    {
+        std::vector<DeBruijnEdge *> nextEdges = findNextEdges(nextNode, forward);
+        *result = (nextEdges.size() > 0);
+        for (size_t i = 0; i < nextEdges.size(); ++i)
+        {
+            DeBruijnEdge * nextEdge = nextEdges[i];
+            DeBruijnNode * nextNextNode = forward ? nextEdge->getEndingNode() : nextEdge->getStartingNode();
+            if (checkNode(nextNextNode->getId()) >= 2)
+                continue;
+
+            bool nextLeadsOnlyToTarget;
+            if (!findLeadsOnlyToTarget(nextEdge, forward, stepsRemaining, &nextLeadsOnlyToTarget))
+            {
+                --m_timesInPath[nextNodeId];
+                return false;
+            }
+            if (!nextLeadsOnlyToTarget)
+            {
+                *result = false;
+                break;
+            }
+        }
+    }
+
+    --m_timesInPath[nextNodeId];
+    return true;
+}
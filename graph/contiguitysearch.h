@@ -0,0 +1,150 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef CONTIGUITYSEARCH_H
+#define CONTIGUITYSEARCH_H
+
+//This class determines the contiguity of nodes relative to one or more
+//starting nodes.  It has two steps:
+// -First, for each edge leaving a starting node, all paths outward are found.
+//  Any nodes in any path are MAYBE_CONTIGUOUS, and nodes in all of the
+//  paths are CONTIGUOUS.
+// -Second, it is necessary to check in the opposite direction - for each
+//  of the MAYBE_CONTIGUOUS nodes, do they have a path that unambiguously
+//  leads to the starting node?  If so, then they are CONTIGUOUS.
+//
+//The paths are never stored.  Instead, each step of the search returns a
+//summary of the paths beyond it (which nodes are in all of them, which are in
+//the first one), and these summaries are remembered so that a part of the
+//graph reached by many different routes is only searched once.  A summary is
+//only reused when the path leading to it would make no difference to the
+//search, so the results are the same as a full search of every path.
+//
+//The search only reads the graph, so it can run in a separate thread.  The
+//results are held here until applyStatuses is called.  The search stops early
+//if it is cancelled or if it takes more steps than its visit budget.
+//
+//The search keeps its own copy of the node index, as the graph remakes its
+//index whenever it is modified.
+
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+#include <functional>
+#include "../program/globals.h"
+
+class DeBruijnNode;
+class DeBruijnEdge;
+
+class ContiguitySearch
+{
+public:
+    //CREATORS
+    ContiguitySearch(const std::vector<DeBruijnNode *> & indexedNodes, int searchSteps,
+                     long long visitBudget = 100000000);
+
+    //ACCESSORS
+    ContiguityStatus getContiguityStatus(const DeBruijnNode * node) const;
+    bool wasCancelled() const {return m_cancelled;}
+    bool wasBudgetExceeded() const {return m_budgetExceeded;}
+    long long getVisitCount() const {return m_visitCount;}
+    void applyStatuses() const;
+
+    //MODIFERS
+    bool determineContiguity(DeBruijnNode * startingNode);
+    void cancel() {m_cancelled = true;}
+
+private:
+    struct PathSummary
+    {
+        bool hasPath;
+        std::vector<int> commonNodes;
+        std::vector<int> commonNodesEitherStrand;
+        std::vector<int> firstPathNodes;
+    };
+
+    //A remembered search step.  The dependencies are the nodes whose path
+    //counts were checked in the step, with their counts in the path leading
+    //to it.  The step can be reused wherever those counts are the same.
+    struct RememberedStep
+    {
+        std::vector<std::pair<int, int> > dependencies;
+        PathSummary summary;
+        bool leadsOnlyToTarget;
+    };
+
+    struct StepKey
+    {
+        const DeBruijnEdge * edge;
+        int stepsRemaining;
+        bool forward;
+        bool operator==(const StepKey & other) const
+        {
+            return edge == other.edge && stepsRemaining == other.stepsRemaining && forward == other.forward;
+        }
+    };
+
+    struct StepKeyHash
+    {
+        std::size_t operator()(const StepKey & key) const
+        {
+            return std::hash<const void *>()(key.edge) ^ (std::size_t(key.stepsRemaining) << 1) ^ std::size_t(key.forward);
+        }
+    };
+
+    std::vector<DeBruijnNode *> m_nodes;
+    int m_searchSteps;
+    long long m_visitBudget;
+    long long m_visitCount;
+    std::atomic<bool> m_cancelled;
+    bool m_budgetExceeded;
+    std::vector<ContiguityStatus> m_statuses;
+
+    //The current path, as a count for each node, and the nodes whose counts
+    //have been checked by the steps in progress.
+    std::vector<int> m_timesInPath;
+    std::vector<int> m_checkedNodes;
+
+    //The nodes found in any path during the first step.
+    std::vector<char> m_inAnyPath;
+    std::vector<int> m_nodesInAnyPath;
+
+    std::unordered_map<StepKey, RememberedStep, StepKeyHash> m_rememberedSteps;
+
+    //The node that paths begin from (and must not loop back to), and the
+    //target node for the second step.
+    DeBruijnNode * m_pathStart;
+    DeBruijnNode * m_target;
+    bool m_includeReverseComplement;
+
+    void upgradeStatus(int nodeId, ContiguityStatus newStatus);
+    bool visit();
+    int checkNode(int nodeId);
+    static std::vector<DeBruijnEdge *> findNextEdges(const DeBruijnNode * node, bool forward);
+    const RememberedStep * findRememberedStep(const StepKey & key) const;
+    void rememberStep(const StepKey & key, std::size_t firstCheckedNode, const RememberedStep & step);
+    bool tracePaths(DeBruijnEdge * edge, bool forward, int stepsRemaining, PathSummary * summary);
+    bool findPathSummary(DeBruijnEdge * edge, bool forward, int stepsRemaining, PathSummary * summary);
+    bool leadsOnlyToTarget(DeBruijnEdge * edge, bool forward, int stepsRemaining, bool * result);
+    bool findLeadsOnlyToTarget(DeBruijnEdge * edge, bool forward, int stepsRemaining, bool * result);
+    bool doesPathLeadOnlyToNode(DeBruijnNode * node, DeBruijnNode * target, bool includeReverseComplement,
+                                bool * result);
+};
+
+#endif // CONTIGUITYSEARCH_H
@@ -0,0 +1,185 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "csvtable.h"
+#include "../program/parallel.h"
+#include <string.h>
+
+CsvTable::CsvTable() :
+    m_rowCount(0)
+{
+}
+
+
+void CsvTable::clear()
+{
+    m_columns.clear();
+    m_rowCount = 0;
+}
+
+
+void CsvTable::setHeaders(QStringList headers)
+{
+    clear();
+    m_columns.resize(headers.size());
+    for (int i = 0; i < headers.size(); ++i)
+        m_columns[i].m_header = headers[i];
+}
+
+
+QStringList CsvTable::getHeaders() const
+{
+    QStringList headers;
+    for (size_t i = 0; i < m_columns.size(); ++i)
+        headers.push_back(m_columns[i].m_header);
+    return headers;
+}
+
+
+//This function returns -1 if the row or column is out of range.
+int CsvTable::getValueId(int row, int column) const
+{
+    if (row < 0 || row >= m_rowCount || column < 0 || column >= getColumnCount())
+        return -1;
+    return m_columns[column].m_valueIds[row];
+}
+
+
+QString CsvTable::getValue(int row, int column) const
+{
+    int valueId = getValueId(row, column);
+    if (valueId < 0)
+        return "";
+    return m_columns[column].m_values[valueId];
+}
+
+
+QStringList CsvTable::getRow(int row) const
+{
+    QStringList values;
+    if (row < 0 || row >= m_rowCount)
+        return values;
+    for (int i = 0; i < getColumnCount(); ++i)
+        values.push_back(getValue(row, i));
+    return values;
+}
+
+
+//This function splits one line into fields.  A field in double quotes may
+//contain the separator, and a pair of double quotes inside it stands for one
+//double quote.  Fields without escapes point into the line's own memory, so
+//the line must outlive them.
+void CsvTable::splitLine(const char * begin, const char * end, char separator,
+                         std::vector<QByteArray> * fields)
+{
+    fields->clear();
+    const char * fieldStart = begin;
+    while (true)
+    {
+        if (fieldStart < end && *fieldStart == '"')
+        {
+            const char * c = fieldStart + 1;
+            bool escaped = false;
+            bool closed = false;
+            while (c < end)
+            {
+                if (*c == '"')
+                {
+                    if (c + 1 < end && c[1] == '"')
+                    {
+                        escaped = true;
+                        c += 2;
+                        continue;
+                    }
+                    closed = true;
+                    break;
+                }
+                ++c;
+            }
+
+            if (closed)
+            {
+                QByteArray field = QByteArray::fromRawData(fieldStart + 1, int(c - fieldStart - 1));
+                if (escaped)
+                    field.replace("\"\"", "\"");
+                fields->push_back(field);
+
+                //Anything between the closing quote and the next separator
+                //is ignored.
+                const char * next = (const char *)memchr(c + 1, separator, end - c - 1);
+                if (next == 0)
+                    return;
+                fieldStart = next + 1;
+                continue;
+            }
+        }
+
+        const char * fieldEnd = (const char *)memchr(fieldStart, separator, end - fieldStart);
+        if (fieldEnd == 0)
+            fieldEnd = end;
+        QByteArray field = QByteArray::fromRawData(fieldStart, int(fieldEnd - fieldStart));
+        if (memchr(fieldStart, '"', fieldEnd - fieldStart) != 0)
+            field.replace("\"\"", "\"");
+        fields->push_back(field);
+
+        if (fieldEnd == end)
+            return;
+        fieldStart = fieldEnd + 1;
+    }
+}
+
+
+//The values are given row by row (rowCount rows of getColumnCount() values).
+//Each column has its own set of distinct values, so the columns are filled
+//in parallel.  Value IDs are given in order of first appearance.
+void CsvTable::addRows(const std::vector<QByteArray> & values, int rowCount)
+{
+    int columnCount = getColumnCount();
+    parallelForChunks(columnCount, [&](int, long long begin, long long end)
+    {
+        for (long long i = begin; i < end; ++i)
+        {
+            Column & column = m_columns[i];
+            for (int row = 0; row < rowCount; ++row)
+            {
+                const QByteArray & text = values[size_t(row) * columnCount + i];
+                QHash<QByteArray, int>::const_iterator found = column.m_valueIdsByText.constFind(text);
+                int valueId;
+                if (found == column.m_valueIdsByText.constEnd())
+                {
+                    valueId = int(column.m_values.size());
+                    column.m_values.push_back(QString::fromUtf8(text));
+                    column.m_valueIdsByText.insert(QByteArray(text.constData(), text.size()), valueId);
+                }
+                else
+                    valueId = found.value();
+                column.m_valueIds.push_back(valueId);
+            }
+        }
+    }, 1);
+    m_rowCount += rowCount;
+}
+
+
+//This function is called once all rows are added.  It frees the lookup used
+//while adding rows.
+void CsvTable::finishLoading()
+{
+    for (size_t i = 0; i < m_columns.size(); ++i)
+        m_columns[i].m_valueIdsByText = QHash<QByteArray, int>();
+}
@@ -0,0 +1,72 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CSVTABLE_H
+#define CSVTABLE_H
+
+//This class holds the data loaded from a CSV file, one column at a time.
+//Each column keeps its distinct values once and stores a value ID for every
+//row, so a column of repeated categories costs four bytes per row and not a
+//string per row.
+//
+//Nodes refer to their row by index (see DeBruijnNode::getCsvRow), so reading
+//a node's value is two array lookups.
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <vector>
+
+class CsvTable
+{
+public:
+    //CREATORS
+    CsvTable();
+
+    //ACCESSORS
+    int getColumnCount() const {return int(m_columns.size());}
+    int getRowCount() const {return m_rowCount;}
+    QStringList getHeaders() const;
+    QString getValue(int row, int column) const;
+    QStringList getRow(int row) const;
+    int getValueId(int row, int column) const;
+    const std::vector<QString> & getDistinctValues(int column) const {return m_columns[column].m_values;}
+    static void splitLine(const char * begin, const char * end, char separator,
+                          std::vector<QByteArray> * fields);
+
+    //MODIFERS
+    void clear();
+    void setHeaders(QStringList headers);
+    void addRows(const std::vector<QByteArray> & values, int rowCount);
+    void finishLoading();
+
+private:
+    struct Column
+    {
+        QString m_header;
+        std::vector<int> m_valueIds;
+        std::vector<QString> m_values;
+        QHash<QByteArray, int> m_valueIdsByText;
+    };
+
+    std::vector<Column> m_columns;
+    int m_rowCount;
+};
+
+#endif // CSVTABLE_H
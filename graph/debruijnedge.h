@@ -33,6 +33,7 @@ public:
     //ACCESSORS
     bool isStartingNode(DeBruijnNode * node) const {return node == m_startingNode;}
     DeBruijnNode * getStartingNode() const {return m_startingNode;}
+    AssemblyGraph * getAssemblyGraph() const {return m_startingNode->getAssemblyGraph();}
     DeBruijnNode * getEndingNode() const {return m_endingNode;}
     GraphicsItemEdge * getGraphicsItemEdge() const {return m_graphicsItemEdge;}
     DeBruijnEdge * getReverseComplement() const {return m_reverseComplement;}
@@ -41,16 +42,6 @@ public:
     EdgeOverlapType getOverlapType() const {return m_overlapType;}
     DeBruijnNode * getOtherNode(const DeBruijnNode * node) const;
     bool testExactOverlap(int overlap) const;
-    void tracePaths(bool forward,
-                    int stepsRemaining,
-                    std::vector<std::vector<DeBruijnNode *> > * allPaths,
-                    DeBruijnNode * startingNode,
-                    std::vector<DeBruijnNode *> pathSoFar = std::vector<DeBruijnNode *>()) const;
-    bool leadsOnlyToNode(bool forward,
-                         int stepsRemaining,
-                         DeBruijnNode * target,
-                         std::vector<DeBruijnNode *> pathSoFar,
-                         bool includeReverseComplement) const;
     QByteArray getGfaLinkLine() const;
     bool isPositiveEdge() const;
     bool isNegativeEdge() const {return !isPositiveEdge();}
@@ -78,9 +69,6 @@ private:
     int m_overlap;
 
     bool edgeIsVisible() const;
-    int timesNodeInPath(DeBruijnNode * node, std::vector<DeBruijnNode *> * path) const;
-    std::vector<DeBruijnEdge *> findNextEdgesInPath(DeBruijnNode * nextNode,
-                                                    bool forward) const;
 };
 
 #endif // DEBRUIJNEDGE_H
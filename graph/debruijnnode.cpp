@@ -24,15 +24,19 @@
 #include "../blast/blasthit.h"
 #include "../blast/blastquery.h"
 #include "assemblygraph.h"
-#include <set>
-#include <QApplication>
+#include "graphwriter.h"
 #include <QSet>
 
 
 //The length parameter is optional.  If it is set, then the node will use that
 //for its length.  If not set, it will just use the sequence length.
-DeBruijnNode::DeBruijnNode(QString name, double depth, QByteArray sequence, int length) :
+//The node uses its graph (not the global one) for the graph's file type, k-mer
+//size and settings, so nodes in different graphs don't affect each other.
+DeBruijnNode::DeBruijnNode(AssemblyGraph * assemblyGraph, QString name, double depth,
+                           QByteArray sequence, int length) :
+    m_assemblyGraph(assemblyGraph),
     m_name(name),
+    m_id(-1),
     m_depth(depth),
     m_readSupportCount(-1),
     m_depthRelativeToMeanDrawnDepth(1.0),
@@ -44,8 +48,8 @@ DeBruijnNode::DeBruijnNode(QString name, double depth, QByteArray sequence, int
     m_graphicsItemNode(0),
     m_specialNode(false),
     m_drawn(false),
-    m_highestDistanceInNeighbourSearch(0),
-    m_csvData()
+    m_blastHitsVersion(0),
+    m_csvRow(-1)
 {
     if (length > 0)
         m_length = length;
@@ -87,7 +91,6 @@ void DeBruijnNode::resetNode()
     resetContiguityStatus();
     setAsNotDrawn();
     setAsNotSpecial();
-    m_highestDistanceInNeighbourSearch = 0;
 }
 
 
@@ -117,10 +120,10 @@ void DeBruijnNode::addToOgdfGraph(ogdf::Graph * ogdfGraph, ogdf::GraphAttributes
         newNode = ogdfGraph->newNode();
         m_ogdfNode->addOgdfNode(newNode);
 
-        if (g_assemblyGraph->useLinearLayout()) {
+        if (m_assemblyGraph->useLinearLayout()) {
             graphAttributes->x(newNode) = xPos;
             graphAttributes->y(newNode) = yPos;
-            xPos += g_settings->nodeSegmentLength;
+            xPos += m_assemblyGraph->m_settings->nodeSegmentLength;
         }
 
         if (i > 0)
@@ -138,14 +141,14 @@ void DeBruijnNode::addToOgdfGraph(ogdf::Graph * ogdfGraph, ogdf::GraphAttributes
 double DeBruijnNode::getDrawnNodeLength() const
 {
     double drawnNodeLength = getNodeLengthPerMegabase() * double(getLength()) / 1000000.0;
-    if (drawnNodeLength < g_settings->minimumNodeLength)
-        drawnNodeLength = g_settings->minimumNodeLength;
+    if (drawnNodeLength < m_assemblyGraph->m_settings->minimumNodeLength)
+        drawnNodeLength = m_assemblyGraph->m_settings->minimumNodeLength;
     return drawnNodeLength;
 }
 
 int DeBruijnNode::getNumberOfOgdfGraphEdges(double drawnNodeLength) const
 {
-    int numberOfGraphEdges = ceil(drawnNodeLength / g_settings->nodeSegmentLength);
+    int numberOfGraphEdges = ceil(drawnNodeLength / m_assemblyGraph->m_settings->nodeSegmentLength);
     if (numberOfGraphEdges <= 0)
         numberOfGraphEdges = 1;
     return numberOfGraphEdges;
@@ -153,162 +156,6 @@ int DeBruijnNode::getNumberOfOgdfGraphEdges(double drawnNodeLength) const
 
 
 
-//This function determines the contiguity of nodes relative to this one.
-//It has two steps:
-// -First, for each edge leaving this node, all paths outward are found.
-//  Any nodes in any path are MAYBE_CONTIGUOUS, and nodes in all of the
-//  paths are CONTIGUOUS.
-// -Second, it is necessary to check in the opposite direction - for each
-//  of the MAYBE_CONTIGUOUS nodes, do they have a path that unambiguously
-//  leads to this node?  If so, then they are CONTIGUOUS.
-void DeBruijnNode::determineContiguity()
-{
-    upgradeContiguityStatus(STARTING);
-
-    //A set is used to store all nodes found in the paths, as the nodes
-    //that show up as MAYBE_CONTIGUOUS will have their paths checked
-    //to this node.
-    std::set<DeBruijnNode *> allCheckedNodes;
-
-    //For each path leaving this node, find all possible paths
-    //outward.  Nodes in any of the paths for an edge are
-    //MAYBE_CONTIGUOUS.  Nodes in all of the paths for an edge
-    //are CONTIGUOUS.
-    for (size_t i = 0; i < m_edges.size(); ++i)
-    {
-        DeBruijnEdge * edge = m_edges[i];
-        bool outgoingEdge = (this == edge->getStartingNode());
-
-        std::vector< std::vector <DeBruijnNode *> > allPaths;
-        edge->tracePaths(outgoingEdge, g_settings->contiguitySearchSteps, &allPaths, this);
-
-        //Set all nodes in the paths as MAYBE_CONTIGUOUS
-        for (size_t j = 0; j < allPaths.size(); ++j)
-        {
-            QApplication::processEvents();
-            for (size_t k = 0; k < allPaths[j].size(); ++k)
-            {
-                DeBruijnNode * node = allPaths[j][k];
-                node->upgradeContiguityStatus(MAYBE_CONTIGUOUS);
-                allCheckedNodes.insert(node);
-            }
-        }
-
-        //Set all common nodes as CONTIGUOUS_STRAND_SPECIFIC
-        std::vector<DeBruijnNode *> commonNodesStrandSpecific = getNodesCommonToAllPaths(&allPaths, false);
-        for (size_t j = 0; j < commonNodesStrandSpecific.size(); ++j)
-            (commonNodesStrandSpecific[j])->upgradeContiguityStatus(CONTIGUOUS_STRAND_SPECIFIC);
-
-        //Set all common nodes (when including reverse complement nodes)
-        //as CONTIGUOUS_EITHER_STRAND
-        std::vector<DeBruijnNode *> commonNodesEitherStrand = getNodesCommonToAllPaths(&allPaths, true);
-        for (size_t j = 0; j < commonNodesEitherStrand.size(); ++j)
-        {
-            DeBruijnNode * node = commonNodesEitherStrand[j];
-            node->upgradeContiguityStatus(CONTIGUOUS_EITHER_STRAND);
-            node->getReverseComplement()->upgradeContiguityStatus(CONTIGUOUS_EITHER_STRAND);
-        }
-    }
-
-    //For each node that was checked, then we check to see if any
-    //of its paths leads unambiuously back to the starting node (this node).
-    for (std::set<DeBruijnNode *>::iterator i = allCheckedNodes.begin(); i != allCheckedNodes.end(); ++i)
-    {
-        QApplication::processEvents();
-        DeBruijnNode * node = *i;
-        ContiguityStatus status = node->getContiguityStatus();
-
-        //First check without reverse complement target for
-        //strand-specific contiguity.
-        if (status != CONTIGUOUS_STRAND_SPECIFIC &&
-                node->doesPathLeadOnlyToNode(this, false))
-            node->upgradeContiguityStatus(CONTIGUOUS_STRAND_SPECIFIC);
-
-        //Now check including the reverse complement target for
-        //either strand contiguity.
-        if (status != CONTIGUOUS_STRAND_SPECIFIC &&
-                status != CONTIGUOUS_EITHER_STRAND &&
-                node->doesPathLeadOnlyToNode(this, true))
-        {
-            node->upgradeContiguityStatus(CONTIGUOUS_EITHER_STRAND);
-            node->getReverseComplement()->upgradeContiguityStatus(CONTIGUOUS_EITHER_STRAND);
-        }
-    }
-}
-
-
-//This function differs from the above by including all reverse complement
-//nodes in the path search.
-std::vector<DeBruijnNode *> DeBruijnNode::getNodesCommonToAllPaths(std::vector< std::vector <DeBruijnNode *> > * paths,
-                                                                   bool includeReverseComplements) const
-{
-    std::vector<DeBruijnNode *> commonNodes;
-
-    //If there are no paths, then return the empty vector.
-    if (paths->size() == 0)
-        return commonNodes;
-
-    //If there is only one path in path, then they are all common nodes
-    commonNodes = (*paths)[0];
-    if (paths->size() == 1)
-        return commonNodes;
-
-    //If there are two or more paths, it's necessary to find the intersection.
-    for (size_t i = 1; i < paths->size(); ++i)
-    {
-        QApplication::processEvents();
-        std::vector <DeBruijnNode *> * path = &((*paths)[i]);
-
-        //If we are including reverse complements in the search,
-        //then it is necessary to build a new vector that includes
-        //reverse complement nodes and then use that vector.
-        std::vector <DeBruijnNode *> pathWithReverseComplements;
-        if (includeReverseComplements)
-        {
-            for (size_t j = 0; j < path->size(); ++j)
-            {
-                DeBruijnNode * node = (*path)[j];
-                pathWithReverseComplements.push_back(node);
-                pathWithReverseComplements.push_back(node->getReverseComplement());
-            }
-            path = &pathWithReverseComplements;
-        }
-
-        //Combine the commonNodes vector with the path vector,
-        //excluding any repeats.
-        std::sort(commonNodes.begin(), commonNodes.end());
-        std::sort(path->begin(), path->end());
-        std::vector<DeBruijnNode *> newCommonNodes;
-        std::set_intersection(commonNodes.begin(), commonNodes.end(), path->begin(), path->end(), std::back_inserter(newCommonNodes));
-        commonNodes = newCommonNodes;
-    }
-
-    return commonNodes;
-}
-
-
-//This function checks whether this node has any path leading outward that
-//unambiguously leads to the given node.
-//It checks a number of steps as set by the contiguitySearchSteps setting.
-//If includeReverseComplement is true, then this function returns true if
-//all paths lead either to the node or its reverse complement node.
-bool DeBruijnNode::doesPathLeadOnlyToNode(DeBruijnNode * node, bool includeReverseComplement)
-{
-    for (size_t i = 0; i < m_edges.size(); ++i)
-    {
-        DeBruijnEdge * edge = m_edges[i];
-        bool outgoingEdge = (this == edge->getStartingNode());
-
-        std::vector<DeBruijnNode *> pathSoFar;
-        pathSoFar.push_back(this);
-        if (edge->leadsOnlyToNode(outgoingEdge, g_settings->contiguitySearchSteps, node, pathSoFar, includeReverseComplement))
-            return true;
-    }
-
-    return false;
-}
-
-
 //This function only upgrades a node's status, never downgrades.
 void DeBruijnNode::upgradeContiguityStatus(ContiguityStatus newStatus)
 {
@@ -343,55 +190,16 @@ bool DeBruijnNode::isNotOnlyPathInItsDirection(DeBruijnNode * connectedNode,
 
 QByteArray DeBruijnNode::getFasta(bool sign, bool newLines, bool evenIfEmpty) const
 {
-    QByteArray sequence = getSequence();
-    if (sequence.isEmpty() && !evenIfEmpty)
-        return QByteArray();
-
-    QByteArray fasta = ">";
-    fasta += getNodeNameForFasta(sign).toUtf8();
-    fasta += "\n";
-    if (newLines)
-        fasta += AssemblyGraph::addNewlinesToSequence(sequence);
-    else
-    {
-        fasta += sequence;
-        fasta += "\n";
-    }
+    QByteArray fasta;
+    GraphWriter::appendFasta(&fasta, this, sign, newLines, evenIfEmpty);
     return fasta;
 }
 
 
 QByteArray DeBruijnNode::getGfaSegmentLine(QString depthTag) const
 {
-    QByteArray gfaSequence = getSequenceForGfa();
-
-    QByteArray gfaSegmentLine = "S";
-    gfaSegmentLine += "\t" + getNameWithoutSign().toUtf8();
-    gfaSegmentLine += "\t" + gfaSequence;
-    gfaSegmentLine += "\tLN:i:" + QString::number(gfaSequence.length()).toUtf8();
-
-    //We use the depthTag to guide how we save the node depth.
-    //If it is empty, that implies that the loaded graph did not have depth
-    //information and so we don't save depth.
-    if (depthTag == "DP")
-        gfaSegmentLine += "\tDP:f:" + QString::number(getDepth()).toUtf8();
-    else if (depthTag == "KC")
-        gfaSegmentLine += "\tKC:i:" + QString::number(int(getDepth() * gfaSequence.length() + 0.5)).toUtf8();
-    else if (depthTag == "RC")
-        gfaSegmentLine += "\tRC:i:" + QString::number(int(getDepth() * gfaSequence.length() + 0.5)).toUtf8();
-    else if (depthTag == "FC")
-        gfaSegmentLine += "\tFC:i:" + QString::number(int(getDepth() * gfaSequence.length() + 0.5)).toUtf8();
-
-    //If the user has included custom labels or colours, include those.
-    if (!m_customLabel.isEmpty())
-        gfaSegmentLine += "\tLB:z:" + getCustomLabel().toUtf8();
-    if (!m_reverseComplement->m_customLabel.isEmpty())
-        gfaSegmentLine += "\tL2:z:" + m_reverseComplement->getCustomLabel().toUtf8();
-    if (hasCustomColour())
-        gfaSegmentLine += "\tCL:z:" + getColourName(getCustomColour()).toUtf8();
-    if (m_reverseComplement->hasCustomColour())
-        gfaSegmentLine += "\tC2:z:" + getColourName(m_reverseComplement->getCustomColour()).toUtf8();
-    gfaSegmentLine += "\n";
+    QByteArray gfaSegmentLine;
+    GraphWriter::appendGfaSegmentLine(&gfaSegmentLine, this, depthTag.toUtf8());
     return gfaSegmentLine;
 }
 
@@ -405,12 +213,12 @@ QByteArray DeBruijnNode::getSequenceForGfa() const
     if (sequenceIsMissing())
         return QByteArray("*");
 
-    if (g_assemblyGraph->m_graphFileType != LAST_GRAPH)
+    if (m_assemblyGraph->m_graphFileType != LAST_GRAPH)
         return getSequence();
 
     //If the code got here, then we are getting a full sequence from a Velvet
     //LastGraph graph, so we need to extend the beginning of the sequence.
-    int extensionLength = g_assemblyGraph->m_kmer - 1;
+    int extensionLength = m_assemblyGraph->m_kmer - 1;
 
     //If the node is at least k-1 in length, then the necessary sequence can be
     //deduced from the reverse complement node.
@@ -479,10 +287,10 @@ QByteArray DeBruijnNode::getUpstreamSequence(int upstreamSequenceLength) const
 
 int DeBruijnNode::getFullLength() const
 {
-    if (g_assemblyGraph->m_graphFileType != LAST_GRAPH)
+    if (m_assemblyGraph->m_graphFileType != LAST_GRAPH)
         return getLength();
     else
-        return getLength() + g_assemblyGraph->m_kmer - 1;
+        return getLength() + m_assemblyGraph->m_kmer - 1;
 }
 
 
@@ -511,60 +319,6 @@ int DeBruijnNode::getLengthWithoutTrailingOverlap() const
 }
 
 
-QString DeBruijnNode::getNodeNameForFasta(bool sign) const
-{
-    QString nodeNameForFasta;
-
-    nodeNameForFasta += "NODE_";
-    if (sign)
-        nodeNameForFasta += getName();
-    else
-        nodeNameForFasta += getNameWithoutSign();
-
-    nodeNameForFasta += "_length_";
-    nodeNameForFasta += QByteArray::number(getLength());
-    nodeNameForFasta += "_cov_";
-    nodeNameForFasta += QByteArray::number(getDepth());
-
-    return nodeNameForFasta;
-}
-
-
-//This function recursively labels all nodes as drawn that are within a
-//certain distance of this node.  Whichever node called this will
-//definitely be drawn, so that one is excluded from the recursive call.
-void DeBruijnNode::labelNeighbouringNodesAsDrawn(int nodeDistance, DeBruijnNode * callingNode)
-{
-    if (m_highestDistanceInNeighbourSearch > nodeDistance)
-        return;
-    m_highestDistanceInNeighbourSearch = nodeDistance;
-
-    if (nodeDistance == 0)
-        return;
-
-    DeBruijnNode * otherNode;
-    for (size_t i = 0; i < m_edges.size(); ++i)
-    {
-        otherNode = m_edges[i]->getOtherNode(this);
-
-        if (otherNode == callingNode)
-            continue;
-
-        if (g_settings->doubleMode)
-            otherNode->m_drawn = true;
-        else //single mode
-        {
-            if (otherNode->isPositiveNode())
-                otherNode->m_drawn = true;
-            else
-                otherNode->getReverseComplement()->m_drawn = true;
-        }
-        otherNode->labelNeighbouringNodesAsDrawn(nodeDistance-1, this);
-    }
-}
-
-
-
 std::vector<BlastHitPart> DeBruijnNode::getBlastHitPartsForThisNode(double scaledNodeLength) const
 {
     std::vector<BlastHitPart> returnVector;
@@ -713,13 +467,30 @@ std::vector<DeBruijnNode *> DeBruijnNode::getUpstreamNodes() const
 
 double DeBruijnNode::getNodeLengthPerMegabase() const
 {
-    if (g_settings->nodeLengthMode == AUTO_NODE_LENGTH)
-        return g_settings->autoNodeLengthPerMegabase;
+    if (m_assemblyGraph->m_settings->nodeLengthMode == AUTO_NODE_LENGTH)
+        return m_assemblyGraph->m_settings->autoNodeLengthPerMegabase;
     else
-        return g_settings->manualNodeLengthPerMegabase;
+        return m_assemblyGraph->m_settings->manualNodeLengthPerMegabase;
+}
+
+
+
+//The CSV values are stored in the graph's CSV table, in the node's row.
+QStringList DeBruijnNode::getAllCsvData() const
+{
+    if (m_csvRow < 0)
+        return QStringList();
+    return m_assemblyGraph->getCsvTable().getRow(m_csvRow);
 }
 
 
+QString DeBruijnNode::getCsvLine(int i) const
+{
+    if (m_csvRow < 0)
+        return "";
+    return m_assemblyGraph->getCsvTable().getValue(m_csvRow, i);
+}
+
 
 bool DeBruijnNode::isInDepthRange(double min, double max) const
 {
@@ -735,8 +506,8 @@ bool DeBruijnNode::sequenceIsMissing() const
 
 QByteArray DeBruijnNode::getSequence() const
 {
-    if (sequenceIsMissing() && g_assemblyGraph->m_sequencesLoadedFromFasta == NOT_TRIED)
-        g_assemblyGraph->attemptToLoadSequencesFromFasta();
+    if (sequenceIsMissing() && m_assemblyGraph->m_sequencesLoadedFromFasta == NOT_TRIED)
+        m_assemblyGraph->attemptToLoadSequencesFromFasta();
 
     //If the sequence is still missing, return a string of Ns equal to the
     //sequence length.
@@ -822,7 +593,7 @@ QStringList DeBruijnNode::getCustomLabelForDisplay() const
         for (int i = 0; i < labelLines.size(); ++i)
             customLabelLines << labelLines[i];
     }
-    if (!g_settings->doubleMode && !m_reverseComplement->getCustomLabel().isEmpty()) {
+    if (!m_assemblyGraph->m_settings->doubleMode && !m_reverseComplement->getCustomLabel().isEmpty()) {
         QStringList labelLines2 = m_reverseComplement->getCustomLabel().split("\n");
         for (int i = 0; i < labelLines2.size(); ++i)
             customLabelLines << labelLines2[i];
@@ -835,7 +606,7 @@ QColor DeBruijnNode::getCustomColourForDisplay() const
 {
     if (hasCustomColour())
         return getCustomColour();
-    if (!g_settings->doubleMode && m_reverseComplement->hasCustomColour())
+    if (!m_assemblyGraph->m_settings->doubleMode && m_reverseComplement->hasCustomColour())
         return m_reverseComplement->getCustomColour();
-    return g_settings->defaultCustomNodeColour;
+    return m_assemblyGraph->m_settings->defaultCustomNodeColour;
 }
@@ -32,16 +32,20 @@ class OgdfNode;
 class DeBruijnEdge;
 class GraphicsItemNode;
 class BlastHit;
+class AssemblyGraph;
 
 class DeBruijnNode
 {
 public:
     //CREATORS
-    DeBruijnNode(QString name, double depth, QByteArray sequence, int length = 0);
+    DeBruijnNode(AssemblyGraph * assemblyGraph, QString name, double depth,
+                 QByteArray sequence, int length = 0);
     ~DeBruijnNode();
 
     //ACCESSORS
+    AssemblyGraph * getAssemblyGraph() const {return m_assemblyGraph;}
     QString getName() const {return m_name;}
+    int getId() const {return m_id;}
     QString getNameWithoutSign() const {return m_name.left(m_name.length() - 1);}
     QString getSign() const {if (m_name.length() > 0) return m_name.right(1); else return "+";}
     double getDepth() const {return m_depth;}
@@ -87,13 +91,15 @@ public:
     const std::vector<BlastHit *> * getBlastHitsPointer() const {return &m_blastHits;}
     bool thisNodeHasBlastHits() const {return m_blastHits.size() > 0;}
     bool thisNodeOrReverseComplementHasBlastHits() const {return m_blastHits.size() > 0 || getReverseComplement()->m_blastHits.size() > 0;}
+    unsigned int getBlastHitsVersion() const {return m_blastHitsVersion;}
     DeBruijnEdge * doesNodeLeadIn(DeBruijnNode * node) const;
     DeBruijnEdge * doesNodeLeadAway(DeBruijnNode * node) const;
     std::vector<BlastHitPart> getBlastHitPartsForThisNode(double scaledNodeLength) const;
     std::vector<BlastHitPart> getBlastHitPartsForThisNodeOrReverseComplement(double scaledNodeLength) const;
-    bool hasCsvData() const {return !m_csvData.isEmpty();}
-    QStringList getAllCsvData() const {return m_csvData;}
-    QString getCsvLine(int i) const {if (i < m_csvData.length()) return m_csvData[i]; else return "";}
+    bool hasCsvData() const {return m_csvRow >= 0;}
+    int getCsvRow() const {return m_csvRow;}
+    QStringList getAllCsvData() const;
+    QString getCsvLine(int i) const;
     bool isInDepthRange(double min, double max) const;
     bool sequenceIsMissing() const;
     DeBruijnEdge *getSelfLoopingEdge() const;
@@ -120,18 +126,19 @@ public:
     void removeEdge(DeBruijnEdge * edge);
     void addToOgdfGraph(ogdf::Graph * ogdfGraph, ogdf::GraphAttributes * graphAttributes,
                         ogdf::EdgeArray<double> * edgeArray, double xPos, double yPos);
-    void determineContiguity();
-    void clearBlastHits() {m_blastHits.clear();}
-    void addBlastHit(BlastHit * newHit) {m_blastHits.push_back(newHit);}
-    void labelNeighbouringNodesAsDrawn(int nodeDistance, DeBruijnNode * callingNode);
-    void setCsvData(QStringList csvData) {m_csvData = csvData;}
-    void clearCsvData() {m_csvData.clear();}
+    void clearBlastHits() {m_blastHits.clear(); ++m_blastHitsVersion;}
+    void addBlastHit(BlastHit * newHit) {m_blastHits.push_back(newHit); ++m_blastHitsVersion;}
+    void setCsvRow(int row) {m_csvRow = row;}
+    void clearCsvData() {m_csvRow = -1;}
     void setDepth(double newDepth) {m_depth = newDepth;}
     void setReadSupportCount(long long newCount) {m_readSupportCount = newCount;}
     void setName(QString newName) {m_name = newName;}
+    void setId(int newId) {m_id = newId;}
 
 private:
+    AssemblyGraph * m_assemblyGraph;
     QString m_name;
+    int m_id;
     double m_depth;
     long long m_readSupportCount;
     double m_depthRelativeToMeanDrawnDepth;
@@ -144,12 +151,11 @@ private:
     std::vector<DeBruijnEdge *> m_edges;
     bool m_specialNode;
     bool m_drawn;
-    int m_highestDistanceInNeighbourSearch;
     QColor m_customColour;
     QString m_customLabel;
     std::vector<BlastHit *> m_blastHits;
-    QStringList m_csvData;
-    QString getNodeNameForFasta(bool sign) const;
+    unsigned int m_blastHitsVersion;
+    int m_csvRow;
     QByteArray getUpstreamSequence(int upstreamSequenceLength) const;
 
     double getNodeLengthPerMegabase() const;
@@ -159,9 +165,6 @@ private:
     bool isNotOnlyPathInItsDirection(DeBruijnNode * connectedNode,
                                      std::vector<DeBruijnNode *> * incomingNodes,
                                      std::vector<DeBruijnNode *> * outgoingNodes) const;
-    std::vector<DeBruijnNode *> getNodesCommonToAllPaths(std::vector< std::vector <DeBruijnNode *> > * paths,
-                                                         bool includeReverseComplements) const;
-    bool doesPathLeadOnlyToNode(DeBruijnNode * node, bool includeReverseComplement);
 };
 
 #endif // DEBRUIJNNODE_H
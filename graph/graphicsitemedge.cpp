@@ -27,15 +27,41 @@
 #include "ogdfnode.h"
 #include <QLineF>
 #include "graphicsitemnode.h"
+#include "../ui/mygraphicsscene.h"
 
 GraphicsItemEdge::GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem * parent) :
-    QGraphicsPathItem(parent), m_deBruijnEdge(deBruijnEdge)
+    QGraphicsPathItem(parent), m_deBruijnEdge(deBruijnEdge), m_selectionIndex(-1)
 
 {
     calculateAndSetPath();
 }
 
 
+//Like GraphicsItemNode, edges tell the scene when their selection changes.
+GraphicsItemEdge::~GraphicsItemEdge()
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0 && m_selectionIndex >= 0)
+        graphicsScene->edgeSelectionChanged(this, false);
+}
+
+
+QVariant GraphicsItemEdge::itemChange(GraphicsItemChange change, const QVariant & value)
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+    {
+        if (change == ItemSelectedHasChanged)
+            graphicsScene->edgeSelectionChanged(this, value.toBool());
+        else if (change == ItemSceneChange && m_selectionIndex >= 0)
+            graphicsScene->edgeSelectionChanged(this, false);
+        else if (change == ItemSceneHasChanged && isSelected())
+            graphicsScene->edgeSelectionChanged(this, true);
+    }
+    return QGraphicsPathItem::itemChange(change, value);
+}
+
+
 
 QPointF GraphicsItemEdge::extendLine(QPointF start, QPointF end, double extensionLength)
 {
@@ -121,6 +147,9 @@ void GraphicsItemEdge::calculateAndSetPath()
     setPath(path);
 }
 
+//Node items are normally at the origin, but while the selected nodes are
+//dragged as a group their offset is in the item's position, so that is added
+//to the node's points.
 void GraphicsItemEdge::setControlPointLocations()
 {
     DeBruijnNode * startingNode = m_deBruijnEdge->getStartingNode();
@@ -128,24 +157,28 @@ void GraphicsItemEdge::setControlPointLocations()
 
     if (startingNode->hasGraphicsItem())
     {
-        m_startingLocation = startingNode->getGraphicsItemNode()->getLast();
-        m_beforeStartingLocation = startingNode->getGraphicsItemNode()->getSecondLast();
+        GraphicsItemNode * graphicsItemNode = startingNode->getGraphicsItemNode();
+        m_startingLocation = graphicsItemNode->getLast() + graphicsItemNode->pos();
+        m_beforeStartingLocation = graphicsItemNode->getSecondLast() + graphicsItemNode->pos();
     }
     else if (startingNode->getReverseComplement()->hasGraphicsItem())
     {
-        m_startingLocation = startingNode->getReverseComplement()->getGraphicsItemNode()->getFirst();
-        m_beforeStartingLocation = startingNode->getReverseComplement()->getGraphicsItemNode()->getSecond();
+        GraphicsItemNode * graphicsItemNode = startingNode->getReverseComplement()->getGraphicsItemNode();
+        m_startingLocation = graphicsItemNode->getFirst() + graphicsItemNode->pos();
+        m_beforeStartingLocation = graphicsItemNode->getSecond() + graphicsItemNode->pos();
     }
 
     if (endingNode->hasGraphicsItem())
     {
-        m_endingLocation = endingNode->getGraphicsItemNode()->getFirst();
-        m_afterEndingLocation = endingNode->getGraphicsItemNode()->getSecond();
+        GraphicsItemNode * graphicsItemNode = endingNode->getGraphicsItemNode();
+        m_endingLocation = graphicsItemNode->getFirst() + graphicsItemNode->pos();
+        m_afterEndingLocation = graphicsItemNode->getSecond() + graphicsItemNode->pos();
     }
     else if (endingNode->getReverseComplement()->hasGraphicsItem())
     {
-        m_endingLocation = endingNode->getReverseComplement()->getGraphicsItemNode()->getLast();
-        m_afterEndingLocation = endingNode->getReverseComplement()->getGraphicsItemNode()->getSecondLast();
+        GraphicsItemNode * graphicsItemNode = endingNode->getReverseComplement()->getGraphicsItemNode();
+        m_endingLocation = graphicsItemNode->getLast() + graphicsItemNode->pos();
+        m_afterEndingLocation = graphicsItemNode->getSecondLast() + graphicsItemNode->pos();
     }
 }
 
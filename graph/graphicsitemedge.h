@@ -33,6 +33,7 @@ class GraphicsItemEdge : public QGraphicsPathItem
 {
 public:
     GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem * parent = 0);
+    ~GraphicsItemEdge();
 
     DeBruijnEdge * m_deBruijnEdge;
     QPointF m_startingLocation;
@@ -41,9 +42,11 @@ public:
     QPointF m_afterEndingLocation;
     QPointF m_controlPoint1;
     QPointF m_controlPoint2;
+    int m_selectionIndex;
 
     void paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *);
     QPainterPath shape() const;
+    QVariant itemChange(GraphicsItemChange change, const QVariant & value);
     QPointF extendLine(QPointF start, QPointF end, double extensionLength);
     void calculateAndSetPath();
     void setControlPointLocations();
@@ -48,7 +48,8 @@
 GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
                                    ogdf::GraphAttributes * graphAttributes, QGraphicsItem * parent) :
     QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
-    m_hasArrow(g_settings->doubleMode || g_settings->arrowheadsInSingleMode)
+    m_hasArrow(g_settings->doubleMode || g_settings->arrowheadsInSingleMode),
+    m_selectionIndex(-1), m_blastHitPathsValid(false)
 
 {
     setWidth();
@@ -91,7 +92,8 @@ GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
                                    QGraphicsItem * parent) :
     QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
     m_hasArrow(toCopy->m_hasArrow),
-    m_linePoints(toCopy->m_linePoints)
+    m_linePoints(toCopy->m_linePoints),
+    m_selectionIndex(-1), m_blastHitPathsValid(false)
 {
     setWidth();
     remakePath();
@@ -104,13 +106,48 @@ GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
                                    QGraphicsItem * parent) :
     QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
     m_hasArrow(g_settings->doubleMode),
-    m_linePoints(linePoints)
+    m_linePoints(linePoints),
+    m_selectionIndex(-1), m_blastHitPathsValid(false)
 {
     setWidth();
     remakePath();
 }
 
 
+//A selected node which is deleted while still in the scene must be taken out
+//of the scene's selection.  The scene is only a MyGraphicsScene here if it is
+//not itself being deleted.
+GraphicsItemNode::~GraphicsItemNode()
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+        graphicsScene->cancelNodeDrag();
+    if (graphicsScene != 0 && m_selectionIndex >= 0)
+        graphicsScene->nodeSelectionChanged(this, false);
+}
+
+
+//The scene keeps track of the selected nodes as they change, instead of
+//looking through all of the selected items when it needs them.
+QVariant GraphicsItemNode::itemChange(GraphicsItemChange change, const QVariant & value)
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+    {
+        if (change == ItemSceneChange)
+            graphicsScene->cancelNodeDrag();
+
+        if (change == ItemSelectedHasChanged)
+            graphicsScene->nodeSelectionChanged(this, value.toBool());
+        else if (change == ItemSceneChange && m_selectionIndex >= 0)
+            graphicsScene->nodeSelectionChanged(this, false);
+        else if (change == ItemSceneHasChanged && isSelected())
+            graphicsScene->nodeSelectionChanged(this, true);
+    }
+    return QGraphicsItem::itemChange(change, value);
+}
+
+
 
 void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *)
 {
@@ -136,24 +173,7 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
     if (nodeHasBlastHits && (g_settings->nodeColourScheme == BLAST_HITS_RAINBOW_COLOUR ||
             g_settings->nodeColourScheme == BLAST_HITS_SOLID_COLOUR))
     {
-        std::vector<BlastHitPart> parts;
-
-        //The scaled node length is passed to the function which makes the
-        //BlastHitPart objects, because we don't want those parts to be much
-        //less than 1 pixel in size, which isn't necessary and can cause weird
-        //visual artefacts.
-        double scaledNodeLength = getNodePathLength() * g_absoluteZoom;
-
-        if (g_settings->doubleMode)
-        {
-            if (m_deBruijnNode->thisNodeHasBlastHits())
-                parts = m_deBruijnNode->getBlastHitPartsForThisNode(scaledNodeLength);
-        }
-        else
-        {
-            if (m_deBruijnNode->thisNodeOrReverseComplementHasBlastHits())
-                parts = m_deBruijnNode->getBlastHitPartsForThisNodeOrReverseComplement(scaledNodeLength);
-        }
+        const std::vector<BlastHitPath> & hitPaths = getBlastHitPaths();
 
         QPen partPen;
         partPen.setWidthF(m_width);
@@ -166,13 +186,15 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
         if (m_hasArrow)
             painter->setClipPath(outlinePath);
 
-        for (size_t i = 0; i < parts.size(); ++i)
+        for (size_t i = 0; i < hitPaths.size(); ++i)
         {
-            partPen.setColor(parts[i].m_colour);
+            if (hitPaths[i].m_query != 0)
+                partPen.setColor(hitPaths[i].m_query->getColour());
+            else
+                partPen.setColor(hitPaths[i].m_colour);
             painter->setPen(partPen);
 
-            painter->drawPath(makePartialPath(parts[i].m_nodeFractionStart,
-                                              parts[i].m_nodeFractionEnd));
+            painter->drawPath(hitPaths[i].m_path);
         }
         painter->setClipping(false);
     }
@@ -491,25 +513,33 @@ void GraphicsItemNode::mousePressEvent(QGraphicsSceneMouseEvent * event)
 //graphics items will need to be adjusted accordingly.
 void GraphicsItemNode::mouseMoveEvent(QGraphicsSceneMouseEvent * event)
 {
-    QPointF difference = event->pos() - event->lastPos();
-
-    //If this node is selected, then move all of the other selected nodes too.
-    //If it is not selected, then only move this node.
-    std::vector<GraphicsItemNode *> nodesToMove;
     MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
-    if (isSelected())
-        nodesToMove = graphicsScene->getSelectedGraphicsItemNodes();
-    else
-        nodesToMove.push_back(this);
 
-    for (size_t i = 0; i < nodesToMove.size(); ++i)
+    //If this node is selected, then all of the other selected nodes move too.
+    //The scene moves them as a group and remakes their paths when the drag
+    //finishes.
+    if (isSelected())
     {
-        nodesToMove[i]->shiftPoints(difference);
-        nodesToMove[i]->remakePath();
+        if (g_settings->nodeDragging != NO_DRAGGING)
+            graphicsScene->dragSelectedNodes(event->scenePos() - event->lastScenePos());
+        return;
     }
-    graphicsScene->possiblyExpandSceneRectangle(&nodesToMove);
 
-    fixEdgePaths(&nodesToMove);
+    //If it is not selected, then only move this node.
+    shiftPoints(event->pos() - event->lastPos());
+    remakePath();
+    std::vector<GraphicsItemNode *> movedNodes(1, this);
+    graphicsScene->possiblyExpandSceneRectangle(&movedNodes);
+    fixEdgePaths();
+}
+
+
+void GraphicsItemNode::mouseReleaseEvent(QGraphicsSceneMouseEvent * event)
+{
+    MyGraphicsScene * graphicsScene = dynamic_cast<MyGraphicsScene *>(scene());
+    if (graphicsScene != 0)
+        graphicsScene->finishNodeDrag();
+    QGraphicsItem::mouseReleaseEvent(event);
 }
 
 
@@ -586,6 +616,18 @@ void GraphicsItemNode::shiftPoints(QPointF difference)
     }
 }
 
+//This function moves the points by the offset a group drag left in the
+//item's position, and puts the item back at the origin.
+void GraphicsItemNode::applyDragOffset(QPointF offset)
+{
+    prepareGeometryChange();
+    for (size_t i = 0; i < m_linePoints.size(); ++i)
+        m_linePoints[i] += offset;
+    setPos(QPointF());
+    remakePath();
+}
+
+
 void GraphicsItemNode::remakePath()
 {
     QPainterPath path;
@@ -595,6 +637,7 @@ void GraphicsItemNode::remakePath()
         path.lineTo(m_linePoints[i]);
 
     m_path = path;
+    m_blastHitPathsValid = false;
 }
 
 
@@ -856,8 +899,9 @@ QColor GraphicsItemNode::getDepthColour()
     double highValue;
     if (g_settings->autoDepthValue)
     {
-        lowValue = g_assemblyGraph->m_firstQuartileDepth;
-        highValue = g_assemblyGraph->m_thirdQuartileDepth;
+        AssemblyGraph * assemblyGraph = m_deBruijnNode->getAssemblyGraph();
+        lowValue = assemblyGraph->m_firstQuartileDepth;
+        highValue = assemblyGraph->m_thirdQuartileDepth;
     }
     else
     {
@@ -1147,3 +1191,79 @@ bool GraphicsItemNode::anyNodeDisplayText()
             g_settings->displayNodeDepth ||
             g_settings->displayNodeCsvData;
 }
+
+
+
+bool GraphicsItemNode::BlastHitPathsKey::operator==(const BlastHitPathsKey & other) const
+{
+    return m_colourScheme == other.m_colourScheme &&
+            m_rainbowPartsPerQuery == other.m_rainbowPartsPerQuery &&
+            m_doubleMode == other.m_doubleMode &&
+            m_zoomBucket == other.m_zoomBucket &&
+            m_hitsVersion == other.m_hitsVersion &&
+            m_reverseComplementHitsVersion == other.m_reverseComplementHitsVersion;
+}
+
+
+//Making the BLAST hit parts and their paths is most of the work of painting
+//a node with many hits, so the paths are cached.  They are remade when the
+//hits, the colour scheme or the rainbow part count change, and when the
+//node's path is remade.
+//Rainbow parts depend on the zoom, because they aren't allowed to be much
+//smaller than a pixel.  The zoom is rounded to a quarter power of two (a zoom
+//bucket), so zooming only remakes the paths when it moves to a new bucket.
+const std::vector<BlastHitPath> & GraphicsItemNode::getBlastHitPaths()
+{
+    BlastHitPathsKey key;
+    key.m_colourScheme = g_settings->nodeColourScheme;
+    key.m_rainbowPartsPerQuery = g_settings->blastRainbowPartsPerQuery;
+    key.m_doubleMode = g_settings->doubleMode;
+    key.m_zoomBucket = 0;
+    if (key.m_colourScheme == BLAST_HITS_RAINBOW_COLOUR && g_absoluteZoom > 0.0)
+        key.m_zoomBucket = int(floor(log2(g_absoluteZoom) * 4.0));
+    key.m_hitsVersion = m_deBruijnNode->getBlastHitsVersion();
+    key.m_reverseComplementHitsVersion = m_deBruijnNode->getReverseComplement()->getBlastHitsVersion();
+
+    if (m_blastHitPathsValid && key == m_blastHitPathsKey)
+        return m_blastHitPaths;
+
+    m_blastHitPaths.clear();
+    m_blastHitPathsKey = key;
+    m_blastHitPathsValid = true;
+    if (key.m_colourScheme != BLAST_HITS_RAINBOW_COLOUR && key.m_colourScheme != BLAST_HITS_SOLID_COLOUR)
+        return m_blastHitPaths;
+
+    //In double mode, only this node's hits are drawn.  In single mode, the
+    //hits on both nodes are drawn, with the negative node's hits reversed.
+    const DeBruijnNode * forwardNode = m_deBruijnNode;
+    const DeBruijnNode * reverseNode = 0;
+    if (!key.m_doubleMode)
+    {
+        forwardNode = m_deBruijnNode->isNegativeNode() ? m_deBruijnNode->getReverseComplement() : m_deBruijnNode;
+        reverseNode = forwardNode->getReverseComplement();
+    }
+
+    double scaledNodeLength = getNodePathLength() * pow(2.0, key.m_zoomBucket / 4.0);
+    for (int reverse = 0; reverse < 2; ++reverse)
+    {
+        const DeBruijnNode * node = reverse ? reverseNode : forwardNode;
+        if (node == 0)
+            continue;
+        const std::vector<BlastHit *> * blastHits = node->getBlastHitsPointer();
+        for (size_t i = 0; i < blastHits->size(); ++i)
+        {
+            BlastHit * hit = (*blastHits)[i];
+            std::vector<BlastHitPart> parts = hit->getBlastHitParts(reverse != 0, scaledNodeLength);
+            for (size_t j = 0; j < parts.size(); ++j)
+            {
+                BlastHitPath hitPath;
+                hitPath.m_path = makePartialPath(parts[j].m_nodeFractionStart, parts[j].m_nodeFractionEnd);
+                hitPath.m_colour = parts[j].m_colour;
+                hitPath.m_query = (key.m_colourScheme == BLAST_HITS_SOLID_COLOUR) ? hit->m_query : 0;
+                m_blastHitPaths.push_back(hitPath);
+            }
+        }
+    }
+
+    return m_blastHitPaths;
+}
@@ -29,9 +29,21 @@
 #include <QString>
 #include <QPainterPath>
 #include <QStringList>
+#include "../program/globals.h"
 
 class DeBruijnNode;
 class Path;
+class BlastQuery;
+
+//A BLAST hit part with its path already made.  Parts drawn in a query's solid
+//colour keep the query instead of the colour, so changing the query's colour
+//doesn't require the path to be remade.
+struct BlastHitPath
+{
+    QPainterPath m_path;
+    QColor m_colour;
+    BlastQuery * m_query;
+};
 
 class GraphicsItemNode : public QGraphicsItem
 {
@@ -45,6 +57,7 @@ public:
     GraphicsItemNode(DeBruijnNode * deBruijnNode,
                      std::vector<QPointF> linePoints,
                      QGraphicsItem * parent = 0);
+    ~GraphicsItemNode();
 
     DeBruijnNode * m_deBruijnNode;
     double m_width;
@@ -53,12 +66,16 @@ public:
     size_t m_grabIndex;
     QColor m_colour;
     QPainterPath m_path;
+    int m_selectionIndex;
 
     void mousePressEvent(QGraphicsSceneMouseEvent * event);
     void mouseMoveEvent(QGraphicsSceneMouseEvent * event);
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent * event);
+    QVariant itemChange(GraphicsItemChange change, const QVariant & value);
     void paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *);
     QPainterPath shape() const;
     void shiftPoints(QPointF difference);
+    void applyDragOffset(QPointF offset);
     void remakePath();
     double distance(QPointF p1, QPointF p2) const;
     bool usePositiveNodeColour();
@@ -91,8 +108,25 @@ public:
                                                                 std::vector<QPointF> * blastHitLocation);
     void drawTextPathAtLocation(QPainter *painter, QPainterPath textPath, QPointF centre);
     void fixEdgePaths(std::vector<GraphicsItemNode *> * nodes = 0);
+    const std::vector<BlastHitPath> & getBlastHitPaths();
 
 private:
+    //These are the settings and hits that the cached BLAST hit paths were
+    //made for.
+    struct BlastHitPathsKey
+    {
+        NodeColourScheme m_colourScheme;
+        int m_rainbowPartsPerQuery;
+        bool m_doubleMode;
+        int m_zoomBucket;
+        unsigned int m_hitsVersion;
+        unsigned int m_reverseComplementHitsVersion;
+        bool operator==(const BlastHitPathsKey & other) const;
+    };
+    std::vector<BlastHitPath> m_blastHitPaths;
+    BlastHitPathsKey m_blastHitPathsKey;
+    bool m_blastHitPathsValid;
+
     void exactPathHighlightNode(QPainter * painter);
     void queryPathHighlightNode(QPainter * painter);
     void pathHighlightNode2(QPainter * painter, DeBruijnNode * node, bool reverse, Path * path);
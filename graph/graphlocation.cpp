@@ -88,8 +88,9 @@ GraphLocation GraphLocation::reverseComplementLocation() const
 
     //For Velvet graphs, the reverse complement location is shifted by the k-mer
     //size and may not even be on the same node!
-    if (g_assemblyGraph->m_graphFileType == LAST_GRAPH)
-        newLocation.moveLocation(-g_assemblyGraph->m_kmer + 1);
+    AssemblyGraph * assemblyGraph = m_node->getAssemblyGraph();
+    if (assemblyGraph->m_graphFileType == LAST_GRAPH)
+        newLocation.moveLocation(-assemblyGraph->m_kmer + 1);
 
     if (newLocation.isValid())
         return newLocation;
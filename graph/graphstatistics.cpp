@@ -0,0 +1,421 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "graphstatistics.h"
+#include "debruijnnode.h"
+#include "debruijnedge.h"
+#include "../program/parallel.h"
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+namespace
+{
+struct DepthEntry
+{
+    double depth;
+    int length;
+    int lengthWithoutTrailingOverlap;
+};
+
+//Each thread fills one of these for its chunk of nodes, and they are
+//combined once all threads have finished.
+struct ChunkStatistics
+{
+    ChunkStatistics() :
+        smallestOverlap(std::numeric_limits<int>::max()), largestOverlap(0),
+        totalLength(0), totalLengthNoOverlaps(0), totalLengthOrphanedNodes(0),
+        nodeCount(0), deadEnds(0),
+        shortestNode(std::numeric_limits<int>::max()), longestNode(0) {}
+
+    int smallestOverlap;
+    int largestOverlap;
+    long long totalLength;
+    long long totalLengthNoOverlaps;
+    long long totalLengthOrphanedNodes;
+    int nodeCount;
+    int deadEnds;
+    int shortestNode;
+    int longestNode;
+    std::vector<int> nodeLengths;
+    std::vector<DepthEntry> depthEntries;
+};
+
+
+//The union-find structure is shared between threads, so it uses atomic parent
+//pointers.  Roots are always linked to a root with a lower index, which keeps
+//the structure acyclic when several threads link at once.
+int findRoot(std::vector< std::atomic<int> > * parents, int x)
+{
+    while (true)
+    {
+        int parent = (*parents)[x].load();
+        if (parent == x)
+            return x;
+        int grandparent = (*parents)[parent].load();
+        if (parent != grandparent)
+            (*parents)[x].compare_exchange_weak(parent, grandparent);
+        x = grandparent;
+    }
+}
+
+void unite(std::vector< std::atomic<int> > * parents, int a, int b)
+{
+    while (true)
+    {
+        a = findRoot(parents, a);
+        b = findRoot(parents, b);
+        if (a == b)
+            return;
+        if (a < b)
+            std::swap(a, b);
+        int expected = a;
+        if ((*parents)[a].compare_exchange_strong(expected, b))
+            return;
+    }
+}
+
+int getPositiveNodeId(DeBruijnNode * node)
+{
+    if (node->isPositiveNode())
+        return node->getId();
+    return node->getReverseComplement()->getId();
+}
+
+
+//This function returns the value at a fractional index of the vector as if
+//it were sorted, interpolating between the two neighbouring values.  It uses
+//selection, so the vector is left partially ordered.
+template<typename T> double selectValueUsingFractionalIndex(std::vector<T> * v, double index)
+{
+    if (v->size() == 0)
+        return 0.0;
+    if (v->size() == 1)
+        return double((*v)[0]);
+
+    long long wholePart = floor(index);
+
+    if (wholePart < 0)
+        return double(*std::min_element(v->begin(), v->end()));
+    if (wholePart >= (long long)(v->size()) - 1)
+        return double(*std::max_element(v->begin(), v->end()));
+
+    double fractionalPart = index - wholePart;
+
+    std::nth_element(v->begin(), v->begin() + wholePart, v->end());
+    double piece1 = double((*v)[wholePart]);
+    double piece2 = double(*std::min_element(v->begin() + wholePart + 1, v->end()));
+
+    return piece1 * (1.0 - fractionalPart) + piece2 * fractionalPart;
+}
+
+
+//This function finds the N50 without sorting: it repeatedly partitions the
+//lengths around a pivot, keeping only the side which contains the length at
+//which the running total (counted from the longest node down) reaches half
+//of the total length.
+int selectN50(std::vector<int> * lengths, double halfTotalLength)
+{
+    size_t lo = 0;
+    size_t hi = lengths->size();
+    while (lo < hi)
+    {
+        int pivot = (*lengths)[lo + (hi - lo) / 2];
+
+        //Partition into [lo, gt) > pivot, [gt, lt) == pivot, [lt, hi) < pivot.
+        size_t gt = lo, i = lo, lt = hi;
+        long long greaterLength = 0, equalLength = 0;
+        while (i < lt)
+        {
+            int length = (*lengths)[i];
+            if (length > pivot)
+            {
+                greaterLength += length;
+                std::swap((*lengths)[gt++], (*lengths)[i++]);
+            }
+            else if (length < pivot)
+                std::swap((*lengths)[i], (*lengths)[--lt]);
+            else
+            {
+                equalLength += length;
+                ++i;
+            }
+        }
+
+        if (greaterLength >= halfTotalLength)
+            hi = gt;
+        else if (greaterLength + equalLength >= halfTotalLength)
+            return pivot;
+        else
+        {
+            halfTotalLength -= greaterLength + equalLength;
+            lo = lt;
+        }
+    }
+    return 0;
+}
+
+
+//This function returns the depth at the given base index, as if the nodes
+//were sorted by depth and laid end to end.  Like selectN50, it partitions
+//around a pivot instead of sorting.
+double selectDepthAtBaseIndex(std::vector<DepthEntry> * entries, long long targetIndex)
+{
+    size_t lo = 0;
+    size_t hi = entries->size();
+    while (lo < hi)
+    {
+        double pivot = (*entries)[lo + (hi - lo) / 2].depth;
+
+        //Partition into [lo, lt) < pivot, [lt, gt) == pivot, [gt, hi) > pivot.
+        size_t lt = lo, i = lo, gt = hi;
+        long long lessLength = 0, equalLength = 0;
+        while (i < gt)
+        {
+            const DepthEntry & entry = (*entries)[i];
+            if (entry.depth < pivot)
+            {
+                lessLength += entry.length;
+                std::swap((*entries)[lt++], (*entries)[i++]);
+            }
+            else if (entry.depth > pivot)
+                std::swap((*entries)[i], (*entries)[--gt]);
+            else
+            {
+                equalLength += entry.length;
+                ++i;
+            }
+        }
+
+        if (targetIndex < lessLength)
+            hi = lt;
+        else if (targetIndex < lessLength + equalLength)
+            return pivot;
+        else
+        {
+            targetIndex -= lessLength + equalLength;
+            lo = gt;
+        }
+    }
+    return 0.0;
+}
+}
+
+
+GraphStatistics::GraphStatistics() :
+    smallestOverlap(0), largestOverlap(0), totalLength(0),
+    totalLengthNoOverlaps(0), nodeCount(0), deadEnds(0), componentCount(0),
+    largestComponentLength(0), totalLengthOrphanedNodes(0), n50(0),
+    shortestNode(0), firstQuartile(0), median(0), thirdQuartile(0),
+    longestNode(0), medianDepthByBase(0.0), estimatedSequenceLength(0)
+{
+}
+
+
+double GraphStatistics::getPercentageDeadEnds() const
+{
+    return 100.0 * double(deadEnds) / (2 * nodeCount);
+}
+
+
+//This function calculates all of the statistics.  The nodes must be the
+//graph's complete indexed node list: each node's ID is its index in the
+//vector and every node's reverse complement is also in the vector.
+void GraphStatistics::calculate(const std::vector<DeBruijnNode *> & nodes)
+{
+    *this = GraphStatistics();
+
+    long long count = nodes.size();
+    std::vector< std::atomic<int> > parents(count);
+    std::vector<ChunkStatistics> chunks(getParallelThreadCount(count));
+
+    parallelForChunks(count, [&](int, long long begin, long long end)
+    {
+        for (long long i = begin; i < end; ++i)
+            parents[i].store(int(i));
+    });
+
+    //First pass: per-node values, with each edge looked at only from its
+    //starting node so that it is counted once.
+    parallelForChunks(count, [&](int chunk, long long begin, long long end)
+    {
+        ChunkStatistics * c = &chunks[chunk];
+        for (long long i = begin; i < end; ++i)
+        {
+            DeBruijnNode * node = nodes[i];
+            const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+            bool hasEnteringEdge = false;
+            bool hasLeavingEdge = false;
+            int maxOverlap = 0;
+            int maxLeavingOverlap = 0;
+            for (size_t j = 0; j < edges->size(); ++j)
+            {
+                DeBruijnEdge * edge = (*edges)[j];
+                int overlap = edge->getOverlap();
+                maxOverlap = std::max(maxOverlap, overlap);
+                if (edge->getEndingNode() == node)
+                    hasEnteringEdge = true;
+                if (edge->getStartingNode() == node)
+                {
+                    hasLeavingEdge = true;
+                    maxLeavingOverlap = std::max(maxLeavingOverlap, overlap);
+                    c->smallestOverlap = std::min(c->smallestOverlap, overlap);
+                    c->largestOverlap = std::max(c->largestOverlap, overlap);
+                    unite(&parents, getPositiveNodeId(node),
+                          getPositiveNodeId(edge->getEndingNode()));
+                }
+            }
+
+            if (!node->isPositiveNode())
+                continue;
+
+            int length = node->getLength();
+            ++c->nodeCount;
+            c->totalLength += length;
+            c->totalLengthNoOverlaps += length - maxOverlap;
+            c->shortestNode = std::min(c->shortestNode, length);
+            c->longestNode = std::max(c->longestNode, length);
+            c->nodeLengths.push_back(length);
+
+            if (edges->size() == 0)
+            {
+                c->deadEnds += 2;
+                c->totalLengthOrphanedNodes += length;
+            }
+            else if (!hasEnteringEdge || !hasLeavingEdge)
+                c->deadEnds += 1;
+
+            //Zero-length nodes can never hold the median base, so they are
+            //left out of the depth selection.
+            if (length > 0)
+            {
+                DepthEntry entry;
+                entry.depth = node->getDepth();
+                entry.length = length;
+                entry.lengthWithoutTrailingOverlap = hasLeavingEdge ? std::max(0, length - maxLeavingOverlap) : length;
+                c->depthEntries.push_back(entry);
+            }
+        }
+    });
+
+    std::vector<int> nodeLengths;
+    std::vector<DepthEntry> depthEntries;
+    nodeLengths.reserve(count / 2);
+    depthEntries.reserve(count / 2);
+    smallestOverlap = std::numeric_limits<int>::max();
+    shortestNode = std::numeric_limits<int>::max();
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        ChunkStatistics * c = &chunks[i];
+        smallestOverlap = std::min(smallestOverlap, c->smallestOverlap);
+        largestOverlap = std::max(largestOverlap, c->largestOverlap);
+        totalLength += c->totalLength;
+        totalLengthNoOverlaps += c->totalLengthNoOverlaps;
+        totalLengthOrphanedNodes += c->totalLengthOrphanedNodes;
+        nodeCount += c->nodeCount;
+        deadEnds += c->deadEnds;
+        shortestNode = std::min(shortestNode, c->shortestNode);
+        longestNode = std::max(longestNode, c->longestNode);
+        nodeLengths.insert(nodeLengths.end(), c->nodeLengths.begin(), c->nodeLengths.end());
+        depthEntries.insert(depthEntries.end(), c->depthEntries.begin(), c->depthEntries.end());
+        std::vector<int>().swap(c->nodeLengths);
+        std::vector<DepthEntry>().swap(c->depthEntries);
+    }
+    if (smallestOverlap == std::numeric_limits<int>::max())
+        smallestOverlap = 0;
+    if (nodeCount == 0)
+        shortestNode = 0;
+
+    //Connected components: every positive node which is its own root starts
+    //a component.
+    std::vector<long long> componentLengths(count, 0);
+    for (long long i = 0; i < count; ++i)
+    {
+        DeBruijnNode * node = nodes[i];
+        if (!node->isPositiveNode())
+            continue;
+        int root = findRoot(&parents, int(i));
+        if (root == i)
+            ++componentCount;
+        componentLengths[root] += node->getLength();
+    }
+    for (long long i = 0; i < count; ++i)
+        largestComponentLength = std::max(largestComponentLength, componentLengths[i]);
+
+    if (nodeLengths.size() > 0)
+    {
+        double firstQuartileIndex = (nodeLengths.size() - 1) / 4.0;
+        double medianIndex = (nodeLengths.size() - 1) / 2.0;
+        double thirdQuartileIndex = (nodeLengths.size() - 1) * 3.0 / 4.0;
+
+        firstQuartile = round(selectValueUsingFractionalIndex(&nodeLengths, firstQuartileIndex));
+        median = round(selectValueUsingFractionalIndex(&nodeLengths, medianIndex));
+        thirdQuartile = round(selectValueUsingFractionalIndex(&nodeLengths, thirdQuartileIndex));
+        n50 = selectN50(&nodeLengths, totalLength / 2.0);
+    }
+
+    if (totalLength == 0)
+        return;
+
+    //If there is only one node, then its depth is the median.
+    if (nodeCount == 1)
+        medianDepthByBase = depthEntries[0].depth;
+    else if (totalLength % 2 == 0)
+    {
+        long long medianIndex2 = totalLength / 2;
+        long long medianIndex1 = medianIndex2 - 1;
+        double depth1 = selectDepthAtBaseIndex(&depthEntries, medianIndex1);
+        double depth2 = selectDepthAtBaseIndex(&depthEntries, medianIndex2);
+        medianDepthByBase = (depth1 + depth2) / 2.0;
+    }
+    else
+        medianDepthByBase = selectDepthAtBaseIndex(&depthEntries, (totalLength - 1) / 2);
+
+    if (medianDepthByBase == 0.0)
+        return;
+
+    //Second pass: the estimated sequence length needs the median depth.
+    std::vector<long long> estimatedLengths(getParallelThreadCount(depthEntries.size()), 0);
+    double medianDepth = medianDepthByBase;
+    parallelForChunks(depthEntries.size(), [&](int chunk, long long begin, long long end)
+    {
+        long long estimatedLength = 0;
+        for (long long i = begin; i < end; ++i)
+        {
+            double relativeDepth = depthEntries[i].depth / medianDepth;
+            long long closestIntegerDepth = llround(relativeDepth);
+            estimatedLength += depthEntries[i].lengthWithoutTrailingOverlap * closestIntegerDepth;
+        }
+        estimatedLengths[chunk] = estimatedLength;
+    });
+    for (size_t i = 0; i < estimatedLengths.size(); ++i)
+        estimatedSequenceLength += estimatedLengths[i];
+}
+
+
+double GraphStatistics::getValueUsingFractionalIndex(std::vector<double> * v, double index)
+{
+    return selectValueUsingFractionalIndex(v, index);
+}
+
+double GraphStatistics::getValueUsingFractionalIndex(std::vector<int> * v, double index)
+{
+    return selectValueUsingFractionalIndex(v, index);
+}
@@ -0,0 +1,66 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef GRAPHSTATISTICS_H
+#define GRAPHSTATISTICS_H
+
+//This class holds the summary statistics shown by Bandage info and the graph
+//information dialog.  They are all calculated together in a single parallel
+//pass over the nodes, using union-find for the connected components and
+//selection (instead of sorting) for the quantiles, N50 and median depth.
+
+#include <vector>
+
+class DeBruijnNode;
+
+class GraphStatistics
+{
+public:
+    //CREATORS
+    GraphStatistics();
+
+    //ACCESSORS
+    double getPercentageDeadEnds() const;
+
+    //MODIFERS
+    void calculate(const std::vector<DeBruijnNode *> & nodes);
+
+    int smallestOverlap;
+    int largestOverlap;
+    long long totalLength;
+    long long totalLengthNoOverlaps;
+    int nodeCount;
+    int deadEnds;
+    int componentCount;
+    long long largestComponentLength;
+    long long totalLengthOrphanedNodes;
+    int n50;
+    int shortestNode;
+    int firstQuartile;
+    int median;
+    int thirdQuartile;
+    int longestNode;
+    double medianDepthByBase;
+    long long estimatedSequenceLength;
+
+    static double getValueUsingFractionalIndex(std::vector<double> * v, double index);
+    static double getValueUsingFractionalIndex(std::vector<int> * v, double index);
+};
+
+#endif // GRAPHSTATISTICS_H
@@ -0,0 +1,319 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "graphwriter.h"
+#include "assemblygraph.h"
+#include "debruijnnode.h"
+#include "debruijnedge.h"
+#include "../program/globals.h"
+#include "../program/parallel.h"
+#include <QThread>
+#include <thread>
+#include <algorithm>
+
+namespace
+{
+
+//Records are gathered into blocks of about this many bytes.  Each block is
+//formatted by one thread and written to the file with a single call.
+const long long BLOCK_SIZE = 4 * 1024 * 1024;
+
+void appendNumber(QByteArray * buffer, int number)
+{
+    buffer->append(QByteArray::number(number));
+}
+
+void appendNumber(QByteArray * buffer, double number)
+{
+    buffer->append(QByteArray::number(number));
+}
+
+void appendString(QByteArray * buffer, const QString & string)
+{
+    buffer->append(string.toUtf8());
+}
+
+}
+
+
+GraphWriter::GraphWriter() :
+    m_okay(false)
+{
+}
+
+GraphWriter::~GraphWriter()
+{
+    close();
+}
+
+
+//The file is unbuffered because the blocks are already large, so going
+//through QFile's own buffer would only add a copy.  It is still opened in
+//text mode, as before, so line endings are the platform's.
+bool GraphWriter::open(QString filename)
+{
+    m_file.setFileName(filename);
+    m_okay = m_file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Unbuffered);
+    return m_okay;
+}
+
+
+bool GraphWriter::close()
+{
+    if (m_file.isOpen())
+        m_file.close();
+    return m_okay;
+}
+
+
+bool GraphWriter::writeFasta(const std::vector<DeBruijnNode *> & nodes, bool sign)
+{
+    loadMissingSequences(nodes);
+    return writeRecords(nodes,
+                        [](DeBruijnNode * node) {return 64LL + node->getLength() + node->getLength() / 70;},
+                        [sign](QByteArray * buffer, DeBruijnNode * node) {appendFasta(buffer, node, sign);});
+}
+
+
+bool GraphWriter::writeGfaSegments(const std::vector<DeBruijnNode *> & nodes, QString depthTag)
+{
+    loadMissingSequences(nodes);
+    QByteArray depthTagBytes = depthTag.toUtf8();
+    return writeRecords(nodes,
+                        [](DeBruijnNode * node) {return 64LL + node->getLength();},
+                        [&depthTagBytes](QByteArray * buffer, DeBruijnNode * node) {appendGfaSegmentLine(buffer, node, depthTagBytes);});
+}
+
+
+bool GraphWriter::writeGfaLinks(const std::vector<DeBruijnEdge *> & edges)
+{
+    return writeRecords(edges,
+                        [](DeBruijnEdge *) {return 32LL;},
+                        [](QByteArray * buffer, DeBruijnEdge * edge) {appendGfaLinkLine(buffer, edge);});
+}
+
+
+//Nodes load missing sequences from a FASTA file the first time one is asked
+//for.  That isn't safe to do from the formatting threads, so it is done here
+//first if it will be needed.
+void GraphWriter::loadMissingSequences(const std::vector<DeBruijnNode *> & nodes)
+{
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes[i]->sequenceIsMissing())
+        {
+            nodes[i]->getAssemblyGraph()->attemptToLoadSequencesFromFasta();
+            return;
+        }
+    }
+}
+
+
+//The items are split into blocks using the estimated size of each record.
+//Each round formats as many blocks as there are threads, and the previous
+//round is written while that happens.
+template<typename Item, typename EstimateSize, typename Format>
+bool GraphWriter::writeRecords(const std::vector<Item> & items, EstimateSize estimateSize, Format format)
+{
+    if (!m_okay)
+        return false;
+
+    std::vector<size_t> blockStarts;
+    std::vector<long long> blockSizes;
+    long long currentBlockSize = BLOCK_SIZE;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        if (currentBlockSize >= BLOCK_SIZE)
+        {
+            blockStarts.push_back(i);
+            blockSizes.push_back(0);
+            currentBlockSize = 0;
+        }
+        currentBlockSize += estimateSize(items[i]);
+        blockSizes.back() = currentBlockSize;
+    }
+    blockStarts.push_back(items.size());
+    long long blockCount = blockSizes.size();
+
+    long long blocksPerRound = std::max(1, QThread::idealThreadCount());
+    std::vector<QByteArray> formatting(blocksPerRound);
+    std::vector<QByteArray> writing(blocksPerRound);
+    std::thread writer;
+    bool writeOkay = true;
+
+    for (long long roundStart = 0; roundStart < blockCount; roundStart += blocksPerRound)
+    {
+        long long roundBlockCount = std::min(blocksPerRound, blockCount - roundStart);
+        parallelForChunks(roundBlockCount, [&](int, long long begin, long long end)
+        {
+            for (long long i = begin; i < end; ++i)
+            {
+                long long block = roundStart + i;
+                QByteArray * buffer = &formatting[i];
+                buffer->clear();
+                buffer->reserve(int(blockSizes[block]));
+                for (size_t j = blockStarts[block]; j < blockStarts[block + 1]; ++j)
+                    format(buffer, items[j]);
+            }
+        }, 1);
+        for (long long i = roundBlockCount; i < blocksPerRound; ++i)
+            formatting[i].clear();
+
+        if (writer.joinable())
+            writer.join();
+        formatting.swap(writing);
+        writer = std::thread([this, &writing, &writeOkay]()
+        {
+            for (size_t i = 0; i < writing.size() && writeOkay; ++i)
+            {
+                if (!writing[i].isEmpty() && m_file.write(writing[i]) != writing[i].size())
+                    writeOkay = false;
+            }
+        });
+    }
+    if (writer.joinable())
+        writer.join();
+
+    m_okay = writeOkay;
+    return m_okay;
+}
+
+
+//This breaks a sequence into lines of the given length.  The output always
+//ends in a newline.
+void GraphWriter::appendSequenceWithNewlines(QByteArray * buffer, const QByteArray & sequence,
+                                             int interval)
+{
+    const char * data = sequence.constData();
+    int charactersRemaining = int(sequence.length());
+    while (charactersRemaining > interval)
+    {
+        buffer->append(data, interval);
+        buffer->append('\n');
+        data += interval;
+        charactersRemaining -= interval;
+    }
+    buffer->append(data, charactersRemaining);
+    buffer->append('\n');
+}
+
+
+void GraphWriter::appendFasta(QByteArray * buffer, const DeBruijnNode * node, bool sign,
+                              bool newLines, bool evenIfEmpty)
+{
+    QByteArray sequence = node->getSequence();
+    if (sequence.isEmpty() && !evenIfEmpty)
+        return;
+
+    buffer->append(">NODE_");
+    appendString(buffer, sign ? node->getName() : node->getNameWithoutSign());
+    buffer->append("_length_");
+    appendNumber(buffer, node->getLength());
+    buffer->append("_cov_");
+    appendNumber(buffer, node->getDepth());
+    buffer->append('\n');
+    if (newLines)
+        appendSequenceWithNewlines(buffer, sequence);
+    else
+    {
+        buffer->append(sequence);
+        buffer->append('\n');
+    }
+}
+
+
+void GraphWriter::appendGfaSegmentLine(QByteArray * buffer, const DeBruijnNode * node,
+                                       const QByteArray & depthTag)
+{
+    QByteArray gfaSequence = node->getSequenceForGfa();
+    int length = int(gfaSequence.length());
+
+    buffer->append("S\t");
+    appendString(buffer, node->getNameWithoutSign());
+    buffer->append('\t');
+    buffer->append(gfaSequence);
+    buffer->append("\tLN:i:");
+    appendNumber(buffer, length);
+
+    //We use the depthTag to guide how we save the node depth.
+    //If it is empty, that implies that the loaded graph did not have depth
+    //information and so we don't save depth.
+    if (depthTag == "DP")
+    {
+        buffer->append("\tDP:f:");
+        appendNumber(buffer, node->getDepth());
+    }
+    else if (depthTag == "KC" || depthTag == "RC" || depthTag == "FC")
+    {
+        buffer->append('\t');
+        buffer->append(depthTag);
+        buffer->append(":i:");
+        appendNumber(buffer, int(node->getDepth() * length + 0.5));
+    }
+
+    //If the user has included custom labels or colours, include those.
+    DeBruijnNode * reverseComplement = node->getReverseComplement();
+    if (!node->getCustomLabel().isEmpty())
+    {
+        buffer->append("\tLB:z:");
+        appendString(buffer, node->getCustomLabel());
+    }
+    if (!reverseComplement->getCustomLabel().isEmpty())
+    {
+        buffer->append("\tL2:z:");
+        appendString(buffer, reverseComplement->getCustomLabel());
+    }
+    if (node->hasCustomColour())
+    {
+        buffer->append("\tCL:z:");
+        appendString(buffer, getColourName(node->getCustomColour()));
+    }
+    if (reverseComplement->hasCustomColour())
+    {
+        buffer->append("\tC2:z:");
+        appendString(buffer, getColourName(reverseComplement->getCustomColour()));
+    }
+    buffer->append('\n');
+}
+
+
+void GraphWriter::appendGfaLinkLine(QByteArray * buffer, const DeBruijnEdge * edge)
+{
+    DeBruijnNode * startingNode = edge->getStartingNode();
+    DeBruijnNode * endingNode = edge->getEndingNode();
+
+    buffer->append("L\t");
+    appendString(buffer, startingNode->getNameWithoutSign());
+    buffer->append('\t');
+    appendString(buffer, startingNode->getSign());
+    buffer->append('\t');
+    appendString(buffer, endingNode->getNameWithoutSign());
+    buffer->append('\t');
+    appendString(buffer, endingNode->getSign());
+    buffer->append('\t');
+
+    //When Velvet graphs are saved to GFA, the sequences are extended to include
+    //the overlap.  So even though this edge might have no overlap, the GFA link
+    //line should.
+    AssemblyGraph * graph = edge->getAssemblyGraph();
+    if (graph->m_graphFileType == LAST_GRAPH)
+        appendNumber(buffer, graph->m_kmer - 1);
+    else
+        appendNumber(buffer, edge->getOverlap());
+    buffer->append("M\n");
+}
@@ -0,0 +1,74 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GRAPHWRITER_H
+#define GRAPHWRITER_H
+
+//This class writes FASTA records and GFA segment and link lines to a file.
+//The records are split into blocks of a few megabytes which are formatted in
+//parallel, each into its own buffer, with sequences appended straight from
+//the nodes.  The buffers are then written to the file in order, on a separate
+//thread so the next round of blocks can be formatted while the last one is
+//being written.
+//
+//The append functions are also used by DeBruijnNode and DeBruijnEdge to make
+//single records, so there is one definition of each file format.
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <vector>
+
+class DeBruijnNode;
+class DeBruijnEdge;
+
+class GraphWriter
+{
+public:
+    //CREATORS
+    GraphWriter();
+    ~GraphWriter();
+
+    //ACCESSORS
+    bool isOkay() const {return m_okay;}
+
+    //MODIFERS
+    bool open(QString filename);
+    bool writeFasta(const std::vector<DeBruijnNode *> & nodes, bool sign);
+    bool writeGfaSegments(const std::vector<DeBruijnNode *> & nodes, QString depthTag);
+    bool writeGfaLinks(const std::vector<DeBruijnEdge *> & edges);
+    bool close();
+
+    static void appendSequenceWithNewlines(QByteArray * buffer, const QByteArray & sequence,
+                                           int interval = 70);
+    static void appendFasta(QByteArray * buffer, const DeBruijnNode * node, bool sign,
+                            bool newLines = true, bool evenIfEmpty = true);
+    static void appendGfaSegmentLine(QByteArray * buffer, const DeBruijnNode * node,
+                                     const QByteArray & depthTag);
+    static void appendGfaLinkLine(QByteArray * buffer, const DeBruijnEdge * edge);
+
+private:
+    QFile m_file;
+    bool m_okay;
+
+    template<typename Item, typename EstimateSize, typename Format>
+    bool writeRecords(const std::vector<Item> & items, EstimateSize estimateSize, Format format);
+    static void loadMissingSequences(const std::vector<DeBruijnNode *> & nodes);
+};
+
+#endif // GRAPHWRITER_H
@@ -0,0 +1,133 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "nodenameindex.h"
+#include "debruijnnode.h"
+#include "../program/parallel.h"
+#include <algorithm>
+#include <iterator>
+
+NodeNameIndex::NodeNameIndex()
+{
+}
+
+
+void NodeNameIndex::clear()
+{
+    m_nodes.clear();
+    m_names.clear();
+    m_trigrams.clear();
+}
+
+
+//Each node is added once to the list of each distinct trigram in its name.
+//The nodes are added in order, so every list is sorted.
+void NodeNameIndex::build(const std::vector<DeBruijnNode *> & nodes)
+{
+    clear();
+    m_nodes = nodes;
+    m_names.reserve(nodes.size());
+
+    std::vector<quint64> nameTrigrams;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        m_names.push_back(nodes[i]->getName());
+        const QString & name = m_names.back();
+
+        nameTrigrams.clear();
+        for (int j = 0; j + 3 <= name.length(); ++j)
+            nameTrigrams.push_back(getTrigram(name.constData() + j));
+        std::sort(nameTrigrams.begin(), nameTrigrams.end());
+        nameTrigrams.erase(std::unique(nameTrigrams.begin(), nameTrigrams.end()), nameTrigrams.end());
+
+        for (size_t j = 0; j < nameTrigrams.size(); ++j)
+            m_trigrams[nameTrigrams[j]].push_back(int(i));
+    }
+}
+
+
+quint64 NodeNameIndex::getTrigram(const QChar * characters)
+{
+    return (quint64(characters[0].unicode()) << 32) |
+           (quint64(characters[1].unicode()) << 16) |
+            quint64(characters[2].unicode());
+}
+
+
+//This function returns the nodes whose names contain the query, in node
+//index order.
+std::vector<DeBruijnNode *> NodeNameIndex::findNodes(QString query) const
+{
+    std::vector<DeBruijnNode *> found;
+    if (query.isEmpty())
+        return found;
+
+    if (query.length() >= 3)
+    {
+        std::vector<int> candidates = getCandidates(query);
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            if (m_names[candidates[i]].contains(query))
+                found.push_back(m_nodes[candidates[i]]);
+        }
+        return found;
+    }
+
+    long long nodeCount = (long long)m_nodes.size();
+    std::vector<std::vector<DeBruijnNode *> > chunkFound(getParallelThreadCount(nodeCount));
+    parallelForChunks(nodeCount, [&](int chunk, long long begin, long long end)
+    {
+        for (long long i = begin; i < end; ++i)
+        {
+            if (m_names[i].contains(query))
+                chunkFound[chunk].push_back(m_nodes[i]);
+        }
+    });
+    for (size_t i = 0; i < chunkFound.size(); ++i)
+        found.insert(found.end(), chunkFound[i].begin(), chunkFound[i].end());
+    return found;
+}
+
+
+//The candidates are the nodes which have every trigram in the query.  The
+//lists are intersected from the shortest up, so the work depends on the
+//rarest trigram and not on the number of nodes.
+std::vector<int> NodeNameIndex::getCandidates(const QString & query) const
+{
+    std::vector<const std::vector<int> *> lists;
+    for (int i = 0; i + 3 <= query.length(); ++i)
+    {
+        QHash<quint64, std::vector<int> >::const_iterator list = m_trigrams.constFind(getTrigram(query.constData() + i));
+        if (list == m_trigrams.constEnd())
+            return std::vector<int>();
+        lists.push_back(&list.value());
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const std::vector<int> * a, const std::vector<int> * b) {return a->size() < b->size();});
+
+    std::vector<int> candidates = *lists[0];
+    std::vector<int> intersection;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i)
+    {
+        intersection.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+    return candidates;
+}
@@ -0,0 +1,60 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef NODENAMEINDEX_H
+#define NODENAMEINDEX_H
+
+//This class finds the nodes whose names contain a given string.  Each node
+//is listed under every trigram (three character substring) in its name, so a
+//search only has to look at the nodes which have all of the query's
+//trigrams, and those are then checked with QString::contains.  Queries
+//shorter than a trigram match too many names for an index to help, so they
+//are checked against every name, in parallel.
+//
+//The nodes are kept in the order they were given (the graph's node index
+//order), and results come back in that order.
+
+#include <QString>
+#include <QHash>
+#include <vector>
+
+class DeBruijnNode;
+
+class NodeNameIndex
+{
+public:
+    //CREATORS
+    NodeNameIndex();
+
+    //ACCESSORS
+    std::vector<DeBruijnNode *> findNodes(QString query) const;
+
+    //MODIFERS
+    void build(const std::vector<DeBruijnNode *> & nodes);
+    void clear();
+
+private:
+    std::vector<DeBruijnNode *> m_nodes;
+    std::vector<QString> m_names;
+    QHash<quint64, std::vector<int> > m_trigrams;
+
+    static quint64 getTrigram(const QChar * characters);
+    std::vector<int> getCandidates(const QString & query) const;
+};
+
+#endif // NODENAMEINDEX_H
@@ -26,6 +26,8 @@
 #include <QStringList>
 #include <QApplication>
 #include <limits>
+#include <algorithm>
+#include <QIODevice>
 
 
 
@@ -115,10 +117,31 @@ Path Path::makeFromOrderedNodes(QList<DeBruijnNode *> nodes, bool circular)
 
 
 
+//This function makes a linear path which starts and ends at the given places
+//in its first and last nodes.
+Path Path::makeFromOrderedNodes(QList<DeBruijnNode *> nodes,
+                                GraphLocation startLocation,
+                                GraphLocation endLocation)
+{
+    Path path = makeFromOrderedNodes(nodes, false);
+    if (path.isEmpty())
+        return path;
+
+    path.m_startLocation = startLocation;
+    path.m_endLocation = endLocation;
+    return path;
+}
+
+
+//The path's nodes are looked up in the given graph, or in the global graph if
+//none is given.
 Path Path::makeFromString(QString pathString, bool circular,
-                          QString * pathStringFailure)
+                          QString * pathStringFailure,
+                          const AssemblyGraph * assemblyGraph)
 {
     Path path;
+    if (assemblyGraph == 0)
+        assemblyGraph = g_assemblyGraph.data();
 
     QRegularExpression re("^(?:\\(([0-9]+)\\) ?)*((?:[^,]+[-\\+], ?)*[^,]+[-\\+])(?: ?\\(([0-9]+)\\))*$");
     QRegularExpressionMatch match = re.match(pathString);
@@ -155,8 +178,9 @@ Path Path::makeFromString(QString pathString, bool circular,
     for (int i = 0; i < nodeNameList.size(); ++i)
     {
         QString nodeName = nodeNameList[i].simplified();
-        if (g_assemblyGraph->m_deBruijnGraphNodes.contains(nodeName))
-            nodesInGraph.push_back(g_assemblyGraph->m_deBruijnGraphNodes[nodeName]);
+        DeBruijnNode * node = assemblyGraph->m_deBruijnGraphNodes.value(nodeName);
+        if (node != 0)
+            nodesInGraph.push_back(node);
         else
             nodesNotInGraph.push_back(nodeName);
     }
@@ -439,71 +463,150 @@ bool Path::checkForOtherEdges()
 
 //This function extracts the sequence for the whole path.  It uses the overlap
 //value in the edges to remove sequences that are duplicated at the end of one
-//node and the start of the next.
+//node and the start of the next.  The output length is known in advance, so
+//the sequence is built in a single allocation.
 QByteArray Path::getPathSequence() const
 {
     if (m_nodes.empty())
         return "";
 
+    std::vector<SequencePart> parts = getSequenceParts();
+    return getSequenceFromParts(parts, 0, getLengthOfParts(parts));
+}
+
+
+//This function gives part of the path's sequence, from start (inclusive) to
+//end (exclusive), both 0-based.  Only that part is copied.
+QByteArray Path::getPathSubsequence(long long start, long long end) const
+{
+    std::vector<SequencePart> parts = getSequenceParts();
+    return getSequenceFromParts(parts, start, end);
+}
+
+
+//A QByteArray's size is an int, so a sequence longer than that can't be
+//built.  For such a range, an empty sequence is returned and the sequence
+//should be written with writeFasta instead.
+QByteArray Path::getSequenceFromParts(const std::vector<SequencePart> & parts,
+                                      long long start, long long end)
+{
     QByteArray sequence;
-    QByteArray firstNodeSequence = m_nodes[0]->getSequence();
+    if (end <= start || end - start > std::numeric_limits<int>::max())
+        return sequence;
+    sequence.reserve(int(end - start));
 
-    //If the path is circular, we trim the overlap from the first node.
-    if (isCircular())
+    long long partStart = 0;
+    for (size_t i = 0; i < parts.size() && partStart < end; ++i)
     {
-        int overlap = m_edges.back()->getOverlap();
-        if (overlap != 0)
-            firstNodeSequence = modifySequenceUsingOverlap(firstNodeSequence, overlap);
-        sequence += firstNodeSequence;
+        const SequencePart & part = parts[i];
+        long long partEnd = partStart + part.length;
+        long long from = std::max(start, partStart);
+        long long to = std::min(end, partEnd);
+        if (from < to)
+        {
+            if (part.nodeSequence.isNull())
+                sequence.append(QByteArray(int(to - from), 'N'));
+            else
+                sequence.append(part.nodeSequence.constData() + part.start + (from - partStart), int(to - from));
+        }
+        partStart = partEnd;
     }
+    return sequence;
+}
+
+
+long long Path::getLengthOfParts(const std::vector<SequencePart> & parts)
+{
+    long long length = 0;
+    for (size_t i = 0; i < parts.size(); ++i)
+        length += parts[i].length;
+    return length;
+}
 
-    //If the path is linear, then we begin either with the entire first node
-    //sequence or part of it.
+
+long long Path::getPathSequenceLength() const
+{
+    return getLengthOfParts(getSequenceParts());
+}
+
+
+//This function breaks the path's sequence into the stretches of node sequence
+//it is made of.  The first node may start part way in, each later node has the
+//overlap trimmed from its start (or Ns added, for a negative overlap) and the
+//end is trimmed to the path's end location.
+std::vector<Path::SequencePart> Path::getSequenceParts() const
+{
+    std::vector<SequencePart> parts;
+    if (m_nodes.empty())
+        return parts;
+    parts.reserve(m_nodes.size() + 1);
+
+    //If the path is circular, we trim the overlap from the first node.  If it
+    //is linear, then we begin either with the entire first node sequence or
+    //part of it.
+    QByteArray firstNodeSequence = m_nodes[0]->getSequence();
+    if (isCircular())
+        addSequencePart(&parts, firstNodeSequence, 0, m_edges.back()->getOverlap());
     else
     {
-        int rightChars = firstNodeSequence.length() - m_startLocation.getPosition() + 1;
-        sequence += firstNodeSequence.right(rightChars);
+        int start = std::min(std::max(0, m_startLocation.getPosition() - 1),
+                             int(firstNodeSequence.length()));
+        addSequencePart(&parts, firstNodeSequence, start, 0);
     }
 
     //The middle nodes are not affected by whether or not the path is circular
     //or has partial node ends.
     for (int i = 1; i < m_nodes.size(); ++i)
-    {
-        int overlap = m_edges[i-1]->getOverlap();
-        QByteArray nodeSequence = m_nodes[i]->getSequence();
-        if (overlap != 0)
-            nodeSequence = modifySequenceUsingOverlap(nodeSequence, overlap);
-        sequence += nodeSequence;
-    }
+        addSequencePart(&parts, m_nodes[i]->getSequence(), 0, m_edges[i-1]->getOverlap());
 
+    //The trim at the end can take in more than the last part if the last
+    //node was mostly overlap.
     DeBruijnNode * lastNode = m_nodes.back();
     int amountToTrimFromEnd = lastNode->getLength() - m_endLocation.getPosition();
-    sequence.chop(amountToTrimFromEnd);
+    while (amountToTrimFromEnd > 0 && !parts.empty())
+    {
+        SequencePart * lastPart = &parts.back();
+        if (lastPart->length <= amountToTrimFromEnd)
+        {
+            amountToTrimFromEnd -= lastPart->length;
+            parts.pop_back();
+        }
+        else
+        {
+            lastPart->length -= amountToTrimFromEnd;
+            amountToTrimFromEnd = 0;
+        }
+    }
 
-    return sequence;
+    return parts;
 }
 
 
-//This function will trim bases from the start of a sequence (in the case of
-//positive overlap) or add Ns to the start (in the case of negative overlap).
-QByteArray Path::modifySequenceUsingOverlap(QByteArray sequence, int overlap) const
+//A positive overlap trims bases from the start of the node's sequence (if it
+//is long enough) and a negative overlap adds Ns before it.
+void Path::addSequencePart(std::vector<SequencePart> * parts, const QByteArray & nodeSequence,
+                           int start, int overlap) const
 {
-    if (overlap > 0)
+    int length = int(nodeSequence.length());
+    if (overlap > 0 && length - overlap >= 0)
+        start += overlap;
+    else if (overlap < 0)
     {
-        int rightChars = sequence.length() - overlap;
-        if (rightChars >= 0)
-            sequence = sequence.right(rightChars);
+        SequencePart nPart = {QByteArray(), 0, -overlap};
+        parts->push_back(nPart);
     }
-    else if (overlap < 0)
-        sequence = QByteArray(-overlap, 'N') + sequence;
 
-    return sequence;
+    if (length - start > 0)
+    {
+        SequencePart part = {nodeSequence, start, length - start};
+        parts->push_back(part);
+    }
 }
 
 
-int Path::getLength() const
+long long Path::getLength() const
 {
-    int length = 0;
+    long long length = 0;
     for (int i = 0; i < m_nodes.size(); ++i)
         length += m_nodes[i]->getLength();
 
@@ -519,30 +622,79 @@ int Path::getLength() const
 }
 
 
+//The description line is a comma-delimited list of the nodes in the path.
+QByteArray Path::getFastaHeader() const
+{
+    QByteArray header = ">" + getString(false).toUtf8();
+    if (isCircular())
+        header += "(circular)";
+    header += "\n";
+    return header;
+}
+
+
 QString Path::getFasta() const
 {
-    //The description line is a comma-delimited list of the nodes in the path
-    QString fasta = ">" + getString(false);
+    return QString::fromUtf8(getFastaHeader() + AssemblyGraph::addNewlinesToSequence(getPathSequence()));
+}
 
-    if (isCircular())
-        fasta += "(circular)";
-    fasta += "\n";
 
-    QString pathSequence = getPathSequence();
+//This function writes the path as a FASTA record without building its
+//sequence in memory: the node sequences are wrapped into lines as they are
+//copied into a buffer, which is written out whenever it fills.  If no name is
+//given, the header is the same as getFasta's.
+bool Path::writeFasta(QIODevice * device, QString name) const
+{
+    const int lineLength = 70;
+    const int bufferSize = 1024 * 1024;
+
+    QByteArray buffer;
+    buffer.reserve(bufferSize + lineLength + 1);
+    if (name.isEmpty())
+        buffer += getFastaHeader();
+    else
+        buffer += ">" + name.toUtf8() + "\n";
+
+    std::vector<SequencePart> parts = getSequenceParts();
+    QByteArray nRun;
     int charactersOnLine = 0;
-    for (int i = 0; i < pathSequence.length(); ++i)
+    for (size_t i = 0; i < parts.size(); ++i)
     {
-        fasta += pathSequence.at(i);
-        ++charactersOnLine;
-        if (charactersOnLine >= 70)
+        const SequencePart & part = parts[i];
+        const char * data;
+        if (part.nodeSequence.isNull())
         {
-            fasta += "\n";
-            charactersOnLine = 0;
+            nRun.fill('N', part.length);
+            data = nRun.constData();
+        }
+        else
+            data = part.nodeSequence.constData() + part.start;
+
+        int remaining = part.length;
+        while (remaining > 0)
+        {
+            if (charactersOnLine == lineLength)
+            {
+                buffer += '\n';
+                charactersOnLine = 0;
+            }
+            int count = std::min(remaining, lineLength - charactersOnLine);
+            buffer.append(data, count);
+            data += count;
+            remaining -= count;
+            charactersOnLine += count;
+
+            if (buffer.size() >= bufferSize)
+            {
+                if (device->write(buffer) != buffer.size())
+                    return false;
+                buffer.resize(0);
+            }
         }
     }
-    fasta += "\n";
+    buffer += '\n';
 
-    return fasta;
+    return device->write(buffer) == buffer.size();
 }
 
 
@@ -697,7 +849,7 @@ QList<Path> Path::getAllPossiblePaths(GraphLocation startLocation,
             {
                 Path potentialFinishedPath = *j;
                 potentialFinishedPath.m_endLocation = endLocation;
-                int length = potentialFinishedPath.getLength();
+                long long length = potentialFinishedPath.getLength();
                 if (length >= minDistance && length <= maxDistance)
                     finishedPaths.push_back(potentialFinishedPath);
                 ++j;
@@ -29,6 +29,7 @@
 
 class DeBruijnNode;
 class DeBruijnEdge;
+class QIODevice;
 
 class Path
 {
@@ -41,8 +42,12 @@ public:
                                        bool strandSpecific);
     static Path makeFromOrderedNodes(QList<DeBruijnNode *> nodes,
                                      bool circular);
+    static Path makeFromOrderedNodes(QList<DeBruijnNode *> nodes,
+                                     GraphLocation startLocation,
+                                     GraphLocation endLocation);
     static Path makeFromString(QString pathString, bool circular,
-                               QString * pathStringFailure);
+                               QString * pathStringFailure,
+                               const AssemblyGraph * assemblyGraph = 0);
 
     //ACCESSORS
     QList<DeBruijnNode *> getNodes() const {return m_nodes;}
@@ -52,9 +57,12 @@ public:
     bool haveSameNodes(Path other) const;
     bool hasNodeSubset(Path other) const;
     QByteArray getPathSequence() const;
+    QByteArray getPathSubsequence(long long start, long long end) const;
+    long long getPathSequenceLength() const;
     QString getFasta() const;
+    bool writeFasta(QIODevice * device, QString name = QString()) const;
     QString getString(bool spaces) const;
-    int getLength() const;
+    long long getLength() const;
     QList<Path> extendPathInAllPossibleWays() const;
     bool canNodeFitOnEnd(DeBruijnNode * node, Path * extendedPath) const;
     bool canNodeFitAtStart(DeBruijnNode * node, Path * extendedPath) const;
@@ -83,6 +91,15 @@ public:
                                            int minDistance, int maxDistance);
 
 private:
+    //A path's sequence is made of stretches of node sequences, which share
+    //the nodes' storage, and runs of Ns where an overlap is negative.
+    struct SequencePart
+    {
+        QByteArray nodeSequence;
+        int start;
+        int length;
+    };
+
     GraphLocation m_startLocation;
     GraphLocation m_endLocation;
     QList<DeBruijnNode *> m_nodes;
@@ -90,7 +107,13 @@ private:
 
     void buildUnambiguousPathFromNodes(QList<DeBruijnNode *> nodes,
                                        bool strandSpecific);
-    QByteArray modifySequenceUsingOverlap(QByteArray sequence, int overlap) const;
+    void addSequencePart(std::vector<SequencePart> * parts, const QByteArray & nodeSequence,
+                         int start, int overlap) const;
+    std::vector<SequencePart> getSequenceParts() const;
+    static QByteArray getSequenceFromParts(const std::vector<SequencePart> & parts,
+                                           long long start, long long end);
+    static long long getLengthOfParts(const std::vector<SequencePart> & parts);
+    QByteArray getFastaHeader() const;
     bool checkForOtherEdges();
 };
 
@@ -0,0 +1,448 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sequenceindex.h"
+#include "assemblygraph.h"
+#include "debruijnnode.h"
+#include "debruijnedge.h"
+#include "graphlocation.h"
+#include "../program/parallel.h"
+#include <QList>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <set>
+
+namespace
+{
+
+//Bases are coded in two bits each.  Anything else (e.g. N) can't be part of
+//a k-mer.
+inline int getBaseCode(char base)
+{
+    switch (base)
+    {
+    case 'A': case 'a': return 0;
+    case 'C': case 'c': return 1;
+    case 'G': case 'g': return 2;
+    case 'T': case 't': return 3;
+    default: return -1;
+    }
+}
+
+
+//This calls function(code, start) for each k-mer in the sequence.
+template<typename Function>
+void forEachKmer(const QByteArray & sequence, int kmerSize, Function function)
+{
+    quint32 mask = (quint32(1) << (2 * kmerSize)) - 1;
+    quint32 code = 0;
+    int basesInKmer = 0;
+    for (int i = 0; i < sequence.length(); ++i)
+    {
+        int baseCode = getBaseCode(sequence.at(i));
+        if (baseCode < 0)
+        {
+            basesInKmer = 0;
+            continue;
+        }
+        code = ((code << 2) | quint32(baseCode)) & mask;
+        if (++basesInKmer >= kmerSize)
+            function(code, i - kmerSize + 1);
+    }
+}
+
+
+//The query is upper case, but a node's sequence might not be.
+inline bool basesMatch(char nodeBase, char queryBase)
+{
+    return nodeBase == queryBase || (nodeBase >= 'a' && nodeBase <= 'z' && nodeBase - ('a' - 'A') == queryBase);
+}
+
+
+//A match (or the part of one found so far) runs from start in the first node
+//to just before end in the last node.  Matches are the same if they take the
+//same nodes and positions.
+struct FoundMatch
+{
+    std::vector<DeBruijnNode *> nodes;
+    int start;
+    int end;
+    int mismatches;
+
+    bool operator<(const FoundMatch & other) const
+    {
+        if (nodes != other.nodes)
+            return nodes < other.nodes;
+        if (start != other.start)
+            return start < other.start;
+        return end < other.end;
+    }
+};
+
+
+//A seed is a k-mer of the query (starting at queryOffset) found in a node.
+struct Seed
+{
+    int node;
+    int position;
+    int queryOffset;
+
+    int getQueryStart() const {return position - queryOffset;}
+};
+
+bool compareSeeds(const Seed & a, const Seed & b)
+{
+    if (a.node != b.node)
+        return a.node < b.node;
+    if (a.getQueryStart() != b.getQueryStart())
+        return a.getQueryStart() < b.getQueryStart();
+    return a.queryOffset < b.queryOffset;
+}
+
+
+//This class collects the matches for one query.  It stops taking matches once
+//it has one more than it can return, so the caller knows they were truncated.
+class MatchFinder
+{
+public:
+    MatchFinder(const QByteArray & query, int maxMismatches, int maxMatches) :
+        m_query(query), m_maxMismatches(maxMismatches), m_maxMatches(size_t(maxMatches)) {}
+
+    bool isFull() const {return m_matches.size() > m_maxMatches;}
+    void addMatchesAt(DeBruijnNode * node, int position, int queryOffset);
+    std::vector<SequenceMatch> getMatches(bool * truncated) const;
+
+private:
+    QByteArray m_query;
+    int m_maxMismatches;
+    size_t m_maxMatches;
+    std::set<FoundMatch> m_matches;
+
+    void extend(DeBruijnNode * node, int position, const QByteArray & query, int queryPosition,
+                int mismatches, std::vector<DeBruijnNode *> * nodes,
+                std::vector<FoundMatch> * extensions) const;
+    void addMatch(const FoundMatch & match);
+};
+
+
+//This follows the query forward from a position in a node, and on into the
+//following nodes if it reaches the end.  An edge's overlap is already at the
+//end of the node it leads from, so the next node is entered after it.  Each
+//time the end of the query is reached, the nodes so far (including any
+//already in nodes) are saved as an extension.
+void MatchFinder::extend(DeBruijnNode * node, int position, const QByteArray & query, int queryPosition,
+                         int mismatches, std::vector<DeBruijnNode *> * nodes,
+                         std::vector<FoundMatch> * extensions) const
+{
+    //Each node normally adds at least one base, so the node limit only stops
+    //loops of nodes which are entirely overlap.
+    if (extensions->size() > m_maxMatches || node->sequenceIsMissing() ||
+            int(nodes->size()) > 2 * m_query.length())
+        return;
+
+    QByteArray sequence = node->getSequence();
+    while (queryPosition < query.length() && position < sequence.length())
+    {
+        if (!basesMatch(sequence.at(position), query.at(queryPosition)) && ++mismatches > m_maxMismatches)
+            return;
+        ++position;
+        ++queryPosition;
+    }
+
+    nodes->push_back(node);
+    if (queryPosition == query.length())
+    {
+        FoundMatch extension;
+        extension.nodes = *nodes;
+        extension.start = 0;
+        extension.end = position;
+        extension.mismatches = mismatches;
+        extensions->push_back(extension);
+    }
+    else
+    {
+        std::vector<DeBruijnEdge *> edges = node->getLeavingEdges();
+        for (size_t i = 0; i < edges.size(); ++i)
+        {
+            if (edges[i]->getOverlap() >= 0)
+                extend(edges[i]->getEndingNode(), edges[i]->getOverlap(), query, queryPosition,
+                       mismatches, nodes, extensions);
+        }
+    }
+    nodes->pop_back();
+}
+
+
+void MatchFinder::addMatch(const FoundMatch & match)
+{
+    if (!isFull())
+        m_matches.insert(match);
+}
+
+
+//This adds the matches which have the query's base at queryOffset at the
+//given position in the node.
+void MatchFinder::addMatchesAt(DeBruijnNode * node, int position, int queryOffset)
+{
+    std::vector<DeBruijnNode *> nodes;
+    std::vector<FoundMatch> extensions;
+    if (position >= queryOffset)
+    {
+        extend(node, position - queryOffset, m_query, 0, 0, &nodes, &extensions);
+        for (size_t i = 0; i < extensions.size(); ++i)
+        {
+            extensions[i].start = position - queryOffset;
+            addMatch(extensions[i]);
+        }
+        return;
+    }
+
+    //If the query starts before this node, the part before the seed is found
+    //by following its reverse complement forward from the same place on the
+    //complement node.  Each of those is then followed forward from the seed.
+    DeBruijnNode * reverseComplement = node->getReverseComplement();
+    QByteArray queryStart = AssemblyGraph::getReverseComplement(m_query.left(queryOffset));
+    std::vector<FoundMatch> startExtensions;
+    extend(reverseComplement, reverseComplement->getSequence().length() - position, queryStart, 0, 0,
+           &nodes, &startExtensions);
+
+    for (size_t i = 0; i < startExtensions.size() && !isFull(); ++i)
+    {
+        const FoundMatch & startExtension = startExtensions[i];
+        nodes.clear();
+        for (size_t j = startExtension.nodes.size() - 1; j > 0; --j)
+            nodes.push_back(startExtension.nodes[j]->getReverseComplement());
+        int start = startExtension.nodes.back()->getSequence().length() - startExtension.end;
+
+        extensions.clear();
+        extend(node, position, m_query, queryOffset, startExtension.mismatches, &nodes, &extensions);
+        for (size_t j = 0; j < extensions.size(); ++j)
+        {
+            extensions[j].start = start;
+            addMatch(extensions[j]);
+        }
+    }
+}
+
+
+//The matches are sorted with the fewest mismatches first, then by path.
+std::vector<SequenceMatch> MatchFinder::getMatches(bool * truncated) const
+{
+    std::vector<std::pair<QString, SequenceMatch> > sortableMatches;
+    for (std::set<FoundMatch>::const_iterator i = m_matches.begin(); i != m_matches.end(); ++i)
+    {
+        QList<DeBruijnNode *> nodes;
+        for (size_t j = 0; j < i->nodes.size(); ++j)
+            nodes.push_back(i->nodes[j]);
+
+        SequenceMatch match;
+        match.path = Path::makeFromOrderedNodes(nodes, GraphLocation(nodes.front(), i->start + 1),
+                                                GraphLocation(nodes.back(), i->end));
+        match.mismatches = i->mismatches;
+        if (!match.path.isEmpty())
+            sortableMatches.push_back(std::pair<QString, SequenceMatch>(match.path.getString(false), match));
+    }
+    std::sort(sortableMatches.begin(), sortableMatches.end(),
+              [](const std::pair<QString, SequenceMatch> & a, const std::pair<QString, SequenceMatch> & b)
+              {
+                  if (a.second.mismatches != b.second.mismatches)
+                      return a.second.mismatches < b.second.mismatches;
+                  return a.first < b.first;
+              });
+
+    if (truncated != 0)
+        *truncated = sortableMatches.size() > m_maxMatches;
+    std::vector<SequenceMatch> matches;
+    for (size_t i = 0; i < sortableMatches.size() && i < m_maxMatches; ++i)
+        matches.push_back(sortableMatches[i].second);
+    return matches;
+}
+
+}
+
+
+SequenceIndex::SequenceIndex()
+{
+}
+
+
+void SequenceIndex::clear()
+{
+    m_nodes.clear();
+    m_offsets.clear();
+    m_positions.clear();
+}
+
+
+//The k-mers are counted for each code, which gives the start of each code's
+//group, and then put in their groups.  Both steps are done in parallel over
+//the nodes, using atomic counters.  The order within a group then depends on
+//the threads, so each group is sorted.
+void SequenceIndex::build(const std::vector<DeBruijnNode *> & nodes)
+{
+    clear();
+    m_nodes = nodes;
+
+    //Getting a node's sequence can load the sequences from a FASTA file,
+    //which can't be done by the worker threads, so they are all got first.
+    //
+    //A k-mer which runs from a node into the next one isn't in either node's
+    //sequence.  Those k-mers are taken from each junction: the end of the
+    //node joined to the start of the next node after the edge's overlap.
+    //Both parts are shorter than a k-mer, so each of the junction's k-mers
+    //crosses the edge.  They are indexed at their start in the first node.
+    std::vector<QByteArray> sequences(nodes.size());
+    std::vector<std::vector<QByteArray> > junctions(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        QByteArray sequence = nodes[i]->getSequence();
+        if (nodes[i]->sequenceIsMissing())
+            continue;
+        sequences[i] = sequence;
+
+        QByteArray end = sequence.right(KMER_SIZE - 1);
+        std::vector<DeBruijnEdge *> edges = nodes[i]->getLeavingEdges();
+        for (size_t j = 0; j < edges.size(); ++j)
+        {
+            DeBruijnNode * nextNode = edges[j]->getEndingNode();
+            int overlap = edges[j]->getOverlap();
+            QByteArray nextSequence = nextNode->getSequence();
+            if (overlap < 0 || nextNode->sequenceIsMissing() || overlap >= nextSequence.length())
+                continue;
+            QByteArray junction = end + nextSequence.mid(overlap, KMER_SIZE - 1);
+            if (std::find(junctions[i].begin(), junctions[i].end(), junction) == junctions[i].end())
+                junctions[i].push_back(junction);
+        }
+    }
+
+    long long nodeCount = (long long)nodes.size();
+    long long codeCount = 1LL << (2 * KMER_SIZE);
+    std::unique_ptr<std::atomic<long long>[]> counts(new std::atomic<long long>[codeCount]());
+    parallelForChunks(nodeCount, [&](int, long long begin, long long end)
+    {
+        for (long long i = begin; i < end; ++i)
+        {
+            forEachKmer(sequences[i], KMER_SIZE, [&](quint32 code, int) {++counts[code];});
+            for (size_t j = 0; j < junctions[i].size(); ++j)
+                forEachKmer(junctions[i][j], KMER_SIZE, [&](quint32 code, int) {++counts[code];});
+        }
+    }, 16);
+
+    m_offsets.resize(codeCount + 1);
+    m_offsets[0] = 0;
+    for (long long code = 0; code < codeCount; ++code)
+    {
+        m_offsets[code + 1] = m_offsets[code] + counts[code];
+        counts[code] = m_offsets[code];
+    }
+
+    m_positions.resize(m_offsets[codeCount]);
+    parallelForChunks(nodeCount, [&](int, long long begin, long long end)
+    {
+        for (long long i = begin; i < end; ++i)
+        {
+            forEachKmer(sequences[i], KMER_SIZE, [&](quint32 code, int position)
+            {
+                KmerPosition & kmerPosition = m_positions[counts[code]++];
+                kmerPosition.node = int(i);
+                kmerPosition.position = position;
+            });
+
+            int junctionStart = sequences[i].length() - std::min(sequences[i].length(), KMER_SIZE - 1);
+            for (size_t j = 0; j < junctions[i].size(); ++j)
+            {
+                forEachKmer(junctions[i][j], KMER_SIZE, [&](quint32 code, int position)
+                {
+                    KmerPosition & kmerPosition = m_positions[counts[code]++];
+                    kmerPosition.node = int(i);
+                    kmerPosition.position = junctionStart + position;
+                });
+            }
+        }
+    }, 16);
+
+    parallelForChunks(codeCount, [&](int, long long begin, long long end)
+    {
+        for (long long code = begin; code < end; ++code)
+            std::sort(m_positions.begin() + m_offsets[code], m_positions.begin() + m_offsets[code + 1],
+                      [](const KmerPosition & a, const KmerPosition & b)
+                      {
+                          return a.node < b.node || (a.node == b.node && a.position < b.position);
+                      });
+    });
+}
+
+
+//This function returns up to maxMatches matches to the query, with no more
+//than maxMismatches mismatches each.  If there were more matches, truncated
+//is set.
+std::vector<SequenceMatch> SequenceIndex::findSequence(QByteArray query, int maxMismatches,
+                                                       int maxMatches, bool * truncated) const
+{
+    if (truncated != 0)
+        *truncated = false;
+    query = query.trimmed().toUpper();
+    if (query.isEmpty() || maxMatches <= 0 || m_offsets.empty())
+        return std::vector<SequenceMatch>();
+
+    maxMismatches = std::max(0, maxMismatches);
+    MatchFinder finder(query, maxMismatches, maxMatches);
+
+    //A match is only certain to have a k-mer with no mismatches if the query
+    //has a separate k-mer for each mismatch and one more.  Otherwise the
+    //query is compared at every position in the graph.
+    if (query.length() < KMER_SIZE * (maxMismatches + 1))
+    {
+        for (size_t i = 0; i < m_nodes.size() && !finder.isFull(); ++i)
+        {
+            if (m_nodes[i]->sequenceIsMissing())
+                continue;
+            int length = m_nodes[i]->getSequence().length();
+            for (int j = 0; j < length && !finder.isFull(); ++j)
+                finder.addMatchesAt(m_nodes[i], j, 0);
+        }
+        return finder.getMatches(truncated);
+    }
+
+    //Each seed places the start of the query relative to the seed's node.
+    //Seeds in the same node which agree on that place lead to the same
+    //matches, so only the first of them is followed.
+    std::vector<Seed> seeds;
+    forEachKmer(query, KMER_SIZE, [&](quint32 code, int queryOffset)
+    {
+        for (long long i = m_offsets[code]; i < m_offsets[code + 1]; ++i)
+        {
+            Seed seed;
+            seed.node = m_positions[i].node;
+            seed.position = m_positions[i].position;
+            seed.queryOffset = queryOffset;
+            seeds.push_back(seed);
+        }
+    });
+    std::sort(seeds.begin(), seeds.end(), compareSeeds);
+
+    for (size_t i = 0; i < seeds.size() && !finder.isFull(); ++i)
+    {
+        if (i > 0 && seeds[i].node == seeds[i - 1].node &&
+                seeds[i].getQueryStart() == seeds[i - 1].getQueryStart())
+            continue;
+        finder.addMatchesAt(m_nodes[seeds[i].node], seeds[i].position, seeds[i].queryOffset);
+    }
+    return finder.getMatches(truncated);
+}
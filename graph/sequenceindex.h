@@ -0,0 +1,83 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SEQUENCEINDEX_H
+#define SEQUENCEINDEX_H
+
+//This class finds exact and near-exact matches to a sequence anywhere in the
+//graph, including matches which run from one node into the next.  Every k-mer
+//of the node sequences is listed (both strands, since each node's reverse
+//complement is also a node), so the query's k-mers lead straight to the
+//places where it might align.  Each of those is then extended through the
+//graph in both directions, following the edges and skipping their overlaps.
+//Only mismatches are allowed, not insertions or deletions.
+//
+//Along with the k-mers within each node, the k-mers which cross from a node
+//into the next one are listed, so a match is found if one of its k-mers
+//matches the query exactly.  This is certain if the query is at least
+//(mismatches + 1) times the k-mer size, unless the match passes through
+//nodes so short that its k-mers span three of them.  Shorter queries are
+//instead compared at every position in the graph.
+//
+//The k-mers are kept in one array grouped by their code, with the start of
+//each code's group in a table, so looking up a k-mer doesn't need a search.
+
+#include "path.h"
+#include <QByteArray>
+#include <vector>
+
+class DeBruijnNode;
+
+struct SequenceMatch
+{
+    Path path;
+    int mismatches;
+};
+
+class SequenceIndex
+{
+public:
+    //CREATORS
+    SequenceIndex();
+
+    //ACCESSORS
+    bool isEmpty() const {return m_nodes.empty();}
+    long long getKmerCount() const {return (long long)m_positions.size();}
+    std::vector<SequenceMatch> findSequence(QByteArray query, int maxMismatches,
+                                            int maxMatches, bool * truncated = 0) const;
+    static int getKmerSize() {return KMER_SIZE;}
+
+    //MODIFERS
+    void build(const std::vector<DeBruijnNode *> & nodes);
+    void clear();
+
+private:
+    static const int KMER_SIZE = 10;
+
+    struct KmerPosition
+    {
+        int node;
+        int position;
+    };
+
+    std::vector<DeBruijnNode *> m_nodes;
+    std::vector<long long> m_offsets;
+    std::vector<KmerPosition> m_positions;
+};
+
+#endif // SEQUENCEINDEX_H
@@ -0,0 +1,411 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "unitigcompactor.h"
+#include "debruijnnode.h"
+#include "debruijnedge.h"
+#include "../program/parallel.h"
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <set>
+
+namespace
+{
+struct FoundChain
+{
+    int seed;
+    int part;
+    long long start;
+    long long length;
+};
+
+bool compareChainSeeds(const FoundChain & a, const FoundChain & b) {return a.seed < b.seed;}
+}
+
+
+UnitigCompactor::UnitigCompactor(const std::vector<DeBruijnNode *> & indexedNodes) :
+    m_nodes(indexedNodes)
+{
+    m_chainStarts.push_back(0);
+}
+
+
+int UnitigCompactor::getReverseComplementId(int id) const
+{
+    return m_nodes[id]->getReverseComplement()->getId();
+}
+
+
+//A node links to the next node in a chain when it has exactly one leaving
+//edge and that edge is the only one entering the next node.  These are the
+//same conditions used by canAddNodeToEndOfMergeList.
+void UnitigCompactor::findLinks()
+{
+    long long nodeCount = m_nodes.size();
+    std::vector<unsigned char> leavingCounts(nodeCount);
+    std::vector<unsigned char> enteringCounts(nodeCount);
+    std::vector<DeBruijnEdge *> leavingEdges(nodeCount);
+    std::vector<DeBruijnEdge *> enteringEdges(nodeCount);
+
+    parallelForChunks(nodeCount, [&](int, long long begin, long long end)
+    {
+        for (long long i = begin; i < end; ++i)
+        {
+            DeBruijnNode * node = m_nodes[i];
+            const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+            int leavingCount = 0, enteringCount = 0;
+            DeBruijnEdge * leavingEdge = 0;
+            DeBruijnEdge * enteringEdge = 0;
+            for (size_t j = 0; j < edges->size(); ++j)
+            {
+                DeBruijnEdge * edge = (*edges)[j];
+                if (edge->getStartingNode() == node)
+                {
+                    ++leavingCount;
+                    leavingEdge = edge;
+                }
+                if (edge->getEndingNode() == node)
+                {
+                    ++enteringCount;
+                    enteringEdge = edge;
+                }
+            }
+            leavingCounts[i] = (unsigned char)(std::min(leavingCount, 2));
+            enteringCounts[i] = (unsigned char)(std::min(enteringCount, 2));
+            leavingEdges[i] = leavingEdge;
+            enteringEdges[i] = enteringEdge;
+        }
+    });
+
+    m_outLinks.assign(nodeCount, -1);
+    m_inLinks.assign(nodeCount, -1);
+    m_outLinkEdges.assign(nodeCount, 0);
+
+    parallelForChunks(nodeCount, [&](int, long long begin, long long end)
+    {
+        for (long long i = begin; i < end; ++i)
+        {
+            if (leavingCounts[i] == 1)
+            {
+                int next = leavingEdges[i]->getEndingNode()->getId();
+                if (next != i && enteringCounts[next] == 1)
+                {
+                    m_outLinks[i] = next;
+                    m_outLinkEdges[i] = leavingEdges[i];
+                }
+            }
+            if (enteringCounts[i] == 1)
+            {
+                int previous = enteringEdges[i]->getStartingNode()->getId();
+                if (previous != i && leavingCounts[previous] == 1)
+                    m_inLinks[i] = previous;
+            }
+        }
+    });
+}
+
+
+//This function grows a chain from a seed node the same way a sequential scan
+//does: forward then backward, never adding a node whose reverse complement is
+//already in the chain.  It is only needed for the rare chains which contain
+//both a node and its reverse complement.
+std::vector<int> UnitigCompactor::extendFromSeed(int seed) const
+{
+    std::deque<int> chain;
+    std::set<int> checked;
+    chain.push_back(seed);
+    checked.insert(seed);
+    checked.insert(getReverseComplementId(seed));
+
+    int next = m_outLinks[seed];
+    while (next != -1 && checked.count(next) == 0)
+    {
+        chain.push_back(next);
+        checked.insert(next);
+        checked.insert(getReverseComplementId(next));
+        next = m_outLinks[next];
+    }
+
+    int previous = m_inLinks[seed];
+    while (previous != -1 && checked.count(previous) == 0)
+    {
+        chain.push_front(previous);
+        checked.insert(previous);
+        checked.insert(getReverseComplementId(previous));
+        previous = m_inLinks[previous];
+    }
+
+    return std::vector<int>(chain.begin(), chain.end());
+}
+
+
+//Each chain and its reverse complement are found together, and the chain is
+//given the orientation of its lowest-index node (its 'seed'), which is the
+//node a sequential scan would have reached first.
+void UnitigCompactor::findChains()
+{
+    findLinks();
+
+    long long nodeCount = m_nodes.size();
+    std::vector<unsigned char> visited(nodeCount, 0);
+    int partCount = getParallelThreadCount(nodeCount);
+    std::vector< std::vector<int> > partIds(partCount + 1);
+    std::vector< std::vector<FoundChain> > partChains(partCount + 1);
+
+    //Linear chains are walked in parallel from their first node.
+    parallelForChunks(nodeCount, [&](int part, long long begin, long long end)
+    {
+        std::vector<int> * ids = &partIds[part];
+        for (long long i = begin; i < end; ++i)
+        {
+            if (m_inLinks[i] != -1 || m_outLinks[i] == -1)
+                continue;
+
+            long long start = ids->size();
+            int seed = std::numeric_limits<int>::max();
+            bool seedInChain = false;
+            int last = int(i);
+            for (int j = int(i); j != -1; j = m_outLinks[j])
+            {
+                visited[j] = 1;
+                ids->push_back(j);
+                int rcId = getReverseComplementId(j);
+                if (j < seed)
+                {
+                    seed = j;
+                    seedInChain = true;
+                }
+                if (rcId < seed)
+                {
+                    seed = rcId;
+                    seedInChain = false;
+                }
+                last = j;
+            }
+
+            //If the chain ends with the reverse complement of its first node,
+            //it is its own reverse complement.
+            if (last == getReverseComplementId(int(i)))
+            {
+                ids->resize(start);
+                std::vector<int> chain = extendFromSeed(seed);
+                ids->insert(ids->end(), chain.begin(), chain.end());
+            }
+            else if (!seedInChain)
+            {
+                ids->resize(start);
+                continue;
+            }
+
+            FoundChain found;
+            found.seed = seed;
+            found.part = part;
+            found.start = start;
+            found.length = ids->size() - start;
+            if (found.length > 1)
+                partChains[part].push_back(found);
+            else
+                ids->resize(start);
+        }
+    });
+
+    //Any linked nodes not yet visited are in circular chains.  These are rare
+    //so they are found on this thread.
+    std::vector<int> * cycleIds = &partIds[partCount];
+    for (long long i = 0; i < nodeCount; ++i)
+    {
+        if (visited[i] || m_outLinks[i] == -1)
+            continue;
+
+        int rcStart = getReverseComplementId(int(i));
+        int seed = std::numeric_limits<int>::max();
+        bool ownReverseComplement = false;
+        int j = int(i);
+        do
+        {
+            int rcId = getReverseComplementId(j);
+            visited[j] = 1;
+            visited[rcId] = 1;
+            if (j == rcStart)
+                ownReverseComplement = true;
+            seed = std::min(seed, std::min(j, rcId));
+            j = m_outLinks[j];
+        } while (j != int(i));
+
+        long long start = cycleIds->size();
+        if (ownReverseComplement)
+        {
+            std::vector<int> chain = extendFromSeed(seed);
+            cycleIds->insert(cycleIds->end(), chain.begin(), chain.end());
+        }
+        else
+        {
+            //The seed is either in this cycle or in its reverse complement.
+            //Either way, the chain goes around from the seed.
+            j = seed;
+            do
+            {
+                cycleIds->push_back(j);
+                j = m_outLinks[j];
+            } while (j != seed);
+        }
+
+        FoundChain found;
+        found.seed = seed;
+        found.part = partCount;
+        found.start = start;
+        found.length = cycleIds->size() - start;
+        if (found.length > 1)
+            partChains[partCount].push_back(found);
+        else
+            cycleIds->resize(start);
+    }
+
+    std::vector<FoundChain> allChains;
+    for (size_t i = 0; i < partChains.size(); ++i)
+        allChains.insert(allChains.end(), partChains[i].begin(), partChains[i].end());
+    std::sort(allChains.begin(), allChains.end(), compareChainSeeds);
+
+    long long totalIds = 0;
+    for (size_t i = 0; i < allChains.size(); ++i)
+        totalIds += allChains[i].length;
+
+    m_chainNodeIds.clear();
+    m_chainNodeIds.reserve(totalIds);
+    m_chainStarts.clear();
+    m_chainStarts.reserve(allChains.size() + 1);
+    for (size_t i = 0; i < allChains.size(); ++i)
+    {
+        const FoundChain & found = allChains[i];
+        const std::vector<int> & ids = partIds[found.part];
+        m_chainStarts.push_back(m_chainNodeIds.size());
+        m_chainNodeIds.insert(m_chainNodeIds.end(), ids.begin() + found.start,
+                              ids.begin() + found.start + found.length);
+    }
+    m_chainStarts.push_back(m_chainNodeIds.size());
+
+    m_posSequences.assign(allChains.size(), QByteArray());
+    m_negSequences.assign(allChains.size(), QByteArray());
+    m_depths.assign(allChains.size(), 0.0);
+}
+
+
+std::vector<DeBruijnNode *> UnitigCompactor::getChain(int chain) const
+{
+    std::vector<DeBruijnNode *> chainNodes;
+    chainNodes.reserve(m_chainStarts[chain + 1] - m_chainStarts[chain]);
+    for (long long i = m_chainStarts[chain]; i < m_chainStarts[chain + 1]; ++i)
+        chainNodes.push_back(m_nodes[m_chainNodeIds[i]]);
+    return chainNodes;
+}
+
+
+std::vector<DeBruijnNode *> UnitigCompactor::getAllChainNodes() const
+{
+    std::vector<DeBruijnNode *> chainNodes;
+    chainNodes.reserve(m_chainNodeIds.size());
+    for (size_t i = 0; i < m_chainNodeIds.size(); ++i)
+        chainNodes.push_back(m_nodes[m_chainNodeIds[i]]);
+    return chainNodes;
+}
+
+
+//This function builds the merged sequences (for both strands) and the merged
+//depth for the chains in [firstChain, lastChain).  Node sequences must
+//already be loaded, as this runs on multiple threads.
+void UnitigCompactor::buildMergedSequences(int firstChain, int lastChain)
+{
+    parallelForChunks(lastChain - firstChain, [&](int, long long begin, long long end)
+    {
+        for (long long c = firstChain + begin; c < firstChain + end; ++c)
+        {
+            long long chainStart = m_chainStarts[c];
+            long long chainEnd = m_chainStarts[c + 1];
+
+            std::vector<DeBruijnNode *> posNodes;
+            std::vector<DeBruijnNode *> negNodes;
+            std::vector<int> posOverlaps;
+            std::vector<int> negOverlaps;
+            long double depthSum = 0.0;
+            long long totalLength = 0;
+            for (long long i = chainStart; i < chainEnd; ++i)
+            {
+                DeBruijnNode * node = m_nodes[m_chainNodeIds[i]];
+                posNodes.push_back(node);
+                totalLength += node->getLength();
+                depthSum += node->getLength() * node->getDepth();
+            }
+            for (long long i = chainEnd - 1; i >= chainStart; --i)
+                negNodes.push_back(m_nodes[m_chainNodeIds[i]]->getReverseComplement());
+            for (long long i = chainStart; i < chainEnd - 1; ++i)
+                posOverlaps.push_back(m_outLinkEdges[m_chainNodeIds[i]]->getOverlap());
+            for (long long i = chainEnd - 2; i >= chainStart; --i)
+                negOverlaps.push_back(m_outLinkEdges[m_chainNodeIds[i]]->getReverseComplement()->getOverlap());
+
+            m_posSequences[c] = joinSequences(posNodes, posOverlaps);
+            m_negSequences[c] = joinSequences(negNodes, negOverlaps);
+            if (totalLength == 0)
+                m_depths[c] = 0.0;
+            else
+                m_depths[c] = depthSum / totalLength;
+        }
+    }, 100);
+}
+
+
+//This function joins node sequences the same way as Path::getPathSequence,
+//but in a single allocation: each node after the first has the overlap
+//trimmed from its start (or Ns added, for a negative overlap).
+QByteArray UnitigCompactor::joinSequences(const std::vector<DeBruijnNode *> & chainNodes,
+                                          const std::vector<int> & overlaps)
+{
+    std::vector<QByteArray> sequences;
+    sequences.reserve(chainNodes.size());
+    long long joinedLength = 0;
+    for (size_t i = 0; i < chainNodes.size(); ++i)
+    {
+        sequences.push_back(chainNodes[i]->getSequence());
+        int length = sequences.back().length();
+        int overlap = (i > 0) ? overlaps[i - 1] : 0;
+        if (overlap > 0 && length - overlap >= 0)
+            joinedLength += length - overlap;
+        else if (overlap < 0)
+            joinedLength += length - overlap;
+        else
+            joinedLength += length;
+    }
+
+    QByteArray joined;
+    joined.reserve(joinedLength);
+    for (size_t i = 0; i < sequences.size(); ++i)
+    {
+        const QByteArray & sequence = sequences[i];
+        int overlap = (i > 0) ? overlaps[i - 1] : 0;
+        if (overlap > 0 && sequence.length() - overlap >= 0)
+            joined.append(sequence.constData() + overlap, sequence.length() - overlap);
+        else
+        {
+            if (overlap < 0)
+                joined.append(QByteArray(-overlap, 'N'));
+            joined.append(sequence);
+        }
+    }
+    return joined;
+}
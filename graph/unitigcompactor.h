@@ -0,0 +1,72 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef UNITIGCOMPACTOR_H
+#define UNITIGCOMPACTOR_H
+
+//This class finds every chain of nodes that can be merged into one (i.e. the
+//unitigs of the graph) and builds the merged sequences.  It only reads the
+//graph: AssemblyGraph::mergeAllPossible applies the merges in one batch.
+//
+//Chains are returned in the order that a sequential scan of the graph's
+//nodes would find them, so the merged node names don't depend on threading.
+
+#include <vector>
+#include <QByteArray>
+
+class DeBruijnNode;
+class DeBruijnEdge;
+
+class UnitigCompactor
+{
+public:
+    //CREATORS
+    UnitigCompactor(const std::vector<DeBruijnNode *> & indexedNodes);
+
+    //ACCESSORS
+    int getChainCount() const {return int(m_chainStarts.size()) - 1;}
+    std::vector<DeBruijnNode *> getChain(int chain) const;
+    std::vector<DeBruijnNode *> getAllChainNodes() const;
+    QByteArray getMergedSequence(int chain) const {return m_posSequences[chain];}
+    QByteArray getMergedReverseComplementSequence(int chain) const {return m_negSequences[chain];}
+    double getMergedDepth(int chain) const {return m_depths[chain];}
+
+    //MODIFERS
+    void findChains();
+    void buildMergedSequences(int firstChain, int lastChain);
+
+private:
+    const std::vector<DeBruijnNode *> & m_nodes;
+    std::vector<int> m_outLinks;
+    std::vector<int> m_inLinks;
+    std::vector<DeBruijnEdge *> m_outLinkEdges;
+    std::vector<int> m_chainNodeIds;
+    std::vector<long long> m_chainStarts;
+    std::vector<QByteArray> m_posSequences;
+    std::vector<QByteArray> m_negSequences;
+    std::vector<double> m_depths;
+
+    int getReverseComplementId(int id) const;
+    void findLinks();
+    std::vector<int> extendFromSeed(int seed) const;
+    static QByteArray joinSequences(const std::vector<DeBruijnNode *> & chainNodes,
+                                    const std::vector<int> & overlaps);
+};
+
+#endif // UNITIGCOMPACTOR_H
@@ -46,6 +46,7 @@
 #include "List.h"
 #include "String.h"
 #include <time.h>
+#include <random>
 
 // Windows includes
 #ifdef OGDF_SYSTEM_WINDOWS
@@ -155,6 +156,35 @@ namespace ogdf {
 #endif
 
 
+// Each thread has its own random number generator, so a thread only sees the
+// numbers from its own seed.
+static std::minstd_rand &threadRandomGenerator()
+{
+	static thread_local std::minstd_rand generator;
+	return generator;
+}
+
+void setSeed(int val)
+{
+	threadRandomGenerator().seed((unsigned int)val);
+}
+
+int randomNumber(int low, int high)
+{
+	int r = int(threadRandomGenerator()() - std::minstd_rand::min());
+	return low + (r % (high-low+1));
+}
+
+double randomDouble(double low, double high)
+{
+	double r = double(threadRandomGenerator()() - std::minstd_rand::min())
+		/ (std::minstd_rand::max() - std::minstd_rand::min());
+	double val = low + r*(high-low);
+	OGDF_ASSERT(val >= low && val <= high);
+	return val;
+}
+
+
 double usedTime(double& T)
 {
 	double t = T;
@@ -341,25 +341,19 @@ static Initialization s_ogdfInitializer;
 
 	enum Direction { before, after };
 
+	//! Sets the seed of the calling thread's random number generator.
+	/**
+	 * Each thread has its own generator, so threads laying out different
+	 * components (see FMMMLayout::componentThreads) neither share nor reseed
+	 * each other's random numbers.
+	 */
+	OGDF_EXPORT void setSeed(int val);
+
 	//! Returns random integer between low and high (including).
-	inline int randomNumber(int low, int high) {
-#if RAND_MAX == 32767
-		// We get only 15 random bits on some systems (Windows, Solaris)!
-		int r1 = (rand() & ((1 << 16) - 1));
-		int r2 = (rand() & ((1 << 16) - 1));
-		int r = (r1 << 15) | r2;
-#else
-		int r = rand();
-#endif
-		return low + (r % (high-low+1));
-	}
+	OGDF_EXPORT int randomNumber(int low, int high);
 
 	//! Returns random double value between low and high.
-	inline double randomDouble(double low, double high) {
-		double val = low +(rand()*(high-low))/RAND_MAX;
-		OGDF_ASSERT(val >= low && val <= high);
-		return val;
-	}
+	OGDF_EXPORT double randomDouble(double low, double high);
 
 	//! Returns a random double value from the normal distribution
 	//! with mean m and standard deviation sd
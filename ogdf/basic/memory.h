@@ -64,10 +64,13 @@
 //#define OGDF_MEMORY_POOL_NTS
 //
 // just using malloc/free (thread-safe)
-#define OGDF_MEMORY_MALLOC_TS
+//#define OGDF_MEMORY_MALLOC_TS
 //
 // new buffered-pool allocator per thread pool (thread-safe)
-//#define OGDF_MEMORY_POOL_TS
+// Bandage uses this one: each thread allocates from its own free lists, whole
+// lists (e.g. all of a graph's nodes) are freed in one step, and a thread's
+// free lists go back to the global pool when the thread ends.
+#define OGDF_MEMORY_POOL_TS
 //
 // default (nothing defined): depending on system / compiler
 //---------------------------------------------------------------------
@@ -53,6 +53,13 @@
 #include "../internal/energybased/EdgeAttributes.h"
 #include "Rectangle.h"
 #include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <QPointF>
 #include <QLineF>
@@ -60,8 +67,26 @@
 namespace ogdf {
 
 
+//The positions reported to the progress listener. Each component's positions
+//are copied here while it is laid out, so the components can be packed for a
+//report without reading the arrays other threads are working on.
+struct FMMMLayout::ProgressState
+{
+	std::mutex mutex;
+	std::chrono::steady_clock::time_point lastReport;
+	std::vector<node> nodes;            //the input graph's nodes, by component
+	std::vector<DPoint> positions;      //their positions within their component
+	std::vector<double> boundaries;     //half the larger side of each node
+	std::vector<int> componentStart;    //index of each component's first node
+	std::vector<DPoint> packedPositions;
+};
+
+
 FMMMLayout::FMMMLayout()
 {
+	m_parentLayout = 0;
+	m_progressState = 0;
+	m_activeComponent = 0;
 	initialize_all_options();
 }
 
@@ -165,24 +190,190 @@ void FMMMLayout::call_DIVIDE_ET_IMPERA_step(
 	EdgeArray<EdgeAttributes>* E_sub = new EdgeArray<EdgeAttributes>[number_of_components];
 	create_maximum_connected_subGraphs(G,A,E,G_sub,A_sub,E_sub,component);
 
+	ProgressState progress;
+	m_progressState = 0;
+	if(progressListener() != 0)
+	{
+		m_progressState = &progress;
+		init_progress_state(A,G_sub,A_sub);
+	}
+
 	if(number_of_components == 1)
-		call_MULTILEVEL_step_for_subGraph(G_sub[0],A_sub[0],E_sub[0],-1);
+		call_MULTILEVEL_step_for_subGraph(G_sub[0],A_sub[0],E_sub[0],0);
+	else if(componentThreads() > 1)
+		call_MULTILEVEL_step_for_subGraphs_in_parallel(G_sub,A_sub,E_sub);
 	else
 		for(int i = 0; i < number_of_components;i++)
 			call_MULTILEVEL_step_for_subGraph(G_sub[i],A_sub[i],E_sub[i],i);
 
+	m_progressState = 0;
 	pack_subGraph_drawings (A,G_sub,A_sub);
 	delete_all_subGraphs(G_sub,A_sub,E_sub);
 }
 
 
+void FMMMLayout::call_MULTILEVEL_step_for_subGraphs_in_parallel(
+	Graph G_sub[],
+	NodeArray<NodeAttributes> A_sub[],
+	EdgeArray<EdgeAttributes> E_sub[])
+{
+	//The components are handed out largest first, so a large component is
+	//not left until the other threads have finished.
+	std::vector<int> order(number_of_components);
+	for(int i = 0; i < number_of_components; i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [G_sub](int a, int b) {
+		return G_sub[a].numberOfNodes() > G_sub[b].numberOfNodes(); });
+
+	//Each thread needs its own copy of the layout state. The copies are made
+	//and deleted here because copying registers arrays with the input graph.
+	int threadCount = min(componentThreads(), number_of_components);
+	std::vector<FMMMLayout*> layouts(threadCount);
+	for(int t = 0; t < threadCount; t++) {
+		layouts[t] = new FMMMLayout(*this);
+		layouts[t]->m_parentLayout = this;
+	}
+
+	std::atomic<int> nextComponent(0);
+	std::vector<std::exception_ptr> errors(threadCount);
+	auto layoutComponents = [&](int t) {
+		try {
+			int i;
+			while((i = nextComponent++) < number_of_components)
+				layouts[t]->call_MULTILEVEL_step_for_subGraph(
+					G_sub[order[i]],A_sub[order[i]],E_sub[order[i]],order[i]);
+		} catch(...) {
+			errors[t] = std::current_exception();
+			nextComponent = number_of_components;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for(int t = 1; t < threadCount; t++)
+		threads.push_back(std::thread(layoutComponents, t));
+	layoutComponents(0);
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	for(int t = 0; t < threadCount; t++)
+		delete layouts[t];
+	for(int t = 0; t < threadCount; t++)
+		if(errors[t])
+			std::rethrow_exception(errors[t]);
+}
+
+
+void FMMMLayout::update_options_from_parent_layout()
+{
+	if(m_parentLayout == 0)
+		return;
+	fixedIterations(m_parentLayout->fixedIterations());
+	fineTuningIterations(m_parentLayout->fineTuningIterations());
+	threshold(m_parentLayout->threshold());
+}
+
+
+void FMMMLayout::init_progress_state(
+	NodeArray<NodeAttributes>& A,
+	Graph G_sub[],
+	NodeArray<NodeAttributes> A_sub[])
+{
+	ProgressState &P = *m_progressState;
+	P.lastReport = std::chrono::steady_clock::now();
+	for(int i = 0; i < number_of_components; i++)
+	{
+		P.componentStart.push_back(int(P.nodes.size()));
+		node v_sub;
+		forall_nodes(v_sub,G_sub[i])
+		{
+			//A_sub links to the reduced graph, whose attributes link to the input graph.
+			P.nodes.push_back(A[A_sub[i][v_sub].get_original_node()].get_original_node());
+			P.positions.push_back(A_sub[i][v_sub].get_position());
+			P.boundaries.push_back(max(A_sub[i][v_sub].get_width()/2, A_sub[i][v_sub].get_height()/2));
+		}
+	}
+	P.componentStart.push_back(int(P.nodes.size()));
+	P.packedPositions.resize(P.nodes.size());
+}
+
+
+void FMMMLayout::report_progress(
+	Graph& G,
+	NodeArray<NodeAttributes>& A,
+	bool component_finished)
+{
+	if(m_progressState == 0)
+		return;
+	ProgressState &P = *m_progressState;
+	std::lock_guard<std::mutex> guard(P.mutex);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	bool reportDue = (now - P.lastReport >= std::chrono::milliseconds(progressInterval()));
+	if(!reportDue && !component_finished)
+		return;
+
+	int index = P.componentStart[m_activeComponent];
+	node v;
+	forall_nodes(v,G)
+		P.positions[index++] = A[v].get_position();
+	if(!reportDue)
+		return;
+	P.lastReport = now;
+
+	//The components are packed as in pack_subGraph_drawings, but without rotation.
+	List<Rectangle> R;
+	for(int i = 0; i < number_of_components; i++)
+	{
+		double x_min = 0.0, x_max = 0.0, y_min = 0.0, y_max = 0.0;
+		for(int j = P.componentStart[i]; j < P.componentStart[i+1]; j++)
+		{
+			double b = P.boundaries[j];
+			if(j == P.componentStart[i] || P.positions[j].m_x - b < x_min) x_min = P.positions[j].m_x - b;
+			if(j == P.componentStart[i] || P.positions[j].m_x + b > x_max) x_max = P.positions[j].m_x + b;
+			if(j == P.componentStart[i] || P.positions[j].m_y - b < y_min) y_min = P.positions[j].m_y - b;
+			if(j == P.componentStart[i] || P.positions[j].m_y + b > y_max) y_max = P.positions[j].m_y + b;
+		}
+		x_min -= minDistCC()/2;
+		x_max += minDistCC()/2;
+		y_min -= minDistCC()/2;
+		y_max += minDistCC()/2;
+		Rectangle r;
+		r.set_rectangle(x_max-x_min,y_max-y_min,x_min,y_min,i);
+		R.pushBack(r);
+	}
+
+	MAARPacking packing;
+	double aspect_ratio_area, bounding_rectangles_area;
+	packing.pack_rectangles_using_Best_Fit_strategy(R,pageRatio(),presortCCs(),
+		aspect_ratio_area,bounding_rectangles_area);
+
+	ListIterator<Rectangle> RectIterator;
+	for(RectIterator = R.begin();RectIterator.valid();++RectIterator)
+	{
+		const Rectangle &r = *RectIterator;
+		int i = r.get_component_index();
+		DPoint offset = r.get_new_dlc_position() - r.get_old_dlc_position();
+		for(int j = P.componentStart[i]; j < P.componentStart[i+1]; j++)
+		{
+			DPoint pos = P.positions[j];
+			if(r.is_tipped_over())
+				pos = DPoint(-pos.m_y, pos.m_x);
+			P.packedPositions[j] = pos + offset;
+		}
+	}
+
+	progressListener()->layoutProgress(P.nodes,P.packedPositions);
+}
+
+
 void FMMMLayout::call_MULTILEVEL_step_for_subGraph(
 	Graph& G,
 	NodeArray<NodeAttributes>& A,
 	EdgeArray<EdgeAttributes>& E,
-    int /*comp_index*/)
+	int comp_index)
 {
 	Multilevel Mult;
+	m_activeComponent = comp_index;
 
 	int max_level = 30;//sufficient for all graphs with upto pow(2,30) nodes!
 	//adapt mingraphsize such that no levels are created beyond input graph.
@@ -221,6 +412,7 @@ void FMMMLayout::call_FORCE_CALCULATION_step(
 {
 	const int ITERBOUND = 10000;//needed to guarantee termination if
 							 //stopCriterion() == scThreshold
+	update_options_from_parent_layout();
 	if(G.numberOfNodes() > 1)
 	{
 		int iter = 1;
@@ -236,21 +428,24 @@ void FMMMLayout::call_FORCE_CALCULATION_step(
 		set_average_ideal_edgelength(G,E);//needed for easy scaling of the forces
 		make_initialisations_for_rep_calc_classes(G);
 
-		while( ((stopCriterion() == scFixedIterations)&&(iter <= max_mult_iter)) ||
+		while( (((stopCriterion() == scFixedIterations)&&(iter <= max_mult_iter)) ||
 			((stopCriterion() == scThreshold)&&(actforcevectorlength >= threshold())&&
 			(iter <= ITERBOUND)) ||
 			((stopCriterion() == scFixedIterationsOrThreshold)&&(iter <= max_mult_iter) &&
-			(actforcevectorlength >= threshold())) )
+			(actforcevectorlength >= threshold()))) && !stopRequested() )
 		{//while
 			calculate_forces(G,A,E,F,F_attr,F_rep,last_node_movement,iter,0);
 			if(stopCriterion() != scFixedIterations)
 				actforcevectorlength = get_average_forcevector_length(G,F);
+			if(act_level == 0)
+				report_progress(G,A,false);
 			iter++;
 		}//while
 
         if(act_level == 0) {
             fixTwistedSplits(G, A);
 			call_POSTPROCESSING_step(G,A,E,F,F_attr,F_rep,last_node_movement);
+			report_progress(G,A,true);
         }
 
 		deallocate_memory_for_rep_calc_classes();
@@ -267,8 +462,13 @@ void FMMMLayout::call_POSTPROCESSING_step(
 	NodeArray<DPoint>& F_rep,
 	NodeArray<DPoint>& last_node_movement)
 {
-	for(int i = 1; i<= 10; i++)
+	for(int i = 1; i<= 10 && !stopRequested(); i++)
+	{
 		calculate_forces(G,A,E,F,F_attr,F_rep,last_node_movement,i,1);
+		report_progress(G,A,false);
+	}
+
+	update_options_from_parent_layout();
 
 	if((resizeDrawing() == true))
 	{
@@ -276,8 +476,11 @@ void FMMMLayout::call_POSTPROCESSING_step(
 		update_boxlength_and_cornercoordinate(G,A);
 	}
 
-	for(int i = 1; i<= fineTuningIterations(); i++)
+	for(int i = 1; i<= fineTuningIterations() && !stopRequested(); i++)
+	{
 		calculate_forces(G,A,E,F,F_attr,F_rep,last_node_movement,i,2);
+		report_progress(G,A,false);
+	}
 
 	if((resizeDrawing() == true))
 		adapt_drawing_to_ideal_average_edgelength(G,A,E);
@@ -296,9 +499,10 @@ void FMMMLayout::initialize_all_options()
 	//setting general options
 	randSeed(100);edgeLengthMeasurement(elmBoundingCircle);
 	allowedPositions(apInteger);maxIntPosExponent(40);
+	progressListener(0);progressInterval(250);
 
 	//setting options for the divide et impera step
-    pageRatio(1.0);stepsForRotatingComponents(10);
+    pageRatio(1.0);stepsForRotatingComponents(10);componentThreads(1);
     tipOverCCs(toNone);minDistCC(100);
     presortCCs(psDecreasingArea);
 
@@ -323,6 +527,7 @@ void FMMMLayout::initialize_all_options()
 	frGridQuotient(2);
 	nmTreeConstruction(rtcSubtreeBySubtree);nmSmallCell(scfIteratively);
 	nmParticlesInLeaves(25); nmPrecision(4);
+	bhTheta(0.5); bhParticlesInLeaves(16);
 }
 
 
@@ -1180,9 +1385,9 @@ void FMMMLayout::create_initial_placement (Graph& G, NodeArray<NodeAttributes>&
 	{//(random)
 		init_boxlength_and_cornercoordinate(G,A);
 		if(initialPlacementForces() == ipfRandomTime)//(RANDOM based on actual CPU-time)
-			srand((unsigned int)time(0));
+			setSeed((int)time(0));
 		else if(initialPlacementForces() == ipfRandomRandIterNr)//(RANDOM based on seed)
-            srand(clock());
+            setSeed((int)clock());
 
 		forall_nodes(v,G)
 		{
@@ -1212,6 +1417,8 @@ inline void FMMMLayout::make_initialisations_for_rep_calc_classes(Graph& G)
 		FR.make_initialisations(boxlength,down_left_corner,frGridQuotient());
 	else if(repulsiveForcesCalculation() == rfcGridApproximation)
 		FR.make_initialisations(boxlength,down_left_corner,frGridQuotient());
+	else if(repulsiveForcesCalculation() == rfcBarnesHut)
+		BH.make_initialisations(G,bhTheta(),bhParticlesInLeaves());
 	else //(repulsiveForcesCalculation() == rfcNMM
 		NM.make_initialisations(G,boxlength,down_left_corner,
 		nmParticlesInLeaves(),nmPrecision(),
@@ -1425,6 +1632,8 @@ void FMMMLayout::update_boxlength_and_cornercoordinate(
 	if(repulsiveForcesCalculation() == rfcExact ||
 		repulsiveForcesCalculation() == rfcGridApproximation)
 		FR.update_boxlength_and_cornercoordinate(boxlength,down_left_corner);
+	else if(repulsiveForcesCalculation() == rfcBarnesHut)
+		BH.update_boxlength_and_cornercoordinate(boxlength,down_left_corner);
 	else //repulsiveForcesCalculation() == rfcNMM
 		NM.update_boxlength_and_cornercoordinate(boxlength,down_left_corner);
 }
@@ -57,12 +57,31 @@
 #include "../ogdf/basic/geometry.h"
 #include "../ogdf/internal/energybased/FruchtermanReingold.h"
 #include "../ogdf/internal/energybased/NMM.h"
+#include "../ogdf/internal/energybased/BarnesHut.h"
+#include <atomic>
+#include <vector>
 
 
 namespace ogdf {
 
 	class Rectangle;
 
+//! Receives the node positions of an FMMMLayout while it is running.
+/**
+ * See FMMMLayout::progressListener(). The positions are those the nodes of
+ * the input graph would be given if the layout stopped now, with the
+ * connected components packed (but not rotated).
+ */
+class OGDF_EXPORT FMMMProgressListener
+{
+public:
+	virtual ~FMMMProgressListener() { }
+
+	//! Called with the current position of each node of the input graph.
+	virtual void layoutProgress(const std::vector<node> &nodes,
+		const std::vector<DPoint> &positions) = 0;
+};
+
 /**
  * \brief The fast multipole multilevel layout algorithm.
  *
@@ -126,6 +145,12 @@ namespace ogdf {
  *     <td><i>maxIntPosExponent</i><td>int<td>40
  *     <td>Defines the exponent used if allowedPositions == apExponent.
  *   </tr><tr>
+ *     <td><i>progressListener</i><td>FMMMProgressListener*<td>0
+ *     <td>Receives the node positions while the layout is running.
+ *   </tr><tr>
+ *     <td><i>progressInterval</i><td>int<td>250
+ *     <td>The minimal time in milliseconds between reports to the progressListener.
+ *   </tr><tr>
  *     <th colspan="4" align="center"><b>Divide et impera step</b>
  *   </tr><tr>
  *     <td><i>pageRatio</i><td>double<td>1.0
@@ -134,6 +159,9 @@ namespace ogdf {
  *     <td><i>stepsForRotatingComponents</i><td>int<td>10
  *     <td>The number of rotations per connected component.
  *   </tr><tr>
+ *     <td><i>componentThreads</i><td>int<td>1
+ *     <td>The number of threads used to lay out the connected components.
+ *   </tr><tr>
  *     <td><i>tipOverCCs</i><td> #TipOver <td> #toNoGrowingRow
  *     <td>Specifies when it is allowed to tip over drawings.
  *   </tr><tr>
@@ -242,6 +270,13 @@ namespace ogdf {
  *   </tr><tr>
  *     <td><i>nmPrecision</i><td>int<td>4
  *     <td>The precision \a p for the <i>p</i>-term multipole expansions.
+ *   </tr><tr>
+ *     <td><i>bhTheta</i><td>double<td>0.5
+ *     <td>The opening criterion of the Barnes-Hut quadtree.
+ *   </tr><tr>
+ *     <td><i>bhParticlesInLeaves</i><td>int<td>16
+ *     <td>The maximal number of particles that are contained in
+ *     a leaf of the Barnes-Hut quadtree.
  *   </tr>
  * </table>
  *
@@ -326,7 +361,8 @@ public:
 	enum RepulsiveForcesMethod {
 		rfcExact,             //!< Exact calculation.
 		rfcGridApproximation, //!< Grid approximation.
-		rfcNMM                //!< Calculation as for new multipole method.
+		rfcNMM,               //!< Calculation as for new multipole method.
+		rfcBarnesHut          //!< Barnes-Hut approximation with a flat quadtree.
 	};
 
 	//! Specifies the stop criterion.
@@ -417,6 +453,20 @@ public:
 		return time_total;
 	}
 
+	//! Stops the layout as soon as possible, keeping the positions reached so far.
+	/**
+	 * This may be called from another thread while call() is running. The
+	 * remaining force calculation steps are skipped, but the nodes are still
+	 * placed on every level and the components are packed, so the result is
+	 * a complete (if less refined) layout. The request holds for later calls.
+	 */
+	void stopLayout() { m_stopRequested.value = true; }
+
+	//! Returns true if stopLayout() has been called.
+	bool stopRequested() const {
+		return (m_parentLayout != 0) ? m_parentLayout->stopRequested() : m_stopRequested.value.load();
+	}
+
 
 	/** @}
 	 *  @name High-level options
@@ -534,6 +584,24 @@ public:
 		m_maxIntPosExponent = (((e >= 31)&&(e<=51))? e : 31);
 	}
 
+	//! Returns the current setting of option progressListener.
+	/**
+	 * If this is set, the listener is sent the positions of all nodes every
+	 * progressInterval() milliseconds during the force calculation on the
+	 * finest level. It is called on whichever thread is laying out a
+	 * component (see componentThreads()), but never on two at once.
+	 */
+	FMMMProgressListener *progressListener() const { return m_progressListener; }
+
+	//! Sets the option progressListener to \a listener (0 for none).
+	void progressListener(FMMMProgressListener *listener) { m_progressListener = listener; }
+
+	//! Returns the current setting of option progressInterval.
+	int progressInterval() const { return m_progressInterval; }
+
+	//! Sets the option progressInterval to \a ms.
+	void progressInterval(int ms) { m_progressInterval = ((0<=ms) ? ms : 0); }
+
 
 	/** @}
 	 *  @name Options for the divide et impera step
@@ -561,6 +629,19 @@ public:
 		m_stepsForRotatingComponents = ((0<=n) ? n : 0);
 	}
 
+	//! Returns the current setting of option componentThreads.
+	/**
+	 * This option sets the number of threads used to lay out the connected
+	 * components. Each thread lays out whole components, largest first, so a
+	 * graph with one component is laid out on the calling thread.
+	 */
+	int componentThreads() const { return m_componentThreads; }
+
+	//! Sets the option componentThreads to \a n.
+	void componentThreads(int n) {
+		m_componentThreads = ((1<=n) ? n : 1);
+	}
+
 	//! Returns the current setting of option tipOverCCs.
 	/**
 	 * Defines in which case it is allowed to tip over drawings of connected components.
@@ -717,6 +798,8 @@ public:
 	 *   - \a rfcExact: exact calculation (slow)
 	 *   - \a rfcGridApproximation: grid approxiamtion (inaccurate)
 	 *   - \a rfcNMM: like in NMM (= New Multipole Method; fast and accurate)
+	 *   - \a rfcBarnesHut: Barnes-Hut approximation over arrays sorted by
+	 *     Morton code (fast; accuracy set by bhTheta)
 	 */
 	RepulsiveForcesMethod repulsiveForcesCalculation() const {
 		return m_repulsiveForcesCalculation;
@@ -929,6 +1012,23 @@ public:
 	//! Sets the precision for the multipole expansions to \ p.
 	void nmPrecision(int p) { m_NMPrecision  = ((p >= 1 ) ? p : 1);}
 
+	//! Returns the opening criterion of the Barnes-Hut quadtree.
+	/**
+	 * A cell acts as one particle on a node if its side length is less than
+	 * bhTheta() times its distance from the node. Smaller values are more
+	 * accurate and slower; 0 gives the exact forces.
+	 */
+	double bhTheta() const { return m_BHTheta; }
+
+	//! Sets the opening criterion of the Barnes-Hut quadtree to \a t.
+	void bhTheta(double t) { m_BHTheta = ((t >= 0) ? t : 0.5);}
+
+	//! Returns the maximal number of particles that are contained in a leaf of the Barnes-Hut quadtree.
+	int bhParticlesInLeaves() const { return m_BHParticlesInLeaves; }
+
+	//! Sets the option bhParticlesInLeaves to \a n.
+	void bhParticlesInLeaves(int n) { m_BHParticlesInLeaves = ((n >= 1) ? n : 1);}
+
 	//! @}
 
 private:
@@ -946,10 +1046,13 @@ private:
 	EdgeLengthMeasurement m_edgeLengthMeasurement; //!< The option for edge length measurement.
 	AllowedPositions      m_allowedPositions; //!< The option for allowed positions.
 	int                   m_maxIntPosExponent; //!< The option for the used	exponent.
+	FMMMProgressListener *m_progressListener; //!< The listener sent the positions during the layout.
+	int                   m_progressInterval; //!< The time between reports to the listener.
 
 	//options for divide et impera step
 	double                m_pageRatio; //!< The desired page ratio.
 	int                   m_stepsForRotatingComponents; //!< The number of rotations.
+	int                   m_componentThreads; //!< The number of threads for laying out components.
 	TipOver               m_tipOverCCs; //!< Option for tip-over of connected components.
 	double                m_minDistCC; //!< The separation between connected components.
 	PreSort               m_presortCCs; //!< The option for presorting connected components.
@@ -994,10 +1097,27 @@ private:
 	SmallestCellFinding   m_NMSmallCell; //!< The option for how to calculate smallest quadtratic cells.
 	int                   m_NMParticlesInLeaves; //!< The maximal number of particles in a leaf.
 	int                   m_NMPrecision; //!< The precision for multipole expansions.
+	double                m_BHTheta; //!< The opening criterion of the Barnes-Hut quadtree.
+	int                   m_BHParticlesInLeaves; //!< The maximal number of particles in a Barnes-Hut leaf.
 
 	//other variables
 	double max_integer_position; //!< The maximum value for an integer position.
 	double cool_factor; //!< Needed for scaling the forces if coolTemperature is true.
+	const FMMMLayout *m_parentLayout; //!< The layout this copy lays out components for, or 0.
+
+	//! A flag that may be set from another thread. Copies start unset, as the
+	//! copies made for components ask their parent layout instead.
+	struct StopFlag {
+		std::atomic<bool> value;
+		StopFlag() : value(false) { }
+		StopFlag(const StopFlag &) : value(false) { }
+		StopFlag &operator=(const StopFlag &) { return *this; }
+	};
+	StopFlag m_stopRequested; //!< Set by stopLayout().
+
+	struct ProgressState;
+	ProgressState *m_progressState; //!< The positions reported to the listener, shared with copies.
+	int m_activeComponent; //!< The component being laid out, for progress reports.
 	double average_ideal_edgelength; //!< Measured from center to center.
 	double boxlength; //!< Holds the length of the quadratic comput. box.
 	int number_of_components; //!< The number of components of the graph.
@@ -1007,6 +1127,7 @@ private:
 
 	FruchtermanReingold FR; //!< Class for repulsive force calculation (Fruchterman, Reingold).
 	NMM NM; //!< Class for repulsive force calculation.
+	BarnesHut BH; //!< Class for repulsive force calculation (Barnes, Hut).
 
 
 	//------------------- most important functions ----------------------------
@@ -1017,6 +1138,28 @@ private:
 		NodeArray<NodeAttributes>& A,
 		EdgeArray<EdgeAttributes>& E);
 
+	//! Calls the multilevel step for all subGraphs, using componentThreads() threads.
+	void call_MULTILEVEL_step_for_subGraphs_in_parallel(
+		Graph G_sub[],
+		NodeArray<NodeAttributes> A_sub[],
+		EdgeArray<EdgeAttributes> E_sub[]);
+
+	//! Takes the iteration options from the parent layout, so a copy stops when it does.
+	void update_options_from_parent_layout();
+
+	//! Records the starting positions of the components if there is a progressListener.
+	void init_progress_state(
+		NodeArray<NodeAttributes>& A,
+		Graph G_sub[],
+		NodeArray<NodeAttributes> A_sub[]);
+
+	//! Records the positions of the active component (\a G, \a A on level 0), and
+	//! reports all positions to the progressListener if progressInterval() has passed.
+	void report_progress(
+		Graph& G,
+		NodeArray<NodeAttributes>& A,
+		bool component_finished);
+
 	//! Calls the multilevel step for subGraph \a G.
 	void call_MULTILEVEL_step_for_subGraph(
 		Graph& G,
@@ -1261,6 +1404,8 @@ private:
 			FR.calculate_exact_repulsive_forces(G,A,F_rep);
 		else if(repulsiveForcesCalculation() == rfcGridApproximation )
 			FR.calculate_approx_repulsive_forces(G,A,F_rep);
+		else if(repulsiveForcesCalculation() == rfcBarnesHut )
+			BH.calculate_repulsive_forces(G,A,F_rep);
 		else //repulsiveForcesCalculation() == rfcNMM
 			NM.calculate_repulsive_forces(G,A,F_rep);
 	}
@@ -1271,6 +1416,8 @@ private:
 	{
 		if(repulsiveForcesCalculation() == rfcNMM)
 			NM.deallocate_memory();
+		else if(repulsiveForcesCalculation() == rfcBarnesHut)
+			BH.deallocate_memory();
 	}
 
 	//! Calculates attractive forces for each node.
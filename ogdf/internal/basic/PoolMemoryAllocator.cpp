@@ -85,11 +85,43 @@ OGDF_DECL_THREAD PoolMemoryAllocator::MemElemPtr PoolMemoryAllocator::s_tp[eTabl
 #endif
 
 
+#ifndef OGDF_MEMORY_POOL_NTS
+#ifdef OGDF_NO_COMPILER_TLS
+// Called by pthreads when a thread ends: its free lists are handed back to the
+// global pool, so memory freed by short-lived worker threads is not lost.
+void PoolMemoryAllocator::releaseThreadFreeLists(void *freeLists)
+{
+	pthread_setspecific(s_tpKey, freeLists);
+	flushPool();
+	pthread_setspecific(s_tpKey, NULL);
+	free(freeLists);
+}
+#else
+OGDF_DECL_THREAD bool PoolMemoryAllocator::s_threadRegistered;
+
+// The same as above for compiler thread-local storage.  A function-local
+// thread_local object is destroyed when its thread ends.
+namespace {
+struct ThreadFreeListReleaser {
+	~ThreadFreeListReleaser() { PoolMemoryAllocator::flushPool(); }
+};
+}
+
+void PoolMemoryAllocator::registerThread()
+{
+	static thread_local ThreadFreeListReleaser releaser;
+	(void)releaser;
+	s_threadRegistered = true;
+}
+#endif
+#endif
+
+
 void PoolMemoryAllocator::init()
 {
 #ifndef OGDF_MEMORY_POOL_NTS
 #ifdef OGDF_NO_COMPILER_TLS
-	pthread_key_create(&s_tpKey,NULL);
+	pthread_key_create(&s_tpKey,releaseThreadFreeLists);
 #endif
 	s_criticalSection = new CriticalSection(500);
 #endif
@@ -99,11 +131,33 @@ void PoolMemoryAllocator::init()
 
 void PoolMemoryAllocator::initThread() {
 #if !defined(OGDF_MEMORY_POOL_NTS) && defined(OGDF_NO_COMPILER_TLS)
+	if (pthread_getspecific(s_tpKey) == NULL)
 		pthread_setspecific(s_tpKey,calloc(eTableSize,sizeof(MemElemPtr)));
 #endif
 }
 
 
+// Returns the free lists of the calling thread, setting them up if the thread
+// has not used the allocator before.
+PoolMemoryAllocator::MemElemPtr *PoolMemoryAllocator::threadFreeLists()
+{
+#ifdef OGDF_MEMORY_POOL_NTS
+	return s_tp;
+#elif defined(OGDF_NO_COMPILER_TLS)
+	MemElemPtr *freeLists = (MemElemPtr*)pthread_getspecific(s_tpKey);
+	if (OGDF_UNLIKELY(freeLists == NULL)) {
+		initThread();
+		freeLists = (MemElemPtr*)pthread_getspecific(s_tpKey);
+	}
+	return freeLists;
+#else
+	if (OGDF_UNLIKELY(!s_threadRegistered))
+		registerThread();
+	return s_tp;
+#endif
+}
+
+
 void PoolMemoryAllocator::cleanup()
 {
 	BlockChainPtr p = s_blocks;
@@ -118,6 +172,7 @@ void PoolMemoryAllocator::cleanup()
 	pthread_key_delete(s_tpKey);
 #endif
 	delete s_criticalSection;
+	s_criticalSection = 0;
 #endif
 }
 
@@ -128,11 +183,7 @@ bool PoolMemoryAllocator::checkSize(size_t nBytes) {
 
 
 void *PoolMemoryAllocator::allocate(size_t nBytes) {
-#if !defined(OGDF_MEMORY_POOL_NTS) && defined(OGDF_NO_COMPILER_TLS)
-	MemElemPtr *pFreeBytes = ((MemElemPtr*)pthread_getspecific(s_tpKey))+nBytes;
-#else
-	MemElemPtr *pFreeBytes = s_tp+nBytes;
-#endif
+	MemElemPtr *pFreeBytes = threadFreeLists()+nBytes;
 	if (OGDF_LIKELY(*pFreeBytes != 0)) {
 		MemElemPtr p = *pFreeBytes;
 		*pFreeBytes = p->m_next;
@@ -144,22 +195,14 @@ void *PoolMemoryAllocator::allocate(size_t nBytes) {
 
 
 void PoolMemoryAllocator::deallocate(size_t nBytes, void *p) {
-#if !defined(OGDF_MEMORY_POOL_NTS) && defined(OGDF_NO_COMPILER_TLS)
-	MemElemPtr *pFreeBytes = ((MemElemPtr*)pthread_getspecific(s_tpKey))+nBytes;
-#else
-	MemElemPtr *pFreeBytes = s_tp+nBytes;
-#endif
+	MemElemPtr *pFreeBytes = threadFreeLists()+nBytes;
 	MemElemPtr(p)->m_next = *pFreeBytes;
 	*pFreeBytes = MemElemPtr(p);
 }
 
 
 void PoolMemoryAllocator::deallocateList(size_t nBytes, void *pHead, void *pTail) {
-#if !defined(OGDF_MEMORY_POOL_NTS) && defined(OGDF_NO_COMPILER_TLS)
-	MemElemPtr *pFreeBytes = ((MemElemPtr*)pthread_getspecific(s_tpKey))+nBytes;
-#else
-	MemElemPtr *pFreeBytes = s_tp+nBytes;
-#endif
+	MemElemPtr *pFreeBytes = threadFreeLists()+nBytes;
 	MemElemPtr(pTail)->m_next = *pFreeBytes;
 	*pFreeBytes = MemElemPtr(pHead);
 }
@@ -175,11 +218,7 @@ PoolMemoryAllocator::collectGroups(
 	int n = slicesPerBlock(nBytes);
 	pRestHead = 0;
 
-#if !defined(OGDF_MEMORY_POOL_NTS) && defined(OGDF_NO_COMPILER_TLS)
-	MemElemPtr p = ((MemElemPtr*)pthread_getspecific(s_tpKey))[nBytes];
-#else
-	MemElemPtr p = s_tp[nBytes];
-#endif
+	MemElemPtr p = threadFreeLists()[nBytes];
 	MemElemExPtr pStart = 0, pLast = 0;
 	while(p != 0)
 	{
@@ -216,11 +255,7 @@ void PoolMemoryAllocator::flushPoolSmall(__uint16 nBytes)
     int n = slicesPerBlock(nBytes < eMinBytes ? int(eMinBytes) : int(nBytes));
 	PoolElement &pe = s_pool[nBytes];
 
-#if !defined(OGDF_MEMORY_POOL_NTS) && defined(OGDF_NO_COMPILER_TLS)
-	MemElemPtr p = ((MemElemPtr*)pthread_getspecific(s_tpKey))[nBytes];
-#else
-	MemElemPtr p = s_tp[nBytes];
-#endif
+	MemElemPtr p = threadFreeLists()[nBytes];
 	if(pe.m_restHead != 0) {
 		pe.m_restTail->m_next = p;
 		p = pe.m_restHead;
@@ -257,6 +292,7 @@ void PoolMemoryAllocator::incVectorSlot(PoolElement &pe)
 
 		PoolVector *pv = (PoolVector *)s_freeVectors;
 		s_freeVectors = MemElemPtr(pv)->m_next;
+		pv->m_prev = pe.m_currentVector;
 		pe.m_currentVector = pv;
 		pe.m_index = 0;
 	}
@@ -280,21 +316,28 @@ void PoolMemoryAllocator::flushPool(__uint16 nBytes)
 			pStart = pStart->m_down;
 		}
 		if(pRestHead != 0) {
+			// The thread's leftover elements go in front of the global
+			// leftovers, and every complete group is then moved into the pool.
+			// Each group must end in a null pointer, since a thread takes a
+			// whole group as its free list.
 			int n = slicesPerBlock(nBytes);
-			pRestTail->m_next = pe.m_restTail;
-			int nTotal = nRest + pe.m_restCount;
-			if(nTotal >= n) {
-				MemElemPtr p = pe.m_restHead;
-				int i = n-nRest;
-				while(--i > 0)
+			pRestTail->m_next = pe.m_restHead;
+			if(pe.m_restHead == 0)
+				pe.m_restTail = pRestTail;
+			pe.m_restHead = pRestHead;
+			pe.m_restCount = __int16(pe.m_restCount + nRest);
+
+			while(pe.m_restCount >= n) {
+				MemElemPtr pGroup = pe.m_restHead, p = pGroup;
+				for(int i = 1; i < n; ++i)
 					p = p->m_next;
 				pe.m_restHead = p->m_next;
-				pe.m_restCount = nTotal-n;
+				p->m_next = 0;
+				pe.m_restCount = __int16(pe.m_restCount - n);
+				if(pe.m_restHead == 0)
+					pe.m_restTail = 0;
 				incVectorSlot(pe);
-				pe.m_currentVector->m_pool[pe.m_index] = pRestHead;
-			} else {
-				pe.m_restHead = pRestHead;
-				pe.m_restCount = nTotal;
+				pe.m_currentVector->m_pool[pe.m_index] = pGroup;
 			}
 		}
 		s_criticalSection->leave();
@@ -304,6 +347,9 @@ void PoolMemoryAllocator::flushPool(__uint16 nBytes)
 		flushPoolSmall(nBytes);
 		s_criticalSection->leave();
 	}
+
+	// The elements now belong to the global pool.
+	threadFreeLists()[nBytes] = 0;
 #endif
 }
 
@@ -311,13 +357,12 @@ void PoolMemoryAllocator::flushPool(__uint16 nBytes)
 void PoolMemoryAllocator::flushPool()
 {
 #ifndef OGDF_MEMORY_POOL_NTS
+	// A thread can end after the allocator has been cleaned up.
+	if (s_criticalSection == 0)
+		return;
+	MemElemPtr *freeLists = threadFreeLists();
 	for(__uint16 nBytes = 1; nBytes < eTableSize; ++nBytes) {
-#ifdef OGDF_NO_COMPILER_TLS
-	MemElemPtr p = ((MemElemPtr*)pthread_getspecific(s_tpKey))[nBytes];
-#else
-	MemElemPtr p = s_tp[nBytes];
-#endif
-		if(p != 0)
+		if(freeLists[nBytes] != 0)
 			flushPool(nBytes);
 	}
 #endif
@@ -345,8 +390,10 @@ void *PoolMemoryAllocator::fillPool(MemElemPtr &pFreeBytes, __uint16 nBytes)
 		s_criticalSection->leave();
 
 	} else {
-		s_criticalSection->leave();
+		// allocateBlock() adds the new block to s_blocks, which all threads
+		// share, so it is called before leaving the critical section.
 		pFreeBytes = allocateBlock(nBytes);
+		s_criticalSection->leave();
 	}
 #endif
 
@@ -432,11 +479,7 @@ size_t PoolMemoryAllocator::memoryInThreadFreeList()
 	size_t bytesFree = 0;
 	for (int sz = 1; sz < eTableSize; ++sz)
 	{
-#if !defined(OGDF_MEMORY_POOL_NTS) && defined(OGDF_NO_COMPILER_TLS)
-		MemElemPtr p = ((MemElemPtr*)pthread_getspecific(s_tpKey))[sz];
-#else
-		MemElemPtr p = s_tp[sz];
-#endif
+		MemElemPtr p = threadFreeLists()[sz];
 		for(; p != 0; p = p->m_next)
 			bytesFree += sz;
 	}
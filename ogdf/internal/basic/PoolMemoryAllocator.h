@@ -170,6 +170,8 @@ private:
 
 	static MemElemPtr allocateBlock(__uint16 nBytes);
 
+	static MemElemPtr *threadFreeLists();
+
 	static PoolElement s_pool[eTableSize];
 	static MemElemPtr s_freeVectors;
 	static BlockChainPtr s_blocks;
@@ -179,9 +181,12 @@ private:
 #elif defined(OGDF_NO_COMPILER_TLS)
 	static CriticalSection *s_criticalSection;
 	static pthread_key_t s_tpKey;
+	static void releaseThreadFreeLists(void *freeLists);
 #else
 	static CriticalSection *s_criticalSection;
 	static OGDF_DECL_THREAD MemElemPtr s_tp[eTableSize];
+	static OGDF_DECL_THREAD bool s_threadRegistered;
+	static void registerThread();
 #endif
 };
 
@@ -0,0 +1,388 @@
+/** \file
+ * \brief Implementation of class BarnesHut (repulsive forces computed with a
+ *        flat, Morton-ordered quadtree).
+ *
+ * \par License:
+ * This file is part of the Open Graph Drawing Framework (OGDF).
+ *
+ * \par
+ * Copyright (C)<br>
+ * See README.txt in the root directory of the OGDF installation for details.
+ *
+ * \par
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * Version 2 or 3 as published by the Free Software Foundation;
+ * see the file LICENSE.txt included in the packaging of this file
+ * for details.
+ *
+ * \par
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * \par
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * \see  http://www.gnu.org/copyleft/gpl.html
+ ***************************************************************/
+
+
+#include "BarnesHut.h"
+#include "../../energybased/numexcept.h"
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+namespace ogdf {
+
+//Spreads the low 16 bits of v to the even bits of the result.
+static inline unsigned int spread_bits(unsigned int v)
+{
+	v &= 0x0000ffff;
+	v = (v | (v << 8)) & 0x00ff00ff;
+	v = (v | (v << 4)) & 0x0f0f0f0f;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+
+//Adds the repulsion on the point (px,py) from the n masses at (x,y) to
+//(fx,fy), where a mass m at distance d pushes with strength m/d.  Masses at
+//exactly the point itself are skipped, and the number of them is returned.
+static inline int add_repulsion(double px, double py, const double *x, const double *y,
+	const double *m, int n, double &fx, double &fy)
+{
+	int i = 0;
+	int zeroDistances = 0;
+
+#ifdef __AVX2__
+	static const int zeroLanes[16] = {4,3,3,2,3,2,2,1,3,2,2,1,2,1,1,0};
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256d vpx = _mm256_set1_pd(px);
+	const __m256d vpy = _mm256_set1_pd(py);
+	__m256d vfx = zero, vfy = zero;
+	for(; i + 4 <= n; i += 4) {
+		__m256d dx = _mm256_sub_pd(vpx, _mm256_loadu_pd(x + i));
+		__m256d dy = _mm256_sub_pd(vpy, _mm256_loadu_pd(y + i));
+		__m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+		__m256d nonZero = _mm256_cmp_pd(d2, zero, _CMP_GT_OQ);
+		zeroDistances += zeroLanes[_mm256_movemask_pd(nonZero)];
+		__m256d s = _mm256_and_pd(_mm256_div_pd(_mm256_loadu_pd(m + i), d2), nonZero);
+		vfx = _mm256_add_pd(vfx, _mm256_mul_pd(dx, s));
+		vfy = _mm256_add_pd(vfy, _mm256_mul_pd(dy, s));
+	}
+	double sumX[4], sumY[4];
+	_mm256_storeu_pd(sumX, vfx);
+	_mm256_storeu_pd(sumY, vfy);
+	fx += (sumX[0] + sumX[1]) + (sumX[2] + sumX[3]);
+	fy += (sumY[0] + sumY[1]) + (sumY[2] + sumY[3]);
+#endif
+
+	for(; i < n; ++i) {
+		double dx = px - x[i];
+		double dy = py - y[i];
+		double d2 = dx * dx + dy * dy;
+		if(d2 > 0) {
+			double s = m[i] / d2;
+			fx += dx * s;
+			fy += dy * s;
+		}
+		else
+			++zeroDistances;
+	}
+	return zeroDistances;
+}
+
+
+BarnesHut::BarnesHut()
+{
+	m_theta = 0.5;
+	m_particlesInLeaves = 16;
+	m_boxSize = 1.0;
+}
+
+
+void BarnesHut::make_initialisations(const Graph &G, double theta, int particles_in_leaves)
+{
+	m_theta = max(0.0, theta);
+	m_particlesInLeaves = max(1, particles_in_leaves);
+
+	m_nodes.clear();
+	m_nodes.reserve(G.numberOfNodes());
+	node v;
+	forall_nodes(v,G)
+		m_nodes.push_back(v);
+}
+
+
+void BarnesHut::deallocate_memory()
+{
+	//Swapping with empty vectors releases their memory.
+	std::vector<node>().swap(m_nodes);
+	std::vector<unsigned int>().swap(m_codes);
+	std::vector<int>().swap(m_order);
+	std::vector<double>().swap(m_x);
+	std::vector<double>().swap(m_y);
+	std::vector<double>().swap(m_cellX);
+	std::vector<double>().swap(m_cellY);
+	std::vector<double>().swap(m_cellMass);
+	std::vector<double>().swap(m_cellSize);
+	std::vector<int>().swap(m_cellBegin);
+	std::vector<int>().swap(m_cellEnd);
+	std::vector<int>().swap(m_cellFirstChild);
+	std::vector<int>().swap(m_cellChildCount);
+	std::vector<double>().swap(m_listX);
+	std::vector<double>().swap(m_listY);
+	std::vector<double>().swap(m_listMass);
+	std::vector<int>().swap(m_stack);
+	std::vector<unsigned int>().swap(m_sortCodes);
+	std::vector<int>().swap(m_sortOrder);
+}
+
+
+void BarnesHut::calculate_repulsive_forces(
+	const Graph & /*G*/,
+	NodeArray<NodeAttributes>& A,
+	NodeArray<DPoint>& F_rep)
+{
+	numexcept N;
+	int n = int(m_nodes.size());
+	if(n == 0)
+		return;
+
+	sort_particles(A);
+	build_tree();
+
+	//The particles of a leaf share one interaction list.
+	int cellCount = int(m_cellBegin.size());
+	for(int leaf = 0; leaf < cellCount; ++leaf) {
+		if(m_cellChildCount[leaf] != 0)
+			continue;
+		collect_interactions(leaf);
+		int listSize = int(m_listMass.size());
+		for(int i = m_cellBegin[leaf]; i < m_cellEnd[leaf]; ++i) {
+			double fx = 0.0, fy = 0.0;
+			int atSamePosition = add_repulsion(m_x[i], m_y[i], m_listX.data(), m_listY.data(),
+				m_listMass.data(), listSize, fx, fy) - 1; //the particle itself is in the list
+			DPoint force(fx, fy);
+
+			//Other nodes at exactly the same position get a random push apart,
+			//as in the other methods.
+			if(atSamePosition > 0) {
+				DPoint push;
+				N.f_rep_near_machine_precision(0.0, push);
+				force = force + push;
+			}
+			F_rep[m_nodes[m_order[i]]] = force;
+		}
+	}
+}
+
+
+void BarnesHut::sort_particles(NodeArray<NodeAttributes>& A)
+{
+	int n = int(m_nodes.size());
+	m_x.resize(n);
+	m_y.resize(n);
+	m_codes.resize(n);
+	m_order.resize(n);
+	m_sortCodes.resize(n);
+	m_sortOrder.resize(n);
+
+	double xMin = A[m_nodes[0]].get_x(), xMax = xMin;
+	double yMin = A[m_nodes[0]].get_y(), yMax = yMin;
+	for(int i = 0; i < n; ++i) {
+		double x = A[m_nodes[i]].get_x();
+		double y = A[m_nodes[i]].get_y();
+		m_x[i] = x;
+		m_y[i] = y;
+		xMin = min(xMin, x);
+		xMax = max(xMax, x);
+		yMin = min(yMin, y);
+		yMax = max(yMax, y);
+	}
+	m_boxSize = max(xMax - xMin, yMax - yMin);
+	if(m_boxSize <= 0.0)
+		m_boxSize = 1.0;
+
+	const double scale = double(1 << eMaxLevel) / m_boxSize;
+	const unsigned int maxCoordinate = (1u << eMaxLevel) - 1;
+	for(int i = 0; i < n; ++i) {
+		unsigned int qx = min(maxCoordinate, (unsigned int)((m_x[i] - xMin) * scale));
+		unsigned int qy = min(maxCoordinate, (unsigned int)((m_y[i] - yMin) * scale));
+		m_codes[i] = (spread_bits(qy) << 1) | spread_bits(qx);
+		m_order[i] = i;
+	}
+
+	//A radix sort, one byte of the codes at a time.
+	for(int shift = 0; shift < 32; shift += 8) {
+		int counts[257] = {0};
+		for(int i = 0; i < n; ++i)
+			++counts[((m_codes[i] >> shift) & 255) + 1];
+		if(counts[((m_codes[0] >> shift) & 255) + 1] == n)
+			continue; //all codes share this byte
+		for(int b = 0; b < 256; ++b)
+			counts[b + 1] += counts[b];
+		for(int i = 0; i < n; ++i) {
+			int p = counts[(m_codes[i] >> shift) & 255]++;
+			m_sortCodes[p] = m_codes[i];
+			m_sortOrder[p] = m_order[i];
+		}
+		m_codes.swap(m_sortCodes);
+		m_order.swap(m_sortOrder);
+	}
+
+	for(int i = 0; i < n; ++i) {
+		const NodeAttributes &attributes = A[m_nodes[m_order[i]]];
+		m_x[i] = attributes.get_x();
+		m_y[i] = attributes.get_y();
+	}
+}
+
+
+void BarnesHut::build_tree()
+{
+	m_cellX.clear();
+	m_cellY.clear();
+	m_cellMass.clear();
+	m_cellSize.clear();
+	m_cellBegin.clear();
+	m_cellEnd.clear();
+	m_cellFirstChild.clear();
+	m_cellChildCount.clear();
+
+	add_cell(0, int(m_x.size()), m_boxSize);
+	build_children(0, 0);
+}
+
+
+int BarnesHut::add_cell(int begin, int end, double size)
+{
+	m_cellX.push_back(0.0);
+	m_cellY.push_back(0.0);
+	m_cellMass.push_back(0.0);
+	m_cellSize.push_back(size);
+	m_cellBegin.push_back(begin);
+	m_cellEnd.push_back(end);
+	m_cellFirstChild.push_back(-1);
+	m_cellChildCount.push_back(0);
+	return int(m_cellBegin.size()) - 1;
+}
+
+
+void BarnesHut::build_children(int cell, int level)
+{
+	int begin = m_cellBegin[cell];
+	int end = m_cellEnd[cell];
+
+	//The particles of a cell are split by the next two bits of their codes.
+	//When they all fall in one quadrant, the cell is shrunk to that quadrant
+	//instead of getting a single child.
+	int first = int(m_cellBegin.size());
+	int count = 0;
+	while(end - begin > m_particlesInLeaves && level < eMaxLevel && count == 0) {
+		int shift = 2 * (eMaxLevel - 1 - level);
+		double childSize = m_cellSize[cell] / 2.0;
+		++level;
+		if(((m_codes[begin] >> shift) & 3) == ((m_codes[end - 1] >> shift) & 3)) {
+			m_cellSize[cell] = childSize;
+			continue;
+		}
+		for(int start = begin; start < end; ++count) {
+			unsigned int quadrant = (m_codes[start] >> shift) & 3;
+			int stop = int(std::upper_bound(m_codes.begin() + start, m_codes.begin() + end, quadrant,
+				[shift](unsigned int q, unsigned int code) { return q < ((code >> shift) & 3); })
+				- m_codes.begin());
+			add_cell(start, stop, childSize);
+			start = stop;
+		}
+	}
+	m_cellFirstChild[cell] = (count > 0) ? first : -1;
+	m_cellChildCount[cell] = count;
+
+	double sumX = 0.0, sumY = 0.0, mass = 0.0;
+	if(count == 0) {
+		for(int i = begin; i < end; ++i) {
+			sumX += m_x[i];
+			sumY += m_y[i];
+		}
+		mass = double(end - begin);
+	} else {
+		for(int child = first; child < first + count; ++child) {
+			build_children(child, level);
+			sumX += m_cellX[child] * m_cellMass[child];
+			sumY += m_cellY[child] * m_cellMass[child];
+			mass += m_cellMass[child];
+		}
+	}
+	m_cellX[cell] = sumX / mass;
+	m_cellY[cell] = sumY / mass;
+	m_cellMass[cell] = mass;
+}
+
+
+void BarnesHut::collect_interactions(int leaf)
+{
+	m_listX.clear();
+	m_listY.clear();
+	m_listMass.clear();
+	m_stack.clear();
+	m_stack.push_back(0);
+
+	//The distance to a cell is measured from the nearest point of the box
+	//around the leaf's particles, so the criterion holds for all of them.
+	int leafBegin = m_cellBegin[leaf];
+	int leafEnd = m_cellEnd[leaf];
+	double xMin = m_x[leafBegin], xMax = xMin;
+	double yMin = m_y[leafBegin], yMax = yMin;
+	for(int i = leafBegin + 1; i < leafEnd; ++i) {
+		xMin = min(xMin, m_x[i]);
+		xMax = max(xMax, m_x[i]);
+		yMin = min(yMin, m_y[i]);
+		yMax = max(yMax, m_y[i]);
+	}
+
+	const double theta2 = m_theta * m_theta;
+	while(!m_stack.empty()) {
+		int cell = m_stack.back();
+		m_stack.pop_back();
+
+		//A cell holding the leaf is always opened.
+		if(leafBegin < m_cellBegin[cell] || leafBegin >= m_cellEnd[cell]) {
+			double cx = m_cellX[cell];
+			double cy = m_cellY[cell];
+			double dx = (cx < xMin) ? xMin - cx : ((cx > xMax) ? cx - xMax : 0.0);
+			double dy = (cy < yMin) ? yMin - cy : ((cy > yMax) ? cy - yMax : 0.0);
+			double size = m_cellSize[cell];
+			if(size * size < theta2 * (dx * dx + dy * dy)) {
+				m_listX.push_back(m_cellX[cell]);
+				m_listY.push_back(m_cellY[cell]);
+				m_listMass.push_back(m_cellMass[cell]);
+				continue;
+			}
+		}
+
+		if(m_cellChildCount[cell] == 0) {
+			for(int j = m_cellBegin[cell]; j < m_cellEnd[cell]; ++j) {
+				m_listX.push_back(m_x[j]);
+				m_listY.push_back(m_y[j]);
+				m_listMass.push_back(1.0);
+			}
+		} else {
+			int first = m_cellFirstChild[cell];
+			for(int child = first; child < first + m_cellChildCount[cell]; ++child)
+				m_stack.push_back(child);
+		}
+	}
+}
+
+}//namespace ogdf
@@ -0,0 +1,124 @@
+/** \file
+ * \brief Declaration of class BarnesHut (repulsive forces computed with a
+ *        flat, Morton-ordered quadtree).
+ *
+ * \par License:
+ * This file is part of the Open Graph Drawing Framework (OGDF).
+ *
+ * \par
+ * Copyright (C)<br>
+ * See README.txt in the root directory of the OGDF installation for details.
+ *
+ * \par
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * Version 2 or 3 as published by the Free Software Foundation;
+ * see the file LICENSE.txt included in the packaging of this file
+ * for details.
+ *
+ * \par
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * \par
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ * \see  http://www.gnu.org/copyleft/gpl.html
+ ***************************************************************/
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef OGDF_BARNES_HUT_H
+#define OGDF_BARNES_HUT_H
+
+#include "../../basic/Graph.h"
+#include "../../basic/geometry.h"
+#include "../../basic/NodeArray.h"
+#include "NodeAttributes.h"
+#include <vector>
+
+namespace ogdf {
+
+//The repulsive forces are approximated as in Barnes and Hut: a cell of the
+//quadtree that is far enough from a node acts on it as one particle at the
+//cell's centre of mass.  Unlike NMM, the positions and forces are kept in
+//plain arrays (one for each coordinate) sorted by Morton code, and the
+//quadtree is a flat array of cells rebuilt at every iteration, so the force
+//calculation runs over contiguous memory.  The nodes of each leaf share one
+//list of interactions, which is summed with AVX2 when it is available.
+class OGDF_EXPORT BarnesHut
+{
+public:
+	BarnesHut();          //constructor
+	~BarnesHut() { }      //destructor
+
+	//Calculate rep. forces for each node.
+	void calculate_repulsive_forces(const Graph &G,
+		NodeArray<NodeAttributes>& A,
+		NodeArray<DPoint>& F_rep);
+
+	//Make all initialisations that are needed for the force calculation.
+	//A cell is used in place of its particles when its side length is less
+	//than theta times its distance from the node (so 0 gives exact forces).
+	void make_initialisations(const Graph &G,
+		double theta,
+		int particles_in_leaves);
+
+	//The arrays are freed here.
+	void deallocate_memory();
+
+	//Import updated information of the drawing area.  The quadtree is fitted
+	//to the positions themselves, so these are not needed.
+	void update_boxlength_and_cornercoordinate(double /*b_l*/, DPoint /*d_l_c*/) { }
+
+private:
+	enum { eMaxLevel = 16 }; //bits of each coordinate in a Morton code
+
+	double m_theta;
+	int m_particlesInLeaves;
+	double m_boxSize; //side length of the quadtree's root
+	std::vector<node> m_nodes;
+
+	//The particles, sorted by Morton code.
+	std::vector<unsigned int> m_codes;
+	std::vector<int> m_order; //index in m_nodes of each sorted particle
+	std::vector<double> m_x, m_y;
+
+	//The quadtree's cells.  The children of a cell are stored next to each
+	//other, and a cell holds the particles [m_cellBegin, m_cellEnd).
+	std::vector<double> m_cellX, m_cellY; //centre of mass
+	std::vector<double> m_cellMass;
+	std::vector<double> m_cellSize;
+	std::vector<int> m_cellBegin, m_cellEnd;
+	std::vector<int> m_cellFirstChild, m_cellChildCount;
+
+	//The interaction list of the current leaf, and the traversal stack.
+	std::vector<double> m_listX, m_listY, m_listMass;
+	std::vector<int> m_stack;
+
+	//Scratch space for sorting.
+	std::vector<unsigned int> m_sortCodes;
+	std::vector<int> m_sortOrder;
+
+	//Fills the particle arrays from A and sorts them by Morton code.
+	void sort_particles(NodeArray<NodeAttributes>& A);
+
+	//Builds the quadtree over the sorted particles.
+	void build_tree();
+	int add_cell(int begin, int end, double size);
+	void build_children(int cell, int level);
+
+	//Gathers the cells and particles acting on the particles of a leaf.
+	void collect_interactions(int leaf);
+};
+
+}//namespace ogdf
+#endif
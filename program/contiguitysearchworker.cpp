@@ -0,0 +1,39 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "contiguitysearchworker.h"
+#include "../graph/contiguitysearch.h"
+
+ContiguitySearchWorker::ContiguitySearchWorker(ContiguitySearch * contiguitySearch,
+                                               std::vector<DeBruijnNode *> startingNodes) :
+    m_contiguitySearch(contiguitySearch), m_startingNodes(startingNodes)
+{
+}
+
+
+void ContiguitySearchWorker::determineContiguity()
+{
+    for (size_t i = 0; i < m_startingNodes.size(); ++i)
+    {
+        if (!m_contiguitySearch->determineContiguity(m_startingNodes[i]))
+            break;
+    }
+
+    emit finishedSearch();
+}
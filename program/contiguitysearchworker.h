@@ -0,0 +1,47 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef CONTIGUITYSEARCHWORKER_H
+#define CONTIGUITYSEARCHWORKER_H
+
+#include <QObject>
+#include <vector>
+
+class ContiguitySearch;
+class DeBruijnNode;
+
+class ContiguitySearchWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    ContiguitySearchWorker(ContiguitySearch * contiguitySearch,
+                           std::vector<DeBruijnNode *> startingNodes);
+
+    ContiguitySearch * m_contiguitySearch;
+    std::vector<DeBruijnNode *> m_startingNodes;
+
+public slots:
+    void determineContiguity();
+
+signals:
+    void finishedSearch();
+};
+
+#endif // CONTIGUITYSEARCHWORKER_H
@@ -0,0 +1,425 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gafcoverage.h"
+#include "gafparser.h"
+#include "parallel.h"
+#include "../graph/assemblygraph.h"
+#include "../graph/debruijnnode.h"
+#include "../graph/debruijnedge.h"
+#include <QFile>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <utility>
+
+namespace
+{
+
+//The GAF file is read in chunks of up to this many lines or bytes, whichever
+//comes first.
+const int CHUNK_LINES = 4096;
+const qint64 CHUNK_BYTES = 4 * 1024 * 1024;
+
+//Only this many skipped records are described individually.
+const int MAX_WARNINGS = 20;
+
+struct GafCoverageChunk
+{
+    long long firstLineNumber;
+    std::vector<QByteArray> lines;
+};
+
+}
+
+
+GafCoverage::GafCoverage() :
+    m_alignmentCount(0)
+{
+}
+
+
+long long GafCoverage::getReadCount(const DeBruijnNode * node) const
+{
+    int pair = getPair(node);
+    if (pair < 0)
+        return 0;
+    return m_readCounts[pair].load(std::memory_order_relaxed);
+}
+
+
+double GafCoverage::getMeanCoverage(const DeBruijnNode * node) const
+{
+    int pair = getPair(node);
+    if (pair < 0)
+        return 0.0;
+    return m_meanCoverage[pair];
+}
+
+
+//The coverage is given in the node's own orientation, so for a negative node
+//it is the positive node's track reversed.
+std::vector<int> GafCoverage::getBaseCoverage(const DeBruijnNode * node) const
+{
+    std::vector<int> coverage;
+    int pair = getPair(node);
+    if (pair < 0)
+        return coverage;
+
+    long long trackStart = m_trackStarts[pair];
+    long long length = m_trackStarts[pair + 1] - trackStart - 1;
+    coverage.reserve(length);
+    for (long long i = 0; i < length; ++i)
+        coverage.push_back(m_baseCoverage[trackStart + i].load(std::memory_order_relaxed));
+    if (node->isNegativeNode())
+        std::reverse(coverage.begin(), coverage.end());
+    return coverage;
+}
+
+
+double GafCoverage::getDepth(const DeBruijnNode * node, DepthSource source) const
+{
+    switch (source)
+    {
+    case GAF_MEAN_COVERAGE:
+        return getMeanCoverage(node);
+    case GAF_READ_COUNT:
+        return double(getReadCount(node));
+    default:
+        return node->getDepth();
+    }
+}
+
+
+//Nodes are matched by name, as the graph renumbers its nodes whenever it
+//changes.  The pointer and length must match too, so a node which has been
+//removed, renamed or added since has no pair, even if a new node reuses the
+//name or the memory of an old one.
+int GafCoverage::getPair(const DeBruijnNode * node) const
+{
+    QHash<QString, int>::const_iterator found = m_nodeIndices.constFind(node->getName());
+    if (found == m_nodeIndices.constEnd() || m_nodes[found.value()] != node)
+        return -1;
+    int pair = m_pairs[found.value()];
+    if (m_trackStarts[pair + 1] - m_trackStarts[pair] - 1 != node->getLength())
+        return -1;
+    return pair;
+}
+
+
+
+//This function reads the GAF file and builds the coverage.  Records which
+//can't be resolved against the graph are skipped and counted in the summary;
+//the function only fails if the file can't be read.
+bool GafCoverage::load(AssemblyGraph * assemblyGraph, QString gafFilename, int threads,
+                       GafCoverageSummary * summary, QString * error)
+{
+    summary->records = 0;
+    summary->alignments = 0;
+    summary->skipped = 0;
+    summary->alignedBases = 0;
+    summary->milliseconds = 0.0;
+    summary->warnings.clear();
+
+    QFile gafFile(gafFilename);
+    if (!gafFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        *error = "could not open " + gafFilename;
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    m_filename = gafFilename;
+    indexGraph(assemblyGraph);
+
+    //The calling thread reads the file and the workers resolve the chunks in
+    //whatever order they come.  Only a few chunks per worker are held at
+    //once, so memory use doesn't depend on the size of the file.
+    int workerCount = std::max(1, threads);
+    size_t maxChunks = 2 * workerCount;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<GafCoverageChunk *> chunks;
+    bool readingFinished = false;
+    std::vector<std::pair<long long, QString> > warnings;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < workerCount; ++i)
+    {
+        workers.push_back(std::thread([&]()
+        {
+            while (true)
+            {
+                GafCoverageChunk * chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    condition.wait(lock, [&] {return !chunks.empty() || readingFinished;});
+                    if (chunks.empty())
+                        return;
+                    chunk = chunks.front();
+                    chunks.pop_front();
+                }
+                condition.notify_all();
+
+                long long records = 0, alignments = 0, skipped = 0, alignedBases = 0;
+                std::vector<std::pair<long long, QString> > chunkWarnings;
+                for (size_t j = 0; j < chunk->lines.size(); ++j)
+                {
+                    QByteArray trimmed = chunk->lines[j].trimmed();
+                    if (trimmed.isEmpty() || trimmed.startsWith('#'))
+                        continue;
+                    ++records;
+
+                    QString failure;
+                    long long bases = 0;
+                    if (addAlignment(trimmed, &failure, &bases))
+                    {
+                        ++alignments;
+                        alignedBases += bases;
+                    }
+                    else
+                    {
+                        ++skipped;
+                        if (int(chunkWarnings.size()) < MAX_WARNINGS)
+                            chunkWarnings.push_back(std::make_pair(chunk->firstLineNumber + (long long)j, failure));
+                    }
+                }
+                delete chunk;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                summary->records += records;
+                summary->alignments += alignments;
+                summary->skipped += skipped;
+                summary->alignedBases += alignedBases;
+                warnings.insert(warnings.end(), chunkWarnings.begin(), chunkWarnings.end());
+            }
+        }));
+    }
+
+    long long lineNumber = 0;
+    while (!gafFile.atEnd())
+    {
+        GafCoverageChunk * chunk = new GafCoverageChunk();
+        chunk->firstLineNumber = lineNumber + 1;
+        qint64 chunkBytes = 0;
+        while (!gafFile.atEnd() && int(chunk->lines.size()) < CHUNK_LINES && chunkBytes < CHUNK_BYTES)
+        {
+            chunk->lines.push_back(gafFile.readLine());
+            chunkBytes += chunk->lines.back().size();
+            ++lineNumber;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] {return chunks.size() < maxChunks;});
+        chunks.push_back(chunk);
+        lock.unlock();
+        condition.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readingFinished = true;
+    }
+    condition.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+    finishCoverage();
+    m_alignmentCount = summary->alignments;
+
+    //The chunks finish in any order, so the warnings are sorted to report
+    //the first ones in the file.
+    std::sort(warnings.begin(), warnings.end());
+    for (size_t i = 0; i < warnings.size() && int(i) < MAX_WARNINGS; ++i)
+        summary->warnings << "line " + QString::number(warnings[i].first) + ": " + warnings[i].second;
+
+    summary->milliseconds = timer.nsecsElapsed() / 1000000.0;
+    return true;
+}
+
+
+//This function gives each pair of complementary nodes a coverage track and
+//makes the lookup table used to find nodes by name.
+void GafCoverage::indexGraph(AssemblyGraph * assemblyGraph)
+{
+    m_nodes = assemblyGraph->getIndexedNodes();
+    m_pairs.assign(m_nodes.size(), -1);
+    m_nodeIndices.clear();
+    m_nodeIndices.reserve(int(m_nodes.size()));
+    m_trackStarts.clear();
+
+    long long trackStart = 0;
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+    {
+        m_nodeIndices.insert(m_nodes[i]->getName(), int(i));
+        if (m_nodes[i]->isPositiveNode())
+        {
+            m_pairs[i] = int(m_trackStarts.size());
+            m_trackStarts.push_back(trackStart);
+            trackStart += m_nodes[i]->getLength() + 1;
+        }
+    }
+    m_trackStarts.push_back(trackStart);
+
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+    {
+        if (m_pairs[i] == -1)
+            m_pairs[i] = m_pairs[m_nodes[i]->getReverseComplement()->getId()];
+    }
+
+    size_t pairCount = m_trackStarts.size() - 1;
+    m_baseCoverage.reset(new std::atomic<int>[trackStart]());
+    m_readCounts.reset(new std::atomic<long long>[pairCount]());
+    m_meanCoverage.assign(pairCount, 0.0);
+}
+
+
+//This function adds one alignment to the coverage.  The walk's positions are
+//worked out from the node lengths and edge overlaps (the same way Path builds
+//its sequence) and the aligned interval (columns 8 and 9) is then split
+//between the nodes it covers.
+bool GafCoverage::addAlignment(const QByteArray & line, QString * failure, long long * alignedBases)
+{
+    QList<QByteArray> fields = line.split('\t');
+    if (fields.size() < 9)
+    {
+        *failure = "not enough fields";
+        return false;
+    }
+
+    QString pathError;
+    QStringList nodeNames = parseGafPath(QString::fromUtf8(fields[5]), &pathError);
+    if (nodeNames.isEmpty())
+    {
+        *failure = "failed to parse path (" + pathError + ")";
+        return false;
+    }
+
+    std::vector<int> nodeIndices;
+    nodeIndices.reserve(nodeNames.size());
+    for (int i = 0; i < nodeNames.size(); ++i)
+    {
+        QHash<QString, int>::const_iterator found = m_nodeIndices.constFind(nodeNames[i]);
+        if (found == m_nodeIndices.constEnd())
+        {
+            *failure = "node " + nodeNames[i] + " is not in the graph";
+            return false;
+        }
+        nodeIndices.push_back(found.value());
+    }
+
+    std::vector<long long> nodeStarts(nodeIndices.size());
+    long long walkLength = 0;
+    for (size_t i = 0; i < nodeIndices.size(); ++i)
+    {
+        DeBruijnNode * node = m_nodes[nodeIndices[i]];
+        nodeStarts[i] = walkLength;
+        if (i + 1 == nodeIndices.size())
+        {
+            walkLength += node->getLength();
+            break;
+        }
+        DeBruijnEdge * edge = node->doesNodeLeadAway(m_nodes[nodeIndices[i + 1]]);
+        if (edge == 0)
+        {
+            *failure = "the nodes do not form a path";
+            return false;
+        }
+        walkLength += std::max(0, node->getLength() - edge->getOverlap());
+    }
+
+    bool startOkay, endOkay;
+    long long start = fields[7].toLongLong(&startOkay);
+    long long end = fields[8].toLongLong(&endOkay);
+    if (!startOkay || !endOkay || start < 0 || end > walkLength || start > end)
+    {
+        *failure = "the path coordinates are outside the walk";
+        return false;
+    }
+
+    //A walk can visit a node more than once, but the alignment is only
+    //counted once for each node.
+    std::vector<int> countedPairs;
+    for (size_t i = 0; i < nodeIndices.size(); ++i)
+    {
+        long long nodeLength = m_nodes[nodeIndices[i]]->getLength();
+        long long nodeStart = std::max(start, nodeStarts[i]) - nodeStarts[i];
+        long long nodeEnd = std::min(end, nodeStarts[i] + nodeLength) - nodeStarts[i];
+        if (nodeEnd <= nodeStart)
+            continue;
+        addInterval(nodeIndices[i], nodeStart, nodeEnd);
+
+        int pair = m_pairs[nodeIndices[i]];
+        if (std::find(countedPairs.begin(), countedPairs.end(), pair) == countedPairs.end())
+        {
+            m_readCounts[pair].fetch_add(1, std::memory_order_relaxed);
+            countedPairs.push_back(pair);
+        }
+    }
+
+    *alignedBases = end - start;
+    return true;
+}
+
+
+//Intervals on a negative node are flipped onto the positive node's track.
+void GafCoverage::addInterval(int nodeIndex, long long start, long long end)
+{
+    DeBruijnNode * node = m_nodes[nodeIndex];
+    if (node->isNegativeNode())
+    {
+        long long length = node->getLength();
+        long long flippedStart = length - end;
+        end = length - start;
+        start = flippedStart;
+    }
+
+    long long trackStart = m_trackStarts[m_pairs[nodeIndex]];
+    m_baseCoverage[trackStart + start].fetch_add(1, std::memory_order_relaxed);
+    m_baseCoverage[trackStart + end].fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+//This function turns the difference arrays into coverage, in place, and
+//gets each node's mean coverage along the way.
+void GafCoverage::finishCoverage()
+{
+    long long pairCount = (long long)m_trackStarts.size() - 1;
+    parallelForChunks(pairCount, [this](int, long long begin, long long end)
+    {
+        for (long long pair = begin; pair < end; ++pair)
+        {
+            long long trackStart = m_trackStarts[pair];
+            long long length = m_trackStarts[pair + 1] - trackStart - 1;
+            int coverage = 0;
+            long long coverageSum = 0;
+            for (long long i = 0; i < length; ++i)
+            {
+                coverage += m_baseCoverage[trackStart + i].load(std::memory_order_relaxed);
+                m_baseCoverage[trackStart + i].store(coverage, std::memory_order_relaxed);
+                coverageSum += coverage;
+            }
+            m_baseCoverage[trackStart + length].store(0, std::memory_order_relaxed);
+            m_meanCoverage[pair] = length > 0 ? double(coverageSum) / length : 0.0;
+        }
+    }, 1000);
+}
@@ -0,0 +1,105 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GAFCOVERAGE_H
+#define GAFCOVERAGE_H
+
+//This class projects the alignments in a GAF file onto a graph.  For each
+//pair of complementary nodes it counts the alignments which pass through the
+//node and builds a per-base coverage track, which can then be used in place
+//of the depth that came with the graph.
+//
+//The GAF file is streamed in chunks which are resolved by a pool of worker
+//threads.  Each alignment adds one to the start of its interval on each node
+//and subtracts one after the end (a difference array), so the workers only
+//touch two positions per node no matter how long the alignment is.  These
+//are atomic counters, so the workers share one set of arrays.  When the file
+//is finished, the differences are summed into coverage, one node per thread.
+//
+//The coverage refers to the nodes that were in the graph when it was made.
+//Those nodes keep it however the graph changes around them, but nodes added
+//or renamed later (e.g. by merging) have no coverage.
+
+#include "globals.h"
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+class AssemblyGraph;
+class DeBruijnNode;
+
+struct GafCoverageSummary
+{
+    long long records;
+    long long alignments;
+    long long skipped;
+    long long alignedBases;
+    double milliseconds;
+    QStringList warnings;
+};
+
+class GafCoverage
+{
+public:
+    //CREATORS
+    GafCoverage();
+
+    //ACCESSORS
+    bool isEmpty() const {return m_nodes.empty();}
+    QString getFilename() const {return m_filename;}
+    long long getAlignmentCount() const {return m_alignmentCount;}
+    long long getReadCount(const DeBruijnNode * node) const;
+    double getMeanCoverage(const DeBruijnNode * node) const;
+    std::vector<int> getBaseCoverage(const DeBruijnNode * node) const;
+    double getDepth(const DeBruijnNode * node, DepthSource source) const;
+
+    //MODIFERS
+    bool load(AssemblyGraph * assemblyGraph, QString gafFilename, int threads,
+              GafCoverageSummary * summary, QString * error);
+
+private:
+    QString m_filename;
+    long long m_alignmentCount;
+
+    //These are the graph's indexed nodes when the coverage was made, and
+    //their indices by name.  Each node's pair is the index of its positive
+    //node's coverage data.
+    std::vector<DeBruijnNode *> m_nodes;
+    std::vector<int> m_pairs;
+    QHash<QString, int> m_nodeIndices;
+
+    //Each pair's coverage track starts at m_trackStarts[pair] in
+    //m_baseCoverage and is one longer than the node, so the difference array
+    //has room for the position after the end.  After loading, the tracks hold
+    //the coverage of each base on the positive node.
+    std::vector<long long> m_trackStarts;
+    std::unique_ptr<std::atomic<int>[]> m_baseCoverage;
+    std::unique_ptr<std::atomic<long long>[]> m_readCounts;
+    std::vector<double> m_meanCoverage;
+
+    int getPair(const DeBruijnNode * node) const;
+    void indexGraph(AssemblyGraph * assemblyGraph);
+    bool addAlignment(const QByteArray & line, QString * failure, long long * alignedBases);
+    void addInterval(int nodeIndex, long long start, long long end);
+    void finishCoverage();
+};
+
+#endif // GAFCOVERAGE_H
@@ -109,8 +109,11 @@ QStringList parseWalkWithSuffixes(const QString &pathField, QString * error)
 
     return nodes;
 }
+}
 
 
+//This function converts a GAF path field (e.g. ">1<2>3" or "1+,2-,3+") into
+//a list of Bandage node names.
 QStringList parseGafPath(const QString &pathField, QString * error)
 {
     QString trimmed = pathField.trimmed();
@@ -129,6 +132,8 @@ QStringList parseGafPath(const QString &pathField, QString * error)
 }
 
 
+namespace
+{
 int safeToInt(const QString &text)
 {
     bool ok = false;
@@ -44,6 +44,7 @@ struct GafParseResult
     bool isEmpty() const {return alignments.isEmpty();}
 };
 
+QStringList parseGafPath(const QString &pathField, QString * error);
 GafParseResult parseGafFile(const QString &fileName);
 
 #endif // GAFPARSER_H
@@ -50,13 +50,16 @@ enum BlastUiState {BLAST_DB_NOT_YET_BUILT, BLAST_DB_BUILD_IN_PROGRESS,
                    READY_FOR_BLAST_SEARCH, BLAST_SEARCH_IN_PROGRESS,
                    BLAST_SEARCH_COMPLETE};
 enum CommandLineCommand {NO_COMMAND, BANDAGE_LOAD, BANDAGE_INFO, BANDAGE_IMAGE,
-                         BANDAGE_DISTANCE, BANDAGE_QUERY_PATHS, BANDAGE_REDUCE};
+                         BANDAGE_DISTANCE, BANDAGE_QUERY_PATHS, BANDAGE_REDUCE,
+                         BANDAGE_BATCH, BANDAGE_SERVE, BANDAGE_GAF_SEQ,
+                         BANDAGE_FIND_SEQ};
 enum EdgeOverlapType {UNKNOWN_OVERLAP, EXACT_OVERLAP,
                       AUTO_DETERMINED_EXACT_OVERLAP};
 enum NodeNameStatus {NODE_NAME_OKAY, NODE_NAME_TAKEN, NODE_NAME_CONTAINS_TAB,
                      NODE_NAME_CONTAINS_NEWLINE, NODE_NAME_CONTAINS_COMMA,
                      NODE_NAME_CONTAINS_SPACE};
 enum SequencesLoadedFromFasta {NOT_READY, NOT_TRIED, TRIED};
+enum DepthSource {GRAPH_DEPTH, GAF_MEAN_COVERAGE, GAF_READ_COUNT};
 
 
 //Some of the program's common components are made global so they don't have
@@ -18,14 +18,21 @@
 
 #include "graphlayoutworker.h"
 #include <time.h>
+#include <stdlib.h>
+#include <math.h>
+#include <map>
+#include <algorithm>
+#include <utility>
 #include "ogdf/basic/geometry.h"
 #include <QLineF>
+#include <QThread>
 
 GraphLayoutWorker::GraphLayoutWorker(ogdf::FMMMLayout * fmmm, ogdf::GraphAttributes * graphAttributes,
                                      ogdf::EdgeArray<double> * edgeArray, int graphLayoutQuality, bool linearLayout,
-                                     double graphLayoutComponentSeparation, double aspectRatio) :
+                                     bool keepPositions, double graphLayoutComponentSeparation, double aspectRatio) :
     m_fmmm(fmmm), m_graphAttributes(graphAttributes), m_edgeArray(edgeArray), m_graphLayoutQuality(graphLayoutQuality),
-    m_linearLayout(linearLayout), m_graphLayoutComponentSeparation(graphLayoutComponentSeparation),
+    m_linearLayout(linearLayout), m_keepPositions(keepPositions),
+    m_graphLayoutComponentSeparation(graphLayoutComponentSeparation),
     m_aspectRatio(aspectRatio)
 {
 }
@@ -42,11 +49,58 @@ void GraphLayoutWorker::layoutGraph()
     m_fmmm->minDistCC(m_graphLayoutComponentSeparation);
     m_fmmm->stepsForRotatingComponents(50); // Helps to make linear graph components more horizontal.
 
+    //Assembly graphs often have many connected components, and these are laid
+    //out on separate threads (each with its own OGDF memory pool).
+    m_fmmm->componentThreads(QThread::idealThreadCount());
+
     if (m_linearLayout)
         m_fmmm->initialPlacementForces(ogdf::FMMMLayout::ipfKeepPositions);
     else
         m_fmmm->initialPlacementForces(ogdf::FMMMLayout::ipfRandomTime);
 
+    setLayoutQualityOptions();
+
+    m_fmmm->progressListener(this);
+
+    //When expanding an existing layout, the nodes already have positions
+    //(the fixed nodes where they were drawn and the new nodes beside them)
+    //so the layout only refines them.  If the fixed nodes are known, only the
+    //other nodes are moved, which leaves the existing drawing exactly as it
+    //was and costs only as much as the new nodes' edges.  No progress is
+    //reported, as the new nodes barely move.
+    if (m_keepPositions && !m_linearLayout)
+    {
+        if (m_fixedNodes.empty())
+        {
+            setRefinementOptions();
+            m_fmmm->call(*m_graphAttributes, *m_edgeArray);
+        }
+        else
+            relaxNodes(getUnfixedNodes(), m_fmmm->fixedIterations());
+    }
+    else if (m_segmentChains.empty() || m_linearLayout)
+        m_fmmm->call(*m_graphAttributes, *m_edgeArray);
+    else
+        layoutCoarseThenRefine();
+
+    emit finishedLayout();
+}
+
+
+//This is called by the layout (on one of its threads) every so often.  The
+//positions are indexed by OGDF node index, so they can be matched to the
+//graph's edges when drawn.
+void GraphLayoutWorker::layoutProgress(const std::vector<ogdf::node> & nodes, const std::vector<ogdf::DPoint> & positions)
+{
+    QPolygonF ogdfNodePositions(m_graphAttributes->constGraph().maxNodeIndex() + 1);
+    for (size_t i = 0; i < nodes.size(); ++i)
+        ogdfNodePositions[nodes[i]->index()] = QPointF(positions[i].m_x, positions[i].m_y);
+    emit layoutUpdated(ogdfNodePositions);
+}
+
+
+void GraphLayoutWorker::setLayoutQualityOptions()
+{
     switch (m_graphLayoutQuality)
     {
     case 0:
@@ -75,9 +129,254 @@ void GraphLayoutWorker::layoutGraph()
         m_fmmm->nmPrecision(8);
         break;
     }
+}
 
-    m_fmmm->call(*m_graphAttributes, *m_edgeArray);
 
-    emit finishedLayout();
+//Long contigs are drawn as long chains of segments, and for graphs with very
+//long contigs these chains can make up most of the layout work.  This
+//function first lays out a coarse graph with one node per chain, where each
+//node's bounding circle has the chain's length as its diameter.  Each chain
+//is then laid out in a line through its coarse position, pointing from the
+//chains joined to its start towards those joined to its end.  Finally, only
+//the segments near the ends of each chain are relaxed, so the chains bend to
+//meet each other.  The rest of each chain stays where it was placed, which
+//keeps this last step's cost independent of the chains' lengths.
+void GraphLayoutWorker::layoutCoarseThenRefine()
+{
+    const ogdf::Graph & graph = m_graphAttributes->constGraph();
+    int chainCount = int(m_segmentChains.size());
+
+    ogdf::NodeArray<int> chainOfNode(graph, -1);
+    ogdf::NodeArray<int> positionInChain(graph, 0);
+    for (int i = 0; i < chainCount; ++i)
+    {
+        for (size_t j = 0; j < m_segmentChains[i].size(); ++j)
+        {
+            chainOfNode[m_segmentChains[i][j]] = i;
+            positionInChain[m_segmentChains[i][j]] = int(j);
+        }
+    }
+
+    //Find each chain's drawn length from the edges between its segments and
+    //gather the edges between chains, keeping the shortest of any duplicates.
+    std::vector<double> chainLengths(chainCount, 0.0);
+    std::map<std::pair<int, int>, double> chainEdges;
+    ogdf::edge e;
+    forall_edges(e, graph)
+    {
+        int sourceChain = chainOfNode[e->source()];
+        int targetChain = chainOfNode[e->target()];
+        if (sourceChain == -1 || targetChain == -1)
+            continue;
+        if (sourceChain == targetChain)
+        {
+            if (abs(positionInChain[e->source()] - positionInChain[e->target()]) == 1)
+                chainLengths[sourceChain] += (*m_edgeArray)[e];
+            continue;
+        }
+        std::pair<int, int> chainPair(std::min(sourceChain, targetChain), std::max(sourceChain, targetChain));
+        std::map<std::pair<int, int>, double>::iterator existing = chainEdges.find(chainPair);
+        if (existing == chainEdges.end() || (*m_edgeArray)[e] < existing->second)
+            chainEdges[chainPair] = (*m_edgeArray)[e];
+    }
+
+    ogdf::Graph coarseGraph;
+    std::vector<ogdf::node> coarseNodes(chainCount);
+    for (int i = 0; i < chainCount; ++i)
+        coarseNodes[i] = coarseGraph.newNode();
+    std::vector<std::pair<ogdf::edge, double> > coarseEdges;
+    for (std::map<std::pair<int, int>, double>::iterator i = chainEdges.begin(); i != chainEdges.end(); ++i)
+    {
+        ogdf::edge coarseEdge = coarseGraph.newEdge(coarseNodes[i->first.first], coarseNodes[i->first.second]);
+        coarseEdges.push_back(std::make_pair(coarseEdge, i->second));
+    }
+
+    ogdf::GraphAttributes coarseAttributes(coarseGraph, ogdf::GraphAttributes::nodeGraphics |
+                                           ogdf::GraphAttributes::edgeGraphics);
+    ogdf::EdgeArray<double> coarseEdgeLengths(coarseGraph);
+    for (size_t i = 0; i < coarseEdges.size(); ++i)
+        coarseEdgeLengths[coarseEdges[i].first] = coarseEdges[i].second;
+
+    //FMMM adds the radius of each node's bounding circle to the length of its
+    //edges, so a square with sides of length / sqrt(2) allows for half of the
+    //chain at each end of an edge.
+    for (int i = 0; i < chainCount; ++i)
+    {
+        double side = std::max(1.0, chainLengths[i]) / sqrt(2.0);
+        coarseAttributes.width(coarseNodes[i]) = side;
+        coarseAttributes.height(coarseNodes[i]) = side;
+    }
+
+    //The coarse graph's nodes aren't the graph's, so its progress isn't shown.
+    m_fmmm->progressListener(0);
+    m_fmmm->call(coarseAttributes, coarseEdgeLengths);
+    m_fmmm->progressListener(this);
+
+    //If the layout was stopped during the coarse stage, the chains are still
+    //expanded so the graph can be shown, but not relaxed.
+    bool cancelled = m_fmmm->stopRequested();
+
+    for (int i = 0; i < chainCount; ++i)
+    {
+        const std::vector<ogdf::node> & chain = m_segmentChains[i];
+        if (chain.empty())
+            continue;
+        QPointF centre(coarseAttributes.x(coarseNodes[i]), coarseAttributes.y(coarseNodes[i]));
+
+        //Average the coarse positions of the chains joined to each end.
+        QPointF startNeighbours, endNeighbours;
+        int startNeighbourCount = 0, endNeighbourCount = 0;
+        for (int end = 0; end < 2; ++end)
+        {
+            ogdf::node endNode = (end == 0) ? chain.front() : chain.back();
+            ogdf::adjEntry adj;
+            forall_adj(adj, endNode)
+            {
+                int otherChain = chainOfNode[adj->twinNode()];
+                if (otherChain == -1 || otherChain == i)
+                    continue;
+                QPointF otherCentre(coarseAttributes.x(coarseNodes[otherChain]), coarseAttributes.y(coarseNodes[otherChain]));
+                if (end == 0)
+                {
+                    startNeighbours += otherCentre;
+                    ++startNeighbourCount;
+                }
+                else
+                {
+                    endNeighbours += otherCentre;
+                    ++endNeighbourCount;
+                }
+            }
+        }
+
+        QPointF startPoint = centre, endPoint = centre;
+        if (startNeighbourCount > 0)
+            startPoint = startNeighbours / startNeighbourCount;
+        if (endNeighbourCount > 0)
+            endPoint = endNeighbours / endNeighbourCount;
+        QLineF direction(startPoint, endPoint);
+        if (direction.length() == 0.0)
+            direction = QLineF(QPointF(0.0, 0.0), QPointF(1.0, 0.0));
+        if (startNeighbourCount == 0 && endNeighbourCount == 0)
+            direction.setAngle(rand() % 360);
+        direction = direction.unitVector();
+        QPointF step = direction.p2() - direction.p1();
+
+        double segmentLength = 0.0;
+        if (chain.size() > 1)
+            segmentLength = chainLengths[i] / (chain.size() - 1);
+        for (size_t j = 0; j < chain.size(); ++j)
+        {
+            QPointF point = centre + step * (j * segmentLength - chainLengths[i] / 2.0);
+            m_graphAttributes->x(chain[j]) = point.x();
+            m_graphAttributes->y(chain[j]) = point.y();
+        }
+    }
+
+    if (cancelled)
+        return;
+
+    std::vector<ogdf::node> chainEnds;
+    for (int i = 0; i < chainCount; ++i)
+    {
+        const std::vector<ogdf::node> & chain = m_segmentChains[i];
+        int chainSize = int(chain.size());
+        int endSize = std::min(int(RELAXED_SEGMENTS_PER_CHAIN_END), (chainSize + 1) / 2);
+        for (int j = 0; j < endSize; ++j)
+        {
+            chainEnds.push_back(chain[j]);
+            if (chainSize - 1 - j != j)
+                chainEnds.push_back(chain[chainSize - 1 - j]);
+        }
+    }
+    relaxNodes(chainEnds, m_fmmm->fixedIterations());
+}
+
+
+//This function moves only the given nodes, holding all others where they are.
+//On each pass, each node moves to the average of the positions its edges would
+//put it at: the neighbour's position plus the edge's ideal length, in the
+//direction the node lies from that neighbour.  This is a local form of stress
+//majorisation, so each pass only costs as much as the given nodes' edges.
+void GraphLayoutWorker::relaxNodes(const std::vector<ogdf::node> & nodes, int passes)
+{
+    for (int pass = 0; pass < passes && !m_fmmm->stopRequested(); ++pass)
+    {
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            ogdf::node v = nodes[i];
+            QPointF position(m_graphAttributes->x(v), m_graphAttributes->y(v));
+            QPointF target;
+            int targetCount = 0;
+            ogdf::adjEntry adj;
+            forall_adj(adj, v)
+            {
+                ogdf::node neighbour = adj->twinNode();
+                if (neighbour == v)
+                    continue;
+                QPointF neighbourPosition(m_graphAttributes->x(neighbour), m_graphAttributes->y(neighbour));
+                QLineF line(neighbourPosition, position);
+                if (line.length() == 0.0)
+                {
+                    line = QLineF(neighbourPosition, neighbourPosition + QPointF(1.0, 0.0));
+                    line.setAngle(rand() % 360);
+                }
+                line.setLength(getIdealEdgeLength(adj->theEdge()));
+                target += line.p2();
+                ++targetCount;
+            }
+            if (targetCount == 0)
+                continue;
+            target /= targetCount;
+            m_graphAttributes->x(v) = target.x();
+            m_graphAttributes->y(v) = target.y();
+        }
+    }
 }
 
+
+std::vector<ogdf::node> GraphLayoutWorker::getUnfixedNodes() const
+{
+    const ogdf::Graph & graph = m_graphAttributes->constGraph();
+    ogdf::NodeArray<bool> fixed(graph, false);
+    for (size_t i = 0; i < m_fixedNodes.size(); ++i)
+        fixed[m_fixedNodes[i]] = true;
+
+    std::vector<ogdf::node> unfixedNodes;
+    ogdf::node v;
+    forall_nodes(v, graph)
+    {
+        if (!fixed[v])
+            unfixedNodes.push_back(v);
+    }
+    return unfixedNodes;
+}
+
+
+//This matches the ideal edge length used by FMMM: the edge's length plus the
+//radii of the circles bounding its nodes.
+double GraphLayoutWorker::getIdealEdgeLength(ogdf::edge e) const
+{
+    double length = (*m_edgeArray)[e] * m_fmmm->unitEdgeLength();
+    ogdf::node ends[2] = {e->source(), e->target()};
+    for (int i = 0; i < 2; ++i)
+    {
+        double halfWidth = m_graphAttributes->width(ends[i]) / 2.0;
+        double halfHeight = m_graphAttributes->height(ends[i]) / 2.0;
+        length += sqrt(halfWidth * halfWidth + halfHeight * halfHeight);
+    }
+    return length;
+}
+
+
+//A refinement starts from the nodes' current positions and runs on a single
+//level, as the multilevel layout would replace them on its coarser levels.
+//The positions are already close, so it needs fewer iterations.
+void GraphLayoutWorker::setRefinementOptions()
+{
+    m_fmmm->initialPlacementForces(ogdf::FMMMLayout::ipfKeepPositions);
+    m_fmmm->setSingleLevel(true);
+    m_fmmm->maxIterFactor(1);
+    m_fmmm->fixedIterations(std::max(1, m_fmmm->fixedIterations() / 4));
+    m_fmmm->fineTuningIterations(std::max(1, m_fmmm->fineTuningIterations() / 4));
+}
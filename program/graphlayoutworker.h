@@ -20,32 +20,64 @@
 #define GRAPHLAYOUTWORKER_H
 
 #include <QObject>
+#include <QPolygonF>
+#include <vector>
 #include "../ogdf/energybased/FMMMLayout.h"
 #include "../ogdf/basic/GraphAttributes.h"
 
 
-class GraphLayoutWorker : public QObject
+//The worker is also the layout's progress listener, so the positions the
+//layout reaches can be drawn while it runs.
+class GraphLayoutWorker : public QObject, public ogdf::FMMMProgressListener
 {
     Q_OBJECT
 
 public:
     GraphLayoutWorker(ogdf::FMMMLayout * fmmm, ogdf::GraphAttributes * graphAttributes,
                       ogdf::EdgeArray<double> * edgeArray, int graphLayoutQuality, bool linearLayout,
-                      double graphLayoutComponentSeparation, double aspectRatio = 1.333333);
+                      bool keepPositions, double graphLayoutComponentSeparation,
+                      double aspectRatio = 1.333333);
 
     ogdf::FMMMLayout * m_fmmm;
     ogdf::GraphAttributes * m_graphAttributes;
     ogdf::EdgeArray<double> * m_edgeArray;
     int m_graphLayoutQuality;
     bool m_linearLayout;
+    bool m_keepPositions;
     double m_graphLayoutComponentSeparation;
     double m_aspectRatio;
 
+    //If this is set, the layout is done in two stages: first with one OGDF
+    //node per chain of segments, then with the chains expanded.
+    std::vector<std::vector<ogdf::node> > m_segmentChains;
+
+    //After the chains are expanded, this many segments at each end of each
+    //chain are relaxed to meet the chains they join.
+    static const int RELAXED_SEGMENTS_PER_CHAIN_END = 4;
+
+    //If this is set when keeping positions, these nodes stay exactly where
+    //they are and only the others are laid out.
+    std::vector<ogdf::node> m_fixedNodes;
+
+    void setSegmentChains(const std::vector<std::vector<ogdf::node> > & segmentChains) {m_segmentChains = segmentChains;}
+    void setFixedNodes(const std::vector<ogdf::node> & fixedNodes) {m_fixedNodes = fixedNodes;}
+
+    void layoutProgress(const std::vector<ogdf::node> & nodes, const std::vector<ogdf::DPoint> & positions);
+
 public slots:
     void layoutGraph();
 
+private:
+    void setLayoutQualityOptions();
+    void layoutCoarseThenRefine();
+    void relaxNodes(const std::vector<ogdf::node> & nodes, int passes);
+    double getIdealEdgeLength(ogdf::edge e) const;
+    std::vector<ogdf::node> getUnfixedNodes() const;
+    void setRefinementOptions();
+
 signals:
     void finishedLayout();
+    void layoutUpdated(QPolygonF ogdfNodePositions);
 };
 
 #endif // GRAPHLAYOUTWORKER_H
@@ -0,0 +1,61 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "graphloadworker.h"
+#include "../graph/assemblygraph.h"
+
+GraphLoadWorker::GraphLoadWorker(AssemblyGraph * assemblyGraph, GraphFileType graphFileType,
+                                 QString fullFileName) :
+    m_assemblyGraph(assemblyGraph), m_graphFileType(graphFileType), m_fullFileName(fullFileName),
+    m_loaded(false), m_unsupportedCigar(false), m_customLabels(false), m_customColours(false),
+    m_badEdgeCount(0)
+{
+}
+
+
+//If the file cannot be loaded or the load is cancelled, m_loaded is left
+//false and the partly built graph is left for the caller to discard.
+void GraphLoadWorker::loadGraph()
+{
+    try
+    {
+        if (m_graphFileType == LAST_GRAPH)
+            m_assemblyGraph->buildDeBruijnGraphFromLastGraph(m_fullFileName);
+        else if (m_graphFileType == FASTG)
+            m_assemblyGraph->buildDeBruijnGraphFromFastg(m_fullFileName);
+        else if (m_graphFileType == GFA)
+            m_assemblyGraph->buildDeBruijnGraphFromGfa(m_fullFileName, &m_unsupportedCigar, &m_customLabels,
+                                                       &m_customColours, &m_bandageOptionsError,
+                                                       &m_bandageOptions);
+        else if (m_graphFileType == TRINITY)
+            m_assemblyGraph->buildDeBruijnGraphFromTrinityFasta(m_fullFileName);
+        else if (m_graphFileType == ASQG)
+            m_badEdgeCount = m_assemblyGraph->buildDeBruijnGraphFromAsqg(m_fullFileName);
+        else if (m_graphFileType == PLAIN_FASTA)
+            m_assemblyGraph->buildDeBruijnGraphFromPlainFasta(m_fullFileName);
+
+        m_loaded = !m_assemblyGraph->wasLoadCancelled();
+    }
+
+    catch (...)
+    {
+        m_loaded = false;
+    }
+
+    emit finishedLoad();
+}
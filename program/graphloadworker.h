@@ -0,0 +1,59 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GRAPHLOADWORKER_H
+#define GRAPHLOADWORKER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include "globals.h"
+
+class AssemblyGraph;
+
+//This class loads a graph file into a new AssemblyGraph object in a different
+//thread.  Anything the loader reports which needs to be acted on in the GUI
+//thread is kept here until the load is finished.
+class GraphLoadWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    GraphLoadWorker(AssemblyGraph * assemblyGraph, GraphFileType graphFileType,
+                    QString fullFileName);
+
+    AssemblyGraph * m_assemblyGraph;
+    GraphFileType m_graphFileType;
+    QString m_fullFileName;
+
+    bool m_loaded;
+    bool m_unsupportedCigar;
+    bool m_customLabels;
+    bool m_customColours;
+    QString m_bandageOptionsError;
+    QStringList m_bandageOptions;
+    int m_badEdgeCount;
+
+public slots:
+    void loadGraph();
+
+signals:
+    void finishedLoad();
+};
+
+#endif // GRAPHLOADWORKER_H
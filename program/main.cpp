@@ -27,6 +27,10 @@
 #include "../command_line/image.h"
 #include "../command_line/querypaths.h"
 #include "../command_line/reduce.h"
+#include "../command_line/batch.h"
+#include "../command_line/serve.h"
+#include "../command_line/gafseq.h"
+#include "../command_line/findseq.h"
 #include "../command_line/commoncommandlinefunctions.h"
 #include "../program/settings.h"
 #include "../program/memory.h"
@@ -51,7 +55,11 @@ void printUsage(QTextStream * out, bool all)
     text << "info         Display information about a graph";
     text << "image        Generate an image file of a graph";
     text << "querypaths   Output graph paths for BLAST queries";
+    text << "gafseq       Output graph sequences for GAF alignments";
+    text << "findseq      Find query sequences in a graph, including across nodes";
     text << "reduce       Save a subgraph of a larger graph";
+    text << "batch        Run info, image and reduce on many graphs in one process";
+    text << "serve        Answer graph queries over a local socket";
     text << "";
     text << "Options:  --help       View this help message";
     text << "--helpall    View all command line settings";
@@ -86,7 +94,7 @@ int main(int argc, char *argv[])
     // Create the application. Some ways of running Bandage require the normal platform while other command line only
     // ways use the minimal platform. Frustratingly, Bandage image cannot render text properly with the minimal
     // platform, so we need to use the full platform if Bandage image is run with text labels.
-    bool imageWithText = (first.toLower() == "image") &&
+    bool imageWithText = (first.toLower() == "image" || first.toLower() == "batch") &&
                          (arguments.contains("--names") || arguments.contains("--lengths") ||
                           arguments.contains("--depth") || arguments.contains("--blasthits"));
     bool guiNeeded = (first == "") || first.startsWith("-") || (first.toLower() == "load") || imageWithText;
@@ -150,12 +158,36 @@ int main(int argc, char *argv[])
             g_memory->commandLineCommand = BANDAGE_QUERY_PATHS;
             return bandageQueryPaths(arguments);
         }
+        else if (first.toLower() == "gafseq")
+        {
+            arguments.pop_front();
+            g_memory->commandLineCommand = BANDAGE_GAF_SEQ;
+            return bandageGafSeq(arguments);
+        }
+        else if (first.toLower() == "findseq")
+        {
+            arguments.pop_front();
+            g_memory->commandLineCommand = BANDAGE_FIND_SEQ;
+            return bandageFindSeq(arguments);
+        }
         else if (first.toLower() == "reduce")
         {
             arguments.pop_front();
             g_memory->commandLineCommand = BANDAGE_REDUCE;
             return bandageReduce(arguments);
         }
+        else if (first.toLower() == "batch")
+        {
+            arguments.pop_front();
+            g_memory->commandLineCommand = BANDAGE_BATCH;
+            return bandageBatch(arguments);
+        }
+        else if (first.toLower() == "serve")
+        {
+            arguments.pop_front();
+            g_memory->commandLineCommand = BANDAGE_SERVE;
+            return bandageServe(arguments);
+        }
 
         //Since a recognised command was not seen, we now check to see if the user
         //was looking for help information.
@@ -0,0 +1,73 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+//These helpers split a range of items into contiguous chunks and process
+//each chunk on its own thread.  Small ranges are run on the calling thread
+//so there is no threading overhead for small graphs.
+
+#include <QThread>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+inline int getParallelThreadCount(long long itemCount,
+                                  long long minItemsPerThread = 10000)
+{
+    if (itemCount <= 0)
+        return 1;
+    long long idealThreads = std::max(1, QThread::idealThreadCount());
+    long long usefulThreads = std::max(1LL, itemCount / std::max(1LL, minItemsPerThread));
+    return int(std::min(idealThreads, usefulThreads));
+}
+
+//The function is called as function(chunk, begin, end) for each chunk, where
+//chunk is in [0, chunkCount) and [begin, end) is the chunk's item range.  It
+//returns the number of chunks used, so callers can size per-chunk results
+//with getParallelThreadCount beforehand.
+template<typename Function>
+int parallelForChunks(long long itemCount, Function function,
+                      long long minItemsPerThread = 10000)
+{
+    int chunkCount = getParallelThreadCount(itemCount, minItemsPerThread);
+    if (chunkCount == 1)
+    {
+        function(0, 0LL, std::max(0LL, itemCount));
+        return 1;
+    }
+
+    long long chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+    std::vector<std::thread> threads;
+    threads.reserve(chunkCount - 1);
+    for (int chunk = 1; chunk < chunkCount; ++chunk)
+    {
+        long long begin = std::min(itemCount, chunk * chunkSize);
+        long long end = std::min(itemCount, begin + chunkSize);
+        threads.push_back(std::thread(function, chunk, begin, end));
+    }
+    function(0, 0LL, std::min(itemCount, chunkSize));
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    return chunkCount;
+}
+
+#endif // PARALLEL_H
@@ -83,6 +83,7 @@ public:
     double minTotalGraphLength;
     IntSetting graphLayoutQuality;
     bool linearLayout;
+    bool coarseLayout;
     FloatSetting minimumNodeLength;
     FloatSetting edgeLength;
     FloatSetting doubleModeNodeSeparation;
@@ -0,0 +1,582 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+//This program times Bandage's main operations on synthetic data of a chosen
+//size and reports the results as JSON.  Each scenario runs in its own process
+//so its peak memory can be measured.  Given the JSON from an earlier run as a
+//baseline, it flags the scenarios which have become slower or larger.
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include "benchmarkdata.h"
+#include "../program/globals.h"
+#include "../program/settings.h"
+#include "../program/memory.h"
+#include "../program/gafparser.h"
+#include "../graph/assemblygraph.h"
+#include "../graph/debruijnnode.h"
+#include "../graph/graphlocation.h"
+#include "../graph/path.h"
+#include "../blast/blastsearch.h"
+#include "../ui/mygraphicsview.h"
+#include "../ogdf/basic/Graph.h"
+#include "../ogdf/energybased/FMMMLayout.h"
+#include "../ogdf/internal/energybased/NMM.h"
+#include "../ogdf/internal/energybased/BarnesHut.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+
+const char * const scenarioNames[] = {"load_gfa", "layout", "coarse_layout", "double_layout", "repulsion_nmm",
+                                     "repulsion_barnes_hut", "blast_hits", "path_search", "merge", "gaf_parse"};
+const int scenarioCount = 10;
+
+struct BenchmarkOptions
+{
+    BenchmarkOptions() : scale(10000), seed(1), repeats(3), tolerance(0.2) {}
+    int scale;
+    unsigned int seed;
+    int repeats;
+    double tolerance;
+    QStringList scenarios;
+    QString dataDirectory;
+    QString outputFilename;
+    QString baselineFilename;
+    QString childScenario;
+};
+
+
+double getMilliseconds(const QElapsedTimer & timer)
+{
+    return timer.nsecsElapsed() / 1000000.0;
+}
+
+
+//This returns the peak resident set size of this process in kilobytes.
+long long getPeakRssKilobytes()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize / 1024;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+
+void printUsage(QTextStream * out)
+{
+    *out << "usage: BandageBenchmarks [options]" << "\n\n";
+    *out << "Times Bandage operations on synthetic data and writes the results as JSON." << "\n\n";
+    *out << "Options:  --scale <int>          Number of segments in the synthetic graph (default: 10000)" << "\n";
+    *out << "          --seed <int>           Seed for the synthetic data (default: 1)" << "\n";
+    *out << "          --repeats <int>        Runs of each scenario, of which the fastest is reported (default: 3)" << "\n";
+    *out << "          --scenarios <list>     Comma-separated scenarios to run (default: all)" << "\n";
+    *out << "          --data <dir>           Directory for the synthetic data (default: a temporary directory)" << "\n";
+    *out << "          --output <file>        Write the JSON results here instead of stdout" << "\n";
+    *out << "          --baseline <file>      JSON results from an earlier run to compare with" << "\n";
+    *out << "          --tolerance <float>    Allowed fractional increase in time or memory over the baseline (default: 0.2)" << "\n\n";
+    *out << "Scenarios: ";
+    for (int i = 0; i < scenarioCount; ++i)
+        *out << (i > 0 ? ", " : "") << scenarioNames[i];
+    *out << "\n\n";
+    *out << "The exit code is 0 on success, 1 on error and 2 if a scenario regressed against the baseline." << "\n";
+}
+
+
+bool parseOptions(QStringList arguments, BenchmarkOptions * options, QString * error)
+{
+    for (int i = 0; i < arguments.size(); ++i)
+    {
+        QString option = arguments[i];
+        if (i + 1 >= arguments.size())
+        {
+            *error = option + " must be followed by a value";
+            return false;
+        }
+        QString value = arguments[++i];
+        bool ok = true;
+        if (option == "--scale")
+            options->scale = value.toInt(&ok);
+        else if (option == "--seed")
+            options->seed = value.toUInt(&ok);
+        else if (option == "--repeats")
+            options->repeats = value.toInt(&ok);
+        else if (option == "--tolerance")
+            options->tolerance = value.toDouble(&ok);
+        else if (option == "--scenarios")
+            options->scenarios = value.split(",", Qt::SkipEmptyParts);
+        else if (option == "--data")
+            options->dataDirectory = value;
+        else if (option == "--output")
+            options->outputFilename = value;
+        else if (option == "--baseline")
+            options->baselineFilename = value;
+        else if (option == "--run-scenario")
+            options->childScenario = value;
+        else
+        {
+            *error = "unknown option " + option;
+            return false;
+        }
+        if (!ok || options->scale < 10 || options->repeats < 1 || options->tolerance < 0.0)
+        {
+            *error = "invalid value for " + option + ": " + value;
+            return false;
+        }
+    }
+
+    if (options->scenarios.isEmpty())
+    {
+        for (int i = 0; i < scenarioCount; ++i)
+            options->scenarios << scenarioNames[i];
+    }
+    for (int i = 0; i < options->scenarios.size(); ++i)
+    {
+        if (std::find(scenarioNames, scenarioNames + scenarioCount, options->scenarios[i]) == scenarioNames + scenarioCount)
+        {
+            *error = "unknown scenario " + options->scenarios[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//The amount of each kind of data depends on the scale (the segment count).
+//Each kind has its own seed, so changing one doesn't change the others.
+std::vector<SyntheticQuery> getBlastQueries(const SyntheticAssembly & assembly, const BenchmarkOptions & options)
+{
+    return assembly.makeQueries(std::max(10, options.scale / 100), 500, 5000, options.seed + 1);
+}
+
+std::vector<SyntheticQuery> getGafQueries(const SyntheticAssembly & assembly, const BenchmarkOptions & options)
+{
+    return assembly.makeQueries(options.scale, 200, 3000, options.seed + 2);
+}
+
+std::vector<SyntheticQuery> getPathSearchQueries(const SyntheticAssembly & assembly, const BenchmarkOptions & options)
+{
+    return assembly.makeQueries(std::min(200, options.scale / 10), 1000, 3000, options.seed + 3);
+}
+
+
+bool writeBenchmarkData(const BenchmarkOptions & options, QString * error)
+{
+    SyntheticAssembly assembly(options.scale, options.seed);
+    QDir data(options.dataDirectory);
+    if (!assembly.writeGfa(data.filePath("graph.gfa")) ||
+            !assembly.writeFasta(data.filePath("queries.fasta"), getBlastQueries(assembly, options)) ||
+            !assembly.writeGaf(data.filePath("alignments.gaf"), getGafQueries(assembly, options)))
+    {
+        *error = "could not write the synthetic data to " + options.dataDirectory;
+        return false;
+    }
+    return true;
+}
+
+
+void resetGlobals()
+{
+    g_settings.reset(new Settings());
+    g_memory.reset(new Memory());
+    g_blastSearch.reset(new BlastSearch());
+    g_assemblyGraph.reset(new AssemblyGraph());
+    if (g_graphicsView == 0)
+        g_graphicsView = new MyGraphicsView();
+}
+
+
+//This runs a scenario once.  Only the operation being benchmarked is timed,
+//not the loading and other setup it needs.
+bool runScenarioOnce(QString scenario, const BenchmarkOptions & options,
+                     double * milliseconds, long long * itemCount, QString * error)
+{
+    resetGlobals();
+    QDir data(options.dataDirectory);
+    QString graphFilename = data.filePath("graph.gfa");
+    QElapsedTimer timer;
+
+    if (scenario == "load_gfa")
+    {
+        timer.start();
+        bool loaded = g_assemblyGraph->loadGraphFromFile(graphFilename);
+        *milliseconds = getMilliseconds(timer);
+        *itemCount = g_assemblyGraph->m_deBruijnGraphNodes.size() / 2;
+        if (!loaded)
+            *error = "could not load " + graphFilename;
+        return loaded;
+    }
+
+    //The repulsion scenarios time one calculation of the repulsive forces
+    //between nodes at random positions, one node per segment, without the
+    //rest of the layout.
+    if (scenario == "repulsion_nmm" || scenario == "repulsion_barnes_hut")
+    {
+        ogdf::Graph graph;
+        for (int i = 0; i < options.scale; ++i)
+            graph.newNode();
+        ogdf::NodeArray<ogdf::NodeAttributes> attributes(graph);
+        ogdf::NodeArray<ogdf::DPoint> forces(graph);
+        ogdf::node v;
+        unsigned int random = options.seed + 4;
+        forall_nodes(v, graph)
+        {
+            random = random * 1103515245 + 12345;
+            double x = (random >> 8) % 100000 / 100.0;
+            random = random * 1103515245 + 12345;
+            double y = (random >> 8) % 100000 / 100.0;
+            attributes[v].set_position(ogdf::DPoint(x, y));
+        }
+
+        if (scenario == "repulsion_nmm")
+        {
+            ogdf::NMM nmm;
+            nmm.make_initialisations(graph, 1002.0, ogdf::DPoint(-1.0, -1.0), 25, 4,
+                                     ogdf::FMMMLayout::rtcSubtreeBySubtree, ogdf::FMMMLayout::scfIteratively);
+            timer.start();
+            nmm.calculate_repulsive_forces(graph, attributes, forces);
+            *milliseconds = getMilliseconds(timer);
+            nmm.deallocate_memory();
+        }
+        else
+        {
+            ogdf::BarnesHut barnesHut;
+            barnesHut.make_initialisations(graph, 0.5, 16);
+            timer.start();
+            barnesHut.calculate_repulsive_forces(graph, attributes, forces);
+            *milliseconds = getMilliseconds(timer);
+            barnesHut.deallocate_memory();
+        }
+        *itemCount = options.scale;
+        return true;
+    }
+
+    if (!g_assemblyGraph->loadGraphFromFile(graphFilename))
+    {
+        *error = "could not load " + graphFilename;
+        return false;
+    }
+
+    //The coarse layout lays out one node per chain of segments before
+    //expanding the chains, so it is timed on the same graph as the full one.
+    //In double mode both strands are drawn, which usually doubles the number
+    //of components the layout spreads over its threads.
+    if (scenario == "layout" || scenario == "coarse_layout" || scenario == "double_layout")
+    {
+        QString errorTitle;
+        QString errorMessage;
+        g_settings->graphScope = WHOLE_GRAPH;
+        g_settings->coarseLayout = (scenario == "coarse_layout");
+        g_settings->doubleMode = (scenario == "double_layout");
+        timer.start();
+        std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
+                                                                                      g_settings->doubleMode, "", "");
+        g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+        g_assemblyGraph->layoutGraph();
+        *milliseconds = getMilliseconds(timer);
+        *itemCount = g_assemblyGraph->m_ogdfGraph->numberOfNodes();
+    }
+
+    else if (scenario == "blast_hits")
+    {
+        SyntheticAssembly assembly(options.scale, options.seed);
+        g_blastSearch->loadBlastQueriesFromFastaFile(data.filePath("queries.fasta"));
+        g_blastSearch->m_blastOutput = assembly.makeBlastOutput(getBlastQueries(assembly, options));
+        timer.start();
+        g_blastSearch->buildHitsFromBlastOutput();
+        g_blastSearch->findQueryPaths();
+        *milliseconds = getMilliseconds(timer);
+        *itemCount = g_blastSearch->m_allHits.size();
+    }
+
+    //Each search is between the ends of a walk through the graph, so there is
+    //always at least one path to find.
+    else if (scenario == "path_search")
+    {
+        SyntheticAssembly assembly(options.scale, options.seed);
+        std::vector<SyntheticQuery> queries = getPathSearchQueries(assembly, options);
+        timer.start();
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            const SyntheticQuery & query = queries[i];
+            DeBruijnNode * startNode = g_assemblyGraph->m_deBruijnGraphNodes[assembly.getSegmentName(query.parts.front().segment) + "+"];
+            DeBruijnNode * endNode = g_assemblyGraph->m_deBruijnGraphNodes[assembly.getSegmentName(query.parts.back().segment) + "+"];
+            Path::getAllPossiblePaths(GraphLocation::startOfNode(startNode), GraphLocation::endOfNode(endNode),
+                                      int(query.parts.size()) + 1, 0, 2 * int(query.sequence.length()) + 4000);
+        }
+        *milliseconds = getMilliseconds(timer);
+        *itemCount = queries.size();
+    }
+
+    else if (scenario == "merge")
+    {
+        *itemCount = g_assemblyGraph->m_deBruijnGraphNodes.size();
+        timer.start();
+        g_assemblyGraph->mergeAllPossible();
+        *milliseconds = getMilliseconds(timer);
+    }
+
+    else if (scenario == "gaf_parse")
+    {
+        timer.start();
+        GafParseResult result = parseGafFile(data.filePath("alignments.gaf"));
+        *milliseconds = getMilliseconds(timer);
+        *itemCount = result.alignments.size();
+    }
+
+    return true;
+}
+
+
+//This is what each child process does: run one scenario a few times and
+//print its result as a line of JSON.
+int runChildScenario(const BenchmarkOptions & options)
+{
+    QTextStream out(stdout);
+    QJsonObject result;
+    result["scenario"] = options.childScenario;
+    result["scale"] = options.scale;
+    result["seed"] = double(options.seed);
+    result["repeats"] = options.repeats;
+
+    double fastestMilliseconds = 0.0;
+    double totalMilliseconds = 0.0;
+    long long itemCount = 0;
+    for (int i = 0; i < options.repeats; ++i)
+    {
+        double milliseconds = 0.0;
+        QString error;
+        if (!runScenarioOnce(options.childScenario, options, &milliseconds, &itemCount, &error))
+        {
+            result["error"] = error;
+            out << QJsonDocument(result).toJson(QJsonDocument::Compact) << "\n";
+            return 1;
+        }
+        if (i == 0 || milliseconds < fastestMilliseconds)
+            fastestMilliseconds = milliseconds;
+        totalMilliseconds += milliseconds;
+    }
+
+    result["wall_ms"] = fastestMilliseconds;
+    result["mean_ms"] = totalMilliseconds / options.repeats;
+    result["peak_rss_kb"] = double(getPeakRssKilobytes());
+    result["items"] = double(itemCount);
+    result["throughput_per_s"] = (fastestMilliseconds > 0.0) ? itemCount / (fastestMilliseconds / 1000.0) : 0.0;
+    out << QJsonDocument(result).toJson(QJsonDocument::Compact) << "\n";
+    return 0;
+}
+
+
+QJsonObject runScenarioInChildProcess(QString scenario, const BenchmarkOptions & options)
+{
+    QStringList arguments;
+    arguments << "--run-scenario" << scenario << "--scale" << QString::number(options.scale)
+              << "--seed" << QString::number(options.seed) << "--repeats" << QString::number(options.repeats)
+              << "--data" << options.dataDirectory;
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(QCoreApplication::applicationFilePath(), arguments);
+    process.waitForFinished(-1);
+
+    QList<QByteArray> lines = process.readAllStandardOutput().trimmed().split('\n');
+    QJsonObject result = QJsonDocument::fromJson(lines.last()).object();
+    if (result.isEmpty())
+    {
+        result["scenario"] = scenario;
+        result["error"] = "the scenario's process did not report a result";
+    }
+    return result;
+}
+
+
+//This marks each result which is slower, or has a larger peak memory, than
+//the same scenario at the same scale in the baseline by more than the
+//tolerance, and returns how many were marked.
+int compareWithBaseline(QJsonArray * results, const QJsonArray & baselineResults,
+                        double tolerance, QTextStream * err)
+{
+    int regressionCount = 0;
+    for (int i = 0; i < results->size(); ++i)
+    {
+        QJsonObject result = (*results)[i].toObject();
+        if (result.contains("error"))
+            continue;
+
+        QJsonObject baseline;
+        for (int j = 0; j < baselineResults.size(); ++j)
+        {
+            QJsonObject candidate = baselineResults[j].toObject();
+            if (candidate.value("scenario") == result.value("scenario") &&
+                    candidate.value("scale") == result.value("scale") &&
+                    !candidate.contains("error"))
+                baseline = candidate;
+        }
+        if (baseline.isEmpty())
+        {
+            *err << result["scenario"].toString() << ": not in the baseline" << "\n";
+            continue;
+        }
+
+        double wallChange = result.value("wall_ms").toDouble() / baseline.value("wall_ms").toDouble() - 1.0;
+        double rssChange = result.value("peak_rss_kb").toDouble() / baseline.value("peak_rss_kb").toDouble() - 1.0;
+        bool regression = (wallChange > tolerance || rssChange > tolerance);
+        if (regression)
+            ++regressionCount;
+
+        result["baseline_wall_ms"] = baseline.value("wall_ms");
+        result["baseline_peak_rss_kb"] = baseline.value("peak_rss_kb");
+        result["wall_change"] = wallChange;
+        result["peak_rss_change"] = rssChange;
+        result["regression"] = regression;
+        results->replace(i, result);
+
+        *err << result["scenario"].toString() << ": time " << QString::number(wallChange * 100.0, 'f', 1)
+             << "%, peak RSS " << QString::number(rssChange * 100.0, 'f', 1) << "%"
+             << (regression ? "  REGRESSION" : "") << "\n";
+    }
+    return regressionCount;
+}
+
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    qputenv("QT_QPA_PLATFORM", QByteArrayLiteral("minimal"));
+    QApplication application(argc, argv);
+    QStringList arguments = QCoreApplication::arguments();
+    arguments.pop_front();
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (arguments.contains("--help") || arguments.contains("-h"))
+    {
+        printUsage(&out);
+        return 0;
+    }
+
+    BenchmarkOptions options;
+    QString error;
+    if (!parseOptions(arguments, &options, &error))
+    {
+        err << "BandageBenchmarks error: " << error << "\n";
+        return 1;
+    }
+
+    if (!options.childScenario.isEmpty())
+        return runChildScenario(options);
+
+    QJsonArray baselineResults;
+    if (!options.baselineFilename.isEmpty())
+    {
+        QFile baselineFile(options.baselineFilename);
+        if (!baselineFile.open(QIODevice::ReadOnly))
+        {
+            err << "BandageBenchmarks error: could not read " << options.baselineFilename << "\n";
+            return 1;
+        }
+        baselineResults = QJsonDocument::fromJson(baselineFile.readAll()).object()["results"].toArray();
+    }
+
+    QTemporaryDir temporaryDirectory;
+    if (options.dataDirectory.isEmpty())
+        options.dataDirectory = temporaryDirectory.path();
+    else
+        QDir().mkpath(options.dataDirectory);
+    err << "Writing synthetic data (" << options.scale << " segments)..." << Qt::endl;
+    if (!writeBenchmarkData(options, &error))
+    {
+        err << "BandageBenchmarks error: " << error << "\n";
+        return 1;
+    }
+
+    QJsonArray results;
+    bool failed = false;
+    for (int i = 0; i < options.scenarios.size(); ++i)
+    {
+        QJsonObject result = runScenarioInChildProcess(options.scenarios[i], options);
+        if (result.contains("error"))
+        {
+            failed = true;
+            err << options.scenarios[i] << ": " << result["error"].toString() << Qt::endl;
+        }
+        else
+            err << options.scenarios[i] << ": " << QString::number(result["wall_ms"].toDouble(), 'f', 1) << " ms, "
+                << result["peak_rss_kb"].toDouble() << " KB peak RSS" << Qt::endl;
+        results.append(result);
+    }
+
+    QJsonObject summary;
+    summary["scale"] = options.scale;
+    summary["seed"] = double(options.seed);
+    summary["repeats"] = options.repeats;
+    if (!options.baselineFilename.isEmpty())
+    {
+        summary["baseline"] = options.baselineFilename;
+        summary["tolerance"] = options.tolerance;
+        summary["regression_count"] = compareWithBaseline(&results, baselineResults, options.tolerance, &err);
+    }
+    summary["results"] = results;
+    QByteArray summaryJson = QJsonDocument(summary).toJson(QJsonDocument::Indented);
+
+    if (options.outputFilename.isEmpty())
+        out << summaryJson;
+    else
+    {
+        QFile outputFile(options.outputFilename);
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            err << "BandageBenchmarks error: could not write " << options.outputFilename << "\n";
+            return 1;
+        }
+        outputFile.write(summaryJson);
+    }
+
+    if (failed)
+        return 1;
+    if (summary["regression_count"].toInt() > 0)
+        return 2;
+    return 0;
+}
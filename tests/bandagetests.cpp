@@ -20,6 +20,10 @@
 #include <QDebug>
 #include "ogdf/basic/Graph.h"
 #include "ogdf/basic/GraphAttributes.h"
+#include "ogdf/energybased/FMMMLayout.h"
+#include "ogdf/internal/energybased/BarnesHut.h"
+#include "ogdf/internal/energybased/NMM.h"
+#include "ogdf/internal/energybased/FruchtermanReingold.h"
 #include "../graph/assemblygraph.h"
 #include "../program/settings.h"
 #include "../blast/blastsearch.h"
@@ -27,6 +31,21 @@
 #include "../program/memory.h"
 #include "../graph/debruijnnode.h"
 #include "../graph/debruijnedge.h"
+#include "../graph/contiguitysearch.h"
+#include "../graph/ogdfnode.h"
+#include "../program/graphloadworker.h"
+#include "../program/graphlayoutworker.h"
+#include "../command_line/batch.h"
+#include "../command_line/serve.h"
+#include "../command_line/gafseq.h"
+#include "../command_line/findseq.h"
+#include "../program/gafcoverage.h"
+#include "../ui/mygraphicsscene.h"
+#include "../graph/graphicsitemnode.h"
+#include "../graph/graphicsitemedge.h"
+#include "../graph/graphwriter.h"
+#include <limits>
+#include <thread>
 #include "../program/globals.h"
 #include "../command_line/commoncommandlinefunctions.h"
 
@@ -45,6 +64,7 @@ private slots:
     void graphLocationFunctions();
     void loadCsvData();
     void loadCsvDataTrinity();
+    void loadCsvDataColumns();
     void blastSearch();
     void blastSearchFilters();
     void graphScope();
@@ -54,10 +74,34 @@ private slots:
     void velvetToGfa();
     void spadesToGfa();
     void mergeNodesOnGfa();
+    void unitigMerges();
     void changeNodeNames();
     void changeNodeDepths();
     void blastQueryPaths();
     void bandageInfo();
+    void graphStatistics();
+    void contiguitySearch();
+    void incrementalScopeExpansion();
+    void nodeDistances();
+    void coarseLayout();
+    void backgroundGraphLoad();
+    void separateGraphs();
+    void batchCommand();
+    void serveRequests();
+    void selectionStatistics();
+    void dragSelectedNodes();
+    void parallelComponentLayout();
+    void barnesHutRepulsion();
+    void progressiveLayout();
+    void graphWriter();
+    void pathSequenceStreaming();
+    void gafSeqCommand();
+    void gafCoverage();
+    void partialNodeNameSearch();
+    void blastHitIndex();
+    void blastHitPathCache();
+    void sequenceSearch();
+    void sequenceSearchAcrossJunctions();
 
 
 private:
@@ -68,6 +112,9 @@ private:
     DeBruijnEdge * getEdgeFromNodeNames(QString startingNodeName,
                                         QString endingNodeName);
     bool doCircularSequencesMatch(QByteArray s1, QByteArray s2);
+    bool loadGfa(QByteArray gfaLines);
+    QStringList getPositiveNodeSequences();
+    QStringList getEdgeNames();
 };
 
 
@@ -153,7 +200,7 @@ void BandageTests::pathFunctionsOnLastGraph()
     DeBruijnNode * node14Minus = g_assemblyGraph->m_deBruijnGraphNodes["14+"];
     DeBruijnNode * node7Plus = g_assemblyGraph->m_deBruijnGraphNodes["7+"];
 
-    QCOMPARE(testPath1.getLength(), 10);
+    QCOMPARE(testPath1.getLength(), 10LL);
     QCOMPARE(testPath1.getPathSequence(), QByteArray("GACCTATAGA"));
     QCOMPARE(testPath1.isEmpty(), false);
     QCOMPARE(testPath1.isCircular(), false);
@@ -191,8 +238,8 @@ void BandageTests::pathFunctionsOnFastg()
     QString pathStringFailure;
     Path testPath1 = Path::makeFromString("(50234) 6+, 26+, 23+, 26+, 24+ (200)", false, &pathStringFailure);
     Path testPath2 = Path::makeFromString("26+, 23+", true, &pathStringFailure);
-    QCOMPARE(testPath1.getLength(), 1764);
-    QCOMPARE(testPath2.getLength(), 1387);
+    QCOMPARE(testPath1.getLength(), 1764LL);
+    QCOMPARE(testPath2.getLength(), 1387LL);
     QCOMPARE(testPath1.isCircular(), false);
     QCOMPARE(testPath2.isCircular(), true);
 }
@@ -422,6 +469,82 @@ void BandageTests::loadCsvDataTrinity()
     QCOMPARE(node3940Plus->getCsvLine(0), QString("3940PLUS"));
 }
 
+void BandageTests::loadCsvDataColumns()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QString csvFilename = tempDir.filePath("columns.csv");
+    QFile csvFile(csvFilename);
+    QVERIFY(csvFile.open(QIODevice::WriteOnly));
+    csvFile.write("Node name,Length,Group,,Colour\r\n"
+                  "6+,100,\"a, b\",x,red\r\n"
+                  "6-,200,\"say \"\"hi\"\"\",x,catA\r\n"
+                  "7+,,\"a, b\",x,catB\r\n"
+                  "4+,3.5,c,x,catA\r\n"
+                  "NOT_A_NODE,1,d,x,catC\r\n");
+    csvFile.close();
+
+    QString errormsg;
+    QStringList columns;
+    bool coloursLoaded = false;
+    QVERIFY(g_assemblyGraph->loadCSV(csvFilename, &columns, &errormsg, &coloursLoaded));
+    QCOMPARE(columns, QStringList() << "Length" << "Group" << "Colour");
+    QCOMPARE(coloursLoaded, true);
+    QCOMPARE(errormsg, QString("There were 1 unmatched entries in the CSV."));
+
+    DeBruijnNode * node6Plus = g_assemblyGraph->m_deBruijnGraphNodes.value("6+");
+    DeBruijnNode * node6Minus = g_assemblyGraph->m_deBruijnGraphNodes.value("6-");
+    DeBruijnNode * node7Plus = g_assemblyGraph->m_deBruijnGraphNodes.value("7+");
+    DeBruijnNode * node4Plus = g_assemblyGraph->m_deBruijnGraphNodes.value("4+");
+    DeBruijnNode * node5Plus = g_assemblyGraph->m_deBruijnGraphNodes.value("5+");
+
+    //Quoted fields can hold the separator and escaped quotes.
+    QCOMPARE(node6Plus->getCsvLine(1), QString("a, b"));
+    QCOMPARE(node6Minus->getCsvLine(1), QString("say \"hi\""));
+    QCOMPARE(node4Plus->getAllCsvData(), QStringList() << "3.5" << "c" << "catA");
+    QCOMPARE(node5Plus->hasCsvData(), false);
+    QCOMPARE(node5Plus->getCsvLine(0), QString(""));
+
+    //Each column stores its distinct values once, and the unmatched line
+    //still has a row.
+    const CsvTable & table = g_assemblyGraph->getCsvTable();
+    QCOMPARE(table.getRowCount(), 5);
+    QCOMPARE(int(table.getDistinctValues(1).size()), 4);
+    QCOMPARE(int(table.getDistinctValues(2).size()), 4);
+    QCOMPARE(table.getValueId(node6Plus->getCsvRow(), 1), table.getValueId(node7Plus->getCsvRow(), 1));
+
+    //Colour names are used directly and other values are given a colour
+    //per category.
+    QCOMPARE(node6Plus->getCustomColour(), QColor("red"));
+    QCOMPARE(node6Minus->getCustomColour(), node4Plus->getCustomColour());
+    QVERIFY(node6Minus->getCustomColour() != node7Plus->getCustomColour());
+
+    //Loading a second CSV replaces the first, so a node which is only in the
+    //first file has no data rather than another node's row.
+    QString secondCsvFilename = tempDir.filePath("second.csv");
+    QFile secondCsvFile(secondCsvFilename);
+    QVERIFY(secondCsvFile.open(QIODevice::WriteOnly));
+    secondCsvFile.write("Node name,Label\n"
+                        "4+,four\n");
+    secondCsvFile.close();
+    coloursLoaded = false;
+    QVERIFY(g_assemblyGraph->loadCSV(secondCsvFilename, &columns, &errormsg, &coloursLoaded));
+    QCOMPARE(columns, QStringList() << "Label");
+    QCOMPARE(g_assemblyGraph->getCsvTable().getRowCount(), 1);
+    QCOMPARE(node4Plus->getAllCsvData(), QStringList() << "four");
+    QCOMPARE(node6Plus->hasCsvData(), false);
+    QCOMPARE(node6Plus->getCsvLine(0), QString(""));
+    QCOMPARE(node6Minus->hasCsvData(), false);
+    QCOMPARE(node7Plus->hasCsvData(), false);
+
+    g_assemblyGraph->clearAllCsvData();
+    QCOMPARE(node4Plus->hasCsvData(), false);
+    QCOMPARE(g_assemblyGraph->getCsvTable().getRowCount(), 0);
+}
+
 void BandageTests::blastSearch()
 {
     createGlobals();
@@ -1238,7 +1361,7 @@ void BandageTests::mergeNodesOnGfa()
     //If we make a circular path with this node, its length should be equal to
     //the length of the path made before.
     Path testPath2 = Path::makeFromString(lastNode->getName(), true, &pathStringFailure);
-    QCOMPARE(path1Length, testPath2.getLength());
+    QCOMPARE((long long)path1Length, testPath2.getLength());
 
     //The sequence of this second path should also match the sequence of the
     //first path.
@@ -1247,6 +1370,112 @@ void BandageTests::mergeNodesOnGfa()
 }
 
 
+//These graphs have edges without overlaps, so each merged sequence is just
+//the node sequences joined together.
+void BandageTests::unitigMerges()
+{
+    QByteArray a = "AACCAACC", b = "GGTAGGTA", c = "TTACTTAC", d = "CAGTCAGA";
+    QByteArray e = "GACTGACA", f = "ATCCATCG", g = "TGGATGGC";
+
+    //A circular chain becomes one node with a loop edge.
+    createGlobals();
+    QVERIFY(loadGfa("S\t1\t" + a + "\nS\t2\t" + b + "\n"
+                    "L\t1\t+\t2\t+\t0M\nL\t2\t+\t1\t+\t0M\n"));
+    QCOMPARE(g_assemblyGraph->mergeAllPossible(), 1);
+    QCOMPARE(getPositiveNodeSequences(), QStringList() << "1_2+ " + a + b);
+    QCOMPARE(getEdgeNames(), QStringList() << "1_2+>1_2+" << "1_2->1_2-");
+
+    //A chain which is its own reverse complement (1+, 2+, 2-, 1-) is merged
+    //up to its middle, and the edge there joins the new node to its reverse
+    //complement.
+    createGlobals();
+    QVERIFY(loadGfa("S\t1\t" + a + "\nS\t2\t" + b + "\n"
+                    "L\t1\t+\t2\t+\t0M\nL\t2\t+\t2\t-\t0M\n"));
+    QCOMPARE(g_assemblyGraph->mergeAllPossible(), 1);
+    QCOMPARE(getPositiveNodeSequences(), QStringList() << "1_2+ " + a + b);
+    QCOMPARE(getEdgeNames(), QStringList() << "1_2+>1_2-");
+
+    //Chains which start at the same branching node and end at the same
+    //joining node are joined to each other's merged nodes.
+    QByteArray branchingGraph = "S\t1\t" + a + "\nS\t2\t" + b + "\nS\t3\t" + c + "\nS\t4\t" + d + "\n"
+            "S\t5\t" + e + "\nS\t6\t" + f + "\nS\t7\t" + g + "\n"
+            "L\t1\t+\t2\t+\t0M\nL\t2\t+\t3\t+\t0M\nL\t2\t+\t5\t+\t0M\nL\t3\t+\t4\t+\t0M\n"
+            "L\t5\t+\t6\t+\t0M\nL\t4\t+\t7\t+\t0M\nL\t6\t+\t7\t+\t0M\n";
+    QStringList branchingNodes;
+    branchingNodes << "1_2+ " + a + b << "3_4+ " + c + d << "5_6+ " + e + f << "7+ " + g;
+    QStringList branchingEdges;
+    branchingEdges << "1_2+>3_4+" << "1_2+>5_6+" << "3_4+>7+" << "5_6+>7+"
+                   << "3_4->1_2-" << "5_6->1_2-" << "7->3_4-" << "7->5_6-";
+    branchingEdges.sort();
+    createGlobals();
+    QVERIFY(loadGfa(branchingGraph));
+    QCOMPARE(g_assemblyGraph->mergeAllPossible(), 3);
+    QCOMPARE(getPositiveNodeSequences(), branchingNodes);
+    QCOMPARE(getEdgeNames(), branchingEdges);
+
+    //A merged name which is already taken gets a suffix, unless the node with
+    //that name is itself replaced by an earlier merge.
+    createGlobals();
+    QVERIFY(loadGfa("S\t0\t" + a + "\nS\t1\t" + b + "\nS\t2\t" + c + "\nS\t1_2\t" + d + "\n"
+                    "S\t3\t" + e + "\nS\t4\t" + f + "\nS\t3_4\t" + g + "\n"
+                    "L\t0\t+\t1_2\t+\t0M\nL\t1\t+\t2\t+\t0M\nL\t3\t+\t4\t+\t0M\n"));
+    QCOMPARE(g_assemblyGraph->mergeAllPossible(), 3);
+    QCOMPARE(getPositiveNodeSequences(), QStringList() << "0_1_2+ " + a + d << "1_2+ " + b + c
+                                                       << "3_4+ " + g << "3_4_2+ " + e + f);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 8);
+    QVERIFY(getEdgeNames().isEmpty());
+
+    //When the graph is drawn, the merged nodes take over the line points of
+    //the nodes they replace, and every remaining item refers to a node or
+    //edge still in the graph.
+    createGlobals();
+    QVERIFY(loadGfa(branchingGraph));
+    QString errorTitle;
+    QString errorMessage;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
+                                                                                  g_settings->doubleMode, "", "all");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+    QPointF node1First = g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getGraphicsItemNode()->getFirst();
+    QPointF node2Last = g_assemblyGraph->m_deBruijnGraphNodes["2+"]->getGraphicsItemNode()->getLast();
+
+    QCOMPARE(g_assemblyGraph->mergeAllPossible(&scene), 3);
+    QCOMPARE(getPositiveNodeSequences(), branchingNodes);
+    QCOMPARE(getEdgeNames(), branchingEdges);
+    GraphicsItemNode * mergedItem = g_assemblyGraph->m_deBruijnGraphNodes["1_2+"]->getGraphicsItemNode();
+    QVERIFY(mergedItem != 0);
+    QCOMPARE(mergedItem->getFirst(), node1First);
+    QCOMPARE(mergedItem->getLast(), node2Last);
+
+    int nodeItemCount = 0;
+    int edgeItemCount = 0;
+    QList<QGraphicsItem *> items = scene.items();
+    for (int i = 0; i < items.size(); ++i)
+    {
+        GraphicsItemNode * nodeItem = dynamic_cast<GraphicsItemNode *>(items[i]);
+        if (nodeItem != 0)
+        {
+            ++nodeItemCount;
+            DeBruijnNode * node = nodeItem->m_deBruijnNode;
+            QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.value(node->getName()), node);
+            QCOMPARE(node->getGraphicsItemNode(), nodeItem);
+        }
+        GraphicsItemEdge * edgeItem = dynamic_cast<GraphicsItemEdge *>(items[i]);
+        if (edgeItem != 0)
+        {
+            ++edgeItemCount;
+            DeBruijnEdge * edge = edgeItem->m_deBruijnEdge;
+            QCOMPARE(getEdgeFromNodeNames(edge->getStartingNode()->getName(), edge->getEndingNode()->getName()), edge);
+            QCOMPARE(edge->getGraphicsItemEdge(), edgeItem);
+        }
+    }
+    QCOMPARE(nodeItemCount, 4);
+    QCOMPARE(edgeItemCount, 4);
+}
+
+
 
 void BandageTests::changeNodeNames()
 {
@@ -1481,19 +1710,1637 @@ void BandageTests::bandageInfo()
 }
 
 
+//The graph statistics use selection instead of sorting, so this test checks
+//them against values from a full sort, and checks that the cached statistics
+//are replaced when the graph changes.
+void BandageTests::graphStatistics()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    std::vector<int> nodeLengths;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        if (i.value()->isPositiveNode())
+            nodeLengths.push_back(i.value()->getLength());
+    }
+    std::sort(nodeLengths.begin(), nodeLengths.end());
+
+    const GraphStatistics & stats = g_assemblyGraph->getGraphStatistics();
+    QCOMPARE(stats.nodeCount, 44);
+    QCOMPARE(stats.totalLength, 214441LL);
+    QCOMPARE(stats.shortestNode, nodeLengths.front());
+    QCOMPARE(stats.longestNode, nodeLengths.back());
+    QCOMPARE(stats.median, int(round((nodeLengths[21] + nodeLengths[22]) / 2.0)));
+    QCOMPARE(stats.n50, 35628);
+    QCOMPARE(stats.componentCount, 1);
+    QCOMPARE(stats.deadEnds, 0);
+
+    //Deleting a node should invalidate the cached statistics.
+    DeBruijnNode * node = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    long long nodeLength = node->getLength();
+    std::vector<DeBruijnNode *> nodesToDelete;
+    nodesToDelete.push_back(node);
+    g_assemblyGraph->deleteNodes(&nodesToDelete);
+
+    const GraphStatistics & newStats = g_assemblyGraph->getGraphStatistics();
+    QCOMPARE(newStats.nodeCount, 43);
+    QCOMPARE(newStats.totalLength, 214441LL - nodeLength);
+}
+
+
+//The contiguity search remembers parts of the search to avoid repeating them,
+//but it should give the same results as checking every path.
+void BandageTests::contiguitySearch()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    ContiguitySearch search(g_assemblyGraph->getIndexedNodes(), 15);
+    DeBruijnNode * node1Pos = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    QCOMPARE(search.determineContiguity(node1Pos), true);
+
+    QCOMPARE(search.getContiguityStatus(node1Pos), STARTING);
+    QCOMPARE(search.getContiguityStatus(g_assemblyGraph->m_deBruijnGraphNodes["12-"]), CONTIGUOUS_STRAND_SPECIFIC);
+    QCOMPARE(search.getContiguityStatus(g_assemblyGraph->m_deBruijnGraphNodes["4-"]), CONTIGUOUS_STRAND_SPECIFIC);
+    QCOMPARE(search.getContiguityStatus(g_assemblyGraph->m_deBruijnGraphNodes["12+"]), CONTIGUOUS_EITHER_STRAND);
+    QCOMPARE(search.getContiguityStatus(g_assemblyGraph->m_deBruijnGraphNodes["33-"]), CONTIGUOUS_EITHER_STRAND);
+    QCOMPARE(search.getContiguityStatus(g_assemblyGraph->m_deBruijnGraphNodes["36+"]), NOT_CONTIGUOUS);
+
+    int statusCounts[5] = {0, 0, 0, 0, 0};
+    const std::vector<DeBruijnNode *> & nodes = g_assemblyGraph->getIndexedNodes();
+    for (size_t i = 0; i < nodes.size(); ++i)
+        ++statusCounts[search.getContiguityStatus(nodes[i])];
+    QCOMPARE(statusCounts[CONTIGUOUS_STRAND_SPECIFIC], 4);
+    QCOMPARE(statusCounts[CONTIGUOUS_EITHER_STRAND], 8);
+    QCOMPARE(statusCounts[MAYBE_CONTIGUOUS], 74);
+    QCOMPARE(statusCounts[NOT_CONTIGUOUS], 1);
+
+    //The results only go to the nodes when they are applied.
+    QCOMPARE(node1Pos->getContiguityStatus(), NOT_CONTIGUOUS);
+    search.applyStatuses();
+    QCOMPARE(node1Pos->getContiguityStatus(), STARTING);
+
+    //A search which runs out of budget stops early.
+    ContiguitySearch limitedSearch(g_assemblyGraph->getIndexedNodes(), 15, 100);
+    QCOMPARE(limitedSearch.determineContiguity(node1Pos), false);
+    QCOMPARE(limitedSearch.wasBudgetExceeded(), true);
+}
+
+
+void BandageTests::nodeDistances()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    DeBruijnNode * node1Pos = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    std::vector<DeBruijnNode *> startingNodes;
+    startingNodes.push_back(node1Pos);
+    std::vector<int> distances = g_assemblyGraph->getNodeDistances(startingNodes, 2);
+    const std::vector<DeBruijnNode *> & nodes = g_assemblyGraph->getIndexedNodes();
+    QCOMPARE(distances.size(), nodes.size());
+    QCOMPARE(distances[node1Pos->getId()], 0);
+
+    //Each node found must be one step further than its closest neighbour.
+    QSet<DeBruijnNode *> positiveNodesFound;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (distances[i] == -1)
+            continue;
+        QVERIFY(distances[i] <= 2);
+        positiveNodesFound.insert(nodes[i]->isPositiveNode() ? nodes[i] : nodes[i]->getReverseComplement());
+
+        int closestNeighbour = std::numeric_limits<int>::max();
+        const std::vector<DeBruijnEdge *> * edges = nodes[i]->getEdgesPointer();
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            int neighbourDistance = distances[(*edges)[j]->getOtherNode(nodes[i])->getId()];
+            if (neighbourDistance != -1)
+                closestNeighbour = std::min(closestNeighbour, neighbourDistance);
+        }
+        if (nodes[i] != node1Pos)
+            QCOMPARE(distances[i], closestNeighbour + 1);
+    }
+
+    //This matches the single mode node count for the same scope in the
+    //graphScope test.
+    QCOMPARE(positiveNodesFound.size(), 10);
+
+    //Multiple starting nodes are searched from together.
+    startingNodes.push_back(g_assemblyGraph->m_deBruijnGraphNodes["36+"]);
+    distances = g_assemblyGraph->getNodeDistances(startingNodes, 0);
+    int found = 0;
+    for (size_t i = 0; i < distances.size(); ++i)
+    {
+        if (distances[i] == 0)
+            ++found;
+    }
+    QCOMPARE(found, 2);
+}
+
+
+void BandageTests::coarseLayout()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = WHOLE_GRAPH;
+    g_settings->doubleMode = false;
+    g_settings->coarseLayout = true;
+
+    //Short segments make long chains, so some have segments between the ends
+    //that are relaxed.
+    g_settings->nodeSegmentLength = 2.0;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+
+    std::vector<std::vector<ogdf::node> > segmentChains = g_assemblyGraph->getOgdfSegmentChains();
+    QCOMPARE(int(segmentChains.size()), g_assemblyGraph->getDrawnNodeCount());
+
+    g_assemblyGraph->layoutGraph();
+
+    //Every node should have been expanded from its coarse position into a
+    //chain with separate ends.
+    for (size_t i = 0; i < segmentChains.size(); ++i)
+    {
+        QVERIFY(segmentChains[i].size() >= 2);
+        ogdf::node first = segmentChains[i].front();
+        ogdf::node last = segmentChains[i].back();
+        double x1 = g_assemblyGraph->m_graphAttributes->x(first);
+        double y1 = g_assemblyGraph->m_graphAttributes->y(first);
+        double x2 = g_assemblyGraph->m_graphAttributes->x(last);
+        double y2 = g_assemblyGraph->m_graphAttributes->y(last);
+        QVERIFY(qIsFinite(x1) && qIsFinite(y1) && qIsFinite(x2) && qIsFinite(y2));
+        QVERIFY(x1 != x2 || y1 != y2);
+    }
+
+    //Only the segments near the ends of each chain are relaxed, so the rest of
+    //each chain is still on the line it was expanded along.
+    int relaxedEndSize = GraphLayoutWorker::RELAXED_SEGMENTS_PER_CHAIN_END;
+    int straightChains = 0;
+    for (size_t i = 0; i < segmentChains.size(); ++i)
+    {
+        int chainSize = int(segmentChains[i].size());
+        if (chainSize < 2 * relaxedEndSize + 3)
+            continue;
+        ++straightChains;
+        ogdf::node first = segmentChains[i][relaxedEndSize];
+        ogdf::node last = segmentChains[i][chainSize - 1 - relaxedEndSize];
+        QLineF line(g_assemblyGraph->m_graphAttributes->x(first), g_assemblyGraph->m_graphAttributes->y(first),
+                    g_assemblyGraph->m_graphAttributes->x(last), g_assemblyGraph->m_graphAttributes->y(last));
+        for (int j = relaxedEndSize + 1; j < chainSize - 1 - relaxedEndSize; ++j)
+        {
+            ogdf::node middle = segmentChains[i][j];
+            QPointF offset = QPointF(g_assemblyGraph->m_graphAttributes->x(middle),
+                                     g_assemblyGraph->m_graphAttributes->y(middle)) - line.p1();
+            double cross = line.dx() * offset.y() - line.dy() * offset.x();
+            QVERIFY(qAbs(cross) <= 1e-6 * line.length() * line.length());
+        }
+    }
+    QVERIFY(straightChains > 0);
+}
+
+
+void BandageTests::incrementalScopeExpansion()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QString errorTitle;
+    QString errorMessage;
+    std::vector<DeBruijnNode *> startingNodes;
+
+    //Draw the full graph at a node distance of 2, to compare against.
+    g_settings->graphScope = AROUND_NODE;
+    g_settings->startingNodes = "1";
+    g_settings->nodeDistance = 2;
+    g_settings->doubleMode = false;
+    startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    int fullDrawnNodes = g_assemblyGraph->getDrawnNodeCount();
+    int fullOgdfNodes = g_assemblyGraph->m_ogdfGraph->numberOfNodes();
+    int fullOgdfEdges = g_assemblyGraph->m_ogdfGraph->numberOfEdges();
+
+    //Now draw at a distance of 1 and expand it to 2.
+    g_settings->nodeDistance = 1;
+    startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+    QVERIFY(g_assemblyGraph->getDrawnNodeCount() < fullDrawnNodes);
+
+    startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "", false);
+    QCOMPARE(g_assemblyGraph->canExpandOgdfGraph(startingNodes, 1), false);
+    QCOMPARE(g_assemblyGraph->canExpandOgdfGraph(startingNodes, 2), true);
+
+    ogdf::node node1Ogdf = g_assemblyGraph->m_deBruijnGraphNodes["1+"]->getOgdfNode()->getFirst();
+    double node1X = g_assemblyGraph->m_graphAttributes->x(node1Ogdf);
+    double node1Y = g_assemblyGraph->m_graphAttributes->y(node1Ogdf);
+
+    QSet<ogdf::node> pinnedOgdfNodes;
+    ogdf::node ogdfNode;
+    forall_nodes(ogdfNode, *g_assemblyGraph->m_ogdfGraph)
+        pinnedOgdfNodes.insert(ogdfNode);
+
+    g_settings->nodeDistance = 2;
+    g_assemblyGraph->expandOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    QCOMPARE(g_assemblyGraph->getDrawnNodeCount(), fullDrawnNodes);
+    QCOMPARE(g_assemblyGraph->m_ogdfGraph->numberOfNodes(), fullOgdfNodes);
+    QCOMPARE(g_assemblyGraph->m_ogdfGraph->numberOfEdges(), fullOgdfEdges);
+
+    //The nodes that were already drawn stay in place through the layout.
+    g_assemblyGraph->layoutGraph();
+    QCOMPARE(g_assemblyGraph->m_graphAttributes->x(node1Ogdf), node1X);
+    QCOMPARE(g_assemblyGraph->m_graphAttributes->y(node1Ogdf), node1Y);
+
+    //The new nodes are refined from where they were placed, beside the
+    //pinned nodes they connect to, so they stay near them.
+    double maxNeighbourDistance = 3.0 * (g_settings->edgeLength + g_settings->nodeSegmentLength);
+    int pinnedToNewEdges = 0;
+    ogdf::edge ogdfEdge;
+    forall_edges(ogdfEdge, *g_assemblyGraph->m_ogdfGraph)
+    {
+        ogdf::node source = ogdfEdge->source();
+        ogdf::node target = ogdfEdge->target();
+        if (pinnedOgdfNodes.contains(source) == pinnedOgdfNodes.contains(target))
+            continue;
+        ++pinnedToNewEdges;
+        QLineF line(g_assemblyGraph->m_graphAttributes->x(source), g_assemblyGraph->m_graphAttributes->y(source),
+                    g_assemblyGraph->m_graphAttributes->x(target), g_assemblyGraph->m_graphAttributes->y(target));
+        QVERIFY(line.length() < maxNeighbourDistance);
+    }
+    QVERIFY(pinnedToNewEdges > 0);
+
+    //The worker moves only the nodes which aren't fixed, and as they barely
+    //move it doesn't report its progress.
+    std::vector<ogdf::node> fixedNodes(pinnedOgdfNodes.begin(), pinnedOgdfNodes.end());
+    std::vector<QPointF> fixedPositions;
+    for (size_t i = 0; i < fixedNodes.size(); ++i)
+        fixedPositions.push_back(QPointF(g_assemblyGraph->m_graphAttributes->x(fixedNodes[i]),
+                                         g_assemblyGraph->m_graphAttributes->y(fixedNodes[i])));
+    ogdf::FMMMLayout fmmm;
+    GraphLayoutWorker worker(&fmmm, g_assemblyGraph->m_graphAttributes, g_assemblyGraph->m_edgeArray, 1, false, true, 50.0);
+    worker.setFixedNodes(fixedNodes);
+    fmmm.progressInterval(0);
+    QSignalSpy updateSpy(&worker, SIGNAL(layoutUpdated(QPolygonF)));
+    worker.layoutGraph();
+    QCOMPARE(updateSpy.count(), 0);
+    for (size_t i = 0; i < fixedNodes.size(); ++i)
+    {
+        QCOMPARE(g_assemblyGraph->m_graphAttributes->x(fixedNodes[i]), fixedPositions[i].x());
+        QCOMPARE(g_assemblyGraph->m_graphAttributes->y(fixedNodes[i]), fixedPositions[i].y());
+    }
+
+    //Changing the graph or a layout setting means it must be drawn again.
+    QCOMPARE(g_assemblyGraph->canExpandOgdfGraph(startingNodes, 3), true);
+    g_settings->nodeSegmentLength = g_settings->nodeSegmentLength * 2.0;
+    QCOMPARE(g_assemblyGraph->canExpandOgdfGraph(startingNodes, 3), false);
+    g_settings->nodeSegmentLength = g_settings->nodeSegmentLength / 2.0;
+    g_assemblyGraph->markModified();
+    QCOMPARE(g_assemblyGraph->canExpandOgdfGraph(startingNodes, 3), false);
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+void BandageTests::backgroundGraphLoad()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    //A graph loaded in a different thread should be the same as one loaded
+    //directly.
+    AssemblyGraph * newGraph = new AssemblyGraph();
+    QThread loadThread;
+    GraphLoadWorker graphLoadWorker(newGraph, FASTG, getTestDirectory() + "test.fastg");
+    graphLoadWorker.moveToThread(&loadThread);
+    connect(&loadThread, SIGNAL(started()), &graphLoadWorker, SLOT(loadGraph()));
+    connect(&graphLoadWorker, SIGNAL(finishedLoad()), &loadThread, SLOT(quit()));
+    loadThread.start();
+    QVERIFY(loadThread.wait(60000));
+
+    QCOMPARE(graphLoadWorker.m_loaded, true);
+    QCOMPARE(newGraph->m_deBruijnGraphNodes.size(), g_assemblyGraph->m_deBruijnGraphNodes.size());
+    QCOMPARE(newGraph->m_deBruijnGraphEdges.size(), g_assemblyGraph->m_deBruijnGraphEdges.size());
+    QCOMPARE(newGraph->m_deBruijnGraphNodes["28-"]->getLength(),
+             g_assemblyGraph->m_deBruijnGraphNodes["28-"]->getLength());
+    newGraph->cleanUp();
+    delete newGraph;
+
+    //A cancelled load should stop partway through the file and report that it
+    //did not load.
+    AssemblyGraph * cancelledGraph = new AssemblyGraph();
+    GraphLoadWorker cancelledWorker(cancelledGraph, FASTG, getTestDirectory() + "test.fastg");
+    cancelledGraph->cancelLoad();
+    cancelledWorker.loadGraph();
+    QCOMPARE(cancelledWorker.m_loaded, false);
+    QCOMPARE(cancelledGraph->wasLoadCancelled(), true);
+    QVERIFY(cancelledGraph->m_deBruijnGraphNodes.size() < g_assemblyGraph->m_deBruijnGraphNodes.size());
+    cancelledGraph->cleanUp();
+    delete cancelledGraph;
+}
+
+
+void BandageTests::separateGraphs()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    double globalNodeLengthPerMegabase = g_settings->autoNodeLengthPerMegabase;
+
+    //Two more graphs, each with its own settings, are loaded at the same time
+    //in different threads.
+    QSharedPointer<Settings> settings1(new Settings(*g_settings));
+    QSharedPointer<Settings> settings2(new Settings(*g_settings));
+    AssemblyGraph lastGraph(settings1);
+    AssemblyGraph trinityGraph(settings2);
+    QThread thread1, thread2;
+    GraphLoadWorker worker1(&lastGraph, LAST_GRAPH, getTestDirectory() + "test.LastGraph");
+    GraphLoadWorker worker2(&trinityGraph, TRINITY, getTestDirectory() + "test.Trinity.fasta");
+    worker1.moveToThread(&thread1);
+    worker2.moveToThread(&thread2);
+    connect(&thread1, SIGNAL(started()), &worker1, SLOT(loadGraph()));
+    connect(&thread2, SIGNAL(started()), &worker2, SLOT(loadGraph()));
+    connect(&worker1, SIGNAL(finishedLoad()), &thread1, SLOT(quit()));
+    connect(&worker2, SIGNAL(finishedLoad()), &thread2, SLOT(quit()));
+    thread1.start();
+    thread2.start();
+    QVERIFY(thread1.wait(60000));
+    QVERIFY(thread2.wait(60000));
+    QCOMPARE(worker1.m_loaded, true);
+    QCOMPARE(worker2.m_loaded, true);
+    lastGraph.determineGraphInfo();
+    trinityGraph.determineGraphInfo();
+
+    //Nodes use their own graph's k-mer size, not the global graph's.
+    DeBruijnNode * node1 = lastGraph.m_deBruijnGraphNodes["1+"];
+    QCOMPARE(node1->getAssemblyGraph(), &lastGraph);
+    QCOMPARE(node1->getFullLength(), node1->getLength() + lastGraph.m_kmer - 1);
+    DeBruijnNode * fastgNode = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    QCOMPARE(fastgNode->getFullLength(), fastgNode->getLength());
+
+    //Each graph's settings are changed by its own graph info, leaving the
+    //global settings alone.
+    QCOMPARE(g_settings->autoNodeLengthPerMegabase, globalNodeLengthPerMegabase);
+    QVERIFY(settings1->autoNodeLengthPerMegabase != globalNodeLengthPerMegabase);
+    QVERIFY(settings2->autoNodeLengthPerMegabase != globalNodeLengthPerMegabase);
+
+    lastGraph.cleanUp();
+    trinityGraph.cleanUp();
+
+    //Bandage options in a GFA header go to the loading graph's settings, not
+    //the global settings.
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QString gfaFilename = tempDir.filePath("options.gfa");
+    QFile gfaFile(gfaFilename);
+    QVERIFY(gfaFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    gfaFile.write("H\tVN:Z:1.0\tbn:Z:--edgelen 7 --names\n"
+                  "S\t1\tACGTACGTAC\n");
+    gfaFile.close();
+    double globalEdgeLength = g_settings->edgeLength;
+    bool globalDisplayNodeNames = g_settings->displayNodeNames;
+    QSharedPointer<Settings> settings3(new Settings(*g_settings));
+    AssemblyGraph gfaGraph(settings3);
+    QCOMPARE(gfaGraph.loadGraphFromFile(gfaFilename), true);
+    QCOMPARE(double(settings3->edgeLength), 7.0);
+    QCOMPARE(settings3->displayNodeNames, true);
+    QCOMPARE(double(g_settings->edgeLength), globalEdgeLength);
+    QCOMPARE(g_settings->displayNodeNames, globalDisplayNodeNames);
+    gfaGraph.cleanUp();
+}
+
+
+void BandageTests::batchCommand()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    int fastgNodeCount = g_assemblyGraph->m_nodeCount;
+
+    createGlobals();
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    QString manifestFilename = tempDir.filePath("manifest.tsv");
+    QFile manifestFile(manifestFilename);
+    QVERIFY(manifestFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream manifest(&manifestFile);
+    manifest << "# graph\toperations\n";
+    manifest << getTestDirectory() + "test.LastGraph\tinfo=lastgraph_info.tsv\n";
+    manifest << getTestDirectory() + "test.fastg\tinfo\treduce=fastg\n";
+    manifest << "\n";
+    manifest.flush();
+    manifestFile.close();
+
+    std::vector<BatchJob> jobs;
+    QString error;
+    QVERIFY(parseBatchManifest(manifestFilename, &jobs, &error));
+    QCOMPARE(int(jobs.size()), 2);
+    QCOMPARE(int(jobs[1].operations.size()), 2);
+    QCOMPARE(jobs[1].operations[1].type, BATCH_REDUCE);
+    QCOMPARE(jobs[1].operations[1].output, tempDir.filePath("fastg.gfa"));
+
+    QStringList arguments;
+    arguments << manifestFilename << "--threads" << "2" << "--memory" << "1"
+              << "--summary" << tempDir.filePath("summary.json");
+    QCOMPARE(bandageBatch(arguments), 0);
+
+    QFile summaryFile(tempDir.filePath("summary.json"));
+    QVERIFY(summaryFile.open(QIODevice::ReadOnly));
+    QJsonObject summary = QJsonDocument::fromJson(summaryFile.readAll()).object();
+    QCOMPARE(summary["graph_count"].toInt(), 2);
+    QCOMPARE(summary["failed_count"].toInt(), 0);
+    QJsonArray graphs = summary["graphs"].toArray();
+    QCOMPARE(graphs[0].toObject()["info"].toObject()["Node count"].toString(), QString("17"));
+    QCOMPARE(graphs[1].toObject()["info"].toObject()["Node count"].toString(), QString::number(fastgNodeCount));
+    QVERIFY(QFile::exists(tempDir.filePath("lastgraph_info.tsv")));
+
+    //The reduced graph is the whole graph, as the scope is the entire graph.
+    createGlobals();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(tempDir.filePath("fastg.gfa")));
+    QCOMPARE(g_assemblyGraph->m_nodeCount, fastgNodeCount);
+
+    //A bad operation is reported as an error in the manifest.
+    QVERIFY(manifestFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    manifestFile.write(QString(getTestDirectory() + "test.fastg\tcolour=x\n").toUtf8());
+    manifestFile.close();
+    jobs.clear();
+    QCOMPARE(parseBatchManifest(manifestFilename, &jobs, &error), false);
+}
+
+
+void BandageTests::serveRequests()
+{
+    createGlobals();
+    GraphServer server(4);
+    QString error;
+    QVERIFY(server.addGraph(getTestDirectory() + "test.LastGraph", &error));
+    QVERIFY(server.addGraph(getTestDirectory() + "test.fastg", &error));
+
+    //Both files are named "test", so the second graph is given a number.
+    QJsonObject response = QJsonDocument::fromJson(server.handleRequestLine("{\"op\": \"graphs\", \"id\": 7}")).object();
+    QCOMPARE(response["ok"].toBool(), true);
+    QCOMPARE(response["id"].toInt(), 7);
+    QCOMPARE(response["graphs"].toArray()[0].toObject()["nodes"].toInt(), 17);
+    QCOMPARE(response["graphs"].toArray()[1].toObject()["graph"].toString(), QString("test_2"));
+
+    //With two graphs loaded, a request must say which one it is for.
+    response = QJsonDocument::fromJson(server.handleRequestLine("{\"op\": \"node\", \"nodes\": \"9+\"}")).object();
+    QCOMPARE(response["ok"].toBool(), false);
+
+    //The path and node sequences match those from the graph loaded directly.
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.LastGraph");
+    QString pathStringFailure;
+    Path path = Path::makeFromString("(1996) 9+, 13+ (5)", false, &pathStringFailure);
+    response = QJsonDocument::fromJson(server.handleRequestLine("{\"op\": \"path\", \"graph\": \"test\", \"path\": \"(1996) 9+, 13+ (5)\"}")).object();
+    QCOMPARE(response["sequence"].toString(), QString(path.getPathSequence()));
+    response = QJsonDocument::fromJson(server.handleRequestLine("{\"op\": \"path\", \"graph\": \"test\", \"gaf\": \">9>13\"}")).object();
+    QCOMPARE((long long)response["length"].toInt(), Path::makeFromString("9+, 13+", false, &pathStringFailure).getLength());
+
+    response = QJsonDocument::fromJson(server.handleRequestLine("{\"op\": \"node\", \"graph\": \"test\", \"nodes\": \"9+\"}")).object();
+    QString nodeSequence = response["nodes"].toArray()[0].toObject()["sequence"].toString();
+    QCOMPARE(nodeSequence, QString(g_assemblyGraph->m_deBruijnGraphNodes["9+"]->getSequence()));
+
+    //A piece of a node's sequence is found in that node.
+    QString findRequest = "{\"op\": \"find\", \"graph\": \"test\", \"sequence\": \"" + nodeSequence.mid(10, 40) + "\"}";
+    response = QJsonDocument::fromJson(server.handleRequestLine(findRequest.toUtf8())).object();
+    bool hitInNode = false;
+    QJsonArray hits = response["hits"].toArray();
+    for (int i = 0; i < hits.size(); ++i)
+    {
+        if (hits[i].toObject()["node"].toString() == "9+" && hits[i].toObject()["start"].toInt() == 11)
+            hitInNode = true;
+    }
+    QVERIFY(hitInNode);
+
+    //Neighbourhood and subgraph requests agree with each other, including when
+    //many requests are answered at once.
+    QByteArray neighbourhoodRequest = "{\"op\": \"neighbourhood\", \"graph\": \"test\", \"nodes\": \"9\", \"distance\": 2}";
+    QByteArray subgraphRequest = "{\"op\": \"subgraph\", \"graph\": \"test\", \"nodes\": \"9\", \"distance\": 2}";
+    QByteArray expectedNeighbourhood = server.handleRequestLine(neighbourhoodRequest);
+    int subgraphNodes = QJsonDocument::fromJson(server.handleRequestLine(subgraphRequest)).object()["nodes"].toInt();
+    QVERIFY(subgraphNodes > 1);
+
+    std::vector<QByteArray> neighbourhoods(8);
+    std::vector<int> subgraphNodeCounts(8);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+        threads.push_back(std::thread([&, i]()
+        {
+            neighbourhoods[i] = server.handleRequestLine(neighbourhoodRequest);
+            subgraphNodeCounts[i] = QJsonDocument::fromJson(server.handleRequestLine(subgraphRequest)).object()["nodes"].toInt();
+        }));
+    for (int i = 0; i < 8; ++i)
+    {
+        threads[i].join();
+        QCOMPARE(QJsonDocument::fromJson(neighbourhoods[i]).object()["nodes"].toArray(),
+                 QJsonDocument::fromJson(expectedNeighbourhood).object()["nodes"].toArray());
+        QCOMPARE(subgraphNodeCounts[i], subgraphNodes);
+    }
+
+    //Each type of request has its latency recorded.
+    response = QJsonDocument::fromJson(server.handleRequestLine("{\"op\": \"stats\"}")).object();
+    QJsonObject operations = response["operations"].toObject();
+    QCOMPARE(operations["neighbourhood"].toObject()["count"].toInt(), 9);
+    QCOMPARE(operations["node"].toObject()["errors"].toInt(), 1);
+}
+
+
+void BandageTests::selectionStatistics()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    QString errorTitle;
+    QString errorMessage;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
+                                                                                  g_settings->doubleMode, "", "all");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
+
+    //Select every third item, then deselect some of those again.
+    QList<QGraphicsItem *> items = scene.items();
+    for (int i = 0; i < items.size(); i += 3)
+        items[i]->setSelected(true);
+    for (int i = 0; i < items.size(); i += 9)
+        items[i]->setSelected(false);
+
+    //Remove (and delete) one selected node and one selected edge.
+    std::vector<GraphicsItemNode *> selectedNodeItems = scene.getSelectedGraphicsItemNodes();
+    QVERIFY(selectedNodeItems.size() > 1);
+    scene.removeItem(selectedNodeItems[0]);
+    delete selectedNodeItems[0];
+    QList<QGraphicsItem *> selection = scene.selectedItems();
+    for (int i = 0; i < selection.size(); ++i)
+    {
+        if (dynamic_cast<GraphicsItemEdge *>(selection[i]) != 0)
+        {
+            delete selection[i];
+            break;
+        }
+    }
+
+    //The tracked selection matches the scene's own selected items.
+    std::vector<DeBruijnNode *> expectedNodes;
+    int expectedEdgeCount = 0;
+    selection = scene.selectedItems();
+    for (int i = 0; i < selection.size(); ++i)
+    {
+        GraphicsItemNode * nodeItem = dynamic_cast<GraphicsItemNode *>(selection[i]);
+        if (nodeItem != 0)
+            expectedNodes.push_back(nodeItem->m_deBruijnNode);
+        if (dynamic_cast<GraphicsItemEdge *>(selection[i]) != 0)
+            ++expectedEdgeCount;
+    }
+    long long expectedLength = 0;
+    for (size_t i = 0; i < expectedNodes.size(); ++i)
+        expectedLength += expectedNodes[i]->getLength();
+
+    QCOMPARE(scene.getSelectedNodeCount(), int(expectedNodes.size()));
+    QCOMPARE(scene.getSelectedEdgeCount(), expectedEdgeCount);
+    QCOMPARE(int(scene.getSelectedEdges().size()), expectedEdgeCount);
+    QCOMPARE(scene.getSelectedNodeTotalLength(), expectedLength);
+    QVERIFY(qAbs(scene.getSelectedNodeMeanDepth() - g_assemblyGraph->getMeanDepth(expectedNodes)) < 1e-6);
+
+    std::vector<DeBruijnNode *> selectedNodes = scene.getSelectedNodes();
+    std::sort(expectedNodes.begin(), expectedNodes.end());
+    std::sort(selectedNodes.begin(), selectedNodes.end());
+    QVERIFY(selectedNodes == expectedNodes);
+
+    unsigned long long version = scene.getSelectionVersion();
+    scene.clearSelection();
+    QVERIFY(scene.getSelectionVersion() > version);
+    QCOMPARE(scene.getSelectedNodeCount(), 0);
+    QCOMPARE(scene.getSelectedEdgeCount(), 0);
+    QCOMPARE(scene.getSelectedNodeTotalLength(), 0LL);
+}
+
+
+void BandageTests::dragSelectedNodes()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    QString errorTitle;
+    QString errorMessage;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
+                                                                                  g_settings->doubleMode, "", "all");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
 
+    MyGraphicsScene scene;
+    g_assemblyGraph->addGraphicsItemsToScene(&scene);
 
+    //Find an edge between two different drawn nodes and select only the node
+    //it starts from.
+    GraphicsItemEdge * edge = 0;
+    QList<QGraphicsItem *> items = scene.items();
+    for (int i = 0; i < items.size() && edge == 0; ++i)
+    {
+        GraphicsItemEdge * edgeItem = dynamic_cast<GraphicsItemEdge *>(items[i]);
+        if (edgeItem == 0)
+            continue;
+        DeBruijnNode * startingNode = edgeItem->m_deBruijnEdge->getStartingNode();
+        DeBruijnNode * endingNode = edgeItem->m_deBruijnEdge->getEndingNode();
+        if (startingNode->hasGraphicsItem() && endingNode->hasGraphicsItem() &&
+                startingNode != endingNode && startingNode != endingNode->getReverseComplement())
+            edge = edgeItem;
+    }
+    QVERIFY(edge != 0);
+    GraphicsItemNode * movedNode = edge->m_deBruijnEdge->getStartingNode()->getGraphicsItemNode();
+    GraphicsItemNode * fixedNode = edge->m_deBruijnEdge->getEndingNode()->getGraphicsItemNode();
+    movedNode->setSelected(true);
+    QPointF originalLast = movedNode->getLast();
+    QPointF originalEnd = edge->m_endingLocation;
+
+    //Moves are added up and applied to the group later (normally on the next
+    //frame, but here directly), without changing the node's points.
+    scene.dragSelectedNodes(QPointF(10.0, 5.0));
+    scene.dragSelectedNodes(QPointF(2.0, 1.0));
+    QVERIFY(scene.isDraggingNodes());
+    QCOMPARE(movedNode->pos(), QPointF());
+    scene.applyNodeDrag();
+    QCOMPARE(movedNode->pos(), QPointF(12.0, 6.0));
+    QCOMPARE(movedNode->getLast(), originalLast);
+    QCOMPARE(edge->m_startingLocation, originalLast + QPointF(12.0, 6.0));
+    QCOMPARE(edge->m_endingLocation, originalEnd);
+
+    //Finishing the drag moves the offset into the node's points.
+    scene.finishNodeDrag();
+    QVERIFY(!scene.isDraggingNodes());
+    QCOMPARE(movedNode->pos(), QPointF());
+    QCOMPARE(movedNode->getLast(), originalLast + QPointF(12.0, 6.0));
+    QCOMPARE(edge->m_startingLocation, movedNode->getLast());
+    QCOMPARE(edge->m_endingLocation, fixedNode->getFirst());
+}
 
 
+void BandageTests::parallelComponentLayout()
+{
+    //Build OGDF graphs on several threads at once and destroy them on another
+    //thread, so memory crosses between the threads' pools.
+    auto buildGraphs = [](int rounds) {
+        auto buildGraph = [](ogdf::Graph * graph, int nodeCount) {
+            std::vector<ogdf::node> nodes;
+            for (int i = 0; i < nodeCount; ++i)
+                nodes.push_back(graph->newNode());
+            for (int i = 1; i < nodeCount; ++i)
+                graph->newEdge(nodes[i - 1], nodes[i]);
+        };
+        bool countsCorrect = true;
+        for (int round = 0; round < rounds; ++round)
+        {
+            std::vector<ogdf::Graph *> graphs(4);
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t)
+            {
+                graphs[t] = new ogdf::Graph();
+                threads.push_back(std::thread(buildGraph, graphs[t], 5000 + t));
+            }
+            for (size_t t = 0; t < threads.size(); ++t)
+                threads[t].join();
+            for (int t = 0; t < 4; ++t)
+            {
+                if (graphs[t]->numberOfNodes() != 5000 + t || graphs[t]->numberOfEdges() != 4999 + t)
+                    countsCorrect = false;
+            }
+            std::thread destroyer([&graphs]() {
+                for (size_t t = 0; t < graphs.size(); ++t)
+                    delete graphs[t];
+            });
+            destroyer.join();
+        }
+        return countsCorrect;
+    };
+    QVERIFY(buildGraphs(1));
+    size_t allocatedAfterFirst = ogdf::PoolMemoryAllocator::memoryAllocatedInBlocks();
+    QVERIFY(buildGraphs(3));
+    size_t allocatedAfterRepeats = ogdf::PoolMemoryAllocator::memoryAllocatedInBlocks();
+
+    //Memory freed on a thread goes back to the global pool when the thread
+    //finishes, so repeating the work should mostly reuse it.
+    QVERIFY(allocatedAfterRepeats - allocatedAfterFirst < allocatedAfterFirst / 2);
+
+    //Lay out a graph of many components on one thread and on four, starting
+    //from the same positions.  Each component's random numbers come from its
+    //own seed, whichever thread lays it out, so each component is laid out
+    //the same way both times.
+    ogdf::Graph graph;
+    std::vector<int> nodeComponents;
+    int componentCount = 40;
+    for (int component = 0; component < componentCount; ++component)
+    {
+        int nodeCount = 2 + (component * 7) % 60;
+        ogdf::node first = graph.newNode();
+        ogdf::node previous = first;
+        nodeComponents.push_back(component);
+        for (int i = 1; i < nodeCount; ++i)
+        {
+            ogdf::node next = graph.newNode();
+            nodeComponents.push_back(component);
+            graph.newEdge(previous, next);
+            previous = next;
+        }
+        if (component % 3 == 0)
+            graph.newEdge(previous, first);
+    }
+    ogdf::NodeArray<int> componentOfNode(graph);
+    ogdf::node v;
+    int nodeIndex = 0;
+    forall_nodes(v, graph)
+        componentOfNode[v] = nodeComponents[nodeIndex++];
+    ogdf::GraphAttributes graphAttributes(graph, ogdf::GraphAttributes::nodeGraphics |
+                                          ogdf::GraphAttributes::edgeGraphics);
+    ogdf::EdgeArray<double> edgeLengths(graph, 10.0);
+
+    //For each run, these hold each component's bounding box.
+    std::vector<std::vector<QRectF> > componentBoxes;
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+        nodeIndex = 0;
+        forall_nodes(v, graph)
+        {
+            graphAttributes.x(v) = (nodeIndex % 50) * 7.0;
+            graphAttributes.y(v) = (nodeIndex / 50) * 11.0;
+            ++nodeIndex;
+        }
+
+        ogdf::FMMMLayout fmmm;
+        fmmm.useHighLevelOptions(false);
+        fmmm.initialPlacementForces(ogdf::FMMMLayout::ipfKeepPositions);
+        fmmm.allowedPositions(ogdf::FMMMLayout::apAll);
+        fmmm.fixedIterations(12);
+        fmmm.fineTuningIterations(8);
+        fmmm.componentThreads(threads);
+        QCOMPARE(fmmm.componentThreads(), threads);
+        fmmm.call(graphAttributes, edgeLengths);
+
+        std::vector<double> minX(componentCount, std::numeric_limits<double>::max());
+        std::vector<double> minY(componentCount, std::numeric_limits<double>::max());
+        std::vector<double> maxX(componentCount, -std::numeric_limits<double>::max());
+        std::vector<double> maxY(componentCount, -std::numeric_limits<double>::max());
+        forall_nodes(v, graph)
+        {
+            double x = graphAttributes.x(v);
+            double y = graphAttributes.y(v);
+            QVERIFY(qIsFinite(x) && qIsFinite(y));
+            int component = componentOfNode[v];
+            minX[component] = std::min(minX[component], x);
+            minY[component] = std::min(minY[component], y);
+            maxX[component] = std::max(maxX[component], x);
+            maxY[component] = std::max(maxY[component], y);
+        }
+        std::vector<QRectF> boxes;
+        for (int component = 0; component < componentCount; ++component)
+            boxes.push_back(QRectF(QPointF(minX[component], minY[component]),
+                                   QPointF(maxX[component], maxY[component])));
+        componentBoxes.push_back(boxes);
+    }
 
+    //Each component has the same shape on one thread as on four, the
+    //components are spread out, and none of them overlap.
+    for (int component = 0; component < componentCount; ++component)
+    {
+        QRectF oneThreadBox = componentBoxes[0][component];
+        QRectF fourThreadBox = componentBoxes[1][component];
+        QVERIFY(oneThreadBox.width() > 0.0 || oneThreadBox.height() > 0.0);
+        QVERIFY(qAbs(oneThreadBox.width() - fourThreadBox.width()) < 1e-6 * (1.0 + oneThreadBox.width()));
+        QVERIFY(qAbs(oneThreadBox.height() - fourThreadBox.height()) < 1e-6 * (1.0 + oneThreadBox.height()));
+        for (int other = 0; other < component; ++other)
+        {
+            QVERIFY(!componentBoxes[0][component].intersects(componentBoxes[0][other]));
+            QVERIFY(!componentBoxes[1][component].intersects(componentBoxes[1][other]));
+        }
+    }
 
+    //Build and lay out a real graph, which is where most of Bandage's OGDF
+    //allocation happens.  This is timed by the double_layout scenario of
+    //BandageBenchmarks.
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = WHOLE_GRAPH;
+    g_settings->doubleMode = true;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+    QCOMPARE(g_assemblyGraph->getDrawnNodeCount(), 88);
+    forall_nodes(v, *g_assemblyGraph->m_ogdfGraph)
+        QVERIFY(qIsFinite(g_assemblyGraph->m_graphAttributes->x(v)) && qIsFinite(g_assemblyGraph->m_graphAttributes->y(v)));
+}
 
 
+void BandageTests::barnesHutRepulsion()
+{
+    //Place nodes in clusters, as in a partly laid out graph.
+    ogdf::Graph graph;
+    for (int i = 0; i < 3000; ++i)
+        graph.newNode();
+    ogdf::NodeArray<ogdf::NodeAttributes> attributes(graph);
+    ogdf::node v;
+    int i = 0;
+    forall_nodes(v, graph)
+    {
+        double clusterX = (i % 7) * 100.0;
+        double clusterY = (i % 5) * 100.0;
+        attributes[v].set_position(ogdf::DPoint(clusterX + (i * 37 % 101) / 3.0, clusterY + (i * 53 % 97) / 3.0));
+        ++i;
+    }
 
+    ogdf::NodeArray<ogdf::DPoint> exactForces(graph);
+    ogdf::FruchtermanReingold exact;
+    exact.calculate_exact_repulsive_forces(graph, attributes, exactForces);
+
+    //With an opening criterion of 0 no cells are approximated, so the forces
+    //should match the exact ones.
+    ogdf::NodeArray<ogdf::DPoint> forces(graph);
+    ogdf::BarnesHut barnesHut;
+    barnesHut.make_initialisations(graph, 0.0, 16);
+    barnesHut.calculate_repulsive_forces(graph, attributes, forces);
+    forall_nodes(v, graph)
+        QVERIFY((forces[v] - exactForces[v]).norm() < 1e-9 * (1.0 + exactForces[v].norm()));
+
+    //The usual criterion should be close.
+    barnesHut.make_initialisations(graph, 0.5, 16);
+    barnesHut.calculate_repulsive_forces(graph, attributes, forces);
+    double errorSquared = 0.0, forceSquared = 0.0;
+    forall_nodes(v, graph)
+    {
+        errorSquared += pow((forces[v] - exactForces[v]).norm(), 2.0);
+        forceSquared += pow(exactForces[v].norm(), 2.0);
+    }
+    QVERIFY(sqrt(errorSquared / forceSquared) < 0.01);
+    barnesHut.deallocate_memory();
+
+    //Two nodes at the same position are pushed apart.
+    ogdf::Graph pairGraph;
+    ogdf::node first = pairGraph.newNode();
+    ogdf::node second = pairGraph.newNode();
+    ogdf::NodeArray<ogdf::NodeAttributes> pairAttributes(pairGraph);
+    pairAttributes[first].set_position(ogdf::DPoint(5.0, 5.0));
+    pairAttributes[second].set_position(ogdf::DPoint(5.0, 5.0));
+    ogdf::NodeArray<ogdf::DPoint> pairForces(pairGraph);
+    barnesHut.make_initialisations(pairGraph, 0.5, 16);
+    barnesHut.calculate_repulsive_forces(pairGraph, pairAttributes, pairForces);
+    QVERIFY(pairForces[first].norm() > 0.0);
+
+    //A full layout using the new method.
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    ogdf::FMMMLayout fmmm;
+    fmmm.useHighLevelOptions(false);
+    fmmm.allowedPositions(ogdf::FMMMLayout::apAll);
+    fmmm.repulsiveForcesCalculation(ogdf::FMMMLayout::rfcBarnesHut);
+    QCOMPARE(fmmm.repulsiveForcesCalculation(), ogdf::FMMMLayout::rfcBarnesHut);
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = WHOLE_GRAPH;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    fmmm.call(*g_assemblyGraph->m_graphAttributes, *g_assemblyGraph->m_edgeArray);
+    forall_nodes(v, *g_assemblyGraph->m_ogdfGraph)
+        QVERIFY(qIsFinite(g_assemblyGraph->m_graphAttributes->x(v)) && qIsFinite(g_assemblyGraph->m_graphAttributes->y(v)));
+}
+
+
+//A listener which checks every report covers the whole graph, and which can
+//stop the layout when it gets its first report.
+class TestProgressListener : public ogdf::FMMMProgressListener
+{
+public:
+    TestProgressListener(int nodeCount, ogdf::FMMMLayout * layoutToStop = 0) :
+        m_nodeCount(nodeCount), m_layoutToStop(layoutToStop), m_reports(0), m_valid(true) {}
+    void layoutProgress(const std::vector<ogdf::node> & nodes, const std::vector<ogdf::DPoint> & positions)
+    {
+        ++m_reports;
+        if (int(nodes.size()) != m_nodeCount || positions.size() != nodes.size())
+            m_valid = false;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            if (!qIsFinite(positions[i].m_x) || !qIsFinite(positions[i].m_y))
+                m_valid = false;
+        }
+        if (m_layoutToStop != 0)
+            m_layoutToStop->stopLayout();
+    }
+    int m_nodeCount;
+    ogdf::FMMMLayout * m_layoutToStop;
+    int m_reports;
+    bool m_valid;
+};
+
+
+void BandageTests::progressiveLayout()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    QString errorTitle;
+    QString errorMessage;
+    g_settings->graphScope = WHOLE_GRAPH;
+    std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    ogdf::Graph & graph = *g_assemblyGraph->m_ogdfGraph;
+    ogdf::GraphAttributes & attributes = *g_assemblyGraph->m_graphAttributes;
+    ogdf::node v;
 
+    //With no interval, the listener hears about every iteration on the finest
+    //level, with (and without) the components laid out on separate threads.
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+        ogdf::FMMMLayout fmmm;
+        fmmm.useHighLevelOptions(false);
+        fmmm.allowedPositions(ogdf::FMMMLayout::apAll);
+        fmmm.componentThreads(threads);
+        TestProgressListener listener(graph.numberOfNodes());
+        fmmm.progressListener(&listener);
+        fmmm.progressInterval(0);
+        QVERIFY(fmmm.progressListener() == &listener);
+        fmmm.call(attributes, *g_assemblyGraph->m_edgeArray);
+        QVERIFY(listener.m_reports >= fmmm.fineTuningIterations());
+        QVERIFY(listener.m_valid);
+        QVERIFY(!fmmm.stopRequested());
+    }
 
+    //Stopping the layout skips the rest of it but still places every node.
+    ogdf::FMMMLayout fullLayout;
+    fullLayout.useHighLevelOptions(false);
+    fullLayout.allowedPositions(ogdf::FMMMLayout::apAll);
+    fullLayout.progressInterval(0);
+    TestProgressListener fullListener(graph.numberOfNodes());
+    fullLayout.progressListener(&fullListener);
+    fullLayout.call(attributes, *g_assemblyGraph->m_edgeArray);
+
+    ogdf::FMMMLayout stoppedLayout;
+    stoppedLayout.useHighLevelOptions(false);
+    stoppedLayout.allowedPositions(ogdf::FMMMLayout::apAll);
+    stoppedLayout.progressInterval(0);
+    TestProgressListener stoppingListener(graph.numberOfNodes(), &stoppedLayout);
+    stoppedLayout.progressListener(&stoppingListener);
+    stoppedLayout.call(attributes, *g_assemblyGraph->m_edgeArray);
+    QVERIFY(stoppedLayout.stopRequested());
+    QVERIFY(stoppingListener.m_reports < fullListener.m_reports);
+    forall_nodes(v, graph)
+        QVERIFY(qIsFinite(attributes.x(v)) && qIsFinite(attributes.y(v)));
+
+    //The worker passes the reports on as positions indexed by OGDF node.
+    ogdf::FMMMLayout workerLayout;
+    GraphLayoutWorker worker(&workerLayout, &attributes, g_assemblyGraph->m_edgeArray, 1, false, false, 50.0);
+    workerLayout.progressInterval(0);
+    QSignalSpy updateSpy(&worker, SIGNAL(layoutUpdated(QPolygonF)));
+    QSignalSpy finishedSpy(&worker, SIGNAL(finishedLayout()));
+    worker.layoutGraph();
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(updateSpy.count() > 0);
+    QPolygonF positions = updateSpy.last().at(0).value<QPolygonF>();
+    QCOMPARE(positions.size(), graph.maxNodeIndex() + 1);
+}
 
 
+void BandageTests::graphWriter()
+{
+    //Sequences are wrapped at 70 bases with a newline at the end.
+    QCOMPARE(AssemblyGraph::addNewlinesToSequence(""), QByteArray("\n"));
+    QCOMPARE(AssemblyGraph::addNewlinesToSequence(QByteArray(70, 'A')), QByteArray(70, 'A') + "\n");
+    QCOMPARE(AssemblyGraph::addNewlinesToSequence(QByteArray(71, 'A')), QByteArray(70, 'A') + "\nA\n");
+    QCOMPARE(AssemblyGraph::addNewlinesToSequence("ACGTACG", 3), QByteArray("ACG\nTAC\nG\n"));
+
+    //The saved files should hold the same records, in the same order, as the
+    //single-record functions give.  The graph is big enough that the writer
+    //uses several blocks.
+    QString gfaFilename = getTestDirectory() + "writer_test_temp.gfa";
+    QFile gfaFile(gfaFilename);
+    QVERIFY(gfaFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream gfaOut(&gfaFile);
+    const char bases[] = "ACGT";
+    for (int i = 1; i <= 3000; ++i)
+    {
+        QByteArray sequence(2000 + (i * 37) % 3000, 'A');
+        for (int j = 0; j < sequence.length(); ++j)
+            sequence[j] = bases[(i * 7 + j * j) % 4];
+        gfaOut << "S\t" << i << "\t" << sequence << "\tDP:f:" << (i % 50) + 0.5 << "\n";
+        if (i > 1)
+            gfaOut << "L\t" << i - 1 << "\t+\t" << i << "\t" << (i % 3 == 0 ? "-" : "+") << "\t0M\n";
+    }
+    gfaOut.flush();
+    gfaFile.close();
+
+    createGlobals();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(gfaFilename));
+    g_assemblyGraph->m_deBruijnGraphNodes["5+"]->setCustomLabel("five");
+    g_assemblyGraph->m_deBruijnGraphNodes["6-"]->setCustomColour(QColor(255, 0, 0));
+
+    QByteArray expectedGfa;
+    QByteArray expectedFasta;
+    std::vector<DeBruijnEdge *> edges;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        expectedFasta += i.value()->getFasta(true);
+        if (i.value()->isPositiveNode())
+            expectedGfa += i.value()->getGfaSegmentLine(g_assemblyGraph->m_depthTag);
+    }
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(g_assemblyGraph->m_deBruijnGraphEdges);
+    while (j.hasNext())
+    {
+        j.next();
+        if (j.value()->isPositiveEdge())
+            edges.push_back(j.value());
+    }
+    std::sort(edges.begin(), edges.end(), DeBruijnEdge::compareEdgePointers);
+    for (size_t k = 0; k < edges.size(); ++k)
+        expectedGfa += edges[k]->getGfaLinkLine();
+    QVERIFY(expectedGfa.contains("\tLB:z:five"));
+    QVERIFY(expectedGfa.contains("\tC2:z:red"));
+
+    QString savedGfaFilename = getTestDirectory() + "writer_test_temp_saved.gfa";
+    QString savedFastaFilename = getTestDirectory() + "writer_test_temp_saved.fasta";
+    QVERIFY(g_assemblyGraph->saveEntireGraphToGfa(savedGfaFilename));
+    g_assemblyGraph->saveEntireGraphToFasta(savedFastaFilename);
+
+    QFile savedGfa(savedGfaFilename);
+    QVERIFY(savedGfa.open(QIODevice::ReadOnly | QIODevice::Text));
+    QCOMPARE(savedGfa.readAll(), expectedGfa);
+    savedGfa.close();
+    QFile savedFasta(savedFastaFilename);
+    QVERIFY(savedFasta.open(QIODevice::ReadOnly | QIODevice::Text));
+    QCOMPARE(savedFasta.readAll(), expectedFasta);
+    savedFasta.close();
+
+    //A writer whose file could not be opened writes nothing.
+    GraphWriter writer;
+    QVERIFY(!writer.open(getTestDirectory() + "no_such_directory/writer_test_temp.gfa"));
+    QVERIFY(!writer.writeGfaLinks(edges));
+
+    QFile::remove(gfaFilename);
+    QFile::remove(savedGfaFilename);
+    QFile::remove(savedFastaFilename);
+}
+
+
+void BandageTests::pathSequenceStreaming()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.LastGraph");
+
+    //A long walk round a circular path makes a sequence bigger than the
+    //writer's buffer.
+    QStringList loopNodes;
+    for (int i = 0; i < 1000; ++i)
+        loopNodes << "26+" << "23+";
+    loopNodes << "26+";
+
+    QString pathStringFailure;
+    QList<Path> paths;
+    paths << Path::makeFromString("(50234) 6+, 26+, 23+, 26+, 24+ (200)", false, &pathStringFailure);
+    paths << Path::makeFromString("26+, 23+", true, &pathStringFailure);
+    paths << Path::makeFromString(loopNodes.join(", "), false, &pathStringFailure);
+
+    for (int i = 0; i < paths.size(); ++i)
+    {
+        const Path & path = paths[i];
+        QVERIFY(!path.isEmpty());
+        QByteArray sequence = path.getPathSequence();
+        QCOMPARE(path.getPathSequenceLength(), (long long)sequence.length());
+        QCOMPARE(path.getLength(), (long long)sequence.length());
+
+        QByteArray fasta;
+        QBuffer buffer(&fasta);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(path.writeFasta(&buffer));
+        QCOMPARE(QString::fromUtf8(fasta), path.getFasta());
+        buffer.close();
+
+        QByteArray namedFasta;
+        QBuffer namedBuffer(&namedFasta);
+        namedBuffer.open(QIODevice::WriteOnly);
+        QVERIFY(path.writeFasta(&namedBuffer, "test_path"));
+        QCOMPARE(namedFasta, ">test_path\n" + AssemblyGraph::addNewlinesToSequence(sequence));
+    }
+    QVERIFY(paths[2].getPathSequenceLength() > 1024 * 1024);
+
+    //A range too long for a QByteArray gives an empty sequence, rather than
+    //a wrong one.
+    QCOMPARE(paths[0].getPathSubsequence(0, 10), paths[0].getPathSequence().left(10));
+    QVERIFY(paths[0].getPathSubsequence(0, 3000000000LL).isEmpty());
+}
+
+
+void BandageTests::gafSeqCommand()
+{
+    createGlobals();
+    QString graphFilename = getTestDirectory() + "test_plasmids.gfa";
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(graphFilename));
+    QString pathStringFailure;
+    QByteArray walkSequence = Path::makeFromString("232+, 277+", false, &pathStringFailure).getPathSequence();
+    QString walkLength = QString::number(walkSequence.length());
+    createGlobals();
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QString gafFilename = tempDir.filePath("alignments.gaf");
+    QFile gafFile(gafFilename);
+    QVERIFY(gafFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream gaf(&gafFile);
+    gaf << "read1\t100\t0\t100\t+\t>232>277\t" << walkLength << "\t10\t110\t100\t100\t60\n";
+    gaf << "# a comment\n";
+    gaf << "read2\t50\t0\t50\t-\t232+,277+\t" << walkLength << "\t200\t250\t50\t50\t60\n";
+    gaf << "read3\t50\t0\t50\t+\t>232>no_such_node\t100\t0\t50\t50\t50\t60\n";
+    gaf << "read4\t50\t0\t50\t+\t>232>277\t" << walkLength << "\t0\t999999\t50\t50\t60\n";
+    gaf.flush();
+    gafFile.close();
+
+    //Records are written in order, trimmed to the path coordinates, and the
+    //ones which can't be resolved are skipped.
+    QString fastaFilename = tempDir.filePath("sequences.fasta");
+    QStringList arguments;
+    arguments << graphFilename << gafFilename << fastaFilename << "--threads" << "3";
+    QCOMPARE(bandageGafSeq(arguments), 0);
+
+    QByteArray expectedFasta = ">read1 query=0-100 strand=+ path=>232>277:10-110\n" +
+            AssemblyGraph::addNewlinesToSequence(walkSequence.mid(10, 100)) +
+            ">read2 query=0-50 strand=- path=232+,277+:200-250\n" +
+            AssemblyGraph::addNewlinesToSequence(AssemblyGraph::getReverseComplement(walkSequence.mid(200, 50)));
+    QFile fastaFile(fastaFilename);
+    QVERIFY(fastaFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    QCOMPARE(fastaFile.readAll(), expectedFasta);
+    fastaFile.close();
+
+    //The summary counts the skipped records and says why they were skipped.
+    GafSeqOptions options;
+    options.threads = 2;
+    options.fastq = true;
+    options.untrimmed = true;
+    GafSeqSummary summary;
+    QString error;
+    QString fastqFilename = tempDir.filePath("sequences.fastq");
+    QVERIFY(extractGafSequences(g_assemblyGraph.data(), gafFilename, fastqFilename, options, &summary, &error));
+    QCOMPARE(summary.records, 4LL);
+    QCOMPARE(summary.sequences, 3LL);
+    QCOMPARE(summary.skipped, 1LL);
+    QCOMPARE(summary.bases, 3LL * walkSequence.length());
+    QCOMPARE(summary.warnings.size(), 1);
+    QVERIFY(summary.warnings[0].startsWith("line 4: "));
+
+    QFile fastqFile(fastqFilename);
+    QVERIFY(fastqFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    QList<QByteArray> fastqLines = fastqFile.readAll().split('\n');
+    QCOMPARE(fastqLines.size(), 13);
+    QCOMPARE(fastqLines[0], QByteArray("@read1 query=0-100 strand=+ path=>232>277:0-" + walkLength.toUtf8()));
+    QCOMPARE(fastqLines[1], walkSequence);
+    QCOMPARE(fastqLines[3], QByteArray(walkSequence.length(), 'I'));
+    QCOMPARE(fastqLines[5], AssemblyGraph::getReverseComplement(walkSequence));
+
+    //A bigger file, spread across several chunks, keeps its order.
+    QVERIFY(gafFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream bigGaf(&gafFile);
+    for (int i = 0; i < 10000; ++i)
+        bigGaf << "read" << i << "\t10\t0\t10\t+\t>232>277\t" << walkLength << "\t" << i % 1000 << "\t" << i % 1000 + 10 << "\t10\t10\t60\n";
+    bigGaf.flush();
+    gafFile.close();
+    options.fastq = false;
+    options.untrimmed = false;
+    options.threads = 4;
+    QVERIFY(extractGafSequences(g_assemblyGraph.data(), gafFilename, fastaFilename, options, &summary, &error));
+    QCOMPARE(summary.sequences, 10000LL);
+    QVERIFY(fastaFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    QList<QByteArray> fastaLines = fastaFile.readAll().split('\n');
+    QCOMPARE(fastaLines.size(), 20001);
+    for (int i = 0; i < 10000; i += 997)
+    {
+        QVERIFY(fastaLines[2 * i].startsWith(">read" + QByteArray::number(i) + " "));
+        QCOMPARE(fastaLines[2 * i + 1], walkSequence.mid(i % 1000, 10));
+    }
+}
+
+
+void BandageTests::gafCoverage()
+{
+    createGlobals();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_plasmids.gfa"));
+    DeBruijnNode * node232 = g_assemblyGraph->m_deBruijnGraphNodes["232+"];
+    DeBruijnNode * node277 = g_assemblyGraph->m_deBruijnGraphNodes["277+"];
+    int length232 = node232->getLength();
+    int length277 = node277->getLength();
+    int overlap = getEdgeFromNodeNames("232+", "277+")->getOverlap();
+    QString walkLength = QString::number(length232 + length277 - overlap);
+    double graphDepth232 = node232->getDepth();
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QString gafFilename = tempDir.filePath("alignments.gaf");
+    QFile gafFile(gafFilename);
+    QVERIFY(gafFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream gaf(&gafFile);
+    gaf << "read1\t100\t0\t100\t+\t>232>277\t" << walkLength << "\t10\t" << length232 + length277 - overlap - 20 << "\t100\t100\t60\n";
+    gaf << "read2\t100\t0\t100\t+\t<277<232\t" << walkLength << "\t0\t" << walkLength << "\t100\t100\t60\n";
+    gaf << "read3\t5\t0\t5\t-\t232+\t" << length232 << "\t0\t5\t5\t5\t60\n";
+    gaf << "read4\t5\t0\t5\t+\t>232>no_such_node\t100\t0\t5\t5\t5\t60\n";
+    gaf.flush();
+    gafFile.close();
+
+    QSharedPointer<GafCoverage> coverage(new GafCoverage());
+    GafCoverageSummary summary;
+    QString error;
+    QVERIFY(coverage->load(g_assemblyGraph.data(), gafFilename, 3, &summary, &error));
+    QCOMPARE(summary.records, 4LL);
+    QCOMPARE(summary.alignments, 3LL);
+    QCOMPARE(summary.skipped, 1LL);
+    QCOMPARE(summary.warnings.size(), 1);
+    QVERIFY(summary.warnings[0].startsWith("line 4: "));
+
+    //Alignments on either strand count towards both nodes in a pair.
+    QCOMPARE(coverage->getReadCount(node232), 3LL);
+    QCOMPARE(coverage->getReadCount(node232->getReverseComplement()), 3LL);
+    QCOMPARE(coverage->getReadCount(node277), 2LL);
+    QCOMPARE(coverage->getReadCount(g_assemblyGraph->m_deBruijnGraphNodes["280+"]), 0LL);
+
+    std::vector<int> baseCoverage232 = coverage->getBaseCoverage(node232);
+    QCOMPARE(int(baseCoverage232.size()), length232);
+    QCOMPARE(baseCoverage232[0], 2);
+    QCOMPARE(baseCoverage232[4], 2);
+    QCOMPARE(baseCoverage232[5], 1);
+    QCOMPARE(baseCoverage232[9], 1);
+    QCOMPARE(baseCoverage232[10], 2);
+    QCOMPARE(baseCoverage232.back(), 2);
+    QCOMPARE(coverage->getMeanCoverage(node232), (2.0 * length232 - 5.0) / length232);
+
+    std::vector<int> baseCoverage277 = coverage->getBaseCoverage(node277);
+    QCOMPARE(baseCoverage277[length277 - 21], 2);
+    QCOMPARE(baseCoverage277[length277 - 20], 1);
+    std::vector<int> reverseCoverage277 = coverage->getBaseCoverage(node277->getReverseComplement());
+    QCOMPARE(reverseCoverage277[0], 1);
+    QCOMPARE(reverseCoverage277[19], 1);
+    QCOMPARE(reverseCoverage277[20], 2);
+
+    //The coverage can replace the graph's depths and be switched back.
+    g_assemblyGraph->setGafCoverage(coverage);
+    QVERIFY(g_assemblyGraph->setDepthSource(GAF_READ_COUNT));
+    QCOMPARE(node232->getDepth(), 3.0);
+    QCOMPARE(node232->getReverseComplement()->getDepth(), 3.0);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes["280+"]->getDepth(), 0.0);
+    QVERIFY(g_assemblyGraph->setDepthSource(GAF_MEAN_COVERAGE));
+    QCOMPARE(node232->getDepth(), coverage->getMeanCoverage(node232));
+
+    //A depth changed while GAF depths are shown is kept as the graph depth.
+    std::vector<DeBruijnNode *> editedNodes(1, node277);
+    g_assemblyGraph->changeNodeDepth(&editedNodes, 42.0);
+    QCOMPARE(node277->getDepth(), 42.0);
+
+    QVERIFY(g_assemblyGraph->setDepthSource(GRAPH_DEPTH));
+    QCOMPARE(node232->getDepth(), graphDepth232);
+    QCOMPARE(node277->getDepth(), 42.0);
+    QCOMPARE(node277->getReverseComplement()->getDepth(), 42.0);
+
+    //Deleting a node renumbers the others, but they keep their coverage.
+    DeBruijnNode * firstNode = g_assemblyGraph->m_deBruijnGraphNodes.first();
+    QVERIFY(firstNode != node232 && firstNode != node277 && firstNode->getReverseComplement() != node232);
+    std::vector<DeBruijnNode *> deletedNodes(1, firstNode);
+    g_assemblyGraph->deleteNodes(&deletedNodes);
+    g_assemblyGraph->getIndexedNodes();
+    QVERIFY(g_assemblyGraph->setDepthSource(GAF_MEAN_COVERAGE));
+    QCOMPARE(node232->getDepth(), (2.0 * length232 - 5.0) / length232);
+    QCOMPARE(coverage->getReadCount(node277), 2LL);
+    QVERIFY(g_assemblyGraph->setDepthSource(GRAPH_DEPTH));
+
+    g_assemblyGraph->setGafCoverage(QSharedPointer<GafCoverage>());
+    QVERIFY(!g_assemblyGraph->setDepthSource(GAF_READ_COUNT));
+    QCOMPARE(g_assemblyGraph->getDepthSource(), GRAPH_DEPTH);
+
+    //A bigger file, spread across several chunks, gives the same totals with
+    //any number of threads.
+    QVERIFY(gafFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream bigGaf(&gafFile);
+    for (int i = 0; i < 10000; ++i)
+        bigGaf << "read" << i << "\t10\t0\t10\t+\t>232>277\t" << walkLength << "\t" << i % 10 << "\t" << i % 10 + 10 << "\t10\t10\t60\n";
+    bigGaf.flush();
+    gafFile.close();
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+        GafCoverage bigCoverage;
+        QVERIFY(bigCoverage.load(g_assemblyGraph.data(), gafFilename, threads, &summary, &error));
+        QCOMPARE(summary.alignments, 10000LL);
+        QCOMPARE(summary.alignedBases, 100000LL);
+        QCOMPARE(bigCoverage.getReadCount(node232), 10000LL);
+        QCOMPARE(bigCoverage.getReadCount(node277), 0LL);
+        std::vector<int> bigCoverage232 = bigCoverage.getBaseCoverage(node232);
+        QCOMPARE(bigCoverage232[0], 1000);
+        QCOMPARE(bigCoverage232[9], 10000);
+        QCOMPARE(bigCoverage232[19], 0);
+    }
+}
+
+
+void BandageTests::partialNodeNameSearch()
+{
+    createGlobals();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_plasmids.gfa"));
+
+    //The indexed search gives the same nodes, in the same order, as checking
+    //every node name.
+    QStringList queries;
+    queries << "2" << "2+" << "23" << "232" << "80+" << "277-" << "9999";
+    for (int i = 0; i < queries.size(); ++i)
+    {
+        std::vector<DeBruijnNode *> expected;
+        QMapIterator<QString, DeBruijnNode*> j(g_assemblyGraph->m_deBruijnGraphNodes);
+        while (j.hasNext())
+        {
+            j.next();
+            if (j.value()->getName().contains(queries[i]))
+                expected.push_back(j.value());
+        }
+        std::vector<QString> nodesNotInGraph;
+        std::vector<DeBruijnNode *> found = g_assemblyGraph->getNodesFromString(queries[i], false, &nodesNotInGraph);
+        QVERIFY(found == expected);
+        QCOMPARE(nodesNotInGraph.size(), size_t(expected.empty() ? 1 : 0));
+    }
+
+    //Several terms give each term's nodes in turn.
+    std::vector<DeBruijnNode *> twoTerms = g_assemblyGraph->getNodesFromString("232+, 277+", false);
+    QCOMPARE(twoTerms.size(), size_t(2));
+    QCOMPARE(twoTerms[0]->getName(), QString("232+"));
+    QCOMPARE(twoTerms[1]->getName(), QString("277+"));
+
+    //Renaming a node makes the index out of date, so it is rebuilt.
+    QCOMPARE(g_assemblyGraph->getNodesFromString("renamed", false).size(), size_t(0));
+    g_assemblyGraph->changeNodeName("232", "renamed_232");
+    QCOMPARE(g_assemblyGraph->getNodesFromString("renamed", false).size(), size_t(2));
+    QCOMPARE(g_assemblyGraph->getNodesFromString("renamed_232-", false).size(), size_t(1));
+}
+
+
+void BandageTests::blastHitIndex()
+{
+    createGlobals();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_plasmids.gfa"));
+    QVERIFY(createBlastTempDirectory());
+    BlastQuery * query1 = new BlastQuery("query1", QString(100, 'A'));
+    BlastQuery * query2 = new BlastQuery("query2", QString(100, 'C'));
+    g_blastSearch->m_blastQueries.addQuery(query1);
+    g_blastSearch->m_blastQueries.addQuery(query2);
+
+    //Hits to unknown queries or nodes, and hits on the reverse strand, are
+    //left out.
+    g_blastSearch->m_blastOutput = "query1\tNODE_232+_length_528_cov_1.0\t100\t50\t0\t0\t1\t50\t1\t50\t1e-20\t90\n"
+                                   "query1\tNODE_277-_length_893_cov_1.0\t100\t50\t0\t0\t51\t100\t1\t50\t1e-20\t90\n"
+                                   "query2\tNODE_232+_length_528_cov_1.0\t100\t50\t0\t0\t1\t50\t101\t150\t1e-20\t90\n"
+                                   "query2\tNODE_999+_length_528_cov_1.0\t100\t50\t0\t0\t1\t50\t1\t50\t1e-20\t90\n"
+                                   "query3\tNODE_232+_length_528_cov_1.0\t100\t50\t0\t0\t1\t50\t1\t50\t1e-20\t90\n"
+                                   "query2\tNODE_277+_length_893_cov_1.0\t100\t50\t0\t0\t1\t50\t50\t1\t1e-20\t90\n";
+    g_blastSearch->buildHitsFromBlastOutput();
+    QCOMPARE(g_blastSearch->m_allHits.size(), 3);
+    QCOMPARE(query1->hitCount(), 2);
+    QCOMPARE(query2->hitCount(), 1);
+
+    DeBruijnNode * node232 = g_assemblyGraph->m_deBruijnGraphNodes["232+"];
+    DeBruijnNode * node277 = g_assemblyGraph->m_deBruijnGraphNodes["277-"];
+    g_blastSearch->blastQueryChanged("query1");
+    QCOMPARE(node232->getBlastHitsPointer()->size(), size_t(1));
+    QCOMPARE(node277->getBlastHitsPointer()->size(), size_t(1));
+    g_blastSearch->blastQueryChanged("all");
+    QCOMPARE(node232->getBlastHitsPointer()->size(), size_t(2));
+    QCOMPARE((*node232->getBlastHitsPointer())[0]->m_query, query1);
+    QCOMPARE((*node232->getBlastHitsPointer())[1]->m_query, query2);
+
+    //Removing a query removes its hits too.
+    std::vector<BlastQuery *> queriesToRemove;
+    queriesToRemove.push_back(query1);
+    g_assemblyGraph->clearAllBlastHitPointers();
+    g_blastSearch->clearSomeQueries(queriesToRemove);
+    QCOMPARE(g_blastSearch->m_allHits.size(), 1);
+    QCOMPARE(g_blastSearch->m_blastQueries.getQueryCount(), 1);
+    QCOMPARE(g_blastSearch->m_allHits[0]->m_query, query2);
+    g_blastSearch->blastQueryChanged("all");
+    QCOMPARE(node232->getBlastHitsPointer()->size(), size_t(1));
+    QCOMPARE(node277->getBlastHitsPointer()->size(), size_t(0));
+
+    deleteBlastTempDirectory();
+}
+
+
+void BandageTests::blastHitPathCache()
+{
+    createGlobals();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_plasmids.gfa"));
+    QVERIFY(createBlastTempDirectory());
+    BlastQuery * query = new BlastQuery("query1", QString(100, 'A'));
+    g_blastSearch->m_blastQueries.addQuery(query);
+    g_blastSearch->m_blastOutput = "query1\tNODE_232+_length_528_cov_1.0\t100\t50\t0\t0\t1\t50\t1\t264\t1e-20\t90\n";
+    g_blastSearch->buildHitsFromBlastOutput();
+    g_blastSearch->blastQueryChanged("all");
+
+    DeBruijnNode * node232 = g_assemblyGraph->m_deBruijnGraphNodes["232+"];
+    std::vector<QPointF> linePoints;
+    linePoints.push_back(QPointF(0.0, 0.0));
+    linePoints.push_back(QPointF(500.0, 0.0));
+    linePoints.push_back(QPointF(1000.0, 0.0));
+    GraphicsItemNode nodeItem(node232, linePoints);
+
+    //The hit covers half of the query, so it gets half of the rainbow parts.
+    g_absoluteZoom = 1.0;
+    g_settings->nodeColourScheme = BLAST_HITS_RAINBOW_COLOUR;
+    g_settings->blastRainbowPartsPerQuery = 20;
+    QCOMPARE(nodeItem.getBlastHitPaths().size(), size_t(10));
+    QVERIFY(nodeItem.getBlastHitPaths()[0].m_query == 0);
+    g_settings->blastRainbowPartsPerQuery = 40;
+    QCOMPARE(nodeItem.getBlastHitPaths().size(), size_t(20));
+
+    //A small zoom change stays in the same bucket, but zooming far enough out
+    //leaves no room for any rainbow parts.
+    g_absoluteZoom = 1.1;
+    QCOMPARE(nodeItem.getBlastHitPaths().size(), size_t(20));
+    g_absoluteZoom = 0.001;
+    QCOMPARE(nodeItem.getBlastHitPaths().size(), size_t(0));
+
+    //A solid hit is one path over the first half of the node, which keeps
+    //its query for the colour.
+    g_settings->nodeColourScheme = BLAST_HITS_SOLID_COLOUR;
+    QCOMPARE(nodeItem.getBlastHitPaths().size(), size_t(1));
+    QCOMPARE(nodeItem.getBlastHitPaths()[0].m_query, query);
+    QVERIFY(qAbs(nodeItem.getBlastHitPaths()[0].m_path.length() - 500.0) < 1.0);
+
+    //Moving the node remakes its paths.
+    nodeItem.m_linePoints[2] = QPointF(2000.0, 0.0);
+    nodeItem.remakePath();
+    QVERIFY(qAbs(nodeItem.getBlastHitPaths()[0].m_path.length() - 1000.0) < 1.0);
+
+    //Clearing the node's hits clears its paths.
+    g_assemblyGraph->clearAllBlastHitPointers();
+    QCOMPARE(nodeItem.getBlastHitPaths().size(), size_t(0));
+
+    deleteBlastTempDirectory();
+}
+
+
+void BandageTests::sequenceSearch()
+{
+    createGlobals();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_plasmids.gfa"));
+    const SequenceIndex & sequenceIndex = g_assemblyGraph->getSequenceIndex();
+    QString pathStringFailure;
+    QByteArray walkSequence = Path::makeFromString("232+, 277+", false, &pathStringFailure).getPathSequence();
+
+    //A query across the end of 232+ is found as a path into 277+ (after the
+    //81 bp overlap), and its reverse complement on the opposite strand.
+    QByteArray query = walkSequence.mid(500, 60);
+    std::vector<SequenceMatch> matches = sequenceIndex.findSequence(query, 0, 100);
+    bool foundForward = false;
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        QCOMPARE(matches[i].path.getPathSequence(), query);
+        QCOMPARE(matches[i].mismatches, 0);
+        if (matches[i].path.getString(true) == "(501) 232+, 277+ (113)")
+            foundForward = true;
+    }
+    QVERIFY(foundForward);
+    QByteArray reverseQuery = AssemblyGraph::getReverseComplement(query);
+    matches = sequenceIndex.findSequence(reverseQuery, 0, 100);
+    bool foundReverse = false;
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        QCOMPARE(matches[i].path.getPathSequence(), reverseQuery);
+        if (matches[i].path.getString(false).contains("277-,232-"))
+            foundReverse = true;
+    }
+    QVERIFY(foundReverse);
+
+    //With one base changed, the match is only found if a mismatch is allowed.
+    QByteArray changedQuery = query;
+    changedQuery[30] = (changedQuery[30] == 'A') ? 'C' : 'A';
+    matches = sequenceIndex.findSequence(changedQuery, 0, 100);
+    for (size_t i = 0; i < matches.size(); ++i)
+        QVERIFY(matches[i].path.getString(true) != "(501) 232+, 277+ (113)");
+    matches = sequenceIndex.findSequence(changedQuery, 1, 100);
+    QVERIFY(!matches.empty());
+    QCOMPARE(matches[0].path.getString(true), QString("(501) 232+, 277+ (113)"));
+    QCOMPARE(matches[0].mismatches, 1);
+
+    //Every exact match within a node is found, for queries both longer and
+    //shorter than the k-mer size.
+    QByteArray node280Sequence = g_assemblyGraph->m_deBruijnGraphNodes.value("280+")->getSequence();
+    QList<QByteArray> queries;
+    queries << node280Sequence.mid(100, 20) << node280Sequence.mid(200, 6);
+    for (int i = 0; i < queries.size(); ++i)
+    {
+        bool truncated;
+        matches = sequenceIndex.findSequence(queries[i], 0, 100000, &truncated);
+        QVERIFY(!truncated);
+        QSet<QString> matchStrings;
+        for (size_t j = 0; j < matches.size(); ++j)
+            matchStrings.insert(matches[j].path.getString(true));
+
+        QMapIterator<QString, DeBruijnNode*> nodes(g_assemblyGraph->m_deBruijnGraphNodes);
+        while (nodes.hasNext())
+        {
+            nodes.next();
+            QByteArray nodeSequence = nodes.value()->getSequence();
+            int position = nodeSequence.indexOf(queries[i]);
+            while (position != -1)
+            {
+                GraphLocation start(nodes.value(), position + 1);
+                GraphLocation end(nodes.value(), position + queries[i].length());
+                QList<DeBruijnNode *> pathNodes;
+                pathNodes << nodes.value();
+                QVERIFY(matchStrings.contains(Path::makeFromOrderedNodes(pathNodes, start, end).getString(true)));
+                position = nodeSequence.indexOf(queries[i], position + 1);
+            }
+        }
+    }
+
+    //Matches beyond the maximum are left out.
+    bool truncated;
+    matches = sequenceIndex.findSequence("A", 0, 5, &truncated);
+    QCOMPARE(matches.size(), size_t(5));
+    QVERIFY(truncated);
+
+    //The findseq table has a row for each match.
+    FindSeqOptions options;
+    options.threads = 2;
+    options.mismatches = 0;
+    options.maxHits = 100;
+    std::vector<QString> queryNames;
+    queryNames.push_back("junction");
+    queryNames.push_back("absent");
+    std::vector<QByteArray> querySequences;
+    querySequences.push_back(query);
+    querySequences.push_back(QByteArray(30, 'N'));
+    FindSeqSummary summary;
+    QByteArray table = findQuerySequences(g_assemblyGraph.data(), queryNames, querySequences, options, &summary);
+    QVERIFY(table.startsWith("Query\tPath\tMismatches\tSequence\n"));
+    QVERIFY(table.contains("junction\t(501) 232+, 277+ (113)\t0\t" + query + "\n"));
+    QCOMPARE(summary.queries, 2LL);
+    QCOMPARE(summary.queriesFound, 1LL);
+}
+
+
+void BandageTests::sequenceSearchAcrossJunctions()
+{
+    createGlobals();
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QString graphFilename = tempDir.filePath("junction.gfa");
+    QFile graphFile(graphFilename);
+    QVERIFY(graphFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream gfa(&graphFile);
+    gfa << "H\tVN:Z:1.0\n";
+    gfa << "S\t1\tACGTTGCATGCCTAGGATCCAGTTCAAGGC\n";
+    gfa << "S\t2\tTTGACCGATAGCTTCGAAGTCCTGAGTACA\n";
+    gfa << "L\t1\t+\t2\t+\t0M\n";
+    gfa.flush();
+    graphFile.close();
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(graphFilename));
+    const SequenceIndex & sequenceIndex = g_assemblyGraph->getSequenceIndex();
+
+    //The edge has no overlap, so none of this query's k-mers lies within one
+    //node.  It is found from the k-mers which cross the junction.
+    QByteArray query = "CAAGGCTTGACC";
+    std::vector<SequenceMatch> matches = sequenceIndex.findSequence(query, 0, 100);
+    QCOMPARE(matches.size(), size_t(1));
+    QCOMPARE(matches[0].path.getString(true), QString("(25) 1+, 2+ (6)"));
+    QCOMPARE(matches[0].path.getPathSequence(), query);
+    QCOMPARE(matches[0].mismatches, 0);
+
+    //With three mismatches in a 30 bp query, every one of its k-mers has a
+    //mismatch.  The match is still found.
+    DeBruijnNode * node2 = g_assemblyGraph->m_deBruijnGraphNodes.value("2+");
+    QByteArray changedQuery = node2->getSequence();
+    for (int position = 5; position < changedQuery.length(); position += 10)
+        changedQuery[position] = (changedQuery[position] == 'A') ? 'C' : 'A';
+    matches = sequenceIndex.findSequence(changedQuery, 3, 100);
+    QList<DeBruijnNode *> pathNodes;
+    pathNodes << node2;
+    QString expectedPath = Path::makeFromOrderedNodes(pathNodes, GraphLocation(node2, 1),
+                                                      GraphLocation(node2, 30)).getString(true);
+    bool found = false;
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        if (matches[i].path.getString(true) == expectedPath)
+        {
+            QCOMPARE(matches[i].mismatches, 3);
+            found = true;
+        }
+    }
+    QVERIFY(found);
+    QVERIFY(sequenceIndex.findSequence(changedQuery, 2, 100).empty());
+}
+
 
 void BandageTests::createGlobals()
 {
@@ -1584,6 +3431,53 @@ bool BandageTests::doCircularSequencesMatch(QByteArray s1, QByteArray s2)
 }
 
 
+//This function loads a graph from GFA lines (without the header), using a
+//temporary file.
+bool BandageTests::loadGfa(QByteArray gfaLines)
+{
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid())
+        return false;
+    QString filename = tempDir.filePath("graph.gfa");
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    file.write("H\tVN:Z:1.0\n" + gfaLines);
+    file.close();
+    return g_assemblyGraph->loadGraphFromFile(filename);
+}
+
+
+//This function returns "name sequence" for each positive node, in name order.
+QStringList BandageTests::getPositiveNodeSequences()
+{
+    QStringList nodeSequences;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        if (i.value()->isPositiveNode())
+            nodeSequences.push_back(i.key() + " " + i.value()->getSequence());
+    }
+    return nodeSequences;
+}
+
+
+//This function returns "start>end" for each edge, sorted.
+QStringList BandageTests::getEdgeNames()
+{
+    QStringList edgeNames;
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> i(g_assemblyGraph->m_deBruijnGraphEdges);
+    while (i.hasNext())
+    {
+        i.next();
+        edgeNames.push_back(i.value()->getStartingNode()->getName() + ">" + i.value()->getEndingNode()->getName());
+    }
+    edgeNames.sort();
+    return edgeNames;
+}
+
+
 
 QTEST_MAIN(BandageTests)
 #include "bandagetests.moc"
@@ -0,0 +1,197 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "benchmarkdata.h"
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+
+SyntheticAssembly::SyntheticAssembly(int segmentCount, unsigned int seed) :
+    m_outgoing(segmentCount)
+{
+    std::mt19937 generator(seed);
+    for (int i = 0; i < segmentCount; ++i)
+    {
+        m_sequences.push_back(randomSequence(generator, randomInt(generator, 50, 2000)));
+        m_depths.push_back(randomInt(generator, 50, 500) / 10.0);
+    }
+
+    //Each segment continues into the next one, except where a chain ends (one
+    //time in 50), and one segment in ten also branches to a random segment.
+    for (int i = 0; i < segmentCount - 1; ++i)
+    {
+        if (randomInt(generator, 0, 49) != 0)
+            m_outgoing[i].push_back(i + 1);
+        if (randomInt(generator, 0, 9) == 0)
+        {
+            int target = randomInt(generator, 0, segmentCount - 1);
+            if (target != i && target != i + 1)
+                m_outgoing[i].push_back(target);
+        }
+    }
+}
+
+
+int SyntheticAssembly::randomInt(std::mt19937 & generator, int min, int max)
+{
+    return min + int(generator() % (unsigned int)(max - min + 1));
+}
+
+
+QByteArray SyntheticAssembly::randomSequence(std::mt19937 & generator, int length)
+{
+    static const char bases[] = "ACGT";
+    QByteArray sequence(length, 'A');
+    unsigned int randomBits = 0;
+    for (int i = 0; i < length; ++i)
+    {
+        if (i % 16 == 0)
+            randomBits = generator();
+        sequence[i] = bases[randomBits & 3];
+        randomBits >>= 2;
+    }
+    return sequence;
+}
+
+
+int SyntheticAssembly::getLinkCount() const
+{
+    int linkCount = 0;
+    for (size_t i = 0; i < m_outgoing.size(); ++i)
+        linkCount += int(m_outgoing[i].size());
+    return linkCount;
+}
+
+
+QString SyntheticAssembly::getBlastNodeLabel(int segment) const
+{
+    return "NODE_" + getSegmentName(segment) + "+_length_" + QString::number(m_sequences[segment].length()) +
+            "_cov_" + QString::number(m_depths[segment]);
+}
+
+
+//Each query starts at a random place in a random segment and follows random
+//links until it is long enough or reaches a dead end.
+std::vector<SyntheticQuery> SyntheticAssembly::makeQueries(int queryCount, int minLength, int maxLength,
+                                                           unsigned int seed) const
+{
+    std::mt19937 generator(seed);
+    std::vector<SyntheticQuery> queries;
+    for (int i = 0; i < queryCount; ++i)
+    {
+        SyntheticQuery query;
+        query.name = "query_" + QString::number(i + 1);
+        int targetLength = randomInt(generator, minLength, maxLength);
+        int segment = randomInt(generator, 0, getSegmentCount() - 1);
+        int segmentStart = randomInt(generator, 0, int(m_sequences[segment].length()) - 1);
+        while (true)
+        {
+            int queryLength = int(query.sequence.length());
+            int segmentEnd = std::min(int(m_sequences[segment].length()),
+                                      segmentStart + targetLength - queryLength);
+            SyntheticQueryPart part = {segment, segmentStart, segmentEnd, queryLength};
+            query.parts.push_back(part);
+            query.sequence += m_sequences[segment].mid(segmentStart, segmentEnd - segmentStart);
+            if (query.sequence.length() >= targetLength || m_outgoing[segment].empty())
+                break;
+            segment = m_outgoing[segment][randomInt(generator, 0, int(m_outgoing[segment].size()) - 1)];
+            segmentStart = 0;
+        }
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+
+bool SyntheticAssembly::writeGfa(QString filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream out(&file);
+    out << "H\tVN:Z:1.0\n";
+    for (int i = 0; i < getSegmentCount(); ++i)
+        out << "S\t" << getSegmentName(i) << "\t" << m_sequences[i] << "\tDP:f:" << m_depths[i] << "\n";
+    for (int i = 0; i < getSegmentCount(); ++i)
+    {
+        for (size_t j = 0; j < m_outgoing[i].size(); ++j)
+            out << "L\t" << getSegmentName(i) << "\t+\t" << getSegmentName(m_outgoing[i][j]) << "\t+\t0M\n";
+    }
+    return true;
+}
+
+
+bool SyntheticAssembly::writeFasta(QString filename, const std::vector<SyntheticQuery> & queries) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream out(&file);
+    for (size_t i = 0; i < queries.size(); ++i)
+        out << ">" << queries[i].name << "\n" << queries[i].sequence << "\n";
+    return true;
+}
+
+
+//Each query is written as a perfect alignment to the walk it was made from.
+bool SyntheticAssembly::writeGaf(QString filename, const std::vector<SyntheticQuery> & queries) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream out(&file);
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        const SyntheticQuery & query = queries[i];
+        QString path;
+        int pathLength = 0;
+        for (size_t j = 0; j < query.parts.size(); ++j)
+        {
+            path += ">" + getSegmentName(query.parts[j].segment);
+            pathLength += int(m_sequences[query.parts[j].segment].length());
+        }
+        int queryLength = int(query.sequence.length());
+        int pathStart = query.parts.front().segmentStart;
+        out << query.name << "\t" << queryLength << "\t0\t" << queryLength << "\t+\t" << path << "\t"
+            << pathLength << "\t" << pathStart << "\t" << pathStart + queryLength << "\t"
+            << queryLength << "\t" << queryLength << "\t60\n";
+    }
+    return true;
+}
+
+
+//This gives the tabular (outfmt 6) BLAST output for the queries: one perfect
+//hit for each part of each query.
+QString SyntheticAssembly::makeBlastOutput(const std::vector<SyntheticQuery> & queries) const
+{
+    QString blastOutput;
+    QTextStream out(&blastOutput);
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        for (size_t j = 0; j < queries[i].parts.size(); ++j)
+        {
+            const SyntheticQueryPart & part = queries[i].parts[j];
+            int length = part.segmentEnd - part.segmentStart;
+            out << queries[i].name << "\t" << getBlastNodeLabel(part.segment) << "\t100.00\t"
+                << length << "\t0\t0\t" << part.queryStart + 1 << "\t" << part.queryStart + length << "\t"
+                << part.segmentStart + 1 << "\t" << part.segmentEnd << "\t1e-50\t" << int(length * 1.8) << "\n";
+        }
+    }
+    out.flush();
+    return blastOutput;
+}
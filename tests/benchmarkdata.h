@@ -0,0 +1,81 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef BENCHMARKDATA_H
+#define BENCHMARKDATA_H
+
+#include <QString>
+#include <QByteArray>
+#include <vector>
+#include <random>
+
+//One stretch of a synthetic query: the part of a segment it was taken from
+//and where that part starts in the query.
+struct SyntheticQueryPart
+{
+    int segment;
+    int segmentStart;
+    int segmentEnd;
+    int queryStart;
+};
+
+//A synthetic query is the sequence of a walk through the graph, so it has
+//known hits and a known path.
+struct SyntheticQuery
+{
+    QString name;
+    QByteArray sequence;
+    std::vector<SyntheticQueryPart> parts;
+};
+
+//This class makes an assembly graph and the data that goes with it (queries,
+//BLAST hits and GAF alignments) for the benchmarks.  Everything comes from a
+//std::mt19937 with a fixed seed, using its raw output because the standard
+//distributions differ between library implementations, so a given size and
+//seed always give the same files.
+//
+//The segments form long chains (so there is plenty to merge) with a branch
+//every few segments.  All links join forward strands with no overlap.
+class SyntheticAssembly
+{
+public:
+    SyntheticAssembly(int segmentCount, unsigned int seed);
+
+    int getSegmentCount() const {return int(m_sequences.size());}
+    int getLinkCount() const;
+    QString getSegmentName(int segment) const {return QString::number(segment + 1);}
+
+    std::vector<SyntheticQuery> makeQueries(int queryCount, int minLength, int maxLength,
+                                            unsigned int seed) const;
+
+    bool writeGfa(QString filename) const;
+    bool writeFasta(QString filename, const std::vector<SyntheticQuery> & queries) const;
+    bool writeGaf(QString filename, const std::vector<SyntheticQuery> & queries) const;
+    QString makeBlastOutput(const std::vector<SyntheticQuery> & queries) const;
+
+private:
+    std::vector<QByteArray> m_sequences;
+    std::vector<double> m_depths;
+    std::vector<std::vector<int> > m_outgoing;
+
+    static int randomInt(std::mt19937 & generator, int min, int max);
+    static QByteArray randomSequence(std::mt19937 & generator, int length);
+    QString getBlastNodeLabel(int segment) const;
+};
+
+#endif // BENCHMARKDATA_H
@@ -3,7 +3,6 @@
 
 #include "../program/globals.h"
 #include "../graph/assemblygraph.h"
-#include <QPair>
 
 GraphInfoDialog::GraphInfoDialog(QWidget *parent) :
     QDialog(parent),
@@ -27,6 +26,7 @@ void GraphInfoDialog::setLabels()
 {
     ui->filenameLabel->setText(g_assemblyGraph->m_filename);
 
+    const GraphStatistics & stats = g_assemblyGraph->getGraphStatistics();
     int nodeCount = g_assemblyGraph->m_nodeCount;
 
     ui->nodeCountLabel->setText(formatIntForDisplay(nodeCount));
@@ -36,9 +36,8 @@ void GraphInfoDialog::setLabels()
         ui->edgeOverlapRangeLabel->setText("n/a");
     else
     {
-        QPair<int, int> overlapRange = g_assemblyGraph->getOverlapRange();
-        int smallestOverlap = overlapRange.first;
-        int largestOverlap = overlapRange.second;
+        int smallestOverlap = stats.smallestOverlap;
+        int largestOverlap = stats.largestOverlap;
         if (smallestOverlap == largestOverlap)
             ui->edgeOverlapRangeLabel->setText(formatIntForDisplay(smallestOverlap) + " bp");
         else
@@ -46,25 +45,24 @@ void GraphInfoDialog::setLabels()
     }
 
     ui->totalLengthLabel->setText(formatIntForDisplay(g_assemblyGraph->m_totalLength) + " bp");
-    ui->totalLengthNoOverlapsLabel->setText(formatIntForDisplay(g_assemblyGraph->getTotalLengthMinusEdgeOverlaps()) + " bp");
+    ui->totalLengthNoOverlapsLabel->setText(formatIntForDisplay(stats.totalLengthNoOverlaps) + " bp");
 
-    int deadEnds = g_assemblyGraph->getDeadEndCount();
+    int deadEnds = stats.deadEnds;
     double percentageDeadEnds = 100.0 * double(deadEnds) / (2 * nodeCount);
 
     ui->deadEndsLabel->setText(formatIntForDisplay(deadEnds));
     ui->percentageDeadEndsLabel->setText(formatDoubleForDisplay(percentageDeadEnds, 2) + "%");
 
 
-    int componentCount = 0;
-    int largestComponentLength = 0;
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
+    int componentCount = stats.componentCount;
+    long long largestComponentLength = stats.largestComponentLength;
     QString percentageLargestComponent;
     if (g_assemblyGraph->m_totalLength > 0)
         percentageLargestComponent = formatDoubleForDisplay(100.0 * double(largestComponentLength) / g_assemblyGraph->m_totalLength, 2);
     else
         percentageLargestComponent = "n/a";
 
-    long long totalLengthOrphanedNodes = g_assemblyGraph->getTotalLengthOrphanedNodes();
+    long long totalLengthOrphanedNodes = stats.totalLengthOrphanedNodes;
     QString percentageOrphaned;
     if (g_assemblyGraph->m_totalLength > 0)
         percentageOrphaned = formatDoubleForDisplay(100.0 * double(totalLengthOrphanedNodes) / g_assemblyGraph->m_totalLength, 2);
@@ -91,7 +89,7 @@ void GraphInfoDialog::setLabels()
     ui->longestNodeLabel->setText(formatIntForDisplay(longestNode) + " bp");
 
     double medianDepthByBase = g_assemblyGraph->getMedianDepthByBase();
-    long long estimatedSequenceLength = g_assemblyGraph->getEstimatedSequenceLength(medianDepthByBase);
+    long long estimatedSequenceLength = g_assemblyGraph->getEstimatedSequenceLength();
 
     ui->medianDepthLabel->setText(formatDepthForDisplay(medianDepthByBase));
     if (medianDepthByBase == 0.0)
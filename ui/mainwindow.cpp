@@ -40,6 +40,11 @@
 #include <QProgressDialog>
 #include <QThread>
 #include "../program/graphlayoutworker.h"
+#include "../program/contiguitysearchworker.h"
+#include "../program/graphloadworker.h"
+#include "../command_line/commoncommandlinefunctions.h"
+#include <QEventLoop>
+#include "../graph/contiguitysearch.h"
 #include <QMessageBox>
 #include <QInputDialog>
 #include <QShortcut>
@@ -64,6 +69,7 @@
 #include "../program/memory.h"
 #include "gafpathsdialog.h"
 #include "../program/gafparser.h"
+#include "../program/gafcoverage.h"
 #include "changenodenamedialog.h"
 #include "changenodedepthdialog.h"
 #include <limits>
@@ -73,21 +79,34 @@
 #include "selectednodespathswidget.h"
 #include <QHash>
 #include <QQueue>
+#include <QGraphicsPathItem>
+#include <QPainterPath>
+#include <QPen>
 #include <QSet>
 #include <QSignalBlocker>
 #include <functional>
 #include <QCompleter>
+#include <QTimer>
 
 MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     QMainWindow(0),
-    ui(new Ui::MainWindow), m_layoutThread(0), m_imageFilter("PNG (*.png)"),
+    ui(new Ui::MainWindow), m_layoutThread(0), m_layoutPreview(0), m_contiguitySearch(0), m_expandingLayout(false), m_imageFilter("PNG (*.png)"),
     m_fileToLoadOnStartup(fileToLoadOnStartup), m_drawGraphAfterLoad(drawGraphAfterLoad),
     m_uiState(NO_GRAPH_LOADED), m_blastSearchDialog(0), m_tabWidget(0), m_gafTabIndex(-1), m_gafPathsWidget(0),
     m_selectedEdgePathTabIndex(-1), m_selectedEdgePathWidget(0), m_nodeSequenceTabIndex(-1),
-    m_nodeSequenceWidget(0), m_selectedNodesPathsTabIndex(-1), m_selectedNodesPathsWidget(0), m_alreadyShown(false)
+    m_nodeSequenceWidget(0), m_selectedNodesPathsTabIndex(-1), m_selectedNodesPathsWidget(0), m_alreadyShown(false),
+    m_selectionTextVersion(0)
 {
     ui->setupUi(this);
 
+    //Selecting many nodes at once (e.g. with a rubber band) changes the
+    //selection many times in a row, so the selection widgets are only updated
+    //once it has settled.
+    m_selectionUpdateTimer = new QTimer(this);
+    m_selectionUpdateTimer->setSingleShot(true);
+    m_selectionUpdateTimer->setInterval(50);
+    connect(m_selectionUpdateTimer, SIGNAL(timeout()), this, SLOT(updateSelectionWidgets()));
+
     // Wrap the original central widget into a tab widget so we can add a GAF tab.
     QWidget * oldCentral = takeCentralWidget();
     m_tabWidget = new QTabWidget(this);
@@ -180,6 +199,7 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     connect(ui->blastSearchButton, SIGNAL(clicked()), this, SLOT(openBlastSearchDialog()));
     connect(ui->blastQueryComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(blastQueryChanged()));
     connect(ui->gafLoadButton, SIGNAL(clicked()), this, SLOT(openGafPathsDialog()));
+    connect(ui->gafDepthSourceComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(gafDepthSourceChanged()));
     connect(ui->nodeAttributesLoadButton, SIGNAL(clicked()), this, SLOT(loadCSV()));
     connect(ui->nodeAttributesClearButton, SIGNAL(clicked()), this, SLOT(clearNodeAttributes()));
     connect(ui->nodeAttributesListWidget, SIGNAL(itemChanged(QListWidgetItem*)), this, SLOT(nodeAttributesItemChanged(QListWidgetItem*)));
@@ -277,6 +297,7 @@ void MainWindow::cleanUp()
     ui->blastQueryComboBox->clear();
     ui->blastQueryComboBox->addItem("none");
     ui->gafFileLabel->setText("Not loaded");
+    resetGafDepthSourceComboBox(false);
 
     if (m_selectedEdgePathTabIndex != -1 && m_tabWidget != 0)
     {
@@ -524,6 +545,23 @@ void MainWindow::openGafPathsDialog()
     QString shortName = QFileInfo(fileName).fileName();
     ui->gafFileLabel->setText(shortName + " (" + QString::number(parseResult.alignments.size()) + " paths)");
 
+    //The alignments are also projected onto the graph, so their coverage can
+    //be used for the node depths.  Replacing the coverage puts the graph's own
+    //depths back, so the display is updated if GAF depths were in use.
+    DepthSource oldDepthSource = g_assemblyGraph->getDepthSource();
+    QSharedPointer<GafCoverage> gafCoverage(new GafCoverage());
+    GafCoverageSummary coverageSummary;
+    QString coverageError;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool coverageLoaded = gafCoverage->load(g_assemblyGraph.data(), fileName, QThread::idealThreadCount(),
+                                            &coverageSummary, &coverageError);
+    QApplication::restoreOverrideCursor();
+    coverageLoaded = coverageLoaded && coverageSummary.alignments > 0;
+    g_assemblyGraph->setGafCoverage(coverageLoaded ? gafCoverage : QSharedPointer<GafCoverage>());
+    resetGafDepthSourceComboBox(coverageLoaded);
+    if (oldDepthSource != GRAPH_DEPTH)
+        nodeDepthsChanged();
+
     m_gafPathsWidget = new GafPathsDialog(m_tabWidget, shortName, parseResult);
     m_gafTabIndex = m_tabWidget->addTab(m_gafPathsWidget, "GAF paths");
 
@@ -535,6 +573,40 @@ void MainWindow::openGafPathsDialog()
 }
 
 
+void MainWindow::gafDepthSourceChanged()
+{
+    DepthSource depthSource = DepthSource(ui->gafDepthSourceComboBox->currentIndex());
+    if (depthSource == g_assemblyGraph->getDepthSource())
+        return;
+    if (!g_assemblyGraph->setDepthSource(depthSource))
+    {
+        resetGafDepthSourceComboBox(false);
+        return;
+    }
+    nodeDepthsChanged();
+}
+
+
+void MainWindow::resetGafDepthSourceComboBox(bool enabled)
+{
+    QSignalBlocker blocker(ui->gafDepthSourceComboBox);
+    ui->gafDepthSourceComboBox->setCurrentIndex(0);
+    ui->gafDepthSourceComboBox->setEnabled(enabled);
+}
+
+
+//This function updates everything drawn from the node depths after many of
+//them have changed at once.
+void MainWindow::nodeDepthsChanged()
+{
+    selectionChanged();
+    g_assemblyGraph->recalculateAllDepthsRelativeToDrawnMean();
+    g_assemblyGraph->recalculateAllNodeWidths();
+    g_assemblyGraph->resetAllNodeColours();
+    g_graphicsView->viewport()->update();
+}
+
+
 void MainWindow::focusOnGafSelection()
 {
     //Switch back to the main graph tab.
@@ -604,6 +676,7 @@ void MainWindow::loadGraph(QString fullFileName)
         g_memory->selectedPathsDialogIsVisible = false;
         g_memory->queryPaths.clear();
         ui->gafFileLabel->setText("Not loaded");
+        resetGafDepthSourceComboBox(false);
 
         GraphFileType detectedFileType = g_assemblyGraph->getGraphFileTypeFromFile(fullFileName);
 
@@ -656,89 +729,98 @@ void MainWindow::loadGraph(QString fullFileName)
 
 void MainWindow::loadGraph2(GraphFileType graphFileType, QString fullFileName)
 {
-    resetScene();
-    cleanUp();
-    ui->selectionSearchNodesLineEdit->clear();
-
-    bool customColours = false, customLabels = false;
-
-    try
-    {
-        MyProgressDialog progress(this, "Loading " + convertGraphFileTypeToString(graphFileType) + " file...", false);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
-
-        if (graphFileType == LAST_GRAPH)
-            g_assemblyGraph->buildDeBruijnGraphFromLastGraph(fullFileName);
-        else if (graphFileType == FASTG)
-            g_assemblyGraph->buildDeBruijnGraphFromFastg(fullFileName);
-        else if (graphFileType == GFA)
-        {
-            bool unsupportedCigar = false;
-            QString bandageOptionsError;
-            g_assemblyGraph->buildDeBruijnGraphFromGfa(fullFileName, &unsupportedCigar, &customLabels, &customColours,
-                                                       &bandageOptionsError);
-            if (unsupportedCigar)
-                QMessageBox::warning(this, "Unsupported CIGAR", "This GFA file contains "
-                                     "links with complex CIGAR strings (containing "
-                                     "operators other than M).\n\n"
-                                     "Bandage does not support edge overlaps that are not "
-                                     "perfect, so the behaviour of such edges in this graph "
-                                     "is undefined.");
-            if (bandageOptionsError.length() > 0)
-                QMessageBox::warning(this, "Bad Bandage options", "This GFA file contains Bandage options but they "
-                                     "were not used because of this error:\n\n" + bandageOptionsError);
-
-        }
-        else if (graphFileType == TRINITY)
-            g_assemblyGraph->buildDeBruijnGraphFromTrinityFasta(fullFileName);
-        else if (graphFileType == ASQG)
+    //The graph is built in a different thread so the UI will stay responsive.
+    //It is built in a new AssemblyGraph object which only replaces the current
+    //graph once the load has finished, so a load which is cancelled or fails
+    //leaves the current graph as it was.  While it loads, it uses a copy of
+    //the settings so nothing it does can affect the current graph.
+    AssemblyGraph * newGraph = new AssemblyGraph(QSharedPointer<Settings>(new Settings(*g_settings)));
+    QThread loadThread;
+    GraphLoadWorker graphLoadWorker(newGraph, graphFileType, fullFileName);
+    graphLoadWorker.moveToThread(&loadThread);
+
+    MyProgressDialog progress(this, "Loading " + convertGraphFileTypeToString(graphFileType) + " file...", true,
+                              "Cancel load", "Cancelling load...",
+                              "Clicking this button will stop loading the graph.  The graph which "
+                              "was loaded before (if any) will be kept.");
+    progress.setWindowModality(Qt::WindowModal);
+    progress.show();
+
+    QEventLoop eventLoop;
+    connect(&progress, SIGNAL(halt()), newGraph, SLOT(cancelLoad()));
+    connect(newGraph, SIGNAL(loadProgress(qint64,qint64,int,int)), &progress, SLOT(setLoadProgress(qint64,qint64,int,int)));
+    connect(&loadThread, SIGNAL(started()), &graphLoadWorker, SLOT(loadGraph()));
+    connect(&graphLoadWorker, SIGNAL(finishedLoad()), &loadThread, SLOT(quit()));
+    connect(&loadThread, SIGNAL(finished()), &eventLoop, SLOT(quit()));
+    loadThread.start();
+    eventLoop.exec();
+    loadThread.wait();
+    progress.hide();
+
+    if (!graphLoadWorker.m_loaded)
+    {
+        if (!newGraph->wasLoadCancelled())
         {
-            int badEdgeCount = g_assemblyGraph->buildDeBruijnGraphFromAsqg(fullFileName);
-            if (badEdgeCount > 0)
-                QMessageBox::warning(this, "Edges not loaded", "Bandage could not load " +
-                                     QString::number(badEdgeCount) + " edges in this file "
-                                     "because they have an abnormal overlap.\n\nBandage can "
-                                     "only handle edges with an exact overlap at the "
-                                     "start/end of node sequences.");
+            QString errorTitle = "Error loading " + convertGraphFileTypeToString(graphFileType);
+            QString errorMessage = "There was an error when attempting to load:\n"
+                                   + fullFileName + "\n\n"
+                                   "Please verify that this file has the correct format.";
+            QMessageBox::warning(this, errorTitle, errorMessage);
         }
-        else if (graphFileType == PLAIN_FASTA)
-            g_assemblyGraph->buildDeBruijnGraphFromPlainFasta(fullFileName);
-
-        setUiState(GRAPH_LOADED);
-        setWindowTitle("Bandage - " + fullFileName);
-
-        g_assemblyGraph->determineGraphInfo();
-        displayGraphDetails();
-        g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-        g_memory->clearGraphSpecificMemory();
+        newGraph->cleanUp();
+        delete newGraph;
+        return;
+    }
 
-        // If the graph has custom colours, automatically switch the colour scheme to custom colours.
-        if (customColours) {
-            if (ui->coloursComboBox->currentIndex() != 6)
-                ui->coloursComboBox->setCurrentIndex(6);
-            else
-                switchColourScheme();
-        }
+    resetScene();
+    cleanUp();
+    ui->selectionSearchNodesLineEdit->clear();
+    g_assemblyGraph.reset(newGraph);
+    g_assemblyGraph->m_settings = g_settings;
+
+    //Bandage options in a GFA file are applied now that they can't change the
+    //settings in use by the previous graph.
+    if (!graphLoadWorker.m_bandageOptions.isEmpty())
+        parseSettings(graphLoadWorker.m_bandageOptions);
+
+    if (graphLoadWorker.m_unsupportedCigar)
+        QMessageBox::warning(this, "Unsupported CIGAR", "This GFA file contains "
+                             "links with complex CIGAR strings (containing "
+                             "operators other than M).\n\n"
+                             "Bandage does not support edge overlaps that are not "
+                             "perfect, so the behaviour of such edges in this graph "
+                             "is undefined.");
+    if (graphLoadWorker.m_bandageOptionsError.length() > 0)
+        QMessageBox::warning(this, "Bad Bandage options", "This GFA file contains Bandage options but they "
+                             "were not used because of this error:\n\n" + graphLoadWorker.m_bandageOptionsError);
+    if (graphLoadWorker.m_badEdgeCount > 0)
+        QMessageBox::warning(this, "Edges not loaded", "Bandage could not load " +
+                             QString::number(graphLoadWorker.m_badEdgeCount) + " edges in this file "
+                             "because they have an abnormal overlap.\n\nBandage can "
+                             "only handle edges with an exact overlap at the "
+                             "start/end of node sequences.");
+
+    setUiState(GRAPH_LOADED);
+    setWindowTitle("Bandage - " + fullFileName);
 
-        // If the graph doesn't have custom colours, but the colour scheme is on 'Custom', automatically switch it back
-        // to the default of 'Random colours'.
-        if (!customColours && ui->coloursComboBox->currentIndex() == 6)
-            ui->coloursComboBox->setCurrentIndex(0);
+    g_assemblyGraph->determineGraphInfo();
+    displayGraphDetails();
+    g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
+    g_memory->clearGraphSpecificMemory();
+
+    // If the graph has custom colours, automatically switch the colour scheme to custom colours.
+    bool customColours = graphLoadWorker.m_customColours;
+    if (customColours) {
+        if (ui->coloursComboBox->currentIndex() != 6)
+            ui->coloursComboBox->setCurrentIndex(6);
+        else
+            switchColourScheme();
     }
 
-    catch (...)
-    {
-        QString errorTitle = "Error loading " + convertGraphFileTypeToString(graphFileType);
-        QString errorMessage = "There was an error when attempting to load:\n"
-                               + fullFileName + "\n\n"
-                               "Please verify that this file has the correct format.";
-        QMessageBox::warning(this, errorTitle, errorMessage);
-        resetScene();
-        cleanUp();
-        clearGraphDetails();
-        setUiState(NO_GRAPH_LOADED);
-    }
+    // If the graph doesn't have custom colours, but the colour scheme is on 'Custom', automatically switch it back
+    // to the default of 'Random colours'.
+    if (!customColours && ui->coloursComboBox->currentIndex() == 6)
+        ui->coloursComboBox->setCurrentIndex(0);
 }
 
 
@@ -1006,12 +1088,39 @@ void MainWindow::clearGraphDetails()
 }
 
 
+//This function updates the selection widgets straight away.  It is used after
+//changes to the selected nodes themselves (e.g. their names or depths), so the
+//selection totals are remade first.
 void MainWindow::selectionChanged()
 {
-    std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
-    std::vector<DeBruijnEdge *> selectedEdges = m_scene->getSelectedEdges();
+    m_selectionUpdateTimer->stop();
+    m_scene->recalculateSelectionStatistics();
+    updateSelectionWidgets();
+}
 
-    if (selectedNodes.size() == 0)
+
+void MainWindow::sceneSelectionChanged()
+{
+    m_selectionUpdateTimer->start();
+}
+
+
+//The counts, total length and mean depth are kept by the scene as the
+//selection changes.  The node and edge lists (and the path controls) take
+//longer to make, so they are only remade when the selection has changed since
+//they were last made.
+void MainWindow::updateSelectionWidgets()
+{
+    int selectedNodeCount = m_scene->getSelectedNodeCount();
+    int selectedEdgeCount = m_scene->getSelectedEdgeCount();
+    bool selectionModified = m_scene->getSelectionVersion() != m_selectionTextVersion;
+    m_selectionTextVersion = m_scene->getSelectionVersion();
+
+    std::vector<DeBruijnNode *> selectedNodes;
+    if (selectionModified)
+        selectedNodes = m_scene->getSelectedNodes();
+
+    if (selectedNodeCount == 0)
     {
         ui->selectedNodesTextEdit->setPlainText("");
         setSelectedNodesWidgetsVisibility(false);
@@ -1021,13 +1130,8 @@ void MainWindow::selectionChanged()
     {
         setSelectedNodesWidgetsVisibility(true);
 
-        int selectedNodeCount;
-        QString selectedNodeCountText;
-        QString selectedNodeListText;
-        QString selectedNodeLengthText;
-        QString selectedNodeDepthText;
-
-        getSelectedNodeInfo(selectedNodeCount, selectedNodeCountText, selectedNodeListText, selectedNodeLengthText, selectedNodeDepthText);
+        QString selectedNodeLengthText = formatIntForDisplay(m_scene->getSelectedNodeTotalLength()) + " bp";
+        QString selectedNodeDepthText = formatDepthForDisplay(m_scene->getSelectedNodeMeanDepth());
 
         if (selectedNodeCount == 1)
         {
@@ -1037,16 +1141,17 @@ void MainWindow::selectionChanged()
         }
         else
         {
-            ui->selectedNodesTitleLabel->setText("Selected nodes (" + selectedNodeCountText + ")");
+            ui->selectedNodesTitleLabel->setText("Selected nodes (" + formatIntForDisplay(selectedNodeCount) + ")");
             ui->selectedNodesLengthLabel->setText("Total length: " + selectedNodeLengthText);
             ui->selectedNodesDepthLabel->setText("Mean depth: " + selectedNodeDepthText);
         }
 
-        ui->selectedNodesTextEdit->setPlainText(selectedNodeListText);
+        if (selectionModified)
+            ui->selectedNodesTextEdit->setPlainText(getSelectedNodeListText(selectedNodes));
     }
 
 
-    if (selectedEdges.size() == 0)
+    if (selectedEdgeCount == 0)
     {
         ui->selectedEdgesTextEdit->setPlainText("");
         setSelectedEdgesWidgetsVisibility(false);
@@ -1055,28 +1160,25 @@ void MainWindow::selectionChanged()
     else //One or more edges selected
     {
         setSelectedEdgesWidgetsVisibility(true);
-        if (selectedEdges.size() == 1)
+        if (selectedEdgeCount == 1)
             ui->selectedEdgesTitleLabel->setText("Selected edge");
         else
-            ui->selectedEdgesTitleLabel->setText("Selected edges (" + formatIntForDisplay(int(selectedEdges.size())) + ")");
+            ui->selectedEdgesTitleLabel->setText("Selected edges (" + formatIntForDisplay(selectedEdgeCount) + ")");
 
-        ui->selectedEdgesTextEdit->setPlainText(getSelectedEdgeListText());
+        if (selectionModified)
+            ui->selectedEdgesTextEdit->setPlainText(getSelectedEdgeListText());
     }
 
-    updateSelectedNodesPathControls(selectedNodes);
+    if (selectionModified)
+        updateSelectedNodesPathControls(selectedNodes);
 }
 
 
-void MainWindow::getSelectedNodeInfo(int & selectedNodeCount, QString & selectedNodeCountText, QString & selectedNodeListText, QString & selectedNodeLengthText, QString & selectedNodeDepthText)
+QString MainWindow::getSelectedNodeListText(const std::vector<DeBruijnNode *> & selectedNodes)
 {
-    std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
-
-    selectedNodeCount = int(selectedNodes.size());
-    selectedNodeCountText = formatIntForDisplay(selectedNodeCount);
-
-    long long totalLength = 0;
-
-    for (int i = 0; i < selectedNodeCount; ++i)
+    QStringList nodeNames;
+    nodeNames.reserve(int(selectedNodes.size()));
+    for (size_t i = 0; i < selectedNodes.size(); ++i)
     {
         QString nodeName = selectedNodes[i]->getName();
 
@@ -1084,15 +1186,10 @@ void MainWindow::getSelectedNodeInfo(int & selectedNodeCount, QString & selected
         if (!g_settings->doubleMode)
             nodeName.chop(1);
 
-        selectedNodeListText += nodeName;
-        if (i != int(selectedNodes.size()) - 1)
-            selectedNodeListText += ", ";
-
-        totalLength += selectedNodes[i]->getLength();
+        nodeNames << nodeName;
     }
 
-    selectedNodeLengthText = formatIntForDisplay(totalLength) + " bp";
-    selectedNodeDepthText = formatDepthForDisplay(g_assemblyGraph->getMeanDepth(selectedNodes));
+    return nodeNames.join(", ");
 }
 
 
@@ -1587,7 +1684,8 @@ void MainWindow::drawGraph()
     std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage,
                                                                                   ui->doubleNodesRadioButton->isChecked(),
                                                                                   ui->startingNodesLineEdit->text(),
-                                                                                  ui->blastQueryComboBox->currentText());
+                                                                                  ui->blastQueryComboBox->currentText(),
+                                                                                  false);
 
     if (errorMessage != "")
     {
@@ -1595,6 +1693,18 @@ void MainWindow::drawGraph()
         return;
     }
 
+    //If the graph is already drawn and the only change is a larger node
+    //distance, the new nodes are added to the existing layout so the nodes
+    //already on screen stay where they are.
+    if (m_uiState == GRAPH_DRAWN &&
+            g_assemblyGraph->canExpandOgdfGraph(startingNodes, g_settings->nodeDistance))
+    {
+        g_assemblyGraph->expandOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+        layoutGraph(true);
+        return;
+    }
+
+    g_assemblyGraph->clearOgdfGraphAndResetNodes();
     resetScene();
     g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
     layoutGraph();
@@ -1605,9 +1715,24 @@ void MainWindow::graphLayoutFinished()
 {
     delete m_fmmm;
     m_layoutThread = 0;
-    g_assemblyGraph->addGraphicsItemsToScene(m_scene);
-    m_scene->setSceneRectangle();
-    zoomToFitScene();
+
+    delete m_layoutPreview;
+    m_layoutPreview = 0;
+
+    //When an existing layout was expanded, only the new nodes and edges need
+    //graphics items, and the view is left where the user had it.
+    if (m_expandingLayout)
+    {
+        g_assemblyGraph->restorePinnedOgdfPositions();
+        g_assemblyGraph->addNewGraphicsItemsToScene(m_scene);
+        m_scene->setSceneRectangle();
+    }
+    else
+    {
+        g_assemblyGraph->addGraphicsItemsToScene(m_scene);
+        m_scene->setSceneRectangle();
+        zoomToFitScene();
+    }
     selectionChanged();
 
     setUiState(GRAPH_DRAWN);
@@ -1619,9 +1744,37 @@ void MainWindow::graphLayoutFinished()
 
 void MainWindow::graphLayoutCancelled()
 {
-    m_fmmm->fixedIterations(0);
-    m_fmmm->fineTuningIterations(0);
-    m_fmmm->threshold(std::numeric_limits<double>::max());
+    m_fmmm->stopLayout();
+}
+
+
+//While the graph is being laid out, its current state is drawn as one path
+//of straight lines between the OGDF nodes, which stays quick to redraw for
+//large graphs.  The graphics items replace it when the layout finishes.
+void MainWindow::graphLayoutUpdated(QPolygonF ogdfNodePositions)
+{
+    if (m_layoutThread == 0)
+        return;
+
+    QPainterPath path;
+    ogdf::edge e;
+    forall_edges(e, *g_assemblyGraph->m_ogdfGraph)
+    {
+        path.moveTo(ogdfNodePositions[e->source()->index()]);
+        path.lineTo(ogdfNodePositions[e->target()->index()]);
+    }
+
+    if (m_layoutPreview == 0)
+    {
+        QPen pen(g_settings->edgeColour);
+        pen.setCosmetic(true);
+        m_layoutPreview = m_scene->addPath(path, pen);
+    }
+    else
+        m_layoutPreview->setPath(path);
+
+    m_scene->setSceneRectangle();
+    zoomToFitScene();
 }
 
 
@@ -1637,7 +1790,8 @@ void MainWindow::resetScene()
     m_scene = new MyGraphicsScene(this);
 
     g_graphicsView->setScene(m_scene);
-    connect(m_scene, SIGNAL(selectionChanged()), this, SLOT(selectionChanged()));
+    connect(m_scene, SIGNAL(selectionChanged()), this, SLOT(sceneSelectionChanged()));
+    m_selectionTextVersion = 0;
     selectionChanged();
 
     g_graphicsView->undoRotation();
@@ -1650,14 +1804,46 @@ std::vector<DeBruijnNode *> MainWindow::getNodesFromLineEdit(QLineEdit * lineEdi
 }
 
 
+//This function returns the nodes in the exact matches to the sequence, which
+//can span more than one node.  Each node is only given once, in the order the
+//matches were found.  If there are more than maxMatches matches, only the
+//nodes in the first maxMatches are given and truncated is set to true.
+std::vector<DeBruijnNode *> MainWindow::getNodesFromSequenceSearch(QString sequence, int maxMatches, bool * truncated)
+{
+    std::vector<SequenceMatch> matches = g_assemblyGraph->getSequenceIndex().findSequence(sequence.toLatin1(), 0,
+                                                                                          maxMatches, truncated);
+
+    std::vector<DeBruijnNode *> nodes;
+    QSet<DeBruijnNode *> nodesAdded;
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        QList<DeBruijnNode *> matchNodes = matches[i].path.getNodes();
+        for (int j = 0; j < matchNodes.size(); ++j)
+        {
+            if (!nodesAdded.contains(matchNodes[j]))
+            {
+                nodesAdded.insert(matchNodes[j]);
+                nodes.push_back(matchNodes[j]);
+            }
+        }
+    }
+    return nodes;
+}
 
 
-void MainWindow::layoutGraph()
+
+
+//If expandExistingLayout is true, the OGDF graph has been expanded from the
+//one already drawn, and the layout starts from the nodes' current positions.
+void MainWindow::layoutGraph(bool expandExistingLayout)
 {
+    m_expandingLayout = expandExistingLayout;
+
     //The actual layout is done in a different thread so the UI will stay responsive.
-    MyProgressDialog * progress = new MyProgressDialog(this, "Laying out graph...", true, "Cancel layout", "Cancelling layout...",
-                                                       "Clicking this button will halt the graph layout and display "
-                                                       "the graph in its current, incomplete state.<br><br>"
+    MyProgressDialog * progress = new MyProgressDialog(this, "Laying out graph...", true, "Stop layout", "Stopping layout...",
+                                                       "The graph is drawn as it is laid out.  Clicking this button "
+                                                       "will stop the layout and keep the graph in its current state, "
+                                                       "which is useful when it already looks good enough.<br><br>"
                                                        "Layout can take a long time for very large graphs.  There are "
                                                        "three strategies to reduce the amount of time required:<ul>"
                                                        "<li>Change the scope of the graph from 'Entire graph' to either "
@@ -1677,10 +1863,19 @@ void MainWindow::layoutGraph()
                                                                   g_assemblyGraph->m_edgeArray,
                                                                   g_settings->graphLayoutQuality,
                                                                   g_assemblyGraph->useLinearLayout(),
+                                                                  expandExistingLayout,
                                                                   g_settings->componentSeparation, aspectRatio);
+    if (g_settings->coarseLayout)
+        graphLayoutWorker->setSegmentChains(g_assemblyGraph->getOgdfSegmentChains());
+    graphLayoutWorker->setFixedNodes(g_assemblyGraph->getPinnedOgdfNodes());
     graphLayoutWorker->moveToThread(m_layoutThread);
 
+    //An expanded layout isn't previewed.  The new nodes barely move, and in a
+    //linear layout the whole graph moves until the pinned nodes are put back
+    //at the end, so the preview would jump.
     connect(progress, SIGNAL(halt()), this, SLOT(graphLayoutCancelled()));
+    if (!expandExistingLayout)
+        connect(graphLayoutWorker, SIGNAL(layoutUpdated(QPolygonF)), this, SLOT(graphLayoutUpdated(QPolygonF)));
     connect(m_layoutThread, SIGNAL(started()), graphLayoutWorker, SLOT(layoutGraph()));
     connect(graphLayoutWorker, SIGNAL(finishedLayout()), m_layoutThread, SLOT(quit()));
     connect(graphLayoutWorker, SIGNAL(finishedLayout()), graphLayoutWorker, SLOT(deleteLater()));
@@ -1900,8 +2095,7 @@ void MainWindow::saveSelectedPathToFile()
     {
         QFile file(fullFileName);
         file.open(QIODevice::WriteOnly | QIODevice::Text);
-        QTextStream out(&file);
-        out << nodePath.getFasta();
+        nodePath.writeFasta(&file);
         g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
     }
 }
@@ -1963,20 +2157,61 @@ void MainWindow::determineContiguityFromSelectedNode()
     std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
     if (selectedNodes.size() > 0)
     {
-        MyProgressDialog progress(this, "Determining contiguity...", false);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
+        //The search is done in a different thread so the UI will stay responsive.
+        MyProgressDialog * progress = new MyProgressDialog(this, "Determining contiguity...", true, "Cancel search", "Cancelling search...",
+                                                           "Clicking this button will stop the contiguity search.  No nodes "
+                                                           "will be coloured by contiguity.<br><br>"
+                                                           "Reducing the contiguity 'Search depth' setting will make the "
+                                                           "search faster.");
+        progress->setWindowModality(Qt::WindowModal);
+        progress->show();
+
+        QThread * contiguityThread = new QThread;
+        m_contiguitySearch = new ContiguitySearch(g_assemblyGraph->getIndexedNodes(), g_settings->contiguitySearchSteps);
+        ContiguitySearchWorker * contiguitySearchWorker = new ContiguitySearchWorker(m_contiguitySearch, selectedNodes);
+        contiguitySearchWorker->moveToThread(contiguityThread);
+
+        connect(progress, SIGNAL(halt()), this, SLOT(contiguitySearchCancelled()));
+        connect(contiguityThread, SIGNAL(started()), contiguitySearchWorker, SLOT(determineContiguity()));
+        connect(contiguitySearchWorker, SIGNAL(finishedSearch()), contiguityThread, SLOT(quit()));
+        connect(contiguitySearchWorker, SIGNAL(finishedSearch()), contiguitySearchWorker, SLOT(deleteLater()));
+        connect(contiguitySearchWorker, SIGNAL(finishedSearch()), this, SLOT(contiguitySearchFinished()));
+        connect(contiguityThread, SIGNAL(finished()), contiguityThread, SLOT(deleteLater()));
+        connect(contiguityThread, SIGNAL(finished()), progress, SLOT(deleteLater()));
+        contiguityThread->start();
+    }
+    else
+        QMessageBox::information(this, "No nodes selected", "Please select one or more nodes for which "
+                                                            "contiguity is to be determined.");
+}
 
-        for (size_t i = 0; i < selectedNodes.size(); ++i)
-            (selectedNodes[i])->determineContiguity();
 
+void MainWindow::contiguitySearchFinished()
+{
+    bool cancelled = m_contiguitySearch->wasCancelled();
+    bool budgetExceeded = m_contiguitySearch->wasBudgetExceeded();
+    if (!cancelled)
+    {
+        m_contiguitySearch->applyStatuses();
         g_assemblyGraph->m_contiguitySearchDone = true;
         g_assemblyGraph->resetAllNodeColours();
         g_graphicsView->viewport()->update();
     }
-    else
-        QMessageBox::information(this, "No nodes selected", "Please select one or more nodes for which "
-                                                            "contiguity is to be determined.");
+    delete m_contiguitySearch;
+    m_contiguitySearch = 0;
+
+    if (budgetExceeded)
+        QMessageBox::information(this, "Contiguity search incomplete",
+                                 "The contiguity search was stopped because it was taking too long.  The nodes "
+                                 "shown as contiguous are correct, but some other nodes may be contiguous too.<br><br>"
+                                 "Reducing the contiguity 'Search depth' setting will make the search faster.");
+}
+
+
+void MainWindow::contiguitySearchCancelled()
+{
+    if (m_contiguitySearch != 0)
+        m_contiguitySearch->cancel();
 }
 
 
@@ -2367,9 +2602,17 @@ void MainWindow::selectUserSpecifiedNodes()
     m_scene->blockSignals(true);
     m_scene->clearSelection();
     std::vector<QString> nodesNotInGraph;
-    std::vector<DeBruijnNode *> nodesToSelect = getNodesFromLineEdit(ui->selectionSearchNodesLineEdit,
-                                                                     ui->selectionSearchNodesExactMatchRadioButton->isChecked(),
-                                                                     &nodesNotInGraph);
+    std::vector<DeBruijnNode *> nodesToSelect;
+    bool sequenceSearch = ui->selectionSearchNodesSequenceMatchRadioButton->isChecked();
+    int maxSequenceMatches = 1000;
+    bool sequenceMatchesTruncated = false;
+    if (sequenceSearch)
+        nodesToSelect = getNodesFromSequenceSearch(ui->selectionSearchNodesLineEdit->text(), maxSequenceMatches,
+                                                   &sequenceMatchesTruncated);
+    else
+        nodesToSelect = getNodesFromLineEdit(ui->selectionSearchNodesLineEdit,
+                                             ui->selectionSearchNodesExactMatchRadioButton->isChecked(),
+                                             &nodesNotInGraph);
 
     //Select each node that actually has a GraphicsItemNode, and build a bounding
     //rectangle so the viewport can focus on the selected node.
@@ -2404,9 +2647,11 @@ void MainWindow::selectUserSpecifiedNodes()
     if (foundNodes > 0)
         zoomToSelection();
 
-    if (nodesNotInGraph.size() > 0 || nodesNotFound.size() > 0)
+    if (nodesNotInGraph.size() > 0 || nodesNotFound.size() > 0 || (sequenceSearch && nodesToSelect.empty()))
     {
         QString errorMessage;
+        if (sequenceSearch && nodesToSelect.empty())
+            errorMessage += "The sequence was not found in the graph.\n";
         if (nodesNotInGraph.size() > 0)
         {
             errorMessage += g_assemblyGraph->generateNodesNotFoundErrorMessage(nodesNotInGraph,
@@ -2428,6 +2673,12 @@ void MainWindow::selectUserSpecifiedNodes()
         QMessageBox::information(this, "Nodes not found", errorMessage);
     }
 
+    if (sequenceMatchesTruncated)
+        QMessageBox::information(this, "Too many matches", "The sequence has more than " +
+                                 QString::number(maxSequenceMatches) + " matches in the graph.  Only the nodes "
+                                 "in the first " + QString::number(maxSequenceMatches) + " matches have been "
+                                 "selected.\n\nA longer sequence will have fewer matches.");
+
     m_scene->blockSignals(false);
     g_graphicsView->viewport()->update();
     selectionChanged();
@@ -2576,7 +2827,11 @@ void MainWindow::setInfoTexts()
     ui->selectionSearchNodesMatchTypeInfoText->setInfoText("When 'Exact' match is used, nodes will only be selected if "
                                                            "their name exactly matches your input above.<br><br>"
                                                            "When 'Partial' match is used, nodes will be selected if any "
-                                                           "part of their name matches your input above.");
+                                                           "part of their name matches your input above.<br><br>"
+                                                           "When 'Sequence' match is used, your input above is a sequence, "
+                                                           "and the nodes where it exactly matches (on either strand, and "
+                                                           "including matches which run from one node into the next) "
+                                                           "will be selected.");
     ui->nodeStyleInfoText->setInfoText("'Single' mode will only one node for each positive/negative pair. "
                                        "This produces a simpler graph visualisation, but "
                                        "strand-specific sequences and directionality will be less clear.<br><br>"
@@ -2654,7 +2909,11 @@ void MainWindow::setInfoTexts()
                                         "with the 'Around BLAST hits' graph scope and the 'BLAST "
                                         "hits' colour modes.");
     ui->gafInfoText->setInfoText("Import a GAF file (graph alignments) to list all paths. "
-                                 "Select path(s) and click 'Highlight selected paths' to select and display the path on the graph.");
+                                 "Select path(s) and click 'Highlight selected paths' to select and display the path on the graph.<br><br>"
+                                 "The alignments' coverage can also be used as the node depths, which affects the 'Colour by depth' "
+                                 "option, node widths and depth statistics. 'GAF mean coverage' is the mean number of alignments "
+                                 "covering each base of a node and 'GAF read count' is the number of alignments which pass through "
+                                 "a node.");
     ui->selectionSearchInfoText->setInfoText("Type a comma-delimited list of one or mode node numbers and then click "
                                              "the 'Find node(s)' button to search for nodes in the graph. "
                                              "If the search is successful, the view will zoom to the found nodes "
@@ -3368,10 +3627,11 @@ void MainWindow::mergeSelectedNodes()
 void MainWindow::mergeAllPossible()
 {
     int merges;
+    bool cancelled;
     {
         MyProgressDialog progress(this, "Merging nodes", true, "Cancel merge", "Cancelling merge...",
-                                  "Clicking this button will stop the merging process. Merges that have already completed will remain "
-                                  "merged but no further merging will take place.");
+                                  "Clicking this button will stop the merging process. The merges are applied "
+                                  "together at the end, so no nodes will be merged.");
 
         progress.setWindowModality(Qt::WindowModal);
         progress.setMaxValue(100);
@@ -3383,6 +3643,7 @@ void MainWindow::mergeAllPossible()
 
         g_graphicsView->viewport()->setUpdatesEnabled(false);
         merges = g_assemblyGraph->mergeAllPossible(m_scene, &progress);
+        cancelled = progress.wasCancelled();
         g_graphicsView->viewport()->setUpdatesEnabled(true);
     }
 
@@ -3396,7 +3657,7 @@ void MainWindow::mergeAllPossible()
         cleanUpAllBlast();
         g_assemblyGraph->resetNodeContiguityStatus();
     }
-    else
+    else if (!cancelled)
         QMessageBox::information(this, "No possible merges", "The graph contains no nodes that can be merged.");
 }
 
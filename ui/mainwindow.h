@@ -33,6 +33,7 @@
 #include <QThread>
 #include "../ogdf/energybased/FMMMLayout.h"
 #include <QTabWidget>
+#include <QPolygonF>
 
 class GraphicsViewZoom;
 class MyGraphicsScene;
@@ -45,6 +46,9 @@ class SelectedEdgePathWidget;
 class NodeSequenceWidget;
 class SelectedNodesPathsWidget;
 class QDockWidget;
+class QTimer;
+class QGraphicsPathItem;
+class ContiguitySearch;
 
 namespace Ui {
 class MainWindow;
@@ -66,6 +70,9 @@ private:
     double m_previousZoomSpinBoxValue;
     QThread * m_layoutThread;
     ogdf::FMMMLayout * m_fmmm;
+    QGraphicsPathItem * m_layoutPreview;
+    ContiguitySearch * m_contiguitySearch;
+    bool m_expandingLayout;
     QString m_imageFilter;
     QString m_fileToLoadOnStartup;
     bool m_drawGraphAfterLoad;
@@ -81,19 +88,22 @@ private:
     int m_selectedNodesPathsTabIndex;
     SelectedNodesPathsWidget * m_selectedNodesPathsWidget;
     bool m_alreadyShown;
+    QTimer * m_selectionUpdateTimer;
+    unsigned long long m_selectionTextVersion;
 
     void cleanUp();
     void displayGraphDetails();
     void clearGraphDetails();
     void resetScene();
-    void layoutGraph();
+    void layoutGraph(bool expandExistingLayout = false);
     void addGraphicsItemsToScene();
     void zoomToFitRect(QRectF rect);
     void zoomToFitScene();
     void setZoomSpinBoxStep();
-    void getSelectedNodeInfo(int & selectedNodeCount, QString & selectedNodeCountText, QString & selectedNodeListText, QString & selectedNodeLengthText, QString &selectedNodeDepthText);
+    QString getSelectedNodeListText(const std::vector<DeBruijnNode *> & selectedNodes);
     QString getSelectedEdgeListText();
     std::vector<DeBruijnNode *> getNodesFromLineEdit(QLineEdit * lineEdit, bool exactMatch, std::vector<QString> * nodesNotInGraph = 0);
+    std::vector<DeBruijnNode *> getNodesFromSequenceSearch(QString sequence, int maxMatches, bool * truncated);
     void setSceneRectangle();
     void loadGraph2(GraphFileType graphFileType, QString filename);
     void setInfoTexts();
@@ -121,6 +131,8 @@ private:
     void setStartingNodesWidgetVisibility(bool visible);
     void setNodeDistanceWidgetVisibility(bool visible);
     void setDepthRangeWidgetVisibility(bool visible);
+    void resetGafDepthSourceComboBox(bool enabled);
+    void nodeDepthsChanged();
     static QByteArray makeStringUrlSafe(QByteArray s);
     void removeGraphicsItemNodes(const std::vector<DeBruijnNode *> * nodes, bool reverseComplement);
     void removeGraphicsItemEdges(const std::vector<DeBruijnEdge *> * edges, bool reverseComplement);
@@ -133,6 +145,8 @@ private slots:
     void clearNodeAttributes();
     void nodeAttributesItemChanged(QListWidgetItem * item);
     void selectionChanged();
+    void sceneSelectionChanged();
+    void updateSelectionWidgets();
     void graphScopeChanged();
     void drawGraph();
     void zoomSpinBoxChanged();
@@ -162,6 +176,9 @@ private slots:
     void blastQueryChanged();
     void showHidePanels();
     void graphLayoutCancelled();
+    void graphLayoutUpdated(QPolygonF ogdfNodePositions);
+    void contiguitySearchFinished();
+    void contiguitySearchCancelled();
     void bringSelectedNodesToFront();
     void selectNodesWithBlastHits();
     void selectNodesWithDeadEnds();
@@ -179,6 +196,7 @@ private slots:
     void startingNodesExactMatchChanged();
     void openPathSpecifyDialog();
     void openGafPathsDialog();
+    void gafDepthSourceChanged();
     void focusOnGafSelection();
     void focusOnSelectedNodesPaths();
     void generateSequenceFromSelectedEdges();
@@ -25,10 +25,19 @@
 #include "../graph/graphicsitemnode.h"
 #include "../graph/graphicsitemedge.h"
 #include "../graph/debruijnnode.h"
+#include "../program/settings.h"
+#include <QTimer>
+#include <QSet>
 
 MyGraphicsScene::MyGraphicsScene(QObject *parent) :
-    QGraphicsScene(parent)
+    QGraphicsScene(parent), m_selectedNodeTotalLength(0), m_selectedNodeDepthSum(0.0),
+    m_selectedNodeLengthWeightedDepthSum(0.0), m_selectionVersion(0),
+    m_nodeDragActive(false)
 {
+    m_dragTimer = new QTimer(this);
+    m_dragTimer->setSingleShot(true);
+    m_dragTimer->setInterval(16);
+    connect(m_dragTimer, SIGNAL(timeout()), this, SLOT(applyNodeDrag()));
 }
 
 
@@ -58,15 +67,9 @@ bool compareNodePointers(DeBruijnNode * a, DeBruijnNode * b)
 std::vector<DeBruijnNode *> MyGraphicsScene::getSelectedNodes()
 {
     std::vector<DeBruijnNode *> returnVector;
-
-    QList<QGraphicsItem *> selection = selectedItems();
-    for (int i = 0; i < selection.size(); ++i)
-    {
-        QGraphicsItem * selectedItem = selection[i];
-        GraphicsItemNode * selectedNodeItem = dynamic_cast<GraphicsItemNode *>(selectedItem);
-        if (selectedNodeItem != 0)
-            returnVector.push_back(selectedNodeItem->m_deBruijnNode);
-    }
+    returnVector.reserve(m_selectedNodeItems.size());
+    for (size_t i = 0; i < m_selectedNodeItems.size(); ++i)
+        returnVector.push_back(m_selectedNodeItems[i]->m_deBruijnNode);
 
     std::sort(returnVector.begin(), returnVector.end(), compareNodePointers);
 
@@ -111,35 +114,109 @@ std::vector<DeBruijnNode *> MyGraphicsScene::getSelectedPositiveNodes()
 //This function returns all of the selected graphics item nodes, unsorted.
 std::vector<GraphicsItemNode *> MyGraphicsScene::getSelectedGraphicsItemNodes()
 {
-    std::vector<GraphicsItemNode *> returnVector;
+    return m_selectedNodeItems;
+}
 
-    QList<QGraphicsItem *> selection = selectedItems();
-    for (int i = 0; i < selection.size(); ++i)
-    {
-        QGraphicsItem * selectedItem = selection[i];
-        GraphicsItemNode * selectedNodeItem = dynamic_cast<GraphicsItemNode *>(selectedItem);
-        if (selectedNodeItem != 0)
-            returnVector.push_back(selectedNodeItem);
-    }
+
+std::vector<DeBruijnEdge *> MyGraphicsScene::getSelectedEdges()
+{
+    std::vector<DeBruijnEdge *> returnVector;
+    returnVector.reserve(m_selectedEdgeItems.size());
+    for (size_t i = 0; i < m_selectedEdgeItems.size(); ++i)
+        returnVector.push_back(m_selectedEdgeItems[i]->m_deBruijnEdge);
 
     return returnVector;
 }
 
 
-std::vector<DeBruijnEdge *> MyGraphicsScene::getSelectedEdges()
+
+//These functions are called by the graphics items when they are selected or
+//deselected (or leave the scene while selected).  They keep the selected items
+//and the running totals for the selected nodes' length and depth.
+void MyGraphicsScene::nodeSelectionChanged(GraphicsItemNode * node, bool selected)
 {
-    std::vector<DeBruijnEdge *> returnVector;
+    if (selected == (node->m_selectionIndex >= 0))
+        return;
 
-    QList<QGraphicsItem *> selection = selectedItems();
-    for (int i = 0; i < selection.size(); ++i)
+    if (selected)
     {
-        QGraphicsItem * selectedItem = selection[i];
-        GraphicsItemEdge * selectedEdgeItem = dynamic_cast<GraphicsItemEdge *>(selectedItem);
-        if (selectedEdgeItem != 0)
-            returnVector.push_back(selectedEdgeItem->m_deBruijnEdge);
+        node->m_selectionIndex = int(m_selectedNodeItems.size());
+        m_selectedNodeItems.push_back(node);
+        addNodeToSelectionStatistics(node->m_deBruijnNode, 1);
     }
+    else
+    {
+        GraphicsItemNode * lastNode = m_selectedNodeItems.back();
+        m_selectedNodeItems[node->m_selectionIndex] = lastNode;
+        lastNode->m_selectionIndex = node->m_selectionIndex;
+        m_selectedNodeItems.pop_back();
+        node->m_selectionIndex = -1;
+        addNodeToSelectionStatistics(node->m_deBruijnNode, -1);
+
+        //Starting the totals again when the selection is empty stops rounding
+        //errors from building up.
+        if (m_selectedNodeItems.empty())
+            recalculateSelectionStatistics();
+    }
+    ++m_selectionVersion;
+}
 
-    return returnVector;
+
+void MyGraphicsScene::edgeSelectionChanged(GraphicsItemEdge * edge, bool selected)
+{
+    if (selected == (edge->m_selectionIndex >= 0))
+        return;
+
+    if (selected)
+    {
+        edge->m_selectionIndex = int(m_selectedEdgeItems.size());
+        m_selectedEdgeItems.push_back(edge);
+    }
+    else
+    {
+        GraphicsItemEdge * lastEdge = m_selectedEdgeItems.back();
+        m_selectedEdgeItems[edge->m_selectionIndex] = lastEdge;
+        lastEdge->m_selectionIndex = edge->m_selectionIndex;
+        m_selectedEdgeItems.pop_back();
+        edge->m_selectionIndex = -1;
+    }
+    ++m_selectionVersion;
+}
+
+
+void MyGraphicsScene::addNodeToSelectionStatistics(DeBruijnNode * node, int sign)
+{
+    m_selectedNodeTotalLength += sign * node->getLength();
+    m_selectedNodeDepthSum += sign * node->getDepth();
+    m_selectedNodeLengthWeightedDepthSum += sign * node->getLength() * (long double)node->getDepth();
+}
+
+
+//This function remakes the selection totals from the selected nodes.  It is
+//needed when the selected nodes themselves change (e.g. their depth or name).
+void MyGraphicsScene::recalculateSelectionStatistics()
+{
+    m_selectedNodeTotalLength = 0;
+    m_selectedNodeDepthSum = 0.0;
+    m_selectedNodeLengthWeightedDepthSum = 0.0;
+    for (size_t i = 0; i < m_selectedNodeItems.size(); ++i)
+        addNodeToSelectionStatistics(m_selectedNodeItems[i]->m_deBruijnNode, 1);
+    ++m_selectionVersion;
+}
+
+
+//This gives the same value as AssemblyGraph::getMeanDepth for the selected
+//nodes: the mean weighted by length, or the plain mean if every selected node
+//has a length of zero.
+double MyGraphicsScene::getSelectedNodeMeanDepth() const
+{
+    if (m_selectedNodeItems.empty())
+        return 0.0;
+    if (m_selectedNodeItems.size() == 1)
+        return m_selectedNodeItems[0]->m_deBruijnNode->getDepth();
+    if (m_selectedNodeTotalLength == 0)
+        return m_selectedNodeDepthSum / m_selectedNodeItems.size();
+    return m_selectedNodeLengthWeightedDepthSum / m_selectedNodeTotalLength;
 }
 
 
@@ -268,3 +345,123 @@ void MyGraphicsScene::mousePressEvent(QGraphicsSceneMouseEvent * event)
     QGraphicsScene::mousePressEvent(event);
 }
 
+
+
+namespace
+{
+//This function returns the graphics item that an edge end is drawn to: the
+//node's own item or, in single mode, its reverse complement's.
+GraphicsItemNode * getDrawnGraphicsItemNode(DeBruijnNode * node)
+{
+    if (node->hasGraphicsItem())
+        return node->getGraphicsItemNode();
+    return node->getReverseComplement()->getGraphicsItemNode();
+}
+}
+
+
+//This function is called for each mouse move while the selected nodes are
+//dragged.  The first call starts the drag.
+void MyGraphicsScene::dragSelectedNodes(QPointF difference)
+{
+    if (!m_nodeDragActive)
+        startNodeDrag();
+
+    m_dragOffset += difference;
+    if (!m_dragTimer->isActive())
+        m_dragTimer->start();
+}
+
+
+//The nodes and the edges which touch them are found once, at the start of
+//the drag.  Edges with both ends in the group move with it, and the others
+//need to be re-routed as the group moves.
+void MyGraphicsScene::startNodeDrag()
+{
+    m_nodeDragActive = true;
+    m_dragOffset = QPointF();
+    m_draggedNodes = m_selectedNodeItems;
+    m_draggedInnerEdges.clear();
+    m_draggedBoundaryEdges.clear();
+
+    QSet<GraphicsItemNode *> draggedNodeSet;
+    for (size_t i = 0; i < m_draggedNodes.size(); ++i)
+        draggedNodeSet.insert(m_draggedNodes[i]);
+
+    QSet<GraphicsItemEdge *> edgesFound;
+    for (size_t i = 0; i < m_draggedNodes.size(); ++i)
+    {
+        const std::vector<DeBruijnEdge *> * edges = m_draggedNodes[i]->m_deBruijnNode->getEdgesPointer();
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            DeBruijnEdge * deBruijnEdge = (*edges)[j];
+            GraphicsItemEdge * graphicsItemEdge = deBruijnEdge->getGraphicsItemEdge();
+            if (graphicsItemEdge == 0 && !g_settings->doubleMode)
+                graphicsItemEdge = deBruijnEdge->getReverseComplement()->getGraphicsItemEdge();
+            if (graphicsItemEdge == 0 || edgesFound.contains(graphicsItemEdge))
+                continue;
+            edgesFound.insert(graphicsItemEdge);
+
+            DeBruijnEdge * drawnEdge = graphicsItemEdge->m_deBruijnEdge;
+            if (draggedNodeSet.contains(getDrawnGraphicsItemNode(drawnEdge->getStartingNode())) &&
+                    draggedNodeSet.contains(getDrawnGraphicsItemNode(drawnEdge->getEndingNode())))
+                m_draggedInnerEdges.push_back(graphicsItemEdge);
+            else
+                m_draggedBoundaryEdges.push_back(graphicsItemEdge);
+        }
+    }
+}
+
+
+//This function is normally called by the drag timer, once per frame, but it
+//can be called directly to apply the moves so far straight away.
+void MyGraphicsScene::applyNodeDrag()
+{
+    if (!m_nodeDragActive)
+        return;
+    m_dragTimer->stop();
+
+    for (size_t i = 0; i < m_draggedNodes.size(); ++i)
+        m_draggedNodes[i]->setPos(m_dragOffset);
+    for (size_t i = 0; i < m_draggedInnerEdges.size(); ++i)
+        m_draggedInnerEdges[i]->setPos(m_dragOffset);
+    for (size_t i = 0; i < m_draggedBoundaryEdges.size(); ++i)
+        m_draggedBoundaryEdges[i]->calculateAndSetPath();
+}
+
+
+//When the drag finishes, the offset is moved into the nodes' points and all
+//of the touching edges are remade, leaving every item back at the origin.
+void MyGraphicsScene::finishNodeDrag()
+{
+    if (!m_nodeDragActive)
+        return;
+    m_dragTimer->stop();
+
+    for (size_t i = 0; i < m_draggedNodes.size(); ++i)
+        m_draggedNodes[i]->applyDragOffset(m_dragOffset);
+    for (size_t i = 0; i < m_draggedInnerEdges.size(); ++i)
+    {
+        m_draggedInnerEdges[i]->setPos(QPointF());
+        m_draggedInnerEdges[i]->calculateAndSetPath();
+    }
+    for (size_t i = 0; i < m_draggedBoundaryEdges.size(); ++i)
+        m_draggedBoundaryEdges[i]->calculateAndSetPath();
+    possiblyExpandSceneRectangle(&m_draggedNodes);
+
+    cancelNodeDrag();
+}
+
+
+//This function forgets the drag without touching the items.  It is used
+//when items are removed from the scene during a drag, as the dragged items
+//may no longer exist.
+void MyGraphicsScene::cancelNodeDrag()
+{
+    m_dragTimer->stop();
+    m_nodeDragActive = false;
+    m_draggedNodes.clear();
+    m_draggedInnerEdges.clear();
+    m_draggedBoundaryEdges.clear();
+    m_dragOffset = QPointF();
+}
@@ -20,11 +20,14 @@
 #define MYGRAPHICSSCENE_H
 
 #include <QGraphicsScene>
+#include <QPointF>
 #include <vector>
 
 class DeBruijnNode;
 class DeBruijnEdge;
 class GraphicsItemNode;
+class GraphicsItemEdge;
+class QTimer;
 
 class MyGraphicsScene : public QGraphicsScene
 {
@@ -42,9 +45,52 @@ public:
     void setSceneRectangle();
     void possiblyExpandSceneRectangle(std::vector<GraphicsItemNode *> * movedNodes);
 
+    void nodeSelectionChanged(GraphicsItemNode * node, bool selected);
+    void edgeSelectionChanged(GraphicsItemEdge * edge, bool selected);
+    void recalculateSelectionStatistics();
+    int getSelectedNodeCount() const {return int(m_selectedNodeItems.size());}
+    int getSelectedEdgeCount() const {return int(m_selectedEdgeItems.size());}
+    long long getSelectedNodeTotalLength() const {return m_selectedNodeTotalLength;}
+    double getSelectedNodeMeanDepth() const;
+    unsigned long long getSelectionVersion() const {return m_selectionVersion;}
+
+    void dragSelectedNodes(QPointF difference);
+    void finishNodeDrag();
+    void cancelNodeDrag();
+    bool isDraggingNodes() const {return m_nodeDragActive;}
+
+public slots:
+    void applyNodeDrag();
+
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent * event);
 
+private:
+    //The selected items are kept as they are selected and deselected, so large
+    //selections don't need a pass over selectedItems().  Each item holds its
+    //own index in these vectors, so it can be removed in constant time.
+    std::vector<GraphicsItemNode *> m_selectedNodeItems;
+    std::vector<GraphicsItemEdge *> m_selectedEdgeItems;
+    long long m_selectedNodeTotalLength;
+    long double m_selectedNodeDepthSum;
+    long double m_selectedNodeLengthWeightedDepthSum;
+    unsigned long long m_selectionVersion;
+
+    //While the selected nodes are dragged, their items (and the edges between
+    //them) are moved as a group by setting their position, and only the edges
+    //leading out of the group are re-routed.  Mouse moves are added up and
+    //applied at most once per frame.  The nodes' points and paths are only
+    //remade when the drag finishes.
+    bool m_nodeDragActive;
+    std::vector<GraphicsItemNode *> m_draggedNodes;
+    std::vector<GraphicsItemEdge *> m_draggedInnerEdges;
+    std::vector<GraphicsItemEdge *> m_draggedBoundaryEdges;
+    QPointF m_dragOffset;
+    QTimer * m_dragTimer;
+
+    void addNodeToSelectionStatistics(DeBruijnNode * node, int sign);
+    void startNodeDrag();
+
 };
 
 #endif // MYGRAPHICSSCENE_H
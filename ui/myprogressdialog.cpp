@@ -19,6 +19,8 @@
 #include "myprogressdialog.h"
 #include "ui_myprogressdialog.h"
 #include "../program/globals.h"
+#include <QLocale>
+#include <algorithm>
 
 MyProgressDialog::MyProgressDialog(QWidget * parent, QString message, bool showCancelButton,
                                    QString cancelButtonText, QString cancelMessage, QString cancelInfoText) :
@@ -71,3 +73,18 @@ void MyProgressDialog::setValue(int value)
 {
     ui->progressBar->setValue(value);
 }
+
+//This shows how far through a file the load has got, with the number of nodes
+//and edges made so far.  The progress bar's range is kept to a thousand steps
+//so it works for files larger than an int can count.
+void MyProgressDialog::setLoadProgress(qint64 bytesRead, qint64 totalBytes, int nodeCount, int edgeCount)
+{
+    if (totalBytes <= 0)
+        return;
+
+    ui->progressBar->setMaximum(1000);
+    ui->progressBar->setValue(int(1000 * std::min(bytesRead, totalBytes) / totalBytes));
+    ui->progressBar->setFormat(QLocale().toString(nodeCount) + " nodes, " +
+                               QLocale().toString(edgeCount) + " edges");
+    ui->progressBar->setTextVisible(true);
+}
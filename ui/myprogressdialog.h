@@ -42,6 +42,7 @@ public:
 public slots:
     void setMaxValue(int max);
     void setValue(int value);
+    void setLoadProgress(qint64 bytesRead, qint64 totalBytes, int nodeCount, int edgeCount);
 
 private:
     Ui::MyProgressDialog *ui;
@@ -102,7 +102,7 @@ void PathSpecifyDialog::checkPathValidity()
     //If the Path isn't empty, then we have succeeded!
     else
     {
-        int pathLength = g_memory->userSpecifiedPath.getLength();
+        long long pathLength = g_memory->userSpecifiedPath.getLength();
         ui->validPathLabel->setText("Valid path: " + formatIntForDisplay(pathLength) + " bp");
         setPathValidityUiElements(true);
     }
@@ -141,8 +141,7 @@ void PathSpecifyDialog::savePathToFile()
     {
         QFile file(fullFileName);
         file.open(QIODevice::WriteOnly | QIODevice::Text);
-        QTextStream out(&file);
-        out << g_memory->userSpecifiedPath.getFasta();
+        g_memory->userSpecifiedPath.writeFasta(&file);
         g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
     }
 }
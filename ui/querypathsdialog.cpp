@@ -73,7 +73,7 @@ QueryPathsDialog::QueryPathsDialog(QWidget * parent, BlastQuery * query) :
         QTableWidgetItem * pathString = new QTableWidgetItem(queryPath->getPath().getString(true));
         pathString->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
 
-        int length = queryPath->getPath().getLength();
+        long long length = queryPath->getPath().getLength();
         TableWidgetItemInt * pathLength = new TableWidgetItemInt(formatIntForDisplay(length), length);
         pathLength->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
 
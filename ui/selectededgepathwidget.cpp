@@ -104,8 +104,8 @@ void SelectedEdgePathWidget::exportFasta()
         return;
     }
 
-    QTextStream out(&file);
-    out << m_path.getFasta();
+    if (!m_path.writeFasta(&file))
+        QMessageBox::warning(this, "Export FASTA", "Could not write to file:\n" + fileName);
     g_memory->rememberedPath = QFileInfo(fileName).absolutePath();
 }
 
@@ -131,7 +131,7 @@ void SelectedEdgePathWidget::exportGaf()
         nodeNames << nodes[i]->getName();
 
     QString pathField = nodeNames.join(",");
-    int pathLength = m_path.getLength();
+    long long pathLength = m_path.getLength();
 
     QStringList fields;
     fields << "selected_edges_path";
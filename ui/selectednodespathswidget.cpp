@@ -248,10 +248,8 @@ void SelectedNodesPathsWidget::exportPathSequence(int row)
     }
 
     const Path &path = m_paths[row];
-    QByteArray sequence = path.getPathSequence();
-    QTextStream out(&file);
-    out << ">selected_node_path\n";
-    out << AssemblyGraph::addNewlinesToSequence(sequence);
+    if (!path.writeFasta(&file, "selected_node_path"))
+        QMessageBox::warning(this, "Export FASTA", "Could not write to file:\n" + fileName);
 
     g_memory->rememberedPath = QFileInfo(fileName).absolutePath();
 }
@@ -231,6 +231,8 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
         ui->graphLayoutQualitySlider->setValue(settings->graphLayoutQuality);
         ui->linearLayoutOffRadioButton->setChecked(!settings->linearLayout);
         ui->linearLayoutOnRadioButton->setChecked(settings->linearLayout);
+        ui->coarseLayoutOffRadioButton->setChecked(!settings->coarseLayout);
+        ui->coarseLayoutOnRadioButton->setChecked(settings->coarseLayout);
         ui->antialiasingOffRadioButton->setChecked(!settings->antialiasing);
         ui->antialiasingOnRadioButton->setChecked(settings->antialiasing);
         ui->antialiasingOffRadioButton->setChecked(!settings->antialiasing);
@@ -251,6 +253,7 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
     {
         settings->graphLayoutQuality = ui->graphLayoutQualitySlider->value();
         settings->linearLayout = ui->linearLayoutOnRadioButton->isChecked();
+        settings->coarseLayout = ui->coarseLayoutOnRadioButton->isChecked();
         settings->antialiasing = ui->antialiasingOnRadioButton->isChecked();
         settings->arrowheadsInSingleMode = ui->singleNodeArrowHeadsOnRadioButton->isChecked();
         settings->autoDepthValue = ui->depthValueAutoRadioButton->isChecked();
@@ -306,6 +309,11 @@ void SettingsDialog::setInfoTexts()
     ui->linearLayoutInfoText->setInfoText("Enable this option if the graph is ordered in a linear fashion, e.g. for a MSA graph.<br><br>"
                                           "When on, Bandage will sort the nodes by name (numerically or alphabetically) and initialise the graph layout left-to-right, resulting in a more linear layout.<br><br>"
                                           "This type of layout is automatically used when viewing plain FASTA files in Bandage.");
+    ui->coarseLayoutInfoText->setInfoText("Enable this option to speed up the layout of graphs with very long nodes, e.g. long read assemblies.<br><br>"
+                                          "When on, Bandage first lays out the graph with each node as a single point, then expands each node to its full length and briefly refines the layout. "
+                                          "Layout time then depends mainly on the number of nodes rather than on their total length.<br><br>"
+                                          "This option has no effect when the linear graph layout is on.<br><br>"
+                                          "The graph must be redrawn to see the effect of changing this setting.");
 
     ui->depthPowerInfoText->setInfoText("This is the power used in the function for determining node widths.");
     ui->depthEffectOnWidthInfoText->setInfoText("This controls the degree to which a node's depth affects its width.<br><br>"
@@ -18,7 +18,7 @@
 
 #include "tablewidgetitemint.h"
 
-TableWidgetItemInt::TableWidgetItemInt(QString text, int value) :
+TableWidgetItemInt::TableWidgetItemInt(QString text, long long value) :
     QTableWidgetItem(text), m_int(value)
 {
 }
@@ -24,9 +24,9 @@
 class TableWidgetItemInt : public QTableWidgetItem
 {
 public:
-    TableWidgetItemInt(QString text, int value);
+    TableWidgetItemInt(QString text, long long value);
 
-    int m_int;
+    long long m_int;
 
     virtual bool operator<(QTableWidgetItem const &other) const;
 };